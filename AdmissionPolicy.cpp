@@ -0,0 +1,291 @@
+/**
+ * @file AdmissionPolicy.cpp
+ * @brief Built-in admission policies and the admission policy factory
+ */
+#include "AdmissionPolicy.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+    /**
+     * @brief Admits everything (unbounded queue)
+     */
+    class AdmitAllPolicy : public AdmissionPolicy {
+    public:
+        std::string name() const override { return "none"; }
+
+        bool admit(const Request&, size_t, int) override { return true; }
+    };
+
+    /**
+     * @brief Sheds arrivals while the queue is full
+     */
+    class TailDropPolicy : public AdmissionPolicy {
+    private:
+        std::string spec;   ///< Name reported by name()
+        size_t capacity;    ///< Largest queue length
+
+    public:
+        TailDropPolicy(const std::string& name, size_t limit) : spec(name), capacity(limit) {}
+
+        std::string name() const override { return spec; }
+
+        bool admit(const Request&, size_t queued, int) override {
+            return queued < capacity;
+        }
+    };
+
+    /**
+     * @brief Random early detection on the smoothed queue length
+     *
+     * The drop probability between the thresholds is spread out with the usual
+     * count correction (pa = pb / (1 - count * pb)), so drops come at roughly even
+     * intervals instead of in clusters.
+     */
+    class RedPolicy : public AdmissionPolicy {
+    private:
+        static constexpr double WEIGHT = 0.02;  ///< EWMA weight of each arrival's queue sample
+
+        std::string spec;               ///< Name reported by name()
+        size_t capacity;                ///< Hard queue limit
+        double low;                     ///< Smoothed length where early drops start
+        double high;                    ///< Smoothed length above which every arrival is shed
+        double pmax;                    ///< Drop probability at the high threshold
+        double average;                 ///< Smoothed queue length
+        int count;                      ///< Arrivals admitted since the last early drop
+        std::mt19937 rng;               ///< Random source for drop decisions
+        std::uniform_real_distribution<double> uniform; ///< Uniform [0, 1) draws
+
+    public:
+        RedPolicy(const std::string& name, size_t limit, double minimum, double maximum, double probability,
+                  unsigned int seed)
+            : spec(name), capacity(limit), low(minimum), high(maximum), pmax(probability), average(0.0), count(0),
+              rng(seed), uniform(0.0, 1.0) {}
+
+        std::string name() const override { return spec; }
+
+        bool admit(const Request&, size_t queued, int) override {
+            average += WEIGHT * (static_cast<double>(queued) - average);
+            if (queued >= capacity || average >= high) {
+                count = 0;
+                return false;
+            }
+            if (average < low) {
+                count = 0;
+                return true;
+            }
+            double pb = pmax * (average - low) / (high - low);
+            count++;
+            if (count * pb >= 1.0 || uniform(rng) < pb / (1.0 - count * pb)) {
+                count = 0;
+                return false;
+            }
+            return true;
+        }
+
+        void reset(const RequestQueue& queue) override {
+            average = static_cast<double>(queue.size());
+            count = 0;
+        }
+    };
+
+    /**
+     * @brief Controlled delay: drops from the head once waits stay above target
+     *
+     * Follows the CoDel state machine. The wait of the request about to be dequeued
+     * is compared with the target; after it has stayed above target for an interval
+     * the policy enters the dropping state and drops heads at intervals of
+     * interval / sqrt(count), leaving it as soon as a head has waited less than
+     * target. Re-entering soon after leaving resumes close to the previous rate.
+     */
+    class CoDelPolicy : public AdmissionPolicy {
+    private:
+        std::string spec;       ///< Name reported by name()
+        size_t capacity;        ///< Hard queue limit
+        int target;             ///< Acceptable wait in ticks
+        int interval;           ///< Ticks the wait must stay above target before dropping
+        bool above;             ///< Whether the wait is above target
+        int first_above;        ///< Tick at which dropping may start
+        bool dropping;          ///< Whether the policy is in the dropping state
+        double drop_next;       ///< Tick of the next drop in the dropping state
+        unsigned int count;     ///< Drops in the current (or last) dropping state
+
+    public:
+        CoDelPolicy(const std::string& name, size_t limit, int targetWait, int window)
+            : spec(name), capacity(limit), target(targetWait), interval(window), above(false), first_above(0),
+              dropping(false), drop_next(0.0), count(0) {}
+
+        std::string name() const override { return spec; }
+
+        bool admit(const Request&, size_t queued, int) override {
+            return queued < capacity;
+        }
+
+        bool dropHead(const Request& head, int now) override {
+            if (now - head.getenqueued() < target) {
+                above = false;
+                dropping = false;
+                return false;
+            }
+            if (dropping) {
+                if (now < drop_next) {
+                    return false;
+                }
+                count++;
+                drop_next += interval / std::sqrt(static_cast<double>(count));
+                return true;
+            }
+            if (!above) {
+                above = true;
+                first_above = now + interval;
+                return false;
+            }
+            if (now < first_above) {
+                return false;
+            }
+            // Start dropping; resume near the old rate if the last episode was recent
+            dropping = true;
+            count = (count > 2 && now - drop_next < 8.0 * interval) ? count - 2 : 1;
+            drop_next = now + interval / std::sqrt(static_cast<double>(count));
+            return true;
+        }
+    };
+
+    /**
+     * @brief Per-class quotas: every processing-time class gets an equal share of the queue
+     *
+     * Keeps long requests from crowding short ones out of a full queue (and the other
+     * way round).
+     */
+    class QuotaPolicy : public AdmissionPolicy {
+    private:
+        std::string spec;               ///< Name reported by name()
+        size_t capacity;                ///< Hard queue limit
+        std::vector<int> bounds;        ///< Largest processing time of each class but the last
+        std::vector<size_t> held;       ///< Queued requests per class
+        size_t share;                   ///< Most requests a class may hold
+
+        /**
+         * @brief Gets the class of a request
+         * @param r Request
+         * @return Class index
+         */
+        size_t classOf(const Request& r) const {
+            size_t k = 0;
+            while (k < bounds.size() && r.gettime() > bounds[k]) {
+                k++;
+            }
+            return k;
+        }
+
+    public:
+        QuotaPolicy(const std::string& name, size_t limit, const std::vector<int>& classBounds)
+            : spec(name), capacity(limit), bounds(classBounds), held(classBounds.size() + 1, 0),
+              share(std::max<size_t>(1, limit / (classBounds.size() + 1))) {}
+
+        std::string name() const override { return spec; }
+
+        bool admit(const Request& r, size_t queued, int) override {
+            size_t k = classOf(r);
+            if (queued >= capacity || held[k] >= share) {
+                return false;
+            }
+            held[k]++;
+            return true;
+        }
+
+        bool tracksDequeues() const override { return true; }
+
+        void dequeued(const Request& r) override {
+            size_t k = classOf(r);
+            if (held[k] > 0) {
+                held[k]--;
+            }
+        }
+
+        void requeued(const Request& r) override {
+            held[classOf(r)]++;
+        }
+
+        void reset(const RequestQueue& queue) override {
+            std::fill(held.begin(), held.end(), 0);
+            for (size_t i = 0; i < queue.size(); ++i) {
+                held[classOf(queue.at(i))]++;
+            }
+        }
+    };
+
+    /**
+     * @brief Parses a comma-separated list of non-negative numbers
+     * @param text List to parse
+     * @param values Receives the numbers
+     * @return false if an item is not a non-negative number
+     */
+    bool parseList(const std::string& text, std::vector<double>& values) {
+        std::istringstream list(text);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            char* end = nullptr;
+            double value = std::strtod(item.c_str(), &end);
+            if (item.empty() || *end != '\0' || !std::isfinite(value) || value < 0.0) {
+                return false;
+            }
+            values.push_back(value);
+        }
+        return true;
+    }
+}
+
+std::unique_ptr<AdmissionPolicy> makeAdmissionPolicy(const std::string& spec, unsigned int seed) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    if (kind == "none") {
+        return colon == std::string::npos ? std::unique_ptr<AdmissionPolicy>(new AdmitAllPolicy()) : nullptr;
+    }
+
+    std::vector<double> values;
+    if (colon == std::string::npos || !parseList(spec.substr(colon + 1), values) || values.empty()
+        || values[0] < 1.0) {
+        return nullptr;     // every other policy needs a capacity
+    }
+    size_t capacity = static_cast<size_t>(values[0]);
+
+    if (kind == "tail" && values.size() == 1) {
+        return std::unique_ptr<AdmissionPolicy>(new TailDropPolicy(spec, capacity));
+    }
+    if (kind == "red" && (values.size() == 1 || values.size() == 4)) {
+        double low = values.size() == 4 ? values[1] : capacity * 0.25;
+        double high = values.size() == 4 ? values[2] : capacity * 0.75;
+        double pmax = values.size() == 4 ? values[3] : 0.1;
+        if (high <= low || pmax > 1.0) {
+            return nullptr;
+        }
+        return std::unique_ptr<AdmissionPolicy>(new RedPolicy(spec, capacity, low, high, pmax, seed));
+    }
+    if (kind == "codel" && (values.size() == 1 || values.size() == 3)) {
+        int target = values.size() == 3 ? static_cast<int>(values[1]) : 10;
+        int interval = values.size() == 3 ? static_cast<int>(values[2]) : 100;
+        if (interval < 1) {
+            return nullptr;
+        }
+        return std::unique_ptr<AdmissionPolicy>(new CoDelPolicy(spec, capacity, target, interval));
+    }
+    if (kind == "quota") {
+        std::vector<int> bounds;
+        for (size_t i = 1; i < values.size(); ++i) {
+            bounds.push_back(static_cast<int>(values[i]));
+        }
+        if (values.size() == 1) {
+            bounds = {3, 7};
+        }
+        if (!std::is_sorted(bounds.begin(), bounds.end())) {
+            return nullptr;
+        }
+        return std::unique_ptr<AdmissionPolicy>(new QuotaPolicy(spec, capacity, bounds));
+    }
+    return nullptr;
+}
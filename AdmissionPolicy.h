@@ -0,0 +1,117 @@
+/**
+ * @file AdmissionPolicy.h
+ * @brief AdmissionPolicy interface header file
+ */
+#ifndef ADMISSIONPOLICY_H
+#define ADMISSIONPOLICY_H
+
+#include "Request.h"
+#include "RequestQueue.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Strategy that decides which requests the load balancer sheds
+ *
+ * Requests can be shed at two points. admit() is asked for every arriving request
+ * that passed the firewall and may refuse it a place in the queue (tail drop, early
+ * random drop, quotas). dropHead() is asked on every tick on which idle servers are
+ * about to take work, before the first request is dequeued, and may discard
+ * requests from the head of the queue instead (sojourn-time based dropping).
+ *
+ * Policies that need to know the queue's contents ask for dequeue notifications
+ * with tracksDequeues(); the others cost nothing on the dispatch path.
+ *
+ * Built-in policies are created by name with makeAdmissionPolicy().
+ */
+class AdmissionPolicy {
+public:
+    /**
+     * @brief Virtual destructor
+     */
+    virtual ~AdmissionPolicy() {}
+
+    /**
+     * @brief Gets the specification the policy was created with
+     * @return Policy name, e.g. "tail:1000"
+     */
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief Decides whether an arriving request may join the queue
+     * @param r Arriving request
+     * @param queued Current queue length
+     * @param now Current tick
+     * @return true to queue the request, false to shed it
+     */
+    virtual bool admit(const Request& r, size_t queued, int now) = 0;
+
+    /**
+     * @brief Decides whether the request at the head of the queue is dropped instead of served
+     *
+     * Called repeatedly while it returns true, so several requests may be dropped.
+     *
+     * @param head Request at the head of the queue
+     * @param now Current tick
+     * @return true to shed the request
+     */
+    virtual bool dropHead(const Request& head, int now) { (void)head; (void)now; return false; }
+
+    /**
+     * @brief Checks whether the policy wants dequeued() notifications
+     * @return true if dequeued() must be called for every request leaving the queue
+     */
+    virtual bool tracksDequeues() const { return false; }
+
+    /**
+     * @brief Notifies the policy that a request left the queue (served or dropped at the head)
+     * @param r Request that left
+     */
+    virtual void dequeued(const Request& r) { (void)r; }
+
+    /**
+     * @brief Notifies the policy that a preempted request went back into the queue
+     *
+     * The request was admitted before, so it bypasses admit(). Only called if
+     * tracksDequeues() is true.
+     *
+     * @param r Request that re-entered the queue
+     */
+    virtual void requeued(const Request& r) { (void)r; }
+
+    /**
+     * @brief Takes over a queue that already holds requests
+     *
+     * Called when the policy is installed on a load balancer.
+     *
+     * @param queue Current queue
+     */
+    virtual void reset(const RequestQueue& queue) { (void)queue; }
+};
+
+/**
+ * @brief Creates one of the built-in admission policies
+ *
+ * Recognised specifications (capacities and lengths in requests, times in ticks):
+ * - none: admit everything; the queue is unbounded (the default)
+ * - tail:<capacity>: shed arrivals while the queue holds capacity requests
+ * - red:<capacity>[,<min>,<max>,<pmax>]: random early detection; arrivals are shed
+ *   with a probability that rises from 0 to pmax as the smoothed queue length goes
+ *   from min to max (defaults: a quarter and three quarters of capacity, 0.1), and
+ *   always above max or at capacity
+ * - codel:<capacity>[,<target>,<interval>]: controlled delay; once the head of the
+ *   queue has waited longer than target for a whole interval, heads are dropped at a
+ *   rate that grows with the square root of the drop count until the wait falls
+ *   below target again (defaults: 10 and 100); tail drop at capacity
+ * - quota:<capacity>[,<bound>,...]: per-class quotas; requests are classed by their
+ *   processing time (class k holds times up to the k-th bound, the last class the
+ *   rest; default bounds 3 and 7) and each class may hold an equal share of capacity
+ *
+ * @param spec Policy name, optionally followed by ':' and parameters
+ * @param seed Seed for policies that make random choices
+ * @return New policy, or nullptr if the specification is not recognised
+ */
+std::unique_ptr<AdmissionPolicy> makeAdmissionPolicy(const std::string& spec, unsigned int seed);
+
+#endif // ADMISSIONPOLICY_H
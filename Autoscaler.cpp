@@ -0,0 +1,275 @@
+/**
+ * @file Autoscaler.cpp
+ * @brief Built-in autoscalers and the autoscaler factory
+ */
+#include "Autoscaler.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+int Autoscaler::quietTicks(ScalingSignals s, int limit) {
+    int consumed = 0;
+    while (consumed < limit && preview(s) == 0) {
+        decide(s);
+        s.time++;
+        consumed++;
+    }
+    return consumed;
+}
+
+namespace {
+    /**
+     * @brief The original one-server-per-tick rule, driven by the instantaneous queue
+     *
+     * Stateless, so quiet ticks cost nothing to skip.
+     */
+    class ReactiveAutoscaler : public Autoscaler {
+    public:
+        std::string name() const override { return "reactive"; }
+
+        int decide(const ScalingSignals& s) override {
+            return preview(s);
+        }
+
+        int preview(const ScalingSignals& s) const override {
+            // Scale up if queue is building up and we have capacity
+            if (s.queued > s.free && s.active < s.maximum) {
+                return 1;
+            }
+            // Scale down ONLY if queue is empty AND we have many idle servers
+            if (s.queued == 0 && s.idle > 2 && s.active > 1) {
+                return -1;
+            }
+            return 0;
+        }
+
+        int quietTicks(ScalingSignals s, int limit) override {
+            return preview(s) == 0 ? limit : 0;
+        }
+    };
+
+    /**
+     * @brief Never changes the pool; for pools sized from outside (e.g. by a Cluster)
+     */
+    class FixedAutoscaler : public Autoscaler {
+    public:
+        std::string name() const override { return "fixed"; }
+
+        int decide(const ScalingSignals&) override { return 0; }
+
+        int preview(const ScalingSignals&) const override { return 0; }
+
+        int quietTicks(ScalingSignals, int limit) override { return limit; }
+    };
+
+    /**
+     * @brief Tuning of PredictiveAutoscaler (see makeAutoscaler() for the meaning)
+     */
+    struct PredictiveSettings {
+        double alpha = 0.1;     ///< EWMA smoothing factor
+        double target = 0.75;   ///< Utilization the pool is sized for
+        double band = 0.1;      ///< Half-width of the hysteresis band around target
+        double drain = 20.0;    ///< Ticks allowed for working off a standing queue
+        int up = 5;             ///< Cooldown after a scale-up before the next one
+        int down = 30;          ///< Cooldown after any change before a scale-down
+        int step = 0;           ///< Most servers changed at once (0 = no limit)
+        bool holt = false;      ///< Forecast arrivals with Holt's linear trend method
+        double beta = 0.05;     ///< Holt trend smoothing factor
+        double horizon = 10.0;  ///< Ticks ahead the forecast looks
+    };
+
+    /**
+     * @brief Sizes the pool for a target utilization from smoothed load signals
+     *
+     * The offered load in cycles per tick is estimated as the smoothed arrival rate
+     * times the smoothed work per request (or the smoothed capacity in use, if
+     * higher), plus what it takes to work off the smoothed queue within the drain
+     * time. Dividing by the mean capacity of a server turns it into servers (for
+     * speed-1 single-slot servers the load is the busy count). The pool is resized in
+     * one step to load / target, but only when the projected
+     * utilization leaves the hysteresis band and the matching cooldown has passed.
+     * With the Holt forecast the arrival rate is replaced by the trend-extrapolated
+     * rate horizon ticks ahead, so the pool grows ahead of a ramp.
+     */
+    class PredictiveAutoscaler : public Autoscaler {
+    private:
+        /**
+         * @brief Everything the autoscaler remembers between ticks
+         */
+        struct State {
+            bool primed = false;        ///< Whether the first tick has been observed
+            double rate = 0.0;          ///< Smoothed arrivals per tick
+            double work = 0.0;          ///< Smoothed cycles per arriving request
+            double queue = 0.0;         ///< Smoothed queue length
+            double busy = 0.0;          ///< Smoothed capacity in use (cycles per tick)
+            double level = 0.0;         ///< Holt level of arrivals per tick
+            double trend = 0.0;         ///< Holt trend of arrivals per tick
+            int last_up = INT_MIN / 2;  ///< Tick of the last scale-up
+            int last_change = INT_MIN / 2; ///< Tick of the last scale-up or scale-down
+        };
+
+        std::string spec;               ///< Name reported by name()
+        PredictiveSettings settings;    ///< Tuning
+        State state;                    ///< Current state
+
+        /**
+         * @brief Folds one tick into a state and decides
+         * @param st State to update
+         * @param s Signals of the tick
+         * @return Change in pool size
+         */
+        int step(State& st, const ScalingSignals& s) const {
+            const double a = settings.alpha;
+            double arrivals = static_cast<double>(s.arrivals);
+            double perRequest = s.arrivals ? static_cast<double>(s.arrival_work) / arrivals : 0.0;
+            if (!st.primed) {
+                st.primed = true;
+                st.rate = st.level = arrivals;
+                st.work = perRequest;
+                st.queue = static_cast<double>(s.queued);
+                st.busy = s.load;
+            } else {
+                st.rate += a * (arrivals - st.rate);
+                if (s.arrivals) {
+                    st.work = st.work > 0.0 ? st.work + a * (perRequest - st.work) : perRequest;
+                }
+                st.queue += a * (static_cast<double>(s.queued) - st.queue);
+                st.busy += a * (s.load - st.busy);
+                if (settings.holt) {
+                    double previous = st.level;
+                    st.level = a * arrivals + (1.0 - a) * (st.level + st.trend);
+                    st.trend = settings.beta * (st.level - previous) + (1.0 - settings.beta) * st.trend;
+                }
+            }
+
+            double rate = settings.holt ? std::max(0.0, st.level + settings.horizon * st.trend) : st.rate;
+            double work = st.work > 0.0 ? st.work : 1.0;   // no request seen yet
+            double load = std::max(st.busy, rate * work) + st.queue * work / settings.drain;
+            size_t present = s.idle + s.busy;
+            double unit = present > 0 && s.capacity > 0.0 ? s.capacity / static_cast<double>(present) : 1.0;
+            double utilization = load / (std::max(s.active, 1) * unit);
+            int desired = static_cast<int>(std::ceil(load / settings.target / unit));
+            desired = std::min(std::max(desired, 1), s.maximum);
+
+            int change = 0;
+            if (utilization > settings.target + settings.band && desired > s.active
+                && s.time - st.last_up >= settings.up) {
+                change = desired - s.active;
+            } else if (utilization < settings.target - settings.band && desired < s.active
+                       && s.time - st.last_change >= settings.down) {
+                change = -std::min(s.active - desired, static_cast<int>(s.idle));
+            }
+            if (settings.step > 0) {
+                change = std::min(std::max(change, -settings.step), settings.step);
+            }
+            if (change > 0) {
+                st.last_up = st.last_change = s.time;
+            } else if (change < 0) {
+                st.last_change = s.time;
+            }
+            return change;
+        }
+
+    public:
+        PredictiveAutoscaler(const std::string& name, const PredictiveSettings& tuning)
+            : spec(name), settings(tuning) {}
+
+        std::string name() const override { return spec; }
+
+        int decide(const ScalingSignals& s) override {
+            return step(state, s);
+        }
+
+        int preview(const ScalingSignals& s) const override {
+            State copy = state;
+            return step(copy, s);
+        }
+    };
+
+    /**
+     * @brief Parses a number that must make up the whole string
+     * @param text Text to parse
+     * @param value Receives the number
+     * @return true if the text is a number
+     */
+    bool parseNumber(const std::string& text, double& value) {
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        return !text.empty() && *end == '\0' && std::isfinite(value);
+    }
+
+    /**
+     * @brief Parses "key=value,..." parameters of the predictive autoscaler
+     * @param params Parameter list (may be empty)
+     * @param settings Receives the parsed values
+     * @return false on an unknown key or an out-of-range value
+     */
+    bool parsePredictive(const std::string& params, PredictiveSettings& settings) {
+        std::istringstream list(params);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            size_t equals = item.find('=');
+            if (equals == std::string::npos) {
+                return false;
+            }
+            std::string key = item.substr(0, equals);
+            std::string text = item.substr(equals + 1);
+            if (key == "forecast") {
+                if (text != "none" && text != "holt") {
+                    return false;
+                }
+                settings.holt = text == "holt";
+                continue;
+            }
+            double value;
+            if (!parseNumber(text, value) || value < 0.0) {
+                return false;
+            }
+            if (key == "alpha" && value > 0.0 && value <= 1.0) {
+                settings.alpha = value;
+            } else if (key == "target" && value > 0.0 && value <= 1.0) {
+                settings.target = value;
+            } else if (key == "band" && value < 1.0) {
+                settings.band = value;
+            } else if (key == "drain" && value >= 1.0) {
+                settings.drain = value;
+            } else if (key == "up" && value <= INT_MAX / 2) {
+                settings.up = static_cast<int>(value);
+            } else if (key == "down" && value <= INT_MAX / 2) {
+                settings.down = static_cast<int>(value);
+            } else if (key == "step" && value <= INT_MAX / 2) {
+                settings.step = static_cast<int>(value);
+            } else if (key == "beta" && value <= 1.0) {
+                settings.beta = value;
+            } else if (key == "horizon") {
+                settings.horizon = value;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+std::unique_ptr<Autoscaler> makeAutoscaler(const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string params = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (kind == "reactive" && colon == std::string::npos) {
+        return std::unique_ptr<Autoscaler>(new ReactiveAutoscaler());
+    }
+    if (kind == "fixed" && colon == std::string::npos) {
+        return std::unique_ptr<Autoscaler>(new FixedAutoscaler());
+    }
+    if (kind == "predictive") {
+        PredictiveSettings settings;
+        if (!parsePredictive(params, settings)) {
+            return nullptr;
+        }
+        return std::unique_ptr<Autoscaler>(new PredictiveAutoscaler(spec, settings));
+    }
+    return nullptr;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file Autoscaler.h
+ * @brief Autoscaler interface header file
+ */
+#ifndef AUTOSCALER_H
+#define AUTOSCALER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief What the load balancer observed at the scaling step of one tick
+ */
+struct ScalingSignals {
+    int time;                   ///< Current tick
+    size_t queued;              ///< Requests waiting in the queue
+    size_t idle;                ///< Servers running no request
+    size_t busy;                ///< Servers running at least one request
+    size_t free;                ///< Free request slots over all servers
+    double capacity;            ///< Cycles per tick the servers in the pool can process
+    double load;                ///< Cycles per tick the running requests are processed at
+    int active;                 ///< Servers in the pool
+    int maximum;                ///< Largest allowed pool size
+    uint64_t arrivals;          ///< Requests queued on this tick
+    uint64_t arrival_work;      ///< Processing cycles of the requests queued on this tick
+};
+
+/**
+ * @brief Strategy that decides how many servers to add or remove on each tick
+ *
+ * The load balancer calls decide() exactly once per tick, after that tick's arrivals
+ * have been queued, and applies the answer. Autoscalers may keep state between calls
+ * (smoothed signals, cooldown timers), so the event engine replays the ticks it skips
+ * through quietTicks() instead of leaving them out; both engines therefore make the
+ * same decisions.
+ *
+ * Built-in autoscalers are created by name with makeAutoscaler().
+ */
+class Autoscaler {
+public:
+    /**
+     * @brief Virtual destructor
+     */
+    virtual ~Autoscaler() {}
+
+    /**
+     * @brief Gets the specification the autoscaler was created with
+     * @return Autoscaler name, e.g. "reactive"
+     */
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief Observes one tick and decides how the pool should change
+     * @param s Signals of the current tick
+     * @return Servers to add (positive) or idle servers to remove (negative); the
+     *         answer never exceeds the pool's limits or the number of idle servers
+     */
+    virtual int decide(const ScalingSignals& s) = 0;
+
+    /**
+     * @brief Gets what decide() would answer, without changing any state
+     * @param s Signals of the current tick
+     * @return Same as decide()
+     */
+    virtual int preview(const ScalingSignals& s) const = 0;
+
+    /**
+     * @brief Steps through ticks on which nothing arrives and nothing completes
+     *
+     * Calls decide() for ticks s.time, s.time + 1, ... (with no arrivals) until one
+     * of them would change the pool or the limit is reached; that tick is not
+     * consumed. Autoscalers without state between ticks override this to answer in
+     * constant time.
+     *
+     * @param s Signals of the first quiet tick (arrivals must be zero)
+     * @param limit Largest number of ticks to step through
+     * @return Number of ticks consumed
+     */
+    virtual int quietTicks(ScalingSignals s, int limit);
+};
+
+/**
+ * @brief Creates one of the built-in autoscalers
+ *
+ * Recognised specifications:
+ * - reactive: adds one server when the queue is longer than the idle set and removes
+ *   one when the queue is empty and more than two servers are idle (the default)
+ * - fixed: never changes the pool
+ * - predictive[:key=value,...]: sizes the pool for a target utilization from
+ *   smoothed signals; keys are
+ *   - alpha (EWMA smoothing of arrivals, work, queue and busy servers; default 0.1)
+ *   - target (utilization to size for; default 0.75)
+ *   - band (hysteresis: act only outside target +/- band; default 0.1)
+ *   - drain (ticks in which a standing queue should be worked off; default 20)
+ *   - up, down (cooldown ticks after a scale-up, and after any change before a
+ *     scale-down; defaults 5 and 30)
+ *   - step (most servers added or removed at once; 0 for no limit, the default)
+ *   - forecast (none or holt; default none)
+ *   - beta, horizon (Holt trend smoothing and look-ahead ticks; defaults 0.05 and 10)
+ *
+ * @param spec Autoscaler name, optionally followed by ':' and parameters
+ * @return New autoscaler, or nullptr if the specification is not recognised
+ */
+std::unique_ptr<Autoscaler> makeAutoscaler(const std::string& spec);
+
+#endif // AUTOSCALER_H
@@ -0,0 +1,209 @@
+/**
+ * @file Blocklist.cpp
+ * @brief Blocklist class implementation
+ */
+
+#include "Blocklist.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+Blocklist::Blocklist() : current(new Firewall()), versions(0), stopping(false), inotify(false) {
+    wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+Blocklist::~Blocklist() {
+    stop();
+    delete current.load();
+}
+
+int Blocklist::load(const std::string& filepath, int* invalidLines) {
+    BlocklistReload result = reload(filepath);
+    if (invalidLines) {
+        *invalidLines = result.invalid;
+    }
+    return result.rules;
+}
+
+size_t Blocklist::prefixCount() const {
+    EpochDomain::Guard guard(readers);
+    return current.load(std::memory_order_acquire)->prefixCount();
+}
+
+size_t Blocklist::memoryBytes() const {
+    EpochDomain::Guard guard(readers);
+    return current.load(std::memory_order_acquire)->memoryBytes();
+}
+
+void Blocklist::publish(const Firewall* next) {
+    std::lock_guard<std::mutex> lock(publishing);
+    const Firewall* old = current.exchange(next, std::memory_order_acq_rel);
+    versions.fetch_add(1, std::memory_order_relaxed);
+    readers.synchronize();
+    delete old;
+}
+
+void Blocklist::saveState(SnapshotWriter& out) const {
+    EpochDomain::Guard guard(readers);
+    current.load(std::memory_order_acquire)->saveState(out);
+}
+
+bool Blocklist::restoreState(SnapshotReader& in) {
+    std::unique_ptr<Firewall> next(new Firewall());
+    if (!next->restoreState(in)) {
+        return false;
+    }
+    publish(next.release());
+    return true;
+}
+
+BlocklistReload Blocklist::reload(const std::string& filepath) {
+    // Parse and compile off to the side; readers keep using the current rules
+    std::unique_ptr<Firewall> next(new Firewall());
+    BlocklistReload result{0, 0, 0, 0};
+    result.rules = next->loadFile(filepath, &result.invalid);
+    if (result.rules >= 0) {
+        result.prefixes = next->prefixCount();
+        result.bytes = next->memoryBytes();
+        publish(next.release());
+    }
+    return result;
+}
+
+bool Blocklist::watch(const std::string& filepath, int pollMs, ReloadCallback onReload) {
+    if (watcher.joinable()) {
+        return false;
+    }
+    stopping.store(false);
+    int fd = openInotify(filepath);
+    inotify.store(fd >= 0);
+    watcher = std::thread([this, fd, filepath, pollMs, onReload]() {
+        if (fd >= 0) {
+            watchInotify(fd, filepath, onReload);
+        } else {
+            watchPolling(filepath, pollMs, onReload);
+        }
+    });
+    return true;
+}
+
+int Blocklist::openInotify(const std::string& filepath) {
+#ifdef __linux__
+    // Watch the directory, not the file: editors often save by renaming a new file
+    // over the old one, which would end a watch on the old inode
+    size_t slash = filepath.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : filepath.substr(0, slash));
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe2(wake_pipe, O_CLOEXEC) != 0) {
+        wake_pipe[0] = wake_pipe[1] = -1;
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)filepath;
+    return -1;
+#endif
+}
+
+void Blocklist::stop() {
+    if (!watcher.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wait_lock);
+        stopping.store(true);
+    }
+    wake.notify_all();
+#ifdef __linux__
+    if (wake_pipe[1] >= 0) {
+        char byte = 0;
+        ssize_t written = write(wake_pipe[1], &byte, 1);
+        (void)written;
+    }
+#endif
+    watcher.join();
+#ifdef __linux__
+    for (int& fd : wake_pipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+#endif
+}
+
+void Blocklist::watchInotify(int fd, const std::string& filepath, const ReloadCallback& onReload) {
+#ifdef __linux__
+    size_t slash = filepath.find_last_of('/');
+    std::string name = slash == std::string::npos ? filepath : filepath.substr(slash + 1);
+    alignas(inotify_event) char buffer[4096];
+    while (!stopping.load()) {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN)) {
+            continue;   // interrupted, or stop() was called
+        }
+
+        // Drain everything queued so far; several events from one save cause one reload
+        bool changed = false;
+        for (ssize_t length; (length = read(fd, buffer, sizeof(buffer))) > 0;) {
+            for (char* p = buffer; p < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                if (event->len > 0 && name == event->name) {
+                    changed = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) {
+            BlocklistReload result = reload(filepath);
+            if (onReload) {
+                onReload(result);
+            }
+        }
+    }
+    close(fd);
+#else
+    (void)fd;
+    (void)filepath;
+    (void)onReload;
+#endif
+}
+
+void Blocklist::watchPolling(const std::string& filepath, int pollMs, const ReloadCallback& onReload) {
+    // A change of size, modification time or inode (a file renamed over the old one)
+    auto signature = [&filepath](struct stat& info) {
+        if (stat(filepath.c_str(), &info) != 0) {
+            std::memset(&info, 0, sizeof(info));
+        }
+    };
+    struct stat last;
+    signature(last);
+
+    std::unique_lock<std::mutex> lock(wait_lock);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(pollMs > 0 ? pollMs : 1000),
+                          [this]() { return stopping.load(); })) {
+        struct stat now;
+        signature(now);
+        if (now.st_size == last.st_size && now.st_mtime == last.st_mtime && now.st_ino == last.st_ino) {
+            continue;
+        }
+        last = now;
+        lock.unlock();
+        BlocklistReload result = reload(filepath);
+        if (onReload) {
+            onReload(result);
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,193 @@
+/**
+ * @file Blocklist.h
+ * @brief Blocklist class header file
+ */
+#ifndef BLOCKLIST_H
+#define BLOCKLIST_H
+
+#include "EpochDomain.h"
+#include "Firewall.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Outcome of reloading a rule file
+ */
+struct BlocklistReload {
+    int rules;          ///< Rules loaded, or -1 if the file could not be opened (the old rules stay)
+    int invalid;        ///< Lines that could not be parsed
+    size_t prefixes;    ///< Prefixes in the published rule set
+    size_t bytes;       ///< Memory used by the published lookup structure
+};
+
+/**
+ * @brief Firewall rule set that can be replaced while other threads look addresses up
+ *
+ * The rules are compiled into an immutable Firewall snapshot that is published
+ * through an atomic pointer. isBlocked() pins the snapshot with an EpochDomain guard
+ * and never takes a lock, so a reload neither stalls nor races lookups: a reader
+ * sees either the old rule set or the new one, never a partly built one. A reload
+ * parses and compiles the new snapshot first, swaps the pointer, waits for the
+ * readers that may still hold the old snapshot, and frees it.
+ *
+ * watch() starts a background thread that reloads the file whenever it changes. On
+ * Linux it uses inotify on the file's directory, so both in-place writes and editors
+ * that save by renaming a new file over the old one are seen; elsewhere, or if
+ * inotify is unavailable, it polls the file's size, modification time and inode.
+ */
+class Blocklist {
+public:
+    /**
+     * @brief Called on the watcher thread after every reload attempt
+     */
+    using ReloadCallback = std::function<void(const BlocklistReload&)>;
+
+    /**
+     * @brief Constructs an empty rule set (every address is allowed)
+     */
+    Blocklist();
+
+    /**
+     * @brief Stops the watcher and frees the rule set
+     */
+    ~Blocklist();
+
+    Blocklist(const Blocklist&) = delete;
+    Blocklist& operator=(const Blocklist&) = delete;
+
+    /**
+     * @brief Loads a rule file and publishes it
+     * @param filepath Path to the rule file (see Firewall for the syntax)
+     * @param invalidLines Receives the number of lines that could not be parsed (optional)
+     * @return Number of rules loaded, or -1 if the file could not be opened (the
+     *         current rules are kept)
+     */
+    int load(const std::string& filepath, int* invalidLines = nullptr);
+
+    /**
+     * @brief Checks whether requests from an address are blocked; safe on any thread
+     * @param ip IPv4 address in host byte order
+     * @return true if the most specific matching rule of the current rules denies it
+     */
+    bool isBlocked(uint32_t ip) const {
+        EpochDomain::Guard guard(readers);
+        return current.load(std::memory_order_acquire)->isBlocked(ip);
+    }
+
+    /**
+     * @brief Checks whether requests from an IPv6 address are blocked; safe on any thread
+     * @param ip IPv6 address
+     * @return true if the most specific matching rule of the current rules denies it
+     */
+    bool isBlocked(const IPv6Address& ip) const {
+        EpochDomain::Guard guard(readers);
+        return current.load(std::memory_order_acquire)->isBlocked(ip);
+    }
+
+    /**
+     * @brief Gets the number of prefixes in the current rules
+     * @return Prefix count
+     */
+    size_t prefixCount() const;
+
+    /**
+     * @brief Gets the memory used by the current lookup structure
+     * @return Size in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Gets the number of rule sets published so far
+     * @return Version of the current rules (0 before the first load)
+     */
+    uint64_t version() const { return versions.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Starts reloading a rule file whenever it changes
+     * @param filepath Rule file to watch
+     * @param pollMs Interval between checks when inotify is not available
+     * @param onReload Called on the watcher thread after every reload attempt (optional)
+     * @return false if a watcher is already running
+     */
+    bool watch(const std::string& filepath, int pollMs, ReloadCallback onReload);
+
+    /**
+     * @brief Checks whether the watcher is notified by inotify rather than polling
+     * @return true if the running watcher uses inotify
+     */
+    bool usesInotify() const { return inotify.load(); }
+
+    /**
+     * @brief Stops the watcher thread, if any; a reload in progress is completed first
+     */
+    void stop();
+
+    /**
+     * @brief Adds the current rules to a checkpoint
+     * @param out Checkpoint being written
+     */
+    void saveState(SnapshotWriter& out) const;
+
+    /**
+     * @brief Publishes the rules stored in a checkpoint in place of the current ones
+     * @param in Open checkpoint
+     * @return false if the rules in the checkpoint are missing or invalid (the current rules are kept)
+     */
+    bool restoreState(SnapshotReader& in);
+
+private:
+    std::atomic<const Firewall*> current;   ///< Published rule set; never null
+    mutable EpochDomain readers;            ///< Readers of current
+    std::mutex publishing;                  ///< Serializes writers
+    std::atomic<uint64_t> versions;         ///< Rule sets published
+    std::thread watcher;                    ///< Background watcher, if running
+    std::atomic<bool> stopping;             ///< Set to ask the watcher to exit
+    std::atomic<bool> inotify;              ///< Whether the watcher uses inotify
+    int wake_pipe[2];                       ///< Wakes the inotify watcher on stop (-1 when closed)
+    std::mutex wait_lock;                   ///< Guards the polling watcher's wait
+    std::condition_variable wake;           ///< Wakes the polling watcher on stop
+
+    /**
+     * @brief Swaps in a new rule set and frees the old one once no reader holds it
+     * @param next New rule set (ownership is taken)
+     */
+    void publish(const Firewall* next);
+
+    /**
+     * @brief Loads a file into a new snapshot and publishes it
+     * @param filepath Rule file
+     * @return Outcome of the reload
+     */
+    BlocklistReload reload(const std::string& filepath);
+
+    /**
+     * @brief Sets up an inotify watch on the directory of a file, and the stop pipe
+     * @param filepath Rule file
+     * @return inotify descriptor, or -1 if inotify is not available
+     */
+    int openInotify(const std::string& filepath);
+
+    /**
+     * @brief Watcher thread body using inotify; closes the descriptor when stopped
+     * @param fd Descriptor from openInotify()
+     * @param filepath Rule file
+     * @param onReload Reload callback
+     */
+    void watchInotify(int fd, const std::string& filepath, const ReloadCallback& onReload);
+
+    /**
+     * @brief Watcher thread body that polls the file's metadata
+     * @param filepath Rule file
+     * @param pollMs Interval between checks
+     * @param onReload Reload callback
+     */
+    void watchPolling(const std::string& filepath, int pollMs, const ReloadCallback& onReload);
+};
+
+#endif // BLOCKLIST_H
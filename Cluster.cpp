@@ -0,0 +1,439 @@
+/**
+ * @file Cluster.cpp
+ * @brief Cluster class implementation
+ */
+
+#include "Cluster.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+    /**
+     * @brief Scrambles a key so that neighbouring zones land on unrelated nodes
+     * @param x Key
+     * @return Mixed key (splitmix64 finalizer)
+     */
+    uint64_t mix64(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * @brief Jump consistent hash (Lamping and Veach)
+     *
+     * Growing the bucket count by one moves only 1/n of the keys, so a larger
+     * cluster keeps most clients on the node that already has them.
+     *
+     * @param key Key
+     * @param buckets Number of buckets (at least 1)
+     * @return Bucket in [0, buckets)
+     */
+    int jumpHash(uint64_t key, int buckets) {
+        int64_t b = -1;
+        int64_t j = 0;
+        while (j < buckets) {
+            b = j;
+            key = key * 2862933555777941757ull + 1;
+            j = static_cast<int64_t>(static_cast<double>(b + 1)
+                                     * (static_cast<double>(1ll << 31) / static_cast<double>((key >> 33) + 1)));
+        }
+        return static_cast<int>(b);
+    }
+
+    /**
+     * @brief Orders deliveries by tick, then front-tier traffic before spilled requests
+     * @param a First delivery
+     * @param b Second delivery
+     * @return true if a reaches the node first
+     */
+    bool arrivesBefore(const ClusterArrival& a, const ClusterArrival& b) {
+        if (a.time != b.time) {
+            return a.time < b.time;
+        }
+        if (a.origin != b.origin) {
+            return a.origin < b.origin;
+        }
+        return a.sequence < b.sequence;
+    }
+
+    /**
+     * @brief Gets a share of a total spread evenly over a number of parts
+     * @param total Amount to spread
+     * @param parts Number of parts
+     * @param part Part number; the first total % parts parts get one more
+     * @return Share of the part
+     */
+    int evenShare(int total, int parts, int part) {
+        return total / parts + (part < total % parts ? 1 : 0);
+    }
+}
+
+/**
+ * @brief One load balancer of the cluster together with its end of the links
+ *
+ * During an epoch only the thread simulating the node touches it; the inbox is
+ * filled and the outboxes are emptied by the main thread between epochs.
+ */
+class Cluster::Node : public ClusterLink {
+public:
+    std::unique_ptr<LoadBalancer> lb;               ///< The node's load balancer
+    size_t index;                                   ///< Node number
+    const Cluster& cluster;                         ///< Cluster, for the settings and the pressure snapshot
+    std::vector<ClusterArrival> inbox;              ///< Deliveries in arrival order
+    size_t next;                                    ///< First delivery in inbox not yet collected
+    std::vector<std::vector<ClusterArrival>> outbox;    ///< Requests spilled this epoch, per destination
+    std::vector<uint64_t> sent;                     ///< Requests spilled this epoch, per destination
+    uint64_t spill_sequence;                        ///< Order of the requests this node spilled
+    uint64_t routed;                                ///< Requests the front tier sent here
+    uint64_t spilled_out;                           ///< Requests this node sent to peers
+    uint64_t spilled_in;                            ///< Requests peers sent here
+
+    /**
+     * @brief Creates the node's load balancer and connects it to the cluster
+     * @param owner Cluster the node belongs to
+     * @param number Node number
+     * @param balancer Load balancer of the node (taken over)
+     */
+    Node(const Cluster& owner, size_t number, LoadBalancer* balancer)
+        : lb(balancer), index(number), cluster(owner), next(0), outbox(owner.settings.nodes),
+          sent(owner.settings.nodes, 0), spill_sequence(0), routed(0), spilled_out(0), spilled_in(0) {
+        lb->setClusterLink(this);
+    }
+
+    void collect(int time, std::vector<ClusterArrival>& out) override {
+        out.clear();
+        while (next < inbox.size() && inbox[next].time <= time) {
+            out.push_back(inbox[next++]);
+        }
+    }
+
+    int nextTime() const override {
+        return next < inbox.size() ? inbox[next].time : INT_MAX;
+    }
+
+    bool spill(const Request& r, int time, size_t queued, double capacity) override {
+        double threshold = cluster.settings.spill;
+        if (threshold <= 0.0 || (capacity > 0.0 && static_cast<double>(queued) < threshold * capacity)) {
+            return false;
+        }
+        // Peers are judged by the barrier snapshot plus what this node has sent them since
+        size_t target = index;
+        double lowest = threshold;
+        for (size_t j = 0; j < cluster.nodes.size(); ++j) {
+            double peerCapacity = cluster.snapshot_capacity[j];
+            if (j == index || peerCapacity <= 0.0) {
+                continue;
+            }
+            double pressure = static_cast<double>(cluster.snapshot_queued[j] + sent[j]) / peerCapacity;
+            if (pressure < lowest) {
+                lowest = pressure;
+                target = j;
+            }
+        }
+        if (target == index) {
+            return false;
+        }
+        outbox[target].push_back(ClusterArrival{time + cluster.settings.latency, static_cast<int>(index),
+                                                spill_sequence++, r});
+        sent[target]++;
+        spilled_out++;
+        return true;
+    }
+};
+
+bool parseClusterSettings(const std::string& spec, ClusterSettings& settings) {
+    std::istringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, equals);
+        std::string text = item.substr(equals + 1);
+        if (key == "scaling") {
+            if (text != "independent" && text != "global") {
+                return false;
+            }
+            settings.scaling = text == "global" ? ClusterScaling::Global : ClusterScaling::Independent;
+            continue;
+        }
+        if (key == "spill") {
+            char* end = nullptr;
+            double value = std::strtod(text.c_str(), &end);
+            if (text.empty() || *end != '\0' || !(value >= 0.0)) {
+                return false;
+            }
+            settings.spill = value;
+            continue;
+        }
+
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0') {
+            return false;
+        }
+        if (key == "nodes" && value >= 1 && value <= 1024) {
+            settings.nodes = static_cast<int>(value);
+        } else if (key == "latency" && value >= 1 && value <= 1000000) {
+            settings.latency = static_cast<int>(value);
+        } else if (key == "locality" && value >= 0 && value <= 32) {
+            settings.locality = static_cast<int>(value);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+Cluster::Cluster(const ClusterSettings& clusterSettings, int numServers, int initialQueueSize,
+                 const std::string& blockedIPsFile, unsigned int seed, bool consoleOutput,
+                 const WorkloadConfig& workloadConfig)
+    : settings(clusterSettings), front(workloadConfig, seed != 0 ? seed : std::random_device{}()),
+      snapshot_queued(clusterSettings.nodes, 0), snapshot_capacity(clusterSettings.nodes, 0.0),
+      autoscaler(makeAutoscaler("reactive")), front_sequence(0), epoch_arrivals(0), epoch_work(0), scale_ups(0),
+      scale_downs(0), clusterLog(new Logger("simulation_log.txt", consoleOutput)) {
+    // The nodes' own traffic only fills their initial queues; each gets a stream of its own
+    Xoshiro256 seeds(seed != 0 ? seed : std::random_device{}());
+    for (int i = 0; i < settings.nodes; ++i) {
+        int servers = std::max(1, evenShare(numServers, settings.nodes, i));
+        int queue = initialQueueSize < 0 ? -1 : evenShare(initialQueueSize, settings.nodes, i);
+        unsigned int nodeSeed = static_cast<unsigned int>(seeds()) | 1u;
+        LoadBalancer* lb = new LoadBalancer(servers, queue, blockedIPsFile, nodeSeed, false, workloadConfig,
+                                            "node" + std::to_string(i) + "_");
+        nodes.emplace_back(new Node(*this, static_cast<size_t>(i), lb));
+        if (settings.scaling == ClusterScaling::Global) {
+            lb->setAutoscaler("fixed");
+        }
+    }
+}
+
+Cluster::~Cluster() {
+    clusterLog->flush();
+}
+
+LoadBalancer& Cluster::node(size_t i) {
+    return *nodes[i]->lb;
+}
+
+bool Cluster::setAutoscaler(const std::string& spec) {
+    std::unique_ptr<Autoscaler> scaler = makeAutoscaler(spec);
+    if (!scaler) {
+        return false;
+    }
+    if (settings.scaling == ClusterScaling::Global) {
+        autoscaler = std::move(scaler);
+        return true;
+    }
+    for (const std::unique_ptr<Node>& n : nodes) {
+        n->lb->setAutoscaler(spec);
+    }
+    return true;
+}
+
+void Cluster::setLogLevel(LogLevel level) {
+    clusterLog->setLevel(level);
+}
+
+size_t Cluster::zoneOf(uint32_t ip) const {
+    uint64_t zone = settings.locality == 0 ? 0 : ip >> (32 - settings.locality);
+    return static_cast<size_t>(jumpHash(mix64(zone), settings.nodes));
+}
+
+void Cluster::route(int to) {
+    epoch_arrivals = 0;
+    epoch_work = 0;
+    while (front.nextTime() <= to) {
+        int time = front.nextTime();
+        for (int r = 0; r < front.batchSize(); ++r) {
+            Request request = front.request(time);
+            Node& target = *nodes[zoneOf(request.getin())];
+            target.inbox.push_back(ClusterArrival{time, -1, front_sequence++, request});
+            target.routed++;
+            epoch_arrivals++;
+            epoch_work += static_cast<uint64_t>(request.gettime());
+        }
+        front.advance();
+    }
+}
+
+void Cluster::exchange() {
+    for (const std::unique_ptr<Node>& source : nodes) {
+        for (size_t j = 0; j < nodes.size(); ++j) {
+            std::vector<ClusterArrival>& spilled = source->outbox[j];
+            nodes[j]->inbox.insert(nodes[j]->inbox.end(), spilled.begin(), spilled.end());
+            nodes[j]->spilled_in += spilled.size();
+            spilled.clear();
+            source->sent[j] = 0;
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Node& n = *nodes[i];
+        n.inbox.erase(n.inbox.begin(), n.inbox.begin() + static_cast<std::ptrdiff_t>(n.next));
+        n.next = 0;
+        std::sort(n.inbox.begin(), n.inbox.end(), arrivesBefore);
+        ScalingSignals s = n.lb->scalingSignals();
+        snapshot_queued[i] = s.queued;
+        snapshot_capacity[i] = s.capacity;
+    }
+}
+
+void Cluster::scale(int time, int ticks) {
+    ScalingSignals total = ScalingSignals();
+    std::vector<ScalingSignals> local;
+    for (const std::unique_ptr<Node>& n : nodes) {
+        ScalingSignals s = n->lb->scalingSignals();
+        total.queued += s.queued;
+        total.idle += s.idle;
+        total.busy += s.busy;
+        total.free += s.free;
+        total.capacity += s.capacity;
+        total.load += s.load;
+        total.active += s.active;
+        total.maximum += s.maximum;
+        local.push_back(s);
+    }
+    total.time = time;
+    total.arrivals = (epoch_arrivals + static_cast<uint64_t>(ticks) / 2) / static_cast<uint64_t>(ticks);
+    total.arrival_work = (epoch_work + static_cast<uint64_t>(ticks) / 2) / static_cast<uint64_t>(ticks);
+    int change = autoscaler->decide(total);
+    if (change == 0) {
+        return;
+    }
+    change > 0 ? scale_ups++ : scale_downs++;
+
+    // One server at a time: up where the queue per capacity is longest, down where it is shortest
+    for (int step = 0; step < std::abs(change); ++step) {
+        size_t chosen = nodes.size();
+        double best = 0.0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const ScalingSignals& s = local[i];
+            bool eligible = change > 0 ? s.active < s.maximum : s.idle > 0 && s.active > 1;
+            double pressure = s.capacity > 0.0 ? static_cast<double>(s.queued) / s.capacity
+                                               : std::numeric_limits<double>::infinity();
+            if (eligible && (chosen == nodes.size() || (change > 0 ? pressure > best : pressure < best))) {
+                chosen = i;
+                best = pressure;
+            }
+        }
+        if (chosen == nodes.size() || nodes[chosen]->lb->applyScaling(change > 0 ? 1 : -1) == 0) {
+            break;
+        }
+        local[chosen] = nodes[chosen]->lb->scalingSignals();
+        logOutput("Time " + std::to_string(time) + ": Cluster autoscaler " + (change > 0 ? "added a server to" : "removed a server from")
+                  + " node " + std::to_string(chosen) + " (" + std::to_string(local[chosen].active) + "/"
+                  + std::to_string(local[chosen].maximum) + ")");
+    }
+}
+
+void Cluster::run(int totalTime) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "Starting cluster simulation with %zu nodes for %d ticks (spill latency %d ticks, "
+                  "spill at %.2f queued per cycle/tick, locality /%d, %s scaling).\n", nodes.size(), totalTime,
+                  settings.latency, settings.spill, settings.locality,
+                  settings.scaling == ClusterScaling::Global ? "global" : "independent");
+    logOutput(line);
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    WorkerPool pool(std::min(nodes.size(), static_cast<size_t>(hardware)));
+    int elapsed = 0;
+    route(std::min(settings.latency, totalTime));
+    exchange();
+    while (elapsed < totalTime) {
+        int ticks = std::min(settings.latency, totalTime - elapsed);
+        pool.run(nodes.size(), [this, ticks](size_t task, size_t) {
+            nodes[task]->lb->advance(ticks);
+        });
+        elapsed += ticks;
+        if (settings.scaling == ClusterScaling::Global) {
+            scale(elapsed, ticks);
+        }
+        route(std::min(elapsed + settings.latency, totalTime));
+        exchange();
+    }
+
+    for (const std::unique_ptr<Node>& n : nodes) {
+        n->lb->report();
+    }
+    report(totalTime);
+}
+
+void Cluster::report(int totalTime) {
+    char line[256];
+    logOutput("\nCluster simulation complete!");
+    RunSummary total;
+    uint64_t in_transit = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& n = *nodes[i];
+        RunSummary s = n.lb->getSummary();
+        std::snprintf(line, sizeof(line), "Node %zu: %llu routed, %llu spilled out, %llu spilled in, %llu completed, "
+                      "%zu queued, %d servers", i, static_cast<unsigned long long>(n.routed),
+                      static_cast<unsigned long long>(n.spilled_out), static_cast<unsigned long long>(n.spilled_in),
+                      static_cast<unsigned long long>(s.sojourn.count()), s.queued, s.active);
+        logOutput(line);
+        total.wait.merge(s.wait);
+        total.service.merge(s.service);
+        total.sojourn.merge(s.sojourn);
+        total.server_ticks += s.server_ticks;
+        total.scale_ups += s.scale_ups;
+        total.scale_downs += s.scale_downs;
+        total.servers_added += s.servers_added;
+        total.servers_removed += s.servers_removed;
+        total.blocked += s.blocked;
+        total.shed += s.shed;
+        total.queued += s.queued;
+        total.active += s.active;
+        total.slo = s.slo;
+        in_transit += n.inbox.size() - n.next;
+    }
+    logOutput("Requests remaining in queues: " + std::to_string(total.queued) + " (" + std::to_string(in_transit)
+              + " spilled requests still in transit after tick " + std::to_string(totalTime) + ")");
+
+    logOutput("Latency of " + std::to_string(total.sojourn.count()) + " completed requests (ticks):");
+    const std::pair<const char*, const LatencyHistogram*> rows[] = {
+        {"wait", &total.wait}, {"service", &total.service}, {"sojourn", &total.sojourn}
+    };
+    for (const auto& row : rows) {
+        const LatencyHistogram& h = *row.second;
+        std::snprintf(line, sizeof(line), "  %-8s mean %.2f  p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu",
+                      row.first, h.mean(),
+                      static_cast<unsigned long long>(h.percentile(50.0)),
+                      static_cast<unsigned long long>(h.percentile(90.0)),
+                      static_cast<unsigned long long>(h.percentile(99.0)),
+                      static_cast<unsigned long long>(h.percentile(99.9)),
+                      static_cast<unsigned long long>(h.max()));
+        logOutput(line);
+    }
+
+    // With global scaling the nodes only carry out the cluster's steps, one server each
+    bool global = settings.scaling == ClusterScaling::Global;
+    std::snprintf(line, sizeof(line), "%llu scale-ups (+%llu servers), %llu scale-downs (-%llu servers), %llu server-ticks",
+                  static_cast<unsigned long long>(global ? scale_ups : total.scale_ups),
+                  static_cast<unsigned long long>(total.servers_added),
+                  static_cast<unsigned long long>(global ? scale_downs : total.scale_downs),
+                  static_cast<unsigned long long>(total.servers_removed),
+                  static_cast<unsigned long long>(total.server_ticks));
+    logOutput(std::string("Scaling (") + (global ? "global " + autoscaler->name() : "independent") + "): " + line);
+    uint64_t violations = total.sojourn.countAbove(static_cast<uint64_t>(total.slo));
+    double share = total.sojourn.count() ? 100.0 * violations / total.sojourn.count() : 0.0;
+    std::snprintf(line, sizeof(line), "SLO (sojourn <= %d ticks): %llu of %llu requests violated it (%.2f%%)", total.slo,
+                  static_cast<unsigned long long>(violations),
+                  static_cast<unsigned long long>(total.sojourn.count()), share);
+    logOutput(line);
+    std::snprintf(line, sizeof(line), "Firewall and rate limiter denied %llu requests, admission shed %llu",
+                  static_cast<unsigned long long>(total.blocked), static_cast<unsigned long long>(total.shed));
+    logOutput(line);
+    clusterLog->flush();
+}
+
+void Cluster::logOutput(const std::string& message) const {
+    clusterLog->log(LogLevel::Info, message);
+}
@@ -0,0 +1,185 @@
+/**
+ * @file Cluster.h
+ * @brief Cluster class header file
+ */
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "Autoscaler.h"
+#include "ClusterLink.h"
+#include "LoadBalancer.h"
+#include "Logger.h"
+#include "WorkloadGenerator.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Who sizes the server pools of a cluster
+ */
+enum class ClusterScaling {
+    Independent,    ///< Every node runs its own autoscaler on its own signals
+    Global          ///< One autoscaler sees the whole cluster and moves servers where the pressure is
+};
+
+/**
+ * @brief Configuration of a Cluster
+ */
+struct ClusterSettings {
+    int nodes = 2;                                      ///< Load balancers in the cluster
+    int latency = 5;                                    ///< Ticks a spilled request takes to reach another node
+    double spill = 10.0;                                ///< Queued requests per cycle/tick of capacity at which a node spills (0 never)
+    int locality = 28;                                  ///< Leading source address bits that keep clients on one node
+    ClusterScaling scaling = ClusterScaling::Independent;   ///< Who sizes the pools
+};
+
+/**
+ * @brief Parses "key=value,..." cluster settings
+ *
+ * Keys: nodes, latency (at least 1), spill, locality (0 to 32) and
+ * scaling=independent|global.
+ *
+ * @param spec Parameter list
+ * @param settings Receives the parsed values (keys that are not given keep their value)
+ * @return false on an unknown key or an invalid value
+ */
+bool parseClusterSettings(const std::string& spec, ClusterSettings& settings);
+
+/**
+ * @brief Several load balancers behind a locality-aware front tier that spill load to each other
+ *
+ * The front tier generates the traffic and sends every request to the node that owns
+ * its client's zone: the leading `locality` bits of the source address, spread over
+ * the nodes by jump consistent hashing. A node whose queue per cycle/tick of capacity
+ * reaches the spill threshold sends an arriving request to the least loaded peer below
+ * the threshold instead of queuing it; the request reaches the peer `latency` ticks
+ * later with its original enqueue time, and is never spilled again.
+ *
+ * Nodes are simulated in parallel in epochs of `latency` ticks. Nothing a node does
+ * in an epoch can reach another node before the next one, so the nodes share nothing
+ * during an epoch: each writes the requests it spills to its own outboxes and reads
+ * its peers' pressure from a snapshot taken at the barrier. Between epochs the main
+ * thread delivers the outboxes, routes the next epoch's traffic and, with global
+ * scaling, applies the cluster autoscaler. A run therefore depends only on the seed,
+ * not on the thread count or scheduling.
+ *
+ * Each node writes node<i>_simulation_log.txt and node<i>_firewall_audit.csv; the
+ * cluster writes the combined report to simulation_log.txt.
+ */
+class Cluster {
+public:
+    /**
+     * @brief Creates the nodes and the front tier
+     * @param settings Node count, spill latency and threshold, locality and scaling
+     * @param numServers Servers over all nodes (spread evenly, at least one per node)
+     * @param initialQueueSize Initial requests over all nodes, or -1 for 100 per server
+     * @param blockedIPsFile Firewall rules every node loads
+     * @param seed Seed of the traffic (0 for random); the nodes derive theirs from it
+     * @param consoleOutput Whether to echo the cluster log to stdout
+     * @param workloadConfig Traffic model of the front tier and the initial queues
+     */
+    Cluster(const ClusterSettings& settings, int numServers, int initialQueueSize, const std::string& blockedIPsFile,
+            unsigned int seed, bool consoleOutput, const WorkloadConfig& workloadConfig);
+
+    /**
+     * @brief Destructor that flushes the cluster log
+     */
+    ~Cluster();
+
+    Cluster(const Cluster&) = delete;
+    Cluster& operator=(const Cluster&) = delete;
+
+    /**
+     * @brief Gets the number of nodes
+     * @return Node count
+     */
+    size_t size() const { return nodes.size(); }
+
+    /**
+     * @brief Gets a node's load balancer, e.g. to configure it before run()
+     * @param i Node number
+     * @return Load balancer of the node
+     */
+    LoadBalancer& node(size_t i);
+
+    /**
+     * @brief Selects the autoscaler
+     *
+     * With independent scaling every node gets its own instance; with global scaling
+     * the cluster consults one instance at every epoch barrier with the summed
+     * signals of all nodes (arrivals averaged over the epoch) and the nodes keep
+     * their pools as the cluster sets them.
+     *
+     * @param spec Autoscaler specification (see makeAutoscaler())
+     * @return false if the specification is not recognised
+     */
+    bool setAutoscaler(const std::string& spec);
+
+    /**
+     * @brief Sets the log verbosity of the cluster log
+     * @param level Most verbose level that is recorded
+     */
+    void setLogLevel(LogLevel level);
+
+    /**
+     * @brief Runs the cluster and logs each node's report and the combined report
+     * @param totalTime Number of time ticks to simulate
+     */
+    void run(int totalTime);
+
+private:
+    class Node;
+
+    ClusterSettings settings;                       ///< Node count, latency, threshold, locality and scaling
+    WorkloadGenerator front;                        ///< Traffic of the front tier
+    std::vector<std::unique_ptr<Node>> nodes;       ///< Nodes with their links
+    std::vector<size_t> snapshot_queued;            ///< Queued requests per node at the last barrier
+    std::vector<double> snapshot_capacity;          ///< Capacity per node at the last barrier
+    std::unique_ptr<Autoscaler> autoscaler;         ///< Cluster autoscaler (global scaling only)
+    uint64_t front_sequence;                        ///< Order of the routed requests
+    uint64_t epoch_arrivals;                        ///< Requests routed for the current epoch
+    uint64_t epoch_work;                            ///< Processing cycles routed for the current epoch
+    uint64_t scale_ups;                             ///< Cluster scaling steps that added servers
+    uint64_t scale_downs;                           ///< Cluster scaling steps that removed servers
+    std::unique_ptr<Logger> clusterLog;             ///< Writer for simulation_log.txt (and the console)
+
+    /**
+     * @brief Picks the node that owns a client's zone
+     * @param ip Source address (host byte order)
+     * @return Node number
+     */
+    size_t zoneOf(uint32_t ip) const;
+
+    /**
+     * @brief Routes the front tier's requests up to a tick to the nodes' inboxes
+     * @param to Last tick to route
+     */
+    void route(int to);
+
+    /**
+     * @brief Delivers the spilled requests, sorts the inboxes and snapshots every node's pressure
+     */
+    void exchange();
+
+    /**
+     * @brief Lets the cluster autoscaler resize the pools at a barrier (global scaling)
+     * @param time Tick the epoch ended on
+     * @param ticks Length of the epoch
+     */
+    void scale(int time, int ticks);
+
+    /**
+     * @brief Logs the combined latency, scaling and spill report
+     * @param totalTime Ticks simulated
+     */
+    void report(int totalTime);
+
+    /**
+     * @brief Writes a message to the cluster log at the info level
+     * @param message Message body
+     */
+    void logOutput(const std::string& message) const;
+};
+
+#endif // CLUSTER_H
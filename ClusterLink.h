@@ -0,0 +1,62 @@
+/**
+ * @file ClusterLink.h
+ * @brief ClusterLink interface header file
+ */
+#ifndef CLUSTERLINK_H
+#define CLUSTERLINK_H
+
+#include "Request.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief A request delivered to one node of a Cluster
+ */
+struct ClusterArrival {
+    int time;               ///< Tick on which the request reaches the node
+    int origin;             ///< Node that spilled it, or -1 if the front tier routed it here
+    uint64_t sequence;      ///< Order among the arrivals from the same origin
+    Request request;        ///< Request, with its enqueue tick set to when it reached the cluster
+};
+
+/**
+ * @brief A load balancer's view of the cluster it runs in
+ *
+ * Replaces the load balancer's own traffic: collect() hands over the requests the
+ * front tier routed to the node and the requests other nodes spilled to it, and
+ * spill() offers an arriving request to the rest of the cluster before it is
+ * queued. A link is only used by the thread that runs its node.
+ */
+class ClusterLink {
+public:
+    /**
+     * @brief Virtual destructor
+     */
+    virtual ~ClusterLink() {}
+
+    /**
+     * @brief Moves the requests that reach the node by a tick to a buffer
+     * @param time Current tick
+     * @param out Receives the requests in arrival order (cleared first)
+     */
+    virtual void collect(int time, std::vector<ClusterArrival>& out) = 0;
+
+    /**
+     * @brief Gets when the next request reaches the node
+     * @return Tick of the next delivery known so far, or INT_MAX if none is
+     */
+    virtual int nextTime() const = 0;
+
+    /**
+     * @brief Offers a request that arrived from the front tier to another node
+     * @param r Request that passed the node's firewall
+     * @param time Current tick
+     * @param queued Requests waiting at the node
+     * @param capacity Cycles per tick the node's servers can process
+     * @return true if the request was sent to a peer and must not be queued here
+     */
+    virtual bool spill(const Request& r, int time, size_t queued, double capacity) = 0;
+};
+
+#endif // CLUSTERLINK_H
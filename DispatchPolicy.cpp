@@ -0,0 +1,369 @@
+/**
+ * @file DispatchPolicy.cpp
+ * @brief Built-in dispatch policy implementations
+ *
+ * Contains the policy factory and the first-idle, round-robin, least-loaded,
+ * power-of-two-choices, weighted round-robin and consistent hashing policies.
+ */
+
+#include "DispatchPolicy.h"
+#include "IndexedHeap.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <vector>
+
+void DispatchPolicy::reset(const ServerPool& pool) {
+    clear();
+    for (size_t i = 0; i < pool.slotCount(); ++i) {
+        if (pool.isActive(i) && !pool.isBusy(i)) {
+            serverIdle(pool, i);
+        }
+    }
+}
+
+namespace {
+    /**
+     * @brief SplitMix64 finalizer, used to spread source addresses over the hash space
+     * @param x Value to mix
+     * @return Well-distributed 64-bit hash
+     */
+    uint64_t mix64(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * @brief Jump consistent hash (Lamping and Veach)
+     * @param key Hashed key
+     * @param buckets Number of buckets (at least one)
+     * @return Bucket in [0, buckets); growing buckets only moves keys to the new buckets
+     */
+    long jumpHash(uint64_t key, long buckets) {
+        long long b = -1;
+        long long j = 0;
+        while (j < buckets) {
+            b = j;
+            key = key * 2862933555777941757ULL + 1;
+            j = static_cast<long long>((b + 1) * (double(1LL << 31) / double((key >> 33) + 1)));
+        }
+        return static_cast<long>(b);
+    }
+
+    /**
+     * @brief Gets a server's load as the least-loaded and power-of-two policies rank it
+     *
+     * The requests the server would run if it took one more, over its capacity: the
+     * share of a cycle per tick each of them would get, inverted. An empty server
+     * ranks by speed alone, and a speed-1 single-slot server scores exactly 1000.
+     *
+     * @param pool Server pool
+     * @param index Server index
+     * @return (in-flight requests + 1) * 10^6 / capacityUnits()
+     */
+    uint64_t loadKey(const ServerPool& pool, size_t index) {
+        return static_cast<uint64_t>(pool.inFlight(index) + 1) * 1000000 / std::max<uint32_t>(pool.capacityUnits(index), 1);
+    }
+
+    /**
+     * @brief Hands work to the most recently active idle server
+     *
+     * Uses the pool's own idle list, so it needs no state. Recently active servers are
+     * reused first and long-idle ones are the first to be scaled down.
+     */
+    class FirstIdlePolicy : public DispatchPolicy {
+    public:
+        std::string name() const override { return "first-idle"; }
+
+        long select(const ServerPool& pool, const Request&) override {
+            return pool.firstIdle();
+        }
+    };
+
+    /**
+     * @brief Cycles through the server indices, skipping busy servers
+     *
+     * The next candidate is found with a bit scan of the pool's busy bitmap, which
+     * examines 64 servers per word.
+     */
+    class RoundRobinPolicy : public DispatchPolicy {
+    private:
+        size_t cursor;  ///< Index after the previously chosen server
+
+    public:
+        RoundRobinPolicy() : cursor(0) {}
+
+        std::string name() const override { return "round-robin"; }
+
+        long select(const ServerPool& pool, const Request&) override {
+            long index = pool.findIdle(cursor);
+            if (index < 0) {
+                index = pool.findIdle(0);
+            }
+            if (index >= 0) {
+                cursor = static_cast<size_t>(index) + 1;
+            }
+            return index;
+        }
+
+    protected:
+        void clear() override { cursor = 0; }
+    };
+
+    /**
+     * @brief Hands work to the idle server with the least in-flight load
+     *
+     * Idle servers sit in an indexed heap keyed by loadKey(), lowest index first on
+     * ties. The key is refreshed whenever the load balancer reports a server idle,
+     * which it does each time a server frees a request slot, so a multi-slot server
+     * that finishes one of several requests moves up without leaving the set.
+     */
+    class LeastLoadedPolicy : public DispatchPolicy {
+    private:
+        IndexedHeap idle;               ///< Idle servers ordered by load
+
+    public:
+        std::string name() const override { return "least-loaded"; }
+
+        long select(const ServerPool&, const Request&) override {
+            return idle.empty() ? -1 : static_cast<long>(idle.top());
+        }
+
+        void serverIdle(const ServerPool& pool, size_t index) override {
+            idle.erase(index);
+            idle.setKey(index, loadKey(pool, index));
+            idle.push(index);
+        }
+
+        void serverAssigned(const ServerPool&, size_t index, const Request&) override {
+            idle.erase(index);
+        }
+
+        void serverRemoved(size_t index) override {
+            idle.erase(index);
+        }
+
+    protected:
+        void clear() override {
+            idle.clear();
+        }
+    };
+
+    /**
+     * @brief Weighted round-robin by stride scheduling over an indexed heap of idle servers
+     *
+     * Every server carries a virtual finish time ("pass"). Taking a request advances
+     * the server's pass by a stride of a constant divided by the server's weight, and
+     * the idle server with the smallest pass is chosen. A server that rejoins the idle
+     * set (added, recycled or back from a long request) has its pass raised to the
+     * pass of the last chosen server, so it cannot claim credit for the time it was away.
+     */
+    class StridePolicy : public DispatchPolicy {
+    private:
+        static constexpr uint64_t WEIGHT_SCALE = 1 << 20;  ///< Stride of a weight-1 server
+
+        std::string policyName;         ///< Name reported by name()
+        std::vector<uint64_t> weights;  ///< Weights cycled over server indices
+        IndexedHeap idle;               ///< Idle servers ordered by pass
+        uint64_t floor;                 ///< Pass of the most recently chosen server
+
+    public:
+        StridePolicy(const std::string& name, const std::vector<uint64_t>& serverWeights)
+            : policyName(name), weights(serverWeights), floor(0) {}
+
+        std::string name() const override { return policyName; }
+
+        long select(const ServerPool&, const Request&) override {
+            return idle.empty() ? -1 : static_cast<long>(idle.top());
+        }
+
+        void serverIdle(const ServerPool&, size_t index) override {
+            if (idle.contains(index)) {
+                return;
+            }
+            idle.setKey(index, std::max(idle.key(index), floor));
+            idle.push(index);
+        }
+
+        void serverAssigned(const ServerPool&, size_t index, const Request&) override {
+            idle.erase(index);
+            floor = std::max(floor, idle.key(index));
+            idle.setKey(index, idle.key(index) + WEIGHT_SCALE / weights[index % weights.size()]);
+        }
+
+        void serverRemoved(size_t index) override {
+            idle.erase(index);
+        }
+
+    protected:
+        void clear() override {
+            idle.clear();
+            floor = 0;
+        }
+    };
+
+    /**
+     * @brief Samples two idle servers at random and picks the less loaded one
+     *
+     * Idle servers are kept in a dense array with a position index, so uniform
+     * sampling and removal are both O(1). The two samples are compared on loadKey(),
+     * read from the pool at selection time, so the comparison always reflects the
+     * requests each server is running; the first sample wins ties.
+     */
+    class PowerOfTwoPolicy : public DispatchPolicy {
+    private:
+        std::mt19937 rng;               ///< Random source for the samples
+        std::vector<size_t> idle;       ///< Idle servers in no particular order
+        std::vector<long> position;     ///< Position of each server in idle, or -1
+
+        size_t sample() {
+            return static_cast<size_t>((static_cast<uint64_t>(rng()) * idle.size()) >> 32);
+        }
+
+    public:
+        explicit PowerOfTwoPolicy(unsigned int seed) : rng(seed) {}
+
+        std::string name() const override { return "power-of-two"; }
+
+        long select(const ServerPool& pool, const Request&) override {
+            if (idle.empty()) {
+                return -1;
+            }
+            size_t a = idle[sample()];
+            if (idle.size() == 1) {
+                return static_cast<long>(a);
+            }
+            size_t b = a;
+            while (b == a) {
+                b = idle[sample()];
+            }
+            return static_cast<long>(loadKey(pool, b) < loadKey(pool, a) ? b : a);
+        }
+
+        void serverIdle(const ServerPool&, size_t index) override {
+            if (index >= position.size()) {
+                position.resize(index + 1, -1);
+            }
+            if (position[index] >= 0) {
+                return;
+            }
+            position[index] = static_cast<long>(idle.size());
+            idle.push_back(index);
+        }
+
+        void serverAssigned(const ServerPool&, size_t index, const Request&) override {
+            serverRemoved(index);
+        }
+
+        void serverRemoved(size_t index) override {
+            if (index >= position.size() || position[index] < 0) {
+                return;
+            }
+            size_t at = static_cast<size_t>(position[index]);
+            idle[at] = idle.back();
+            position[idle[at]] = static_cast<long>(at);
+            idle.pop_back();
+            position[index] = -1;
+        }
+
+    protected:
+        void clear() override {
+            idle.clear();
+            position.assign(position.size(), -1);
+        }
+    };
+
+    /**
+     * @brief Consistent hashing on the source address for session affinity
+     *
+     * Jump consistent hash maps each source address to a home slot among all the
+     * pool's slots. Slots keep their index while servers come and go, so scaling only
+     * moves the addresses whose home slot was added or removed. If the home server is
+     * busy or absent, a few further slots derived from the same address are tried
+     * (always in the same order, so the address still sticks to a small set of
+     * servers) before falling back to any idle server.
+     */
+    class HashPolicy : public DispatchPolicy {
+    private:
+        static constexpr int PROBES = 8;    ///< Slots tried per request before giving up on affinity
+
+    public:
+        std::string name() const override { return "hash"; }
+
+        long select(const ServerPool& pool, const Request& r) override {
+            long slots = static_cast<long>(pool.slotCount());
+            if (slots == 0) {
+                return -1;
+            }
+            uint64_t key = mix64(r.getin());
+            for (int probe = 0; probe < PROBES; ++probe) {
+                long index = jumpHash(key, slots);
+                if (pool.isActive(index) && !pool.isBusy(index)) {
+                    return index;
+                }
+                key = mix64(key);
+            }
+            return pool.firstIdle();
+        }
+    };
+
+    /**
+     * @brief Parses a comma-separated list of positive weights
+     * @param text Weight list, e.g. "3,1,1"
+     * @param weights Receives the weights
+     * @return false if the list is empty or contains an invalid weight
+     */
+    bool parseWeights(const std::string& text, std::vector<uint64_t>& weights) {
+        std::istringstream items(text);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            if (item.empty() || item.size() > 6 || item.find_first_not_of("0123456789") != std::string::npos) {
+                return false;
+            }
+            uint64_t weight = std::stoul(item);
+            if (weight == 0) {
+                return false;
+            }
+            weights.push_back(weight);
+        }
+        return !weights.empty();
+    }
+}
+
+std::unique_ptr<DispatchPolicy> makeDispatchPolicy(const std::string& spec, unsigned int seed) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string params = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (kind == "weighted") {
+        std::vector<uint64_t> weights;
+        if (params.empty()) {
+            weights.push_back(1);
+        } else if (!parseWeights(params, weights)) {
+            return nullptr;
+        }
+        return std::unique_ptr<DispatchPolicy>(new StridePolicy(spec, weights));
+    }
+    if (colon != std::string::npos) {
+        return nullptr;     // only the weighted policy takes parameters
+    }
+    if (kind == "first-idle") {
+        return std::unique_ptr<DispatchPolicy>(new FirstIdlePolicy());
+    }
+    if (kind == "round-robin") {
+        return std::unique_ptr<DispatchPolicy>(new RoundRobinPolicy());
+    }
+    if (kind == "least-loaded") {
+        return std::unique_ptr<DispatchPolicy>(new LeastLoadedPolicy());
+    }
+    if (kind == "power-of-two") {
+        return std::unique_ptr<DispatchPolicy>(new PowerOfTwoPolicy(seed));
+    }
+    if (kind == "hash") {
+        return std::unique_ptr<DispatchPolicy>(new HashPolicy());
+    }
+    return nullptr;
+}
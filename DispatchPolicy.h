@@ -0,0 +1,106 @@
+/**
+ * @file DispatchPolicy.h
+ * @brief DispatchPolicy interface header file
+ */
+#ifndef DISPATCHPOLICY_H
+#define DISPATCHPOLICY_H
+
+#include "Request.h"
+#include "ServerPool.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Strategy that picks which idle server receives the next queued request
+ *
+ * Only idle servers, those with a free request slot, are candidates. The load
+ * balancer keeps the policy informed about the idle set: serverIdle() when a server
+ * is added, frees a slot (even if it already had a free one) or still has one after
+ * taking a request, serverAssigned() when it takes one and serverRemoved() when an
+ * empty server is scaled away. A policy that ranks servers by load refreshes its key
+ * on every serverIdle(). Policies use these
+ * notifications to maintain their own index (heap, sample array, ...) so that
+ * select() never scans the whole pool.
+ *
+ * Built-in policies are created by name with makeDispatchPolicy().
+ */
+class DispatchPolicy {
+public:
+    /**
+     * @brief Virtual destructor
+     */
+    virtual ~DispatchPolicy() {}
+
+    /**
+     * @brief Gets the name the policy was created with
+     * @return Policy name, e.g. "round-robin"
+     */
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief Picks an idle server for a request
+     * @param pool Server pool the load balancer dispatches to
+     * @param r Request at the front of the queue
+     * @return Index of an idle server, or -1 if there is none
+     */
+    virtual long select(const ServerPool& pool, const Request& r) = 0;
+
+    /**
+     * @brief Notifies the policy that a server has a free request slot (added, finished a
+     *        request or still has room after taking one); may repeat for an idle server
+     * @param pool Server pool the server belongs to (for its load and capacity)
+     * @param index Server index
+     */
+    virtual void serverIdle(const ServerPool& pool, size_t index) { (void)pool; (void)index; }
+
+    /**
+     * @brief Notifies the policy that a server started processing a request
+     * @param pool Server pool the server belongs to (for its capacity)
+     * @param index Server index
+     * @param r Request assigned to the server
+     */
+    virtual void serverAssigned(const ServerPool& pool, size_t index, const Request& r) {
+        (void)pool; (void)index; (void)r;
+    }
+
+    /**
+     * @brief Notifies the policy that an idle server left the pool
+     * @param index Server index
+     */
+    virtual void serverRemoved(size_t index) { (void)index; }
+
+    /**
+     * @brief Forgets all tracked servers and re-registers the idle servers of a pool
+     *
+     * Called when a policy is installed on a load balancer that already has servers.
+     *
+     * @param pool Server pool to take the idle set from
+     */
+    void reset(const ServerPool& pool);
+
+protected:
+    /**
+     * @brief Drops every tracked server; called by reset()
+     */
+    virtual void clear() {}
+};
+
+/**
+ * @brief Creates one of the built-in dispatch policies
+ *
+ * Recognised specifications:
+ * - first-idle: the most recently active idle server (the default; keeps caches warm)
+ * - round-robin: the next idle server after the previously chosen index
+ * - least-loaded: the idle server with the fewest requests in flight per unit of capacity
+ * - power-of-two: the less loaded (same measure) of two idle servers sampled at random
+ * - weighted[:w0,w1,...]: weighted round-robin; server i gets weight w(i mod n)
+ * - hash: consistent hashing on the source address (session affinity)
+ *
+ * @param spec Policy name, optionally followed by ':' and policy parameters
+ * @param seed Seed for policies that make random choices
+ * @return New policy, or nullptr if the specification is not recognised
+ */
+std::unique_ptr<DispatchPolicy> makeDispatchPolicy(const std::string& spec, unsigned int seed);
+
+#endif // DISPATCHPOLICY_H
@@ -0,0 +1,43 @@
+/**
+ * @file EpochDomain.cpp
+ * @brief EpochDomain class implementation
+ */
+
+#include "EpochDomain.h"
+#include <functional>
+#include <thread>
+
+EpochDomain::EpochDomain() : epoch(1) {
+    for (Slot& slot : slots) {
+        slot.pinned.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t EpochDomain::enter() {
+    static thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+    for (size_t i = hint;; ++i) {
+        Slot& slot = slots[i % MAX_READERS];
+        uint64_t expected = 0;
+        // The compare-and-swap is a full barrier, so the caller's load of the
+        // published pointer cannot move ahead of the pin
+        if (slot.pinned.load(std::memory_order_relaxed) == 0
+            && slot.pinned.compare_exchange_strong(expected, epoch.load(std::memory_order_seq_cst),
+                                                   std::memory_order_seq_cst)) {
+            hint = i % MAX_READERS;
+            return hint;
+        }
+    }
+}
+
+void EpochDomain::synchronize() {
+    uint64_t target = epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    for (Slot& slot : slots) {
+        for (;;) {
+            uint64_t pinned = slot.pinned.load(std::memory_order_acquire);
+            if (pinned == 0 || pinned >= target) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file EpochDomain.h
+ * @brief EpochDomain class header file
+ */
+#ifndef EPOCHDOMAIN_H
+#define EPOCHDOMAIN_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Epoch-based reclamation for data published through an atomic pointer
+ *
+ * Readers bracket every access to the published data with enter() and leave()
+ * (or a Guard). enter() claims a free reader slot and pins the current epoch in it
+ * with a single compare-and-swap; leave() clears the slot. Neither ever waits for a
+ * writer, so readers never block.
+ *
+ * A writer swaps the pointer first and then calls synchronize(), which starts a new
+ * epoch and waits until no slot is pinned to an older one. Every reader that could
+ * have loaded the old pointer has left by then, so the old data can be freed.
+ * Reader sections are a few lookups long, so the wait is short, and it only ever
+ * happens on the writer's thread.
+ *
+ * Slots are cache-line sized so concurrent readers do not share lines; a thread
+ * starts searching at the slot it used last, so it normally finds it free at once.
+ */
+class EpochDomain {
+public:
+    static constexpr size_t MAX_READERS = 64;   ///< Readers that can be inside at the same time
+
+    /**
+     * @brief Keeps the calling thread inside the domain for its lifetime
+     */
+    class Guard {
+    private:
+        EpochDomain& domain;    ///< Domain that was entered
+        size_t slot;            ///< Slot claimed by enter()
+
+    public:
+        /**
+         * @brief Enters the domain
+         * @param d Domain to enter
+         */
+        explicit Guard(EpochDomain& d) : domain(d), slot(d.enter()) {}
+
+        /**
+         * @brief Leaves the domain
+         */
+        ~Guard() { domain.leave(slot); }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    /**
+     * @brief Constructs a domain with no readers inside
+     */
+    EpochDomain();
+
+    /**
+     * @brief Marks the calling thread as reading until leave()
+     * @return Slot to pass to leave()
+     */
+    size_t enter();
+
+    /**
+     * @brief Marks the end of a read section
+     * @param slot Slot returned by enter()
+     */
+    void leave(size_t slot) { slots[slot].pinned.store(0, std::memory_order_release); }
+
+    /**
+     * @brief Waits until every reader that entered before the call has left
+     *
+     * Call after unpublishing data and before freeing it.
+     */
+    void synchronize();
+
+private:
+    /**
+     * @brief Epoch pinned by one reader, alone on its cache line
+     */
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> pinned;   ///< Epoch at which the reader entered; 0 when free
+    };
+
+    Slot slots[MAX_READERS];            ///< Reader slots
+    std::atomic<uint64_t> epoch;        ///< Current epoch (starts at 1; 0 marks a free slot)
+};
+
+#endif // EPOCHDOMAIN_H
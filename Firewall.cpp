@@ -0,0 +1,360 @@
+/**
+ * @file Firewall.cpp
+ * @brief Firewall class implementation
+ *
+ * Contains rule parsing, range-to-prefix expansion and the compiler that turns
+ * the rule list into the poptrie used for lookups.
+ */
+
+#include "Firewall.h"
+#include "IpAddress.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+Firewall::Firewall() {
+    compile();
+}
+
+void Firewall::addPrefix(uint32_t prefix, int length, FirewallAction action) {
+    if (length < 0 || length > 32) {
+        return;
+    }
+    uint32_t mask = length == 0 ? 0 : ~0u << (32 - length);
+    rules.push_back(Rule{prefix & mask, static_cast<uint8_t>(length), action, static_cast<uint32_t>(rules.size())});
+}
+
+void Firewall::addRange(uint32_t first, uint32_t last, FirewallAction action) {
+    // Cover the range with the largest aligned blocks that fit, left to right
+    uint64_t start = first;
+    uint64_t end = last;
+    while (start <= end) {
+        int length = 32;
+        while (length > 0) {
+            uint64_t size = 1ULL << (32 - (length - 1));
+            if ((start & (size - 1)) != 0 || start + size - 1 > end) {
+                break;
+            }
+            length--;
+        }
+        addPrefix(static_cast<uint32_t>(start), length, action);
+        start += 1ULL << (32 - length);
+    }
+}
+
+void Firewall::addPrefix(const IPv6Address& prefix, int length, FirewallAction action) {
+    if (length < 0 || length > 128) {
+        return;
+    }
+    if (length >= 96 && prefix.isIPv4Mapped()) {
+        addPrefix(prefix.toIPv4(), length - 96, action);
+        return;
+    }
+    IPv6Address network = prefix;
+    if (length <= 64) {
+        network.hi = length == 0 ? 0 : network.hi & (~0ULL << (64 - length));
+        network.lo = 0;
+    } else {
+        network.lo = length == 128 ? network.lo : network.lo & (~0ULL << (128 - length));
+    }
+    rules6.push_back(Rule6{network, static_cast<uint8_t>(length), action, static_cast<uint32_t>(rules6.size())});
+}
+
+bool Firewall::addRule(const std::string& line) {
+    std::string text = line.substr(0, line.find('#'));
+    std::istringstream tokens(text);
+    std::string word;
+    if (!(tokens >> word)) {
+        return true;    // blank or comment-only line
+    }
+
+    FirewallAction action = FirewallAction::Deny;
+    if (word == "allow" || word == "deny") {
+        action = word == "allow" ? FirewallAction::Allow : FirewallAction::Deny;
+        if (!(tokens >> word)) {
+            return false;
+        }
+    }
+    std::string extra;
+    if (tokens >> extra) {
+        return false;
+    }
+
+    size_t slash = word.find('/');
+    size_t dash = word.find('-');
+    if (word.find(':') != std::string::npos) {
+        IPv6Address network;
+        std::string bits = slash == std::string::npos ? "128" : word.substr(slash + 1);
+        if (dash != std::string::npos || bits.empty() || bits.size() > 3
+            || bits.find_first_not_of("0123456789") != std::string::npos
+            || !parseIPv6(word.substr(0, slash), network) || std::stoi(bits) > 128) {
+            return false;
+        }
+        addPrefix(network, std::stoi(bits), action);
+        return true;
+    }
+    uint32_t first, last;
+    if (slash != std::string::npos) {
+        std::string bits = word.substr(slash + 1);
+        if (bits.empty() || bits.size() > 2 || bits.find_first_not_of("0123456789") != std::string::npos
+            || !parseIPv4(word.substr(0, slash), first)) {
+            return false;
+        }
+        int length = std::stoi(bits);
+        if (length > 32) {
+            return false;
+        }
+        addPrefix(first, length, action);
+    } else if (dash != std::string::npos) {
+        if (!parseIPv4(word.substr(0, dash), first) || !parseIPv4(word.substr(dash + 1), last) || last < first) {
+            return false;
+        }
+        addRange(first, last, action);
+    } else {
+        if (!parseIPv4(word, first)) {
+            return false;
+        }
+        addPrefix(first, 32, action);
+    }
+    return true;
+}
+
+int Firewall::loadFile(const std::string& filepath, int* invalidLines) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        return -1;
+    }
+
+    int count = 0;
+    int invalid = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back(); // Remove carriage return if present
+        }
+        size_t before = rules.size() + rules6.size();
+        if (!addRule(line)) {
+            invalid++;
+        } else if (rules.size() + rules6.size() != before) {
+            count++;
+        }
+    }
+
+    if (invalidLines) {
+        *invalidLines = invalid;
+    }
+    compile();
+    return count;
+}
+
+void Firewall::compile() {
+    // Sorting by network address keeps every trie region a contiguous run of rules;
+    // within a prefix, shorter and older rules come first so newer ones override them
+    std::sort(rules.begin(), rules.end(), [](const Rule& a, const Rule& b) {
+        if (a.prefix != b.prefix) return a.prefix < b.prefix;
+        if (a.length != b.length) return a.length < b.length;
+        return a.order < b.order;
+    });
+    // The IPv6 scan stops at the first match, so the most specific and newest come first
+    std::sort(rules6.begin(), rules6.end(), [](const Rule6& a, const Rule6& b) {
+        if (a.length != b.length) return a.length > b.length;
+        return a.order > b.order;
+    });
+
+    const size_t blocks = size_t(1) << DIRECT_BITS;
+    const int shift = 32 - DIRECT_BITS;
+    std::vector<FirewallAction> blockAction(blocks, FirewallAction::None);
+
+    // Rules no longer than the direct table's width paint whole blocks
+    std::vector<const Rule*> shortRules;
+    for (const Rule& rule : rules) {
+        if (rule.length <= DIRECT_BITS) {
+            shortRules.push_back(&rule);
+        }
+    }
+    std::stable_sort(shortRules.begin(), shortRules.end(), [](const Rule* a, const Rule* b) {
+        if (a->length != b->length) return a->length < b->length;
+        return a->order < b->order;
+    });
+    for (const Rule* rule : shortRules) {
+        size_t start = rule->prefix >> shift;
+        size_t span = size_t(1) << (DIRECT_BITS - rule->length);
+        std::fill(blockAction.begin() + start, blockAction.begin() + start + span, rule->action);
+    }
+
+    direct.resize(blocks);
+    for (size_t block = 0; block < blocks; ++block) {
+        direct[block] = LEAF_FLAG | static_cast<uint32_t>(blockAction[block]);
+    }
+    nodes.clear();
+    leaves.clear();
+    for (size_t i = 0; i < rules.size();) {
+        // Gather the longer rules that fall in this block, which become a trie below it
+        size_t block = rules[i].prefix >> shift;
+        size_t last = i;
+        bool deeper = false;
+        while (last < rules.size() && (rules[last].prefix >> shift) == block) {
+            deeper = deeper || rules[last].length > DIRECT_BITS;
+            last++;
+        }
+        if (deeper) {
+            direct[block] = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(Node{0, 0, 0, 0});
+            compileNode(direct[block], DIRECT_BITS, blockAction[block], i, last);
+        }
+        i = last;
+    }
+    nodes.shrink_to_fit();
+    leaves.shrink_to_fit();
+}
+
+void Firewall::compileNode(size_t index, int depth, FirewallAction inherited, size_t first, size_t last) {
+    const int shift = 32 - depth - STRIDE;  // position of this node's slot bits in the address
+
+    FirewallAction slotAction[64];
+    std::fill(slotAction, slotAction + 64, inherited);
+
+    // Rules that end inside this node paint a block of slots (leaf pushing)
+    std::vector<const Rule*> local;
+    for (size_t i = first; i < last; ++i) {
+        if (rules[i].length > depth && rules[i].length <= depth + STRIDE) {
+            local.push_back(&rules[i]);
+        }
+    }
+    std::stable_sort(local.begin(), local.end(), [](const Rule* a, const Rule* b) {
+        if (a->length != b->length) return a->length < b->length;
+        return a->order < b->order;
+    });
+    for (const Rule* rule : local) {
+        unsigned start = (rule->prefix >> shift) & 63;
+        unsigned span = 1u << (depth + STRIDE - rule->length);
+        std::fill(slotAction + start, slotAction + start + span, rule->action);
+    }
+
+    // Longer rules continue into a child node per slot
+    uint64_t children = 0;
+    size_t childFirst[64];
+    size_t childLast[64];
+    for (size_t i = first; i < last; ++i) {
+        unsigned slot = (rules[i].prefix >> shift) & 63;
+        if (rules[i].length > depth + STRIDE) {
+            if (!(children & (1ULL << slot))) {
+                children |= 1ULL << slot;
+                childFirst[slot] = i;
+            }
+            childLast[slot] = i + 1;
+        }
+    }
+
+    // Store each run of equal verdicts among the leaf slots once
+    Node node{children, 0, static_cast<uint32_t>(leaves.size()), 0};
+    bool haveLeaf = false;
+    FirewallAction previous = FirewallAction::None;
+    for (unsigned slot = 0; slot < 64; ++slot) {
+        if (children & (1ULL << slot)) {
+            continue;
+        }
+        if (!haveLeaf || slotAction[slot] != previous) {
+            node.leafStarts |= 1ULL << slot;
+            leaves.push_back(slotAction[slot]);
+            previous = slotAction[slot];
+            haveLeaf = true;
+        }
+    }
+
+    // Children of a node are contiguous so they can be found with a popcount
+    node.childBase = static_cast<uint32_t>(nodes.size());
+    nodes.resize(nodes.size() + __builtin_popcountll(children));
+    nodes[index] = node;
+
+    uint32_t child = node.childBase;
+    for (unsigned slot = 0; slot < 64; ++slot) {
+        if (children & (1ULL << slot)) {
+            compileNode(child++, depth + STRIDE, slotAction[slot], childFirst[slot], childLast[slot]);
+        }
+    }
+}
+
+FirewallAction Firewall::lookup(const IPv6Address& ip) const {
+    if (ip.isIPv4Mapped()) {
+        return lookup(ip.toIPv4());
+    }
+    for (const Rule6& rule : rules6) {
+        uint64_t hiMask = rule.length == 0 ? 0 : rule.length >= 64 ? ~0ULL : ~0ULL << (64 - rule.length);
+        uint64_t loMask = rule.length <= 64 ? 0 : rule.length == 128 ? ~0ULL : ~0ULL << (128 - rule.length);
+        if ((ip.hi & hiMask) == rule.prefix.hi && (ip.lo & loMask) == rule.prefix.lo) {
+            return rule.action;
+        }
+    }
+    return FirewallAction::None;
+}
+
+size_t Firewall::prefixCount() const {
+    return rules.size() + rules6.size();
+}
+
+size_t Firewall::nodeCount() const {
+    return nodes.size();
+}
+
+size_t Firewall::memoryBytes() const {
+    return direct.size() * sizeof(uint32_t) + nodes.size() * sizeof(Node) + leaves.size() * sizeof(FirewallAction);
+}
+
+void Firewall::saveState(SnapshotWriter& out) const {
+    out.add("firewall.rules", rules);
+    out.add("firewall.rules6", rules6);
+    out.add("firewall.direct", direct);
+    out.add("firewall.nodes", nodes);
+    out.add("firewall.leaves", leaves);
+}
+
+bool Firewall::restoreState(SnapshotReader& in) {
+    std::vector<Rule> restoredRules;
+    std::vector<Rule6> restoredRules6;
+    std::vector<uint32_t> restoredDirect;
+    std::vector<Node> restoredNodes;
+    std::vector<FirewallAction> restoredLeaves;
+    if (!in.read("firewall.rules", restoredRules) || !in.read("firewall.rules6", restoredRules6)
+        || !in.read("firewall.direct", restoredDirect)
+        || !in.read("firewall.nodes", restoredNodes) || !in.read("firewall.leaves", restoredLeaves)) {
+        return false;
+    }
+    // Children always follow their parent, so the checks also rule out cycles, and a
+    // node's depth is known before its children are reached. lookup() takes the leaf
+    // run of every slot that is not a child, so the first such slot must start a run
+    // and no slot may be both; and no chain may go past the last address bit
+    bool valid = restoredDirect.size() == (size_t(1) << DIRECT_BITS);
+    std::vector<int> depth(restoredNodes.size(), 0);
+    for (uint32_t entry : restoredDirect) {
+        valid = valid && ((entry & LEAF_FLAG) || entry < restoredNodes.size());
+        if (valid && !(entry & LEAF_FLAG)) {
+            depth[entry] = DIRECT_BITS + STRIDE;
+        }
+    }
+    for (size_t i = 0; i < restoredNodes.size() && valid; ++i) {
+        const Node& node = restoredNodes[i];
+        size_t children = static_cast<size_t>(__builtin_popcountll(node.children));
+        size_t runs = static_cast<size_t>(__builtin_popcountll(node.leafStarts));
+        uint64_t leafSlots = ~node.children;
+        valid = (children == 0 || (node.childBase > i && node.childBase + children <= restoredNodes.size()))
+                && node.leafBase + runs <= restoredLeaves.size() && (node.leafStarts & node.children) == 0
+                && (leafSlots == 0 || (node.leafStarts & leafSlots & (~leafSlots + 1)) != 0)
+                && depth[i] <= 32 && (children == 0 || depth[i] + STRIDE <= 32);
+        for (size_t c = 0; c < children && valid; ++c) {
+            depth[node.childBase + c] = std::max(depth[node.childBase + c], depth[i] + STRIDE);
+        }
+    }
+    for (const Rule6& rule : restoredRules6) {
+        valid = valid && rule.length <= 128;
+    }
+    if (!valid) {
+        return false;
+    }
+    rules = std::move(restoredRules);
+    rules6 = std::move(restoredRules6);
+    direct = std::move(restoredDirect);
+    nodes = std::move(restoredNodes);
+    leaves = std::move(restoredLeaves);
+    return true;
+}
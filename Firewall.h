@@ -0,0 +1,248 @@
+/**
+ * @file Firewall.h
+ * @brief Firewall class header file
+ */
+#ifndef FIREWALL_H
+#define FIREWALL_H
+
+#include "IpAddress.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Verdict of a firewall rule for the addresses it covers
+ */
+enum class FirewallAction : uint8_t {
+    None = 0,   ///< No rule covers the address
+    Deny,       ///< Requests from the address are blocked
+    Allow       ///< Requests from the address are explicitly permitted
+};
+
+/**
+ * @brief IPv4 firewall with CIDR, range and allow/deny rules
+ *
+ * Rules are collected with addRule()/loadFile() and then compiled into a poptrie.
+ * The first 14 address bits index a flat "direct pointing" table; the remaining 18
+ * bits are resolved by at most three trie levels with a stride of six bits. Each
+ * trie node stores a 64-bit child bitmap and a 64-bit leaf bitmap instead of pointer
+ * arrays; its children and leaves live in contiguous arrays and are located with a
+ * popcount, and runs of identical leaves are stored once. A lookup therefore costs
+ * at most five dependent memory accesses (direct entry, three nodes, one leaf byte)
+ * no matter how many rules are loaded. Clustered rules and CIDR blocks share nodes;
+ * the worst case, isolated /32 host rules, costs roughly 50 bytes per rule.
+ *
+ * Matching is longest-prefix: the most specific rule covering an address decides
+ * its verdict, so an "allow" host rule can punch a hole in a denied network. Among
+ * rules with the same prefix the one added last wins. Address ranges are split into
+ * the minimal set of CIDR prefixes when they are added.
+ *
+ * IPv6 addresses and CIDR blocks are accepted too. IPv4-mapped IPv6 rules and
+ * lookups (::ffff:a.b.c.d) go through the IPv4 trie; other IPv6 rules are kept in a
+ * short list ordered most specific first and matched by a linear scan, which suits
+ * the handful of IPv6 rules a simulated rule file carries.
+ *
+ * Rule file syntax, one rule per line ('#' starts a comment):
+ * @code
+ * 10.0.0.7                     # deny a single address
+ * 192.168.1.0/28               # deny a CIDR block
+ * 172.16.0.5-172.16.0.90       # deny an inclusive range
+ * allow 192.168.1.7            # explicit allow
+ * deny 203.0.113.0/24          # explicit deny
+ * 2001:db8::/32                # deny an IPv6 CIDR block
+ * allow 2001:db8::7            # explicit IPv6 allow
+ * @endcode
+ */
+class Firewall {
+private:
+    /**
+     * @brief A rule prefix waiting to be compiled
+     */
+    struct Rule {
+        uint32_t prefix;        ///< Network address (host bits cleared)
+        uint8_t length;         ///< Prefix length in bits (0-32)
+        FirewallAction action;  ///< Verdict for matching addresses
+        uint32_t order;         ///< Insertion order, used to break ties between equal prefixes
+    };
+
+    /**
+     * @brief One compiled trie node covering STRIDE address bits
+     */
+    struct Node {
+        uint64_t children;      ///< Bit i set if slot i continues into a child node
+        uint64_t leafStarts;    ///< Bit i set if leaf slot i starts a new run of leaf values
+        uint32_t leafBase;      ///< Index of this node's first leaf in leaves
+        uint32_t childBase;     ///< Index of this node's first child in nodes
+    };
+
+    static constexpr int DIRECT_BITS = 14;              ///< Address bits resolved by the direct table
+    static constexpr int STRIDE = 6;                    ///< Address bits consumed per trie level
+    static constexpr uint32_t LEAF_FLAG = 0x80000000u;  ///< Marks a direct entry that holds a verdict
+
+    /**
+     * @brief An IPv6 rule prefix (not IPv4-mapped)
+     */
+    struct Rule6 {
+        IPv6Address prefix;     ///< Network address (host bits cleared)
+        uint8_t length;         ///< Prefix length in bits (0-128)
+        FirewallAction action;  ///< Verdict for matching addresses
+        uint32_t order;         ///< Insertion order, used to break ties between equal prefixes
+    };
+
+    std::vector<Rule> rules;            ///< Rules added since construction
+    std::vector<Rule6> rules6;          ///< IPv6 rules, most specific (then newest) first after compile()
+    std::vector<uint32_t> direct;       ///< Per top-14-bit block: node index, or LEAF_FLAG | verdict
+    std::vector<Node> nodes;            ///< Compiled trie nodes below the direct table
+    std::vector<FirewallAction> leaves; ///< Compressed leaf verdicts
+
+    /**
+     * @brief Compiles one trie node from the rules that fall inside its region
+     * @param index Position of the node in nodes (already allocated)
+     * @param depth Number of leading address bits fixed above this node
+     * @param inherited Verdict pushed down from the covering slot of the parent
+     * @param first Index in rules of the first rule inside the node's region
+     * @param last One past the last rule inside the node's region
+     */
+    void compileNode(size_t index, int depth, FirewallAction inherited, size_t first, size_t last);
+
+public:
+    /**
+     * @brief Constructs a firewall with no rules (every address is allowed)
+     */
+    Firewall();
+
+    /**
+     * @brief Adds a CIDR rule
+     * @param prefix Network address; host bits beyond length are ignored
+     * @param length Prefix length in bits (0-32)
+     * @param action Verdict for addresses inside the prefix
+     */
+    void addPrefix(uint32_t prefix, int length, FirewallAction action);
+
+    /**
+     * @brief Adds a rule for an inclusive address range
+     * @param first First address of the range
+     * @param last Last address of the range (must not be below first)
+     * @param action Verdict for addresses inside the range
+     */
+    void addRange(uint32_t first, uint32_t last, FirewallAction action);
+
+    /**
+     * @brief Adds an IPv6 CIDR rule; IPv4-mapped prefixes of /96 or longer become IPv4 rules
+     * @param prefix Network address; host bits beyond length are ignored
+     * @param length Prefix length in bits (0-128)
+     * @param action Verdict for addresses inside the prefix
+     */
+    void addPrefix(const IPv6Address& prefix, int length, FirewallAction action);
+
+    /**
+     * @brief Parses and adds one line of the rule file syntax
+     * @param line Rule text; blank lines and comments are accepted and ignored
+     * @return false if the line is not a valid rule
+     */
+    bool addRule(const std::string& line);
+
+    /**
+     * @brief Adds every rule in a rule file and compiles the result
+     * @param filepath Path to the rule file
+     * @param invalidLines Receives the number of lines that could not be parsed (optional)
+     * @return Number of rules added, or -1 if the file could not be opened
+     */
+    int loadFile(const std::string& filepath, int* invalidLines = nullptr);
+
+    /**
+     * @brief Builds the lookup trie from the current rule set
+     *
+     * Must be called after adding rules and before lookup(); loadFile() does this itself.
+     */
+    void compile();
+
+    /**
+     * @brief Finds the verdict of the most specific rule covering an address
+     * @param ip IPv4 address in host byte order
+     * @return Verdict of the matching rule, or FirewallAction::None if no rule matches
+     */
+    FirewallAction lookup(uint32_t ip) const {
+        uint32_t entry = direct[ip >> (32 - DIRECT_BITS)];
+        if (entry & LEAF_FLAG) {
+            return static_cast<FirewallAction>(entry & 0xff);
+        }
+        const Node* node = &nodes[entry];
+        int shift = 32 - DIRECT_BITS - STRIDE;
+        for (;;) {
+            unsigned slot = (ip >> shift) & 63;
+            uint64_t bit = 1ULL << slot;
+            uint64_t upTo = (bit << 1) - 1;     // slots 0..slot (all ones when slot is 63)
+            if (node->children & bit) {
+                node = &nodes[node->childBase + __builtin_popcountll(node->children & upTo) - 1];
+                shift -= STRIDE;
+            } else {
+                return leaves[node->leafBase + __builtin_popcountll(node->leafStarts & upTo) - 1];
+            }
+        }
+    }
+
+    /**
+     * @brief Finds the verdict of the most specific rule covering an IPv6 address
+     * @param ip IPv6 address; IPv4-mapped addresses are looked up in the IPv4 trie
+     * @return Verdict of the matching rule, or FirewallAction::None if no rule matches
+     */
+    FirewallAction lookup(const IPv6Address& ip) const;
+
+    /**
+     * @brief Checks whether requests from an address are blocked
+     * @param ip IPv4 address in host byte order
+     * @return true if the most specific matching rule is a deny rule
+     */
+    bool isBlocked(uint32_t ip) const {
+        return lookup(ip) == FirewallAction::Deny;
+    }
+
+    /**
+     * @brief Checks whether requests from an IPv6 address are blocked
+     * @param ip IPv6 address
+     * @return true if the most specific matching rule is a deny rule
+     */
+    bool isBlocked(const IPv6Address& ip) const {
+        return lookup(ip) == FirewallAction::Deny;
+    }
+
+    /**
+     * @brief Gets the number of CIDR prefixes the rules expanded into (both families)
+     * @return Number of stored prefixes
+     */
+    size_t prefixCount() const;
+
+    /**
+     * @brief Gets the number of compiled trie nodes (not counting the direct table)
+     * @return Node count
+     */
+    size_t nodeCount() const;
+
+    /**
+     * @brief Gets the memory used by the compiled lookup structure
+     * @return Size of the direct table, node and leaf arrays in bytes
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Adds the rules and the compiled lookup structure to a checkpoint
+     * @param out Checkpoint being written
+     */
+    void saveState(SnapshotWriter& out) const;
+
+    /**
+     * @brief Replaces the rules and lookup structure with those stored in a checkpoint
+     *
+     * The trie refers to its nodes and leaves by index, so it is copied as it is
+     * and not compiled again.
+     *
+     * @param in Open checkpoint
+     * @return false if a section is missing or an index points outside its array
+     */
+    bool restoreState(SnapshotReader& in);
+};
+
+#endif // FIREWALL_H
@@ -0,0 +1,235 @@
+/**
+ * @file FirewallAudit.cpp
+ * @brief FirewallAudit class implementation
+ */
+
+#include "FirewallAudit.h"
+#include "IpAddress.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#ifdef LB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+    const char* HEADER = "window_start,window_end,ip,blocked,rate_limited,temporary_blocks,shed,first_tick,last_tick\n";
+
+    /**
+     * @brief Compresses a file into a gzip file and deletes the original on success
+     * @param from File to compress
+     * @param to Path of the compressed file
+     */
+    void gzipFile(const std::string& from, const std::string& to) {
+#ifdef LB_HAVE_ZLIB
+        std::FILE* in = std::fopen(from.c_str(), "rb");
+        if (!in) {
+            return;
+        }
+        gzFile out = gzopen(to.c_str(), "wb6");
+        bool ok = out != nullptr;
+        std::vector<char> chunk(1 << 16);
+        size_t length;
+        while (ok && (length = std::fread(chunk.data(), 1, chunk.size(), in)) > 0) {
+            ok = gzwrite(out, chunk.data(), static_cast<unsigned>(length)) == static_cast<int>(length);
+        }
+        std::fclose(in);
+        if (out && gzclose(out) != Z_OK) {
+            ok = false;
+        }
+        // Keep the uncompressed file if anything went wrong
+        std::remove(ok ? from.c_str() : to.c_str());
+#else
+        (void)from;
+        (void)to;
+#endif
+    }
+}
+
+bool parseAuditSettings(const std::string& spec, AuditSettings& settings) {
+    std::istringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, equals);
+        std::string text = item.substr(equals + 1);
+        if (key == "compress") {
+            if (text != "gzip" && text != "none") {
+                return false;
+            }
+            if (text == "gzip" && !FirewallAudit::compressionAvailable()) {
+                return false;
+            }
+            settings.compress = text == "gzip";
+            continue;
+        }
+
+        // Non-negative integers, with a k or m suffix for sizes
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+        if (text.empty() || end == text.c_str() || text[0] == '-') {
+            return false;
+        }
+        if (key == "max-size" && (*end == 'k' || *end == 'm')) {
+            value <<= *end == 'k' ? 10 : 20;
+            end++;
+        }
+        if (*end != '\0') {
+            return false;
+        }
+        if (key == "window" && value >= 1 && value <= 1000000000ULL) {
+            settings.window = static_cast<int>(value);
+        } else if (key == "max-size" && value <= (1ULL << 40)) {
+            settings.max_bytes = static_cast<size_t>(value);
+        } else if (key == "keep" && value <= 1000) {
+            settings.keep = static_cast<int>(value);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+FirewallAudit::FirewallAudit(const std::string& filepath, const AuditSettings& auditSettings)
+    : path(filepath), settings(auditSettings), index(64, NONE), mask(63), shift(26), window_start(0), window_end(0),
+      file(nullptr), file_bytes(0), totals(), records(0), rotations(0) {
+    settings.window = std::max(settings.window, 1);
+    window_end = settings.window;
+}
+
+FirewallAudit::~FirewallAudit() {
+    if (!entries.empty()) {
+        writeWindow(window_end);
+    }
+    if (file) {
+        std::fclose(file);
+    }
+    if (compressor.joinable()) {
+        compressor.join();
+    }
+}
+
+bool FirewallAudit::compressionAvailable() {
+#ifdef LB_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FirewallAudit::configure(const AuditSettings& auditSettings) {
+    settings = auditSettings;
+    settings.window = std::max(settings.window, 1);
+    window_end = window_start + settings.window;
+}
+
+size_t FirewallAudit::insert(uint32_t ip, bool ipv6, int now, uint32_t slot) {
+    if ((entries.size() + 1) * 2 > index.size()) {
+        // Rehash into twice the slots; entry numbers do not change
+        index.assign(index.size() * 2, NONE);
+        mask = static_cast<uint32_t>(index.size() - 1);
+        shift--;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            uint32_t s = home(entries[i].ip);
+            while (index[s] != NONE) {
+                s = (s + 1) & mask;
+            }
+            index[s] = static_cast<uint32_t>(i);
+            entries[i].slot = s;
+        }
+        for (slot = home(ip); index[slot] != NONE; slot = (slot + 1) & mask) {
+        }
+    }
+    index[slot] = static_cast<uint32_t>(entries.size());
+    entries.push_back(Entry{ip, now, now, slot, ipv6, {0, 0, 0, 0}});
+    return entries.size() - 1;
+}
+
+void FirewallAudit::closeWindow(int now) {
+    if (!entries.empty()) {
+        writeWindow(window_end);
+    }
+    window_start = now - now % settings.window;
+    window_end = window_start + settings.window;
+}
+
+void FirewallAudit::flush(int now) {
+    if (!entries.empty()) {
+        writeWindow(std::min(window_end, std::max(now, window_start) + 1));
+    }
+    if (file) {
+        std::fflush(file);
+    }
+}
+
+void FirewallAudit::writeWindow(int end) {
+    buffer.clear();
+    char line[224];
+    char address[48];
+    for (Entry& e : entries) {
+        if (e.ipv6) {
+            std::snprintf(address, sizeof(address), "%s", formatIPv6(ipv6At(e.ip)).c_str());
+        } else {
+            formatIPv4(e.ip, address);
+        }
+        int length = std::snprintf(line, sizeof(line), "%d,%d,%s,%llu,%llu,%llu,%llu,%d,%d\n", window_start, end,
+                                   address, static_cast<unsigned long long>(e.counts[0]),
+                                   static_cast<unsigned long long>(e.counts[1]),
+                                   static_cast<unsigned long long>(e.counts[2]),
+                                   static_cast<unsigned long long>(e.counts[3]), e.first, e.last);
+        buffer.append(line, static_cast<size_t>(length));
+        index[e.slot] = NONE;
+    }
+    records += entries.size();
+    entries.clear();
+
+    if (!file) {
+        file = std::fopen(path.c_str(), "ab");
+        if (!file) {
+            return;
+        }
+        // Appending to an earlier run's file: count its size, and only a new file gets a header
+        std::fseek(file, 0, SEEK_END);
+        long existing = std::ftell(file);
+        file_bytes = existing > 0 ? static_cast<size_t>(existing) : 0;
+        if (file_bytes == 0) {
+            std::fputs(HEADER, file);
+            file_bytes = std::char_traits<char>::length(HEADER);
+        }
+    }
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    file_bytes += buffer.size();
+    if (settings.max_bytes > 0 && file_bytes >= settings.max_bytes) {
+        rotate();
+    }
+}
+
+void FirewallAudit::rotate() {
+    std::fclose(file);
+    file = nullptr;
+    file_bytes = 0;
+    rotations++;
+    if (compressor.joinable()) {
+        compressor.join();
+    }
+    if (settings.keep == 0) {
+        std::remove(path.c_str());
+        return;
+    }
+
+    // file.1 is the newest rotated file; the one past keep is dropped
+    std::string suffix = settings.compress ? ".gz" : "";
+    std::remove((path + "." + std::to_string(settings.keep) + suffix).c_str());
+    for (int i = settings.keep - 1; i >= 1; --i) {
+        std::rename((path + "." + std::to_string(i) + suffix).c_str(),
+                    (path + "." + std::to_string(i + 1) + suffix).c_str());
+    }
+    std::string newest = path + ".1";
+    std::rename(path.c_str(), newest.c_str());
+    if (settings.compress) {
+        compressor = std::thread(gzipFile, newest, newest + suffix);
+    }
+}
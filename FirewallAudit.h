@@ -0,0 +1,236 @@
+/**
+ * @file FirewallAudit.h
+ * @brief FirewallAudit class header file
+ */
+#ifndef FIREWALLAUDIT_H
+#define FIREWALLAUDIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief What the firewall did with a request
+ */
+enum class AuditAction {
+    Blocked,        ///< Refused by a firewall rule or a temporary block
+    RateLimited,    ///< Refused by the rate limiter
+    TemporaryBlock, ///< Source put on a temporary block (counted once per block, not per request)
+    Shed            ///< Dropped by the admission policy
+};
+
+/**
+ * @brief Aggregation and rotation settings of a FirewallAudit
+ */
+struct AuditSettings {
+    int window = 1000;                  ///< Ticks aggregated into one record per source
+    size_t max_bytes = 8u << 20;        ///< File size that triggers a rotation (0 never rotates)
+    int keep = 5;                       ///< Rotated files kept (file.1 is the newest)
+    bool compress = false;              ///< Whether rotated files are gzip-compressed
+};
+
+/**
+ * @brief Parses "key=value,..." audit settings
+ *
+ * Keys: window (ticks), max-size (bytes, with an optional k or m suffix), keep (files)
+ * and compress (gzip or none).
+ *
+ * @param spec Parameter list
+ * @param settings Receives the parsed values (keys that are not given keep their value)
+ * @return false on an unknown key or an invalid value
+ */
+bool parseAuditSettings(const std::string& spec, AuditSettings& settings);
+
+/**
+ * @brief Aggregated, size-rotated audit log of firewall and admission drops
+ *
+ * Instead of one line per dropped request, record() only bumps a counter for the
+ * source address. At the end of every window of simulated time one CSV record per
+ * source is written:
+ *
+ *     window_start,window_end,ip,blocked,rate_limited,temporary_blocks,shed,first_tick,last_tick
+ *
+ * so an attacker sending a million requests in a window costs a million counter
+ * increments and one line. The counters live in an open-addressing table keyed by
+ * address that is cleared, not freed, between windows, and the records are written
+ * in first-seen order with a single write per window.
+ *
+ * When the file grows past max_bytes it is renamed to file.1 (older files move up to
+ * file.keep and the oldest is deleted) and a new file is started. Rotated files can be
+ * gzip-compressed, which happens on a background thread so the simulation does not
+ * wait for it. Compression needs zlib at build time (see compressionAvailable()).
+ *
+ * The file is created on the first write, so runs without drops leave nothing behind.
+ * Not thread safe: every call must come from the simulation thread.
+ */
+class FirewallAudit {
+public:
+    /**
+     * @brief Creates an audit log; nothing is written until the first window closes
+     * @param filepath Path of the CSV file
+     * @param settings Aggregation and rotation settings
+     */
+    FirewallAudit(const std::string& filepath, const AuditSettings& settings = AuditSettings());
+
+    /**
+     * @brief Writes the open window, closes the file and waits for any compression
+     */
+    ~FirewallAudit();
+
+    FirewallAudit(const FirewallAudit&) = delete;
+    FirewallAudit& operator=(const FirewallAudit&) = delete;
+
+    /**
+     * @brief Checks whether this build can compress rotated files
+     * @return true if built with zlib
+     */
+    static bool compressionAvailable();
+
+    /**
+     * @brief Changes the settings; counts of the open window are kept
+     * @param settings New settings
+     */
+    void configure(const AuditSettings& settings);
+
+    /**
+     * @brief Gets the current settings
+     * @return Settings in use
+     */
+    const AuditSettings& getSettings() const { return settings; }
+
+    /**
+     * @brief Counts one firewall action against a source
+     * @param ip Source address (host byte order), or IPv6 side table handle
+     * @param action What was done
+     * @param now Current simulation time; closes the open window if it has ended
+     * @param ipv6 Whether ip is an IPv6 side table handle (see internIPv6())
+     */
+    void record(uint32_t ip, AuditAction action, int now, bool ipv6 = false) {
+        if (now >= window_end) {
+            closeWindow(now);
+        }
+        entries[find(ip, ipv6, now)].counts[static_cast<int>(action)]++;
+        totals[static_cast<int>(action)]++;
+    }
+
+    /**
+     * @brief Writes the open window, ending it at the given time
+     * @param now Current simulation time
+     */
+    void flush(int now);
+
+    /**
+     * @brief Gets the number of actions of one kind recorded so far
+     * @param action Kind of action
+     * @return Count since construction
+     */
+    uint64_t total(AuditAction action) const { return totals[static_cast<int>(action)]; }
+
+    /**
+     * @brief Gets the number of CSV records written so far
+     * @return Records written, not counting headers
+     */
+    uint64_t recordCount() const { return records; }
+
+    /**
+     * @brief Gets the number of times the file has been rotated
+     * @return Rotations since construction
+     */
+    uint64_t rotationCount() const { return rotations; }
+
+    /**
+     * @brief Gets the path of the CSV file
+     * @return File path
+     */
+    const std::string& getPath() const { return path; }
+
+private:
+    static constexpr int ACTIONS = 4;           ///< Number of AuditAction values
+    static constexpr uint32_t NONE = UINT32_MAX;    ///< Empty slot of the index
+
+    /**
+     * @brief Counters of one source in the open window
+     */
+    struct Entry {
+        uint32_t ip;                    ///< Source address, or IPv6 side table handle
+        int first;                      ///< First tick with an action
+        int last;                       ///< Last tick with an action
+        uint32_t slot;                  ///< Index slot that points at this entry
+        bool ipv6;                      ///< Whether ip is an IPv6 side table handle
+        uint64_t counts[ACTIONS];       ///< Actions by kind
+    };
+
+    std::string path;                   ///< CSV file
+    AuditSettings settings;             ///< Aggregation and rotation settings
+    std::vector<Entry> entries;         ///< Sources of the open window, in first-seen order
+    std::vector<uint32_t> index;        ///< Open-addressing table of entry numbers, power-of-two sized
+    uint32_t mask;                      ///< index.size() - 1
+    int shift;                          ///< 32 - log2(index.size()), for home()
+    int window_start;                   ///< First tick of the open window
+    int window_end;                     ///< First tick after the open window
+    std::FILE* file;                    ///< Open CSV file, or null before the first write
+    size_t file_bytes;                  ///< Bytes in the open file
+    std::string buffer;                 ///< Records of the window being written
+    std::thread compressor;             ///< Compresses the newest rotated file, if running
+    uint64_t totals[ACTIONS];           ///< Actions by kind since construction
+    uint64_t records;                   ///< CSV records written
+    uint64_t rotations;                 ///< Files rotated
+
+    /**
+     * @brief Gets the index slot a source hashes to
+     * @param ip Source address
+     * @return Slot to start probing at
+     */
+    uint32_t home(uint32_t ip) const { return (ip * 0x9e3779b1u) >> shift; }
+
+    /**
+     * @brief Finds the entry of a source, adding it if it is new to the window
+     * @param ip Source address, or IPv6 side table handle
+     * @param ipv6 Whether ip is an IPv6 side table handle
+     * @param now Current simulation time
+     * @return Entry number
+     */
+    size_t find(uint32_t ip, bool ipv6, int now) {
+        uint32_t slot = home(ip);
+        for (; index[slot] != NONE; slot = (slot + 1) & mask) {
+            Entry& e = entries[index[slot]];
+            if (e.ip == ip && e.ipv6 == ipv6) {
+                e.last = now;
+                return index[slot];
+            }
+        }
+        return insert(ip, ipv6, now, slot);
+    }
+
+    /**
+     * @brief Adds a source to the window, growing the index if it gets half full
+     * @param ip Source address, or IPv6 side table handle
+     * @param ipv6 Whether ip is an IPv6 side table handle
+     * @param now Current simulation time
+     * @param slot Free slot found for it
+     * @return Entry number
+     */
+    size_t insert(uint32_t ip, bool ipv6, int now, uint32_t slot);
+
+    /**
+     * @brief Writes the open window and starts the one containing a tick
+     * @param now Tick the next window must contain
+     */
+    void closeWindow(int now);
+
+    /**
+     * @brief Writes the open window's records up to a given end and clears them
+     * @param end First tick after the records' window
+     */
+    void writeWindow(int end);
+
+    /**
+     * @brief Closes the file, shifts the rotated files and starts compressing the newest
+     */
+    void rotate();
+};
+
+#endif // FIREWALLAUDIT_H
@@ -0,0 +1,169 @@
+/**
+ * @file IndexedHeap.h
+ * @brief Indexed binary heap of server indices
+ */
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Binary min-heap of server indices that can update or remove any member
+ *
+ * Each member has a 64-bit key; ties are broken by the lower server index so the
+ * order is deterministic. The position of every member is tracked, so erase()
+ * and key updates cost O(log n) instead of a search.
+ */
+class IndexedHeap {
+private:
+    std::vector<size_t> heap;       ///< Server indices in heap order
+    std::vector<long> position;     ///< Position of each server in heap, or -1
+    std::vector<uint64_t> keys;     ///< Key of each server
+
+    /**
+     * @brief Orders two members
+     * @param a Server index
+     * @param b Server index
+     * @return true if a comes out before b
+     */
+    bool less(size_t a, size_t b) const {
+        return keys[a] != keys[b] ? keys[a] < keys[b] : a < b;
+    }
+
+    /**
+     * @brief Stores a member at a heap position
+     * @param at Heap position
+     * @param index Server index
+     */
+    void place(size_t at, size_t index) {
+        heap[at] = index;
+        position[index] = static_cast<long>(at);
+    }
+
+    /**
+     * @brief Moves a member towards the root until its parent comes out first
+     * @param at Heap position of the member
+     */
+    void siftUp(size_t at) {
+        size_t index = heap[at];
+        while (at > 0) {
+            size_t parent = (at - 1) / 2;
+            if (!less(index, heap[parent])) {
+                break;
+            }
+            place(at, heap[parent]);
+            at = parent;
+        }
+        place(at, index);
+    }
+
+    /**
+     * @brief Moves a member away from the root until it comes out before its children
+     * @param at Heap position of the member
+     */
+    void siftDown(size_t at) {
+        size_t index = heap[at];
+        for (;;) {
+            size_t child = 2 * at + 1;
+            if (child >= heap.size()) {
+                break;
+            }
+            if (child + 1 < heap.size() && less(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!less(heap[child], index)) {
+                break;
+            }
+            place(at, heap[child]);
+            at = child;
+        }
+        place(at, index);
+    }
+
+public:
+    /**
+     * @brief Checks whether the heap has no members
+     * @return true if empty
+     */
+    bool empty() const { return heap.empty(); }
+
+    /**
+     * @brief Gets the member with the smallest key
+     * @return Server index; the heap must not be empty
+     */
+    size_t top() const { return heap.front(); }
+
+    /**
+     * @brief Checks whether a server is a member
+     * @param index Server index
+     * @return true if the server is in the heap
+     */
+    bool contains(size_t index) const { return index < position.size() && position[index] >= 0; }
+
+    /**
+     * @brief Gets a server's key
+     * @param index Server index
+     * @return Last key set for the server, 0 if none was
+     */
+    uint64_t key(size_t index) const { return index < keys.size() ? keys[index] : 0; }
+
+    /**
+     * @brief Sets a server's key
+     *
+     * Only for servers that are not members; erase() a member first and push() it
+     * again afterwards.
+     *
+     * @param index Server index
+     * @param key New key
+     */
+    void setKey(size_t index, uint64_t key) {
+        if (index >= keys.size()) {
+            keys.resize(index + 1, 0);
+            position.resize(index + 1, -1);
+        }
+        keys[index] = key;
+    }
+
+    /**
+     * @brief Adds a server with the key last set for it; does nothing for a member
+     * @param index Server index
+     */
+    void push(size_t index) {
+        if (contains(index)) {
+            return;
+        }
+        heap.push_back(index);
+        siftUp(heap.size() - 1);
+    }
+
+    /**
+     * @brief Removes a server in O(log n); does nothing if it is not a member
+     * @param index Server index
+     */
+    void erase(size_t index) {
+        if (!contains(index)) {
+            return;
+        }
+        size_t at = static_cast<size_t>(position[index]);
+        position[index] = -1;
+        size_t last = heap.back();
+        heap.pop_back();
+        if (last != index) {
+            place(at, last);
+            siftDown(at);
+            siftUp(static_cast<size_t>(position[last]));
+        }
+    }
+
+    /**
+     * @brief Removes every member, keeping the keys
+     */
+    void clear() {
+        heap.clear();
+        position.assign(position.size(), -1);
+    }
+};
+
+#endif // INDEXEDHEAP_H
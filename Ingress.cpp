@@ -0,0 +1,137 @@
+/**
+ * @file Ingress.cpp
+ * @brief Ingress class implementation
+ */
+#include "Ingress.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+namespace {
+    const int YIELD_LIMIT = 64;     ///< Yields before a waiting producer starts sleeping
+
+    /**
+     * @brief Waits a little, yielding first and sleeping once the wait drags on
+     * @param attempts Number of earlier waits in the same loop (incremented)
+     */
+    void backOff(int& attempts) {
+        if (attempts++ < YIELD_LIMIT) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+bool Ingress::Producer::reach(int tick) {
+    ingress.watermarks[id].tick.store(tick - 1, std::memory_order_release);
+    int attempts = 0;
+    while (tick > ingress.consumer_time.load(std::memory_order_acquire) + ingress.horizon) {
+        if (ingress.stopping.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        backOff(attempts);
+    }
+    return !ingress.stopping.load(std::memory_order_relaxed);
+}
+
+bool Ingress::Producer::push(Arrival arrival) {
+    arrival.producer = id;
+    arrival.sequence = sequence++;
+    int attempts = 0;
+    while (!ingress.ring.tryPush(std::move(arrival))) {
+        if (ingress.stopping.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        backOff(attempts);
+    }
+    return true;
+}
+
+Ingress::Ingress(size_t capacity, int aheadTicks)
+    : ring(capacity), horizon(aheadTicks), consumer_time(0), stopping(false) {
+}
+
+Ingress::~Ingress() {
+    stop();
+}
+
+void Ingress::start(size_t producers, int tick, const std::function<void(Producer&)>& body) {
+    stop();
+    stopping.store(false);
+    consumer_time.store(tick);
+    watermarks.reset(new Watermark[producers]);
+    for (size_t p = 0; p < producers; ++p) {
+        watermarks[p].tick.store(NOT_STARTED);
+    }
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([this, p, body]() {
+            Producer producer(*this, static_cast<uint32_t>(p));
+            body(producer);
+            watermarks[p].tick.store(INT_MAX, std::memory_order_release);   // no further arrivals
+        });
+    }
+}
+
+void Ingress::stop() {
+    stopping.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    drain();
+    staged.clear();
+}
+
+void Ingress::drain() {
+    Arrival arrival;
+    while (ring.tryPop(arrival)) {
+        staged.push_back(arrival);
+    }
+}
+
+int Ingress::lowestWatermark() const {
+    int lowest = INT_MAX;
+    for (size_t p = 0; p < threads.size(); ++p) {
+        lowest = std::min(lowest, watermarks[p].tick.load(std::memory_order_acquire));
+    }
+    return lowest;
+}
+
+void Ingress::collect(int tick, std::vector<Arrival>& out) {
+    out.clear();
+    consumer_time.store(tick, std::memory_order_release);
+    int attempts = 0;
+    while (lowestWatermark() < tick) {
+        drain();
+        backOff(attempts);
+    }
+    drain();    // everything pushed before the watermarks moved is in the ring now
+
+    auto due = std::partition(staged.begin(), staged.end(),
+                              [tick](const Arrival& a) { return a.request.getenqueued() <= tick; });
+    out.assign(staged.begin(), due);
+    staged.erase(staged.begin(), due);
+    std::sort(out.begin(), out.end(), [](const Arrival& a, const Arrival& b) {
+        if (a.request.getenqueued() != b.request.getenqueued()) {
+            return a.request.getenqueued() < b.request.getenqueued();
+        }
+        return a.producer != b.producer ? a.producer < b.producer : a.sequence < b.sequence;
+    });
+}
+
+int Ingress::nextTime() {
+    // A producer's watermark is always the tick before its next arrival, so the next
+    // arrival overall is the earliest of the watermarks and the staged arrivals
+    int attempts = 0;
+    int lowest;
+    while ((lowest = lowestWatermark()) == NOT_STARTED) {
+        backOff(attempts);
+    }
+    drain();
+    int next = lowest == INT_MAX ? INT_MAX : lowest + 1;
+    for (const Arrival& arrival : staged) {
+        next = std::min(next, arrival.request.getenqueued());
+    }
+    return next;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file Ingress.h
+ * @brief Ingress class header file
+ */
+#ifndef INGRESS_H
+#define INGRESS_H
+
+#include "Request.h"
+#include "RingBuffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One request handed from a producer thread to the simulation
+ */
+struct Arrival {
+    Request request;        ///< Request, with its enqueue tick set to the arrival tick
+    uint32_t producer;      ///< Producer that generated it (filled in by Ingress::Producer::push())
+    uint32_t sequence;      ///< Position in its producer's output (filled in by Ingress::Producer::push())
+    uint16_t burst;         ///< Number of requests that arrived together with it (1 for a single arrival)
+    uint16_t position;      ///< Its position within that group
+    bool blocked;           ///< Whether the firewall denies its source address
+};
+
+/**
+ * @brief Multi-producer ingress stage between traffic producer threads and the simulation
+ *
+ * Producer threads push arrivals into a bounded lock-free RingBuffer; the
+ * simulation thread drains it once per tick with collect(). Each producer also
+ * publishes a watermark on its own cache line: the tick before its next arrival.
+ * collect() waits until every watermark has reached the current tick, so it
+ * always sees the complete set of arrivals for that tick, and returns them sorted
+ * by (tick, producer, sequence). Thread scheduling therefore never changes what
+ * the simulation sees: runs are as reproducible as with inline generation.
+ *
+ * Producers may run at most a fixed horizon of ticks ahead of the simulation and
+ * wait while the ring is full, so memory stays bounded however fast they are.
+ */
+class Ingress {
+private:
+    /**
+     * @brief A producer's watermark, alone on its cache line
+     */
+    struct alignas(64) Watermark {
+        std::atomic<int> tick;      ///< Every arrival up to this tick has been pushed
+    };
+
+    static constexpr int NOT_STARTED = -2147483647 - 1;    ///< Watermark before a producer's first reach()
+
+    RingBuffer<Arrival> ring;                       ///< Arrivals pushed but not yet drained
+    std::unique_ptr<Watermark[]> watermarks;        ///< One watermark per producer
+    std::vector<std::thread> threads;               ///< Producer threads
+    std::vector<Arrival> staged;                    ///< Drained arrivals not yet collected (consumer only)
+    int horizon;                                    ///< How many ticks producers may run ahead
+    alignas(64) std::atomic<int> consumer_time;     ///< Tick the simulation is collecting
+    std::atomic<bool> stopping;                     ///< Set to make producers return
+
+    /**
+     * @brief Moves everything in the ring into the staging buffer
+     */
+    void drain();
+
+    /**
+     * @brief Gets the lowest producer watermark
+     * @return Lowest watermark; NOT_STARTED if some producer has not announced its first arrival
+     */
+    int lowestWatermark() const;
+
+public:
+    /**
+     * @brief Handle through which one producer thread publishes its arrivals
+     *
+     * A producer announces each arrival tick with reach() before pushing the
+     * requests of that tick; ticks must increase from one reach() to the next.
+     */
+    class Producer {
+    private:
+        Ingress& ingress;       ///< Owning ingress stage
+        uint32_t id;            ///< Producer number
+        uint32_t sequence;      ///< Arrivals pushed so far
+
+    public:
+        /**
+         * @brief Constructs the handle of one producer
+         * @param owner Owning ingress stage
+         * @param producer Producer number
+         */
+        Producer(Ingress& owner, uint32_t producer) : ingress(owner), id(producer), sequence(0) {}
+
+        /**
+         * @brief Announces the tick of the producer's next arrival
+         *
+         * Publishes that every earlier arrival has been pushed, then waits while the
+         * tick is beyond the horizon of the simulation.
+         *
+         * @param tick Tick of the next arrival
+         * @return false once the ingress is stopping; the producer should return
+         */
+        bool reach(int tick);
+
+        /**
+         * @brief Pushes one arrival, waiting while the ring is full
+         * @param arrival Arrival at the tick last passed to reach()
+         * @return false once the ingress is stopping; the producer should return
+         */
+        bool push(Arrival arrival);
+
+        /**
+         * @brief Gets the producer number
+         * @return Producer number, from 0
+         */
+        uint32_t number() const { return id; }
+    };
+
+    /**
+     * @brief Constructs an idle ingress stage
+     * @param capacity Number of arrivals the ring holds
+     * @param aheadTicks How many ticks producers may run ahead of the simulation
+     */
+    explicit Ingress(size_t capacity = 1 << 14, int aheadTicks = 256);
+
+    /**
+     * @brief Stops the producers
+     */
+    ~Ingress();
+
+    Ingress(const Ingress&) = delete;
+    Ingress& operator=(const Ingress&) = delete;
+
+    /**
+     * @brief Starts producer threads
+     *
+     * A producer that returns on its own is treated as having no further arrivals.
+     *
+     * @param producers Number of producer threads
+     * @param tick Current simulation tick; arrivals must come after it
+     * @param body Producer thread body
+     */
+    void start(size_t producers, int tick, const std::function<void(Producer&)>& body);
+
+    /**
+     * @brief Stops and joins the producer threads and discards arrivals not yet collected
+     */
+    void stop();
+
+    /**
+     * @brief Takes every arrival up to a tick, waiting for producers that are behind
+     * @param tick Current simulation tick
+     * @param out Receives the arrivals in (tick, producer, sequence) order
+     */
+    void collect(int tick, std::vector<Arrival>& out);
+
+    /**
+     * @brief Gets the tick of the next arrival after the last collect()
+     * @return Arrival tick, or INT_MAX if every producer has finished
+     */
+    int nextTime();
+
+    /**
+     * @brief Gets the number of running producers
+     * @return Producer count
+     */
+    size_t producers() const { return threads.size(); }
+};
+
+#endif // INGRESS_H
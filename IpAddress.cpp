@@ -0,0 +1,283 @@
+/**
+ * @file IpAddress.cpp
+ * @brief IP address parsing and formatting
+ *
+ * Contains allocation-free conversions between packed integer IP addresses and
+ * their text forms. Addresses are only turned into text when they are logged.
+ */
+
+#include "IpAddress.h"
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    /**
+     * @brief Parses one IPv4 octet starting at text[pos]
+     * @param text Address text
+     * @param pos Current position, advanced past the octet
+     * @param octet Receives the octet value
+     * @return true if 1-3 digits forming a value <= 255 were read
+     */
+    bool parseOctet(const std::string& text, size_t& pos, uint32_t& octet) {
+        size_t start = pos;
+        octet = 0;
+        while (pos < text.size() && pos - start < 3 && text[pos] >= '0' && text[pos] <= '9') {
+            octet = octet * 10 + static_cast<uint32_t>(text[pos] - '0');
+            pos++;
+        }
+        return pos > start && octet <= 255;
+    }
+
+    /**
+     * @brief Converts a hexadecimal digit to its value
+     * @param c Character to convert
+     * @return Digit value, or -1 if c is not a hex digit
+     */
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    /**
+     * @brief Hash for IPv6 addresses in the side table index
+     */
+    struct IPv6Hash {
+        size_t operator()(const IPv6Address& ip) const {
+            uint64_t h = ip.hi * 0x9e3779b97f4a7c15ULL ^ ip.lo;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    /**
+     * @brief Process-wide IPv6 side table referenced by Request handles
+     */
+    struct IPv6Table {
+        std::mutex mutex;                                           ///< Guards both containers
+        std::vector<IPv6Address> addresses;                         ///< Addresses indexed by handle
+        std::unordered_map<IPv6Address, uint32_t, IPv6Hash> index;  ///< Address to handle
+    };
+
+    /**
+     * @brief Returns the side table, constructed on first use
+     * @return Process-wide table
+     */
+    IPv6Table& sideTable() {
+        static IPv6Table table;
+        return table;
+    }
+}
+
+bool parseIPv4(const std::string& text, uint32_t& ip) {
+    size_t pos = 0;
+    uint32_t result = 0;
+    for (int part = 0; part < 4; ++part) {
+        if (part > 0) {
+            if (pos >= text.size() || text[pos] != '.') {
+                return false;
+            }
+            pos++;
+        }
+        uint32_t octet;
+        if (!parseOctet(text, pos, octet)) {
+            return false;
+        }
+        result = (result << 8) | octet;
+    }
+    if (pos != text.size()) {
+        return false;
+    }
+    ip = result;
+    return true;
+}
+
+size_t formatIPv4(uint32_t ip, char* buffer) {
+    size_t len = 0;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        uint32_t octet = (ip >> shift) & 0xff;
+        if (octet >= 100) {
+            buffer[len++] = static_cast<char>('0' + octet / 100);
+        }
+        if (octet >= 10) {
+            buffer[len++] = static_cast<char>('0' + (octet / 10) % 10);
+        }
+        buffer[len++] = static_cast<char>('0' + octet % 10);
+        if (shift > 0) {
+            buffer[len++] = '.';
+        }
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+std::string formatIPv4(uint32_t ip) {
+    char buffer[16];
+    size_t len = formatIPv4(ip, buffer);
+    return std::string(buffer, len);
+}
+
+bool parseIPv6(const std::string& text, IPv6Address& ip) {
+    uint16_t groups[8] = {0};
+    int count = 0;          // groups parsed so far
+    int gap = -1;           // index in groups[] where "::" was seen
+    size_t pos = 0;
+
+    if (text.compare(0, 2, "::") == 0) {
+        gap = 0;
+        pos = 2;
+    }
+
+    while (pos < text.size()) {
+        if (count >= 8) {
+            return false;
+        }
+
+        // A trailing dotted quad fills the last two groups
+        size_t next = text.find_first_of(":.", pos);
+        if (next != std::string::npos && text[next] == '.') {
+            uint32_t v4;
+            if (count > 6 || !parseIPv4(text.substr(pos), v4)) {
+                return false;
+            }
+            groups[count++] = static_cast<uint16_t>(v4 >> 16);
+            groups[count++] = static_cast<uint16_t>(v4 & 0xffff);
+            pos = text.size();
+            break;
+        }
+
+        uint32_t value = 0;
+        size_t start = pos;
+        while (pos < text.size() && pos - start < 4 && hexValue(text[pos]) >= 0) {
+            value = (value << 4) | static_cast<uint32_t>(hexValue(text[pos]));
+            pos++;
+        }
+        if (pos == start) {
+            return false;
+        }
+        groups[count++] = static_cast<uint16_t>(value);
+
+        if (pos == text.size()) {
+            break;
+        }
+        if (text[pos] != ':') {
+            return false;
+        }
+        pos++;
+        if (pos < text.size() && text[pos] == ':') {
+            if (gap >= 0) {
+                return false;   // only one "::" is allowed
+            }
+            gap = count;
+            pos++;
+        } else if (pos == text.size()) {
+            return false;       // trailing single ':'
+        }
+    }
+
+    if (gap >= 0) {
+        if (count == 8) {
+            return false;
+        }
+        // Shift the groups after "::" to the end and zero the gap
+        int tail = count - gap;
+        for (int i = 0; i < tail; ++i) {
+            groups[7 - i] = groups[count - 1 - i];
+        }
+        for (int i = gap; i < 8 - tail; ++i) {
+            groups[i] = 0;
+        }
+    } else if (count != 8) {
+        return false;
+    }
+
+    ip.hi = 0;
+    ip.lo = 0;
+    for (int i = 0; i < 4; ++i) {
+        ip.hi = (ip.hi << 16) | groups[i];
+        ip.lo = (ip.lo << 16) | groups[i + 4];
+    }
+    return true;
+}
+
+std::string formatIPv6(const IPv6Address& ip) {
+    if (ip.isIPv4Mapped()) {
+        return "::ffff:" + formatIPv4(ip.toIPv4());
+    }
+
+    uint16_t groups[8];
+    for (int i = 0; i < 4; ++i) {
+        groups[i] = static_cast<uint16_t>(ip.hi >> (48 - 16 * i));
+        groups[i + 4] = static_cast<uint16_t>(ip.lo >> (48 - 16 * i));
+    }
+
+    // Find the longest run (of at least two) zero groups to compress as "::"
+    int best_start = -1, best_len = 1;
+    for (int i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            i++;
+            continue;
+        }
+        int j = i;
+        while (j < 8 && groups[j] == 0) {
+            j++;
+        }
+        if (j - i > best_len) {
+            best_start = i;
+            best_len = j - i;
+        }
+        i = j;
+    }
+
+    std::string result;
+    char buffer[8];
+    for (int i = 0; i < 8; ++i) {
+        if (i == best_start) {
+            result += "::";
+            i += best_len - 1;
+            continue;
+        }
+        if (!result.empty() && result.back() != ':') {
+            result += ':';
+        }
+        std::snprintf(buffer, sizeof(buffer), "%x", groups[i]);
+        result += buffer;
+    }
+    return result;
+}
+
+uint32_t internIPv6(const IPv6Address& ip) {
+    IPv6Table& table = sideTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto found = table.index.find(ip);
+    if (found != table.index.end()) {
+        return found->second;
+    }
+    uint32_t handle = static_cast<uint32_t>(table.addresses.size());
+    table.addresses.push_back(ip);
+    table.index.emplace(ip, handle);
+    return handle;
+}
+
+IPv6Address ipv6At(uint32_t handle) {
+    IPv6Table& table = sideTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return handle < table.addresses.size() ? table.addresses[handle] : IPv6Address{0, 0};
+}
+
+std::vector<IPv6Address> ipv6Table() {
+    IPv6Table& table = sideTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.addresses;
+}
+
+void restoreIPv6Table(const std::vector<IPv6Address>& addresses) {
+    IPv6Table& table = sideTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.addresses = addresses;
+    table.index.clear();
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        table.index.emplace(addresses[i], static_cast<uint32_t>(i));
+    }
+}
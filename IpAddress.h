@@ -0,0 +1,140 @@
+/**
+ * @file IpAddress.h
+ * @brief Compact integer IP address representation and text conversion
+ */
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Packs four dotted-quad octets into an IPv4 address in host byte order
+ * @param a First (most significant) octet
+ * @param b Second octet
+ * @param c Third octet
+ * @param d Fourth (least significant) octet
+ * @return Packed 32-bit address
+ */
+constexpr uint32_t makeIPv4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    return (a << 24) | (b << 16) | (c << 8) | d;
+}
+
+/**
+ * @brief Parses a dotted-quad IPv4 address such as "192.168.1.7"
+ * @param text Address text (surrounding whitespace is not accepted)
+ * @param ip Receives the packed address in host byte order on success
+ * @return true if the text is a valid IPv4 address, false otherwise
+ */
+bool parseIPv4(const std::string& text, uint32_t& ip);
+
+/**
+ * @brief Formats an IPv4 address into a caller-provided buffer without allocating
+ * @param ip Packed address in host byte order
+ * @param buffer Output buffer of at least 16 bytes; the result is NUL terminated
+ * @return Number of characters written, excluding the terminator
+ */
+size_t formatIPv4(uint32_t ip, char* buffer);
+
+/**
+ * @brief Formats an IPv4 address as dotted-quad text
+ * @param ip Packed address in host byte order
+ * @return Address text
+ */
+std::string formatIPv4(uint32_t ip);
+
+/**
+ * @brief 128-bit IPv6 address stored as two 64-bit halves in host byte order
+ *
+ * IPv4 addresses can be carried as IPv4-mapped addresses (::ffff:a.b.c.d), which
+ * lets code that must handle both families work on a single value type.
+ */
+struct IPv6Address {
+    uint64_t hi;    ///< Most significant 64 bits (first four groups)
+    uint64_t lo;    ///< Least significant 64 bits (last four groups)
+
+    /**
+     * @brief Builds the IPv4-mapped IPv6 address for an IPv4 address
+     * @param ip Packed IPv4 address in host byte order
+     * @return ::ffff:a.b.c.d
+     */
+    static constexpr IPv6Address fromIPv4(uint32_t ip) {
+        return IPv6Address{0, 0x0000ffff00000000ULL | ip};
+    }
+
+    /**
+     * @brief Checks whether this is an IPv4-mapped address
+     * @return true for ::ffff:0:0/96 addresses
+     */
+    constexpr bool isIPv4Mapped() const {
+        return hi == 0 && (lo >> 32) == 0x0000ffffULL;
+    }
+
+    /**
+     * @brief Extracts the IPv4 address from an IPv4-mapped address
+     * @return Low 32 bits of the address
+     */
+    constexpr uint32_t toIPv4() const {
+        return static_cast<uint32_t>(lo);
+    }
+
+    bool operator==(const IPv6Address& other) const {
+        return hi == other.hi && lo == other.lo;
+    }
+
+    bool operator!=(const IPv6Address& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief Parses an IPv6 address in RFC 4291 text form, including "::" compression
+ *        and a trailing dotted-quad (e.g. "::ffff:192.168.1.7")
+ * @param text Address text
+ * @param ip Receives the address on success
+ * @return true if the text is a valid IPv6 address, false otherwise
+ */
+bool parseIPv6(const std::string& text, IPv6Address& ip);
+
+/**
+ * @brief Formats an IPv6 address in RFC 5952 canonical text form
+ * @param ip Address to format
+ * @return Address text (IPv4-mapped addresses use the dotted-quad suffix)
+ */
+std::string formatIPv6(const IPv6Address& ip);
+
+/**
+ * @brief Interns an IPv6 address in the process-wide IPv6 side table
+ *
+ * Requests keep packed 32-bit addresses so they stay 16 bytes; an IPv6 request
+ * stores the handle returned here instead and the firewall and log formatting
+ * resolve it with ipv6At(). Interning the same address twice returns the same
+ * handle. Thread-safe.
+ *
+ * @param ip Address to intern
+ * @return Stable handle for the address
+ */
+uint32_t internIPv6(const IPv6Address& ip);
+
+/**
+ * @brief Resolves a handle returned by internIPv6()
+ * @param handle Side table handle
+ * @return Interned address, or :: for an unknown handle
+ */
+IPv6Address ipv6At(uint32_t handle);
+
+/**
+ * @brief Copies the IPv6 side table in handle order, for checkpoints
+ * @return Every interned address, indexed by handle
+ */
+std::vector<IPv6Address> ipv6Table();
+
+/**
+ * @brief Replaces the IPv6 side table, for checkpoint restore
+ * @param table Addresses indexed by handle, as returned by ipv6Table()
+ */
+void restoreIPv6Table(const std::vector<IPv6Address>& table);
+
+#endif // IPADDRESS_H
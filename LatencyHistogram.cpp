@@ -0,0 +1,65 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief LatencyHistogram class implementation
+ */
+
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+uint64_t LatencyHistogram::highestIn(size_t bucket) {
+    if (bucket < (size_t(1) << SUB_BITS)) {
+        return bucket;
+    }
+    int shift = static_cast<int>(bucket >> (SUB_BITS - 1)) - 1;
+    uint64_t mantissa = bucket - (static_cast<uint64_t>(shift) << (SUB_BITS - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+void LatencyHistogram::clear() {
+    std::fill(counts, counts + BUCKETS, 0);
+    total = 0;
+    sum = 0;
+    minimum = UINT64_MAX;
+    maximum = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+    if (total == 0) {
+        return 0;
+    }
+    percent = std::min(std::max(percent, 0.0), 100.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(total)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(highestIn(i), maximum);
+        }
+    }
+    return maximum;
+}
+
+uint64_t LatencyHistogram::countAbove(uint64_t value) const {
+    uint64_t above = 0;
+    for (size_t i = bucketOf(value) + 1; i < BUCKETS; ++i) {
+        above += counts[i];
+    }
+    return above;
+}
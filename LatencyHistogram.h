@@ -0,0 +1,125 @@
+/**
+ * @file LatencyHistogram.h
+ * @brief LatencyHistogram class header file
+ */
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Constant-memory histogram of non-negative integer samples (HDR style)
+ *
+ * Values below 128 get a bucket each. Every larger power-of-two range [2^k, 2^(k+1))
+ * is split into 64 equal sub-buckets, so any recorded value is known to within
+ * 1/64 (about 1.6%) of itself. The full 64-bit range fits in a fixed array of a
+ * few thousand counters, so recording is a bit scan and an increment, and
+ * percentiles are read with a single pass over the buckets.
+ */
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 7;                          ///< log2 of the exact range (values below 128)
+    static constexpr size_t HALF = size_t(1) << (SUB_BITS - 1); ///< Sub-buckets per power of two above the exact range
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * HALF + HALF; ///< Buckets needed for any uint64_t value
+
+    uint64_t counts[BUCKETS];   ///< Samples per bucket
+    uint64_t total;             ///< Number of recorded samples
+    uint64_t sum;               ///< Sum of recorded samples (for the mean)
+    uint64_t minimum;           ///< Smallest recorded sample
+    uint64_t maximum;           ///< Largest recorded sample
+
+    /**
+     * @brief Maps a value to its bucket
+     * @param value Sample value
+     * @return Bucket index
+     */
+    static size_t bucketOf(uint64_t value) {
+        if (value < (uint64_t(1) << SUB_BITS)) {
+            return static_cast<size_t>(value);
+        }
+        int shift = 63 - __builtin_clzll(value) - (SUB_BITS - 1);
+        return (static_cast<size_t>(shift) << (SUB_BITS - 1)) + static_cast<size_t>(value >> shift);
+    }
+
+    /**
+     * @brief Gets the largest value that maps to a bucket
+     * @param bucket Bucket index
+     * @return Highest value equivalent to the bucket
+     */
+    static uint64_t highestIn(size_t bucket);
+
+public:
+    /**
+     * @brief Constructs an empty histogram
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Records one sample
+     * @param value Sample value
+     */
+    void record(uint64_t value) {
+        counts[bucketOf(value)]++;
+        total++;
+        sum += value;
+        if (value < minimum) minimum = value;
+        if (value > maximum) maximum = value;
+    }
+
+    /**
+     * @brief Adds every sample of another histogram to this one
+     * @param other Histogram to merge in
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Removes all samples
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of recorded samples
+     * @return Sample count
+     */
+    uint64_t count() const { return total; }
+
+    /**
+     * @brief Gets the smallest recorded sample
+     * @return Minimum, or 0 if the histogram is empty
+     */
+    uint64_t min() const { return total ? minimum : 0; }
+
+    /**
+     * @brief Gets the largest recorded sample
+     * @return Maximum, or 0 if the histogram is empty
+     */
+    uint64_t max() const { return maximum; }
+
+    /**
+     * @brief Gets the arithmetic mean of the recorded samples (exact)
+     * @return Mean, or 0 if the histogram is empty
+     */
+    double mean() const { return total ? static_cast<double>(sum) / static_cast<double>(total) : 0.0; }
+
+    /**
+     * @brief Gets the value below or at which a given share of the samples lie
+     * @param percent Percentile in [0, 100], e.g. 99.9
+     * @return Highest value equivalent to the bucket holding that rank (never above max()),
+     *         or 0 if the histogram is empty
+     */
+    uint64_t percentile(double percent) const;
+
+    /**
+     * @brief Counts the samples greater than a value
+     *
+     * Exact for values below 128. Above that, samples that share the value's bucket
+     * are counted as not greater, so the result may be low by up to one bucket.
+     *
+     * @param value Threshold
+     * @return Number of samples above the threshold
+     */
+    uint64_t countAbove(uint64_t value) const;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -7,15 +7,22 @@
  */
 
 #include "LoadBalancer.h"
+#include "IpAddress.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <functional>
 #include <iostream>
-#include <sstream>
 #include <random>
 #include <fstream>
 #include <string>
-#include <chrono>
-#include <ctime>
 
-LoadBalancer::LoadBalancer(int numServers, int initialQueueSize, const std::string& blockedIPsFile) : current_time(0), max_servers(numServers), active_servers(0) {
+LoadBalancer::LoadBalancer(int numServers, int initialQueueSize, const std::string& blockedIPsFile, unsigned int seed,
+                           bool consoleOutput, const WorkloadConfig& workloadConfig, const std::string& filePrefix) 
+    : discipline(QueueDiscipline::Fifo), audit(filePrefix + "firewall_audit.csv"), dispatchPolicy(makeDispatchPolicy("first-idle", 0)), autoscaler(makeAutoscaler("reactive")), admission(makeAdmissionPolicy("none", 0)), current_time(0), max_servers(numServers), active_servers(0),
+      base_seed(seed != 0 ? seed : std::random_device{}()), workload(workloadConfig, base_seed), next_arrival(0), engine(SimulationEngine::Tick), event_sequence(0),
+      tick_arrivals(0), tick_arrival_work(0), scale_ups(0), scale_downs(0), servers_added(0), servers_removed(0),
+      slo_ticks(50), shed_on_arrival(0), shed_at_head(0), peak_queue(0), preemptions(0), producer_count(0), cluster(nullptr), simulationLog(new Logger(filePrefix + "simulation_log.txt", consoleOutput)) {
     // Load blocked IPs first, before generating initial requests
     loadBlockedIPs(blockedIPsFile);
     
@@ -24,299 +31,1587 @@ LoadBalancer::LoadBalancer(int numServers, int initialQueueSize, const std::stri
     
     // Add all servers initially
     for (int i = 0; i < max_servers; ++i) {
-        servers.push_back(new WebServer());
+        dispatchPolicy->serverIdle(servers, servers.add());
         active_servers++;
     }
     
     // Add initial requests - use parameter or default
     int queueSize = (initialQueueSize == -1) ? (max_servers * 100) : initialQueueSize;
     
-    // Random number generators for initial requests
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> ip_part(0, 254);  // Include 0 to match blocked_ips.txt
-    std::uniform_int_distribution<> process_time(1, 10);
-    
+    // Initial requests come from the same address ranges and service times as the traffic
+    requestQueue.reserve(queueSize);
     for (int i = 0; i < queueSize; ++i) { 
-        // Generate random IP addresses
-        std::ostringstream ip_in, ip_out;
-        ip_in << "192.168.1." << ip_part(gen);
-        ip_out << "192.168.1." << ip_part(gen);
-        
-        Request initialRequest(ip_in.str(), ip_out.str(), process_time(gen));
+        Request request = workload.request(current_time);
         
         // Check if the request should be blocked
-        if (isBlocked(initialRequest.getin())) {
-            logBlockedRequest(initialRequest.getin());
+        if (isBlocked(request)) {
+            logBlockedRequest(request);
             continue; // Skip adding this request to the queue
         }
         
-        requestQueue.push(initialRequest);
+        requestQueue.push(request);
     }
+    peak_queue = requestQueue.size();
+    next_arrival = workload.nextTime();
     
     logOutput("LoadBalancer initialized with " + std::to_string(max_servers) + "/" + std::to_string(max_servers) 
               + " servers and " + std::to_string(queueSize) + " initial requests");
 }
 
 LoadBalancer::~LoadBalancer() {
-    // Clean up all allocated WebServers
-    for (WebServer* server : servers) {
-        delete server;
+    // The watcher logs reloads, so it has to stop before the loggers
+    blocklist.stop();
+    
+    // Drain any queued log messages before the writers shut down
+    simulationLog->flush();
+}
+
+void LoadBalancer::addArrivals() {
+    ScopedPhase timer(profiler.get(), ProfilePhase::Arrivals);
+    // enqueueArrival() counts the requests that make it into the queue
+    tick_arrivals = 0;
+    tick_arrival_work = 0;
+    if (replay) {
+        replayArrivals();
+    } else if (ingress) {
+        ingressArrivals();
+    } else if (cluster) {
+        clusterArrivals();
+    } else {
+        addRandomRequest();
+    }
+}
+
+void LoadBalancer::replayArrivals() {
+    Request request;
+    while (replay->nextTime() <= current_time && replay->next(request)) {
+        if (recorder) {
+            recorder->write(request);
+        }
+        if (isBlocked(request)) {
+            logBlockedRequest(request);
+            continue;
+        }
+        if (throttled(request)) {
+            continue;
+        }
+        if (enqueueArrival(request) && simulationLog->enabled(LogLevel::Info)) {
+            logOutput("Time " + std::to_string(current_time) + ": New request added (" 
+                      + request.describe() + ", " + std::to_string(request.gettime()) + " cycles)");
+        }
+    }
+    next_arrival = replay->nextTime();
+}
+
+void LoadBalancer::ingressArrivals() {
+    ingress->collect(current_time, arrival_scratch);
+    for (const Arrival& arrival : arrival_scratch) {
+        // Log exactly what addRandomRequest() logs for the same traffic
+        const Request& request = arrival.request;
+        if (arrival.burst > 1 && arrival.position == 0) {
+            logOutput("Time " + std::to_string(current_time) + ": TRAFFIC SURGE! Adding " 
+                      + std::to_string(arrival.burst) + " requests");
+        }
+        if (recorder) {
+            recorder->write(request);
+        }
+        if (arrival.blocked) {
+            logBlockedRequest(request);
+        } else if (throttled(request)) {
+            // Stateful, so applied here in arrival order rather than on the producers
+        } else if (enqueueArrival(request)) {
+            if (arrival.burst == 1 && simulationLog->enabled(LogLevel::Info)) {
+                logOutput("Time " + std::to_string(current_time) + ": New request added (" 
+                          + request.describe() + ", " + std::to_string(request.gettime()) + " cycles)");
+            }
+        }
+        if (arrival.burst > 1 && arrival.position + 1 == arrival.burst) {
+            logOutput("Time " + std::to_string(current_time) + ": Added " + std::to_string(arrival.burst) 
+                      + " requests to queue");
+        }
+    }
+    next_arrival = ingress->nextTime();
+}
+
+void LoadBalancer::clusterArrivals() {
+    cluster->collect(current_time, cluster_scratch);
+    for (const ClusterArrival& arrival : cluster_scratch) {
+        const Request& request = arrival.request;
+        if (arrival.origin < 0) {
+            if (isBlocked(request)) {
+                logBlockedRequest(request);
+                continue;
+            }
+            if (throttled(request)) {
+                continue;
+            }
+            if (cluster->spill(request, current_time, queuedCount(), servers.capacity())) {
+                if (simulationLog->enabled(LogLevel::Debug)) {
+                    logOutput(LogLevel::Debug, "Time " + std::to_string(current_time) + ": Spilled request (" 
+                              + request.describe() + ") to another node");
+                }
+                continue;
+            }
+        }
+        if (enqueueArrival(request) && simulationLog->enabled(LogLevel::Info)) {
+            logOutput("Time " + std::to_string(current_time) + ": New request added (" + request.describe() + ", " 
+                      + std::to_string(request.gettime()) + " cycles" 
+                      + (arrival.origin < 0 ? ")" : ", spilled by node " + std::to_string(arrival.origin) + ")"));
+        }
+    }
+    next_arrival = cluster->nextTime();
+}
+
+bool LoadBalancer::throttled(const Request& request) {
+    if (!rateLimiter.enabled()) {
+        return false;
+    }
+    uint32_t ip = request.getin();
+    RateVerdict verdict = rateLimiter.check(ip, current_time);
+    if (verdict == RateVerdict::Allow) {
+        return false;
+    }
+    audit.record(ip, verdict == RateVerdict::Blocked ? AuditAction::Blocked : AuditAction::RateLimited, current_time,
+                 request.isIPv6());
+    profileCount(profiler.get(), ProfileCounter::Blocks);
+    if (simulationLog->enabled(LogLevel::Debug)) {
+        logOutput(LogLevel::Debug, verdict == RateVerdict::Blocked
+                  ? "FIREWALL: Blocked request from IP " + request.describeSource() + " (temporary block)"
+                  : "FIREWALL: Rate-limited request from IP " + request.describeSource());
+    }
+    if (verdict == RateVerdict::Promoted) {
+        // Rare enough to log every time
+        audit.record(ip, AuditAction::TemporaryBlock, current_time, request.isIPv6());
+        logOutput("FIREWALL: Temporarily blocked IP " + request.describeSource() + " until time " 
+                  + std::to_string(rateLimiter.blockedUntil(ip)) + " (over its rate limit)");
+    }
+    return true;
+}
+
+bool LoadBalancer::enqueueArrival(const Request& r) {
+    if (!admission->admit(r, queuedCount(), current_time)) {
+        shed_on_arrival++;
+        logShedRequest(r, false);
+        return false;
+    }
+    pushQueued(r);
+    profileCount(profiler.get(), ProfileCounter::Enqueues);
+    peak_queue = std::max(peak_queue, queuedCount());
+    tick_arrivals++;
+    tick_arrival_work += static_cast<uint64_t>(r.gettime());
+    return true;
+}
+
+size_t LoadBalancer::queuedCount() const {
+    return discipline == QueueDiscipline::Fifo ? requestQueue.size() : shortestQueue.size();
+}
+
+const Request& LoadBalancer::nextQueued() const {
+    return discipline == QueueDiscipline::Fifo ? requestQueue.front() : shortestQueue.top();
+}
+
+void LoadBalancer::popQueued() {
+    if (discipline == QueueDiscipline::Fifo) {
+        requestQueue.pop();
+    } else {
+        shortestQueue.pop();
+    }
+}
+
+void LoadBalancer::pushQueued(const Request& r) {
+    if (discipline == QueueDiscipline::Fifo) {
+        requestQueue.push(r);
+    } else {
+        shortestQueue.push(r);
+    }
+}
+
+void LoadBalancer::shedQueueHead() {
+    if (servers.idleCount() == 0) {
+        return;
+    }
+    while (queuedCount() > 0 && admission->dropHead(nextQueued(), current_time)) {
+        const Request& head = nextQueued();
+        shed_at_head++;
+        logShedRequest(head, true);
+        if (admission->tracksDequeues()) {
+            admission->dequeued(head);
+        }
+        popQueued();
+    }
+}
+
+void LoadBalancer::produceTraffic(Ingress::Producer& out, WorkloadGenerator gen) const {
+    // Same draws in the same order as addRandomRequest(), so one producer
+    // continuing the simulation's generator reproduces inline generation.
+    // Only surges count as bursts; the requests of other batches are logged one by one.
+    for (int time = gen.nextTime(); out.reach(time); time = gen.nextTime()) {
+        int requests = gen.batchSize();
+        uint16_t burst = gen.isSurge() ? static_cast<uint16_t>(requests) : 1;
+        for (int r = 0; r < requests; ++r) {
+            Request request = gen.request(time);
+            bool blocked = isBlocked(request);
+            Arrival arrival{request, 0, 0, burst, static_cast<uint16_t>(burst > 1 ? r : 0), blocked};
+            if (!out.push(arrival)) {
+                return;
+            }
+        }
+        gen.advance();
     }
-    servers.clear();
 }
 
 void LoadBalancer::addRandomRequest() {
-    // Random number generator
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> chance(1, 100);
-    static std::uniform_int_distribution<> ip_part(0, 254);  // Include 0 to match blocked_ips.txt
-    static std::uniform_int_distribution<> process_time(1, 10);
-    static std::uniform_int_distribution<> burst_chance(1, 100);
-    
-    // 30% chance to add new request(s) each tick
-    if (chance(gen) <= 30) {
-        int requestsToAdd = 1;
-        
-        // burst of 5 requests
-        if (burst_chance(gen) <= 1) {
-            requestsToAdd = 5;
-            logOutput("Time " + std::to_string(current_time) + ": TRAFFIC SURGE! Adding 5 requests");
+    if (current_time >= next_arrival) {
+        int requestsToAdd = workload.batchSize();
+        bool surge = workload.isSurge();
+        if (surge) {
+            logOutput("Time " + std::to_string(current_time) + ": TRAFFIC SURGE! Adding " 
+                      + std::to_string(requestsToAdd) + " requests");
         }
         
         for (int r = 0; r < requestsToAdd; ++r) {
-            // Generate random IP addresses in 192.168.1.xxx
-            std::ostringstream ip_in, ip_out;
-            ip_in << "192.168.1." << ip_part(gen);
-            ip_out << "192.168.1." << ip_part(gen);
-            
             // Create and enqueue new request
-            Request newRequest(ip_in.str(), ip_out.str(), process_time(gen));
+            const Request newRequest = workload.request(current_time);
+            
+            if (recorder) {
+                recorder->write(newRequest);
+            }
             
             // Check if the request should be blocked
-            if (isBlocked(newRequest.getin())) {
-                logBlockedRequest(newRequest.getin());
+            if (isBlocked(newRequest)) {
+                logBlockedRequest(newRequest);
                 continue; // Skip adding this request to the queue
             }
             
-            requestQueue.push(newRequest);
+            if (throttled(newRequest) || !enqueueArrival(newRequest)) {
+                continue;
+            }
             
-            if (requestsToAdd == 1) {
-                // Normal single request - show details
+            if (!surge && simulationLog->enabled(LogLevel::Info)) {
+                // Normal request - show details
                 logOutput("Time " + std::to_string(current_time) + ": New request added (" 
-                          + ip_in.str() + " -> " + ip_out.str() 
+                          + newRequest.describe() 
                           + ", " + std::to_string(newRequest.gettime()) + " cycles)");
             }
         }
         
-        if (requestsToAdd > 1) {
+        if (surge) {
             logOutput("Time " + std::to_string(current_time) + ": Added " + std::to_string(requestsToAdd) 
                       + " requests to queue");
         }
+        workload.advance();
+        next_arrival = workload.nextTime();
     }
 }
 
 void LoadBalancer::tick() {
+    ScopedPhase timer(profiler.get(), ProfilePhase::Tick);
     current_time++;
+    servers.setTime(current_time);
+    if (PROFILING && profiler) {
+        profiler->setTick(current_time);
+    }
+    
     logOutput("\n--- Time " + std::to_string(current_time) + " ---");
     
+    // Per-server lines are only formatted when debug output is enabled
+    bool verbose = simulationLog->enabled(LogLevel::Debug);
+    
     // 1. Possibly add a new Request (random chance)
-    addRandomRequest();
+    addArrivals();
     
     // 2. Manage server load (dynamic scaling)
     manageServerLoad();
     
-    // 3. For each WebServer:
-    for (size_t i = 0; i < servers.size(); ++i) {
-        WebServer* server = servers[i];
+    // Sojourn-based policies may drop requests that are about to be served
+    ScopedPhase serverTimer(profiler.get(), ProfilePhase::Servers);
+    shedQueueHead();
+    
+    if (workers && discipline != QueueDiscipline::ShortestRemaining) {
+        // 3. Same as below, one shard of the pool per task
+        shardedStep(verbose);
+    } else {
+        // 3a. Busy servers tick down time_remaining; finishers stay busy until 3c so
+        // they do not pick up new work on the tick they finish
+        servers.countdown(finished_scratch);
         
-        if (server->isbusy()) {
-            // Get current request info before ticking
-            Request currentRequest = server->getcurr();
-            
-            // a. If it's busy: tick down time_remaining
-            server->tick();
-            
-            // Check if server just finished
-            if (!server->isbusy()) {
-                logOutput("Server " + std::to_string(i) + ": Completed request (" 
-                          + currentRequest.getin() + " -> " + currentRequest.getout() 
-                          + ")!");
+        // 3b. Servers that were idle at the start of the tick take the next requests in the queue
+        dispatchToIdle(verbose ? &assigned_scratch : nullptr, false);
+        if (discipline == QueueDiscipline::ShortestRemaining) {
+            preemptLongest(verbose ? &assigned_scratch : nullptr, false);
+        }
+        
+        if (verbose) {
+            logServerStates(finished_scratch, assigned_scratch, true);
+        }
+        
+        // 3c. Finished servers become idle
+        for (size_t w = 0; w < finished_scratch.size(); ++w) {
+            for (uint64_t bits = finished_scratch[w]; bits; bits &= bits - 1) {
+                finishRequest(w * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+    
+    logTickSummary();
+}
+
+void LoadBalancer::dispatchToIdle(std::vector<uint64_t>* assigned, bool schedule) {
+    if (assigned) {
+        assigned->assign(servers.wordCount(), 0);
+    }
+    
+    while (queuedCount() > 0 && servers.idleCount() > 0) {
+        const Request& request = nextQueued();
+        long i = dispatchPolicy->select(servers, request);
+        if (i < 0) {
+            break;
+        }
+        servers.assign(i, request);
+        dispatchPolicy->serverAssigned(servers, i, request);
+        profileCount(profiler.get(), ProfileCounter::Dispatches);
+        if (!servers.isBusy(i)) {
+            dispatchPolicy->serverIdle(servers, i);      // a multi-slot server with room left
+        }
+        if (admission->tracksDequeues()) {
+            admission->dequeued(request);
+        }
+        popQueued();
+        
+        if (assigned) {
+            (*assigned)[i >> 6] |= 1ULL << (i & 63);
+        }
+        if (schedule) {
+            scheduleCompletion(i);
+        }
+        trackPreemptible(i);
+    }
+}
+
+void LoadBalancer::preemptLongest(std::vector<uint64_t>* assigned, bool schedule) {
+    // Requests started on this tick are left alone, so none is preempted twice; their
+    // servers are set aside and go back once the queue has been served
+    std::vector<size_t> started;
+    while (!shortestQueue.empty() && servers.idleCount() == 0 && !preemptible.empty()) {
+        // The busy single-slot server with the most work left is on top; the lowest
+        // index wins ties. Multi-slot servers are never full with a single request, so
+        // they are not candidates
+        size_t longest = preemptible.top();
+        if (servers.startTime(longest) == current_time) {
+            preemptible.erase(longest);
+            started.push_back(longest);
+            continue;
+        }
+        // The event engine does not count servers down; their completion time is fixed
+        int most = schedule ? servers.startTime(longest) + servers.timeLeft(longest) - current_time
+                            : servers.timeLeft(longest);
+        const Request next = shortestQueue.top();
+        if (most <= next.gettime()) {
+            break;
+        }
+        
+        Request displaced = servers.preempt(longest, most);
+        preemptible.erase(longest);
+        dispatchPolicy->serverIdle(servers, longest);
+        preemptions++;
+        if (simulationLog->enabled(LogLevel::Debug)) {
+            logOutput(LogLevel::Debug, "Server " + std::to_string(longest) + ": Preempted request (" 
+                      + displaced.describe() + "), " + std::to_string(most) + " cycles remaining");
+        }
+        if (schedule) {
+            single_completions.erase(longest);
+        }
+        
+        servers.assign(longest, next);
+        dispatchPolicy->serverAssigned(servers, longest, next);
+        profileCount(profiler.get(), ProfileCounter::Dispatches);
+        shortestQueue.pop();
+        shortestQueue.push(displaced);
+        if (admission->tracksDequeues()) {
+            admission->dequeued(next);
+            admission->requeued(displaced);
+        }
+        if (assigned) {
+            (*assigned)[longest >> 6] |= 1ULL << (longest & 63);
+        }
+        if (schedule) {
+            scheduleCompletion(longest);
+        }
+        trackPreemptible(longest);
+    }
+    for (size_t index : started) {
+        preemptible.push(index);
+    }
+}
+
+void LoadBalancer::trackPreemptible(size_t index) {
+    if (discipline != QueueDiscipline::ShortestRemaining || servers.concurrency(index) > 1) {
+        return;
+    }
+    // Every running server counts down one cycle per tick, so the completion tick
+    // keeps the candidates in order without touching them; the latest comes out first
+    preemptible.erase(index);
+    preemptible.setKey(index, static_cast<uint64_t>(INT_MAX - (current_time + servers.timeLeft(index))));
+    preemptible.push(index);
+}
+
+void LoadBalancer::resetPreemptible() {
+    preemptible.clear();
+    for (size_t i = 0; i < servers.slotCount(); ++i) {
+        if (servers.isRunning(i)) {
+            trackPreemptible(i);
+        }
+    }
+}
+
+void LoadBalancer::scheduleCompletion(size_t index) {
+    int time = current_time + servers.timeLeft(index);
+    if (servers.concurrency(index) > 1) {
+        completions.push_back(CompletionEvent{time, event_sequence++, index});
+        std::push_heap(completions.begin(), completions.end(), std::greater<CompletionEvent>());
+        return;
+    }
+    // A single-slot server has one completion at a time, so a preemption can take it
+    // out by position
+    event_sequence++;
+    single_completions.erase(index);
+    single_completions.setKey(index, static_cast<uint64_t>(time));
+    single_completions.push(index);
+}
+
+void LoadBalancer::finishRequest(size_t index) {
+    if (servers.concurrency(index) == 1) {
+        recordLatency(index, waitLatency, serviceLatency, sojournLatency);
+        servers.complete(index);
+        preemptible.erase(index);
+        profileCount(profiler.get(), ProfileCounter::Completions);
+        dispatchPolicy->serverIdle(servers, index);
+        return;
+    }
+    // A multi-slot server finishes every request that is due, earliest first, and is
+    // reported idle again even if it already had room, so load-ranking policies see
+    // the requests it no longer runs
+    while (servers.isDue(index)) {
+        recordLatency(index, waitLatency, serviceLatency, sojournLatency);
+        servers.complete(index);
+        profileCount(profiler.get(), ProfileCounter::Completions);
+    }
+    if (!servers.isBusy(index)) {
+        dispatchPolicy->serverIdle(servers, index);
+    }
+}
+
+void LoadBalancer::recordLatency(size_t index, LatencyHistogram& wait, LatencyHistogram& service,
+                                 LatencyHistogram& sojourn) const {
+    const Request& request = servers.request(index);
+    int started = servers.startTime(index);
+    wait.record(static_cast<uint64_t>(started - request.getenqueued()));
+    service.record(static_cast<uint64_t>(current_time - started));
+    sojourn.record(static_cast<uint64_t>(current_time - request.getenqueued()));
+}
+
+void LoadBalancer::shardedStep(bool verbose) {
+    const size_t words = servers.wordCount();
+    const size_t chunk = std::max<size_t>(1, words / (workers->size() * 4));   // a few shards per thread
+    const size_t shards = (words + chunk - 1) / chunk;
+    finished_scratch.resize(words);
+    if (verbose) {
+        assigned_scratch.assign(words, 0);
+    }
+    shard_offset.assign(shards + 1, 0);
+    shard_delta.assign(shards, 0);
+    shard_units.assign(shards, 0);
+    
+    // 3a. Count down, and count the servers that are idle at the start of the tick
+    workers->run(shards, [&](size_t shard, size_t) {
+        size_t first = shard * chunk, last = std::min(words, first + chunk);
+        servers.countdown(finished_scratch, first, last);
+        shard_offset[shard + 1] = servers.idleCount(first, last);
+    });
+    
+    // Idle servers take queued requests in index order, so each shard's share of the
+    // queue starts where the idle servers of the shards before it end
+    for (size_t s = 0; s < shards; ++s) {
+        shard_offset[s + 1] += shard_offset[s];
+    }
+    if (discipline != QueueDiscipline::Fifo) {
+        // The heap has no positions; line up the requests this tick hands out
+        for (size_t n = std::min(shortestQueue.size(), shard_offset[shards]); n > 0; --n) {
+            requestQueue.push(shortestQueue.top());
+            shortestQueue.pop();
+        }
+    }
+    const size_t taken = std::min(requestQueue.size(), shard_offset[shards]);
+    
+    // 3b. Idle servers take their requests
+    auto assign = [&](size_t shard, size_t worker) {
+        size_t end = std::min(words, (shard + 1) * chunk) * 64;
+        size_t position = shard_offset[shard];
+        for (long i = servers.findIdle(shard * chunk * 64, end); i >= 0 && position < taken;
+             i = servers.findIdle(i + 1, end)) {
+            servers.startSlot(i, requestQueue.at(position++));
+            shard_units[shard] += servers.capacityUnits(i);
+            if (verbose) {
+                assigned_scratch[i >> 6] |= 1ULL << (i & 63);
+            }
+        }
+        shard_delta[shard] += static_cast<long>(position - shard_offset[shard]);
+        profileCount(profiler.get(), ProfileCounter::Dispatches, worker, position - shard_offset[shard]);
+    };
+    
+    // 3c. Finished servers become idle; latencies go to the worker's own histograms
+    auto finish = [&](size_t shard, size_t worker) {
+        LatencyHistogram* latency = &worker_latency[worker * 3];
+        size_t last = std::min(words, (shard + 1) * chunk);
+        for (size_t w = shard * chunk; w < last; ++w) {
+            for (uint64_t bits = finished_scratch[w]; bits; bits &= bits - 1) {
+                size_t index = w * 64 + __builtin_ctzll(bits);
+                recordLatency(index, latency[0], latency[1], latency[2]);
+                servers.finishSlot(index);
+                shard_delta[shard]--;
+                shard_units[shard] -= servers.capacityUnits(index);
+                profileCount(profiler.get(), ProfileCounter::Completions, worker);
+            }
+        }
+    };
+    
+    if (verbose) {
+        workers->run(shards, assign);
+        logServerStates(finished_scratch, assigned_scratch, true);
+        workers->run(shards, finish);
+    } else {
+        workers->run(shards, [&](size_t shard, size_t worker) {
+            assign(shard, worker);
+            finish(shard, worker);
+        });
+    }
+    
+    if (admission->tracksDequeues()) {
+        for (size_t i = 0; i < taken; ++i) {
+            admission->dequeued(requestQueue.at(i));
+        }
+    }
+    requestQueue.pop(taken);
+    long delta = 0, units = 0;
+    for (size_t shard = 0; shard < shards; ++shard) {
+        delta += shard_delta[shard];
+        units += shard_units[shard];
+    }
+    servers.commitSlots(delta, units);
+}
+
+void LoadBalancer::collectLatency() {
+    for (size_t w = 0; w + 2 < worker_latency.size(); w += 3) {
+        waitLatency.merge(worker_latency[w]);
+        serviceLatency.merge(worker_latency[w + 1]);
+        sojournLatency.merge(worker_latency[w + 2]);
+        worker_latency[w].clear();
+        worker_latency[w + 1].clear();
+        worker_latency[w + 2].clear();
+    }
+}
+
+void LoadBalancer::logStatistics() const {
+    char line[256];
+    logOutput("Latency of " + std::to_string(sojournLatency.count()) + " completed requests (ticks):");
+    const std::pair<const char*, const LatencyHistogram*> rows[] = {
+        {"wait", &waitLatency}, {"service", &serviceLatency}, {"sojourn", &sojournLatency}
+    };
+    for (const auto& row : rows) {
+        const LatencyHistogram& h = *row.second;
+        std::snprintf(line, sizeof(line), "  %-8s mean %.2f  p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu",
+                      row.first, h.mean(), 
+                      static_cast<unsigned long long>(h.percentile(50.0)),
+                      static_cast<unsigned long long>(h.percentile(90.0)),
+                      static_cast<unsigned long long>(h.percentile(99.0)),
+                      static_cast<unsigned long long>(h.percentile(99.9)),
+                      static_cast<unsigned long long>(h.max()));
+        logOutput(line);
+    }
+    
+    // Utilization is busy time over time present in the pool (per request slot for
+    // multi-slot servers); slots that never held a server for a full tick are left out
+    size_t counted = 0;
+    uint64_t serverTicks = 0;
+    double total = 0.0;
+    double capacityTicks = 0.0, usedTicks = 0.0;
+    double lowest = 2.0, highest = -1.0;
+    size_t lowestServer = 0, highestServer = 0;
+    bool verbose = simulationLog->enabled(LogLevel::Debug);
+    for (size_t i = 0; i < servers.slotCount(); ++i) {
+        uint64_t present = servers.presentTime(i);
+        if (present == 0) {
+            continue;
+        }
+        double utilization = static_cast<double>(servers.busyTime(i)) 
+                             / (static_cast<double>(present) * servers.concurrency(i));
+        counted++;
+        serverTicks += present;
+        total += utilization;
+        capacityTicks += static_cast<double>(present) * servers.capacityUnits(i);
+        usedTicks += utilization * static_cast<double>(present) * servers.capacityUnits(i);
+        if (utilization < lowest) {
+            lowest = utilization;
+            lowestServer = i;
+        }
+        if (utilization > highest) {
+            highest = utilization;
+            highestServer = i;
+        }
+        if (verbose) {
+            std::snprintf(line, sizeof(line), "Server %zu: %llu requests, busy %llu of %llu ticks (%.1f%%)", i,
+                          static_cast<unsigned long long>(servers.servedCount(i)),
+                          static_cast<unsigned long long>(servers.busyTime(i)),
+                          static_cast<unsigned long long>(present), 100.0 * utilization);
+            logOutput(LogLevel::Debug, line);
+        }
+    }
+    if (counted > 0) {
+        std::snprintf(line, sizeof(line), 
+                      "Server utilization over %zu servers: mean %.1f%%, min %.1f%% (server %zu), max %.1f%% (server %zu)",
+                      counted, 100.0 * total / counted, 100.0 * lowest, lowestServer, 100.0 * highest, highestServer);
+        logOutput(line);
+    }
+    const std::vector<ServerProfile>& fleet = servers.getFleet();
+    if (fleet.size() > 1 || fleet[0].slots != 1 || fleet[0].speed != 1.0) {
+        std::snprintf(line, sizeof(line), "Fleet %s: capacity %.2f cycles/tick, %zu free request slots, "
+                      "capacity-weighted utilization %.1f%%", formatFleet(fleet).c_str(), servers.capacity(),
+                      servers.freeCount(), capacityTicks > 0.0 ? 100.0 * usedTicks / capacityTicks : 0.0);
+        logOutput(line);
+    }
+    
+    // Cost against latency: server-ticks paid for and requests that missed the objective
+    std::snprintf(line, sizeof(line), "%llu scale-ups (+%llu servers), %llu scale-downs (-%llu servers), %llu server-ticks",
+                  static_cast<unsigned long long>(scale_ups), static_cast<unsigned long long>(servers_added),
+                  static_cast<unsigned long long>(scale_downs), static_cast<unsigned long long>(servers_removed),
+                  static_cast<unsigned long long>(serverTicks));
+    logOutput("Scaling (" + autoscaler->name() + "): " + line);
+    uint64_t violations = sojournLatency.countAbove(static_cast<uint64_t>(slo_ticks));
+    double share = sojournLatency.count() ? 100.0 * violations / sojournLatency.count() : 0.0;
+    std::snprintf(line, sizeof(line), "SLO (sojourn <= %d ticks): %llu of %llu requests violated it (%.2f%%)", slo_ticks,
+                  static_cast<unsigned long long>(violations),
+                  static_cast<unsigned long long>(sojournLatency.count()), share);
+    logOutput(line);
+    if (provisioner.enabled()) {
+        std::snprintf(line, sizeof(line), 
+                      "Provisioning: %llu scale-ups from standby, %llu cold starts, %llu standby server-ticks, "
+                      "%llu booting server-ticks",
+                      static_cast<unsigned long long>(provisioner.standbyDraws()),
+                      static_cast<unsigned long long>(provisioner.coldStarts()),
+                      static_cast<unsigned long long>(provisioner.standbyTicks(current_time)),
+                      static_cast<unsigned long long>(provisioner.bootingTicks(current_time)));
+        logOutput(line);
+    }
+    std::snprintf(line, sizeof(line), 
+                  "%llu requests shed (%llu on arrival, %llu from the head of the queue), peak queue length %zu",
+                  static_cast<unsigned long long>(shed_on_arrival + shed_at_head),
+                  static_cast<unsigned long long>(shed_on_arrival),
+                  static_cast<unsigned long long>(shed_at_head), peak_queue);
+    logOutput("Admission (" + admission->name() + "): " + line);
+    if (rateLimiter.enabled()) {
+        std::snprintf(line, sizeof(line), 
+                      "Rate limiting: %llu requests limited, %llu dropped by %llu temporary blocks, "
+                      "%zu sources tracked (%llu evicted)",
+                      static_cast<unsigned long long>(rateLimiter.limitedCount()),
+                      static_cast<unsigned long long>(rateLimiter.blockedCount()),
+                      static_cast<unsigned long long>(rateLimiter.promotionCount()), rateLimiter.size(),
+                      static_cast<unsigned long long>(rateLimiter.evictionCount()));
+        logOutput(line);
+    }
+    std::snprintf(line, sizeof(line), 
+                  "Firewall audit: %llu blocked, %llu rate limited, %llu temporary blocks, %llu shed; "
+                  "%llu records in %s (%d-tick windows, %llu rotations)",
+                  static_cast<unsigned long long>(audit.total(AuditAction::Blocked)),
+                  static_cast<unsigned long long>(audit.total(AuditAction::RateLimited)),
+                  static_cast<unsigned long long>(audit.total(AuditAction::TemporaryBlock)),
+                  static_cast<unsigned long long>(audit.total(AuditAction::Shed)),
+                  static_cast<unsigned long long>(audit.recordCount()), audit.getPath().c_str(),
+                  audit.getSettings().window, static_cast<unsigned long long>(audit.rotationCount()));
+    logOutput(line);
+    if (discipline != QueueDiscipline::Fifo) {
+        std::snprintf(line, sizeof(line), "Queue discipline (%s, aging %d): %llu preemptions",
+                      discipline == QueueDiscipline::ShortestFirst ? "sjf" : "srpt", shortestQueue.getAging(),
+                      static_cast<unsigned long long>(preemptions));
+        logOutput(line);
+    }
+}
+
+void LoadBalancer::logTickSummary() const {
+    logOutput("Queue size: " + std::to_string(queuedCount())
+              + " | Active servers: " + std::to_string(active_servers) + "/" + std::to_string(max_servers)
+              + " | Idle servers: " + std::to_string(getIdleServerCount()));
+}
+
+void LoadBalancer::logServerStates(const std::vector<uint64_t>& finished, const std::vector<uint64_t>& assigned,
+                                   bool unchanged) const {
+    for (size_t i = 0; i < servers.slotCount(); ++i) {
+        if (!servers.isActive(i)) {
+            continue;
+        }
+        uint64_t bit = 1ULL << (i & 63);
+        const Request& request = servers.request(i);
+        if (servers.concurrency(i) > 1 && ((assigned[i >> 6] & bit) || (unchanged && !(finished[i >> 6] & bit)))) {
+            // Several requests share the server; summarize them
+            if (assigned[i >> 6] & bit) {
+                logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Assigned new request(s), " 
+                          + std::to_string(servers.inFlight(i)) + "/" + std::to_string(servers.concurrency(i)) 
+                          + " slots in use");
+            } else if (servers.isRunning(i)) {
+                logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Processing " 
+                          + std::to_string(servers.inFlight(i)) + "/" + std::to_string(servers.concurrency(i)) 
+                          + " requests, next completes in " 
+                          + std::to_string(servers.completionTime(i) - current_time) + " cycles");
             } else {
-                logOutput("Server " + std::to_string(i) + ": Processing request (" 
-                          + currentRequest.getin() + " -> " + currentRequest.getout() 
-                          + "), " + std::to_string(server->gettimeleft()) + " cycles remaining");
+                logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Idle");
             }
+        } else if (assigned[i >> 6] & bit) {
+            logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Assigned new request (" 
+                      + request.describe() + ", " + std::to_string(request.gettime()) + " cycles)");
+        } else if (finished[i >> 6] & bit) {
+            logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Completed request (" 
+                      + request.describe() + ")!");
+        } else if (!unchanged) {
+            continue;
+        } else if (servers.isBusy(i)) {
+            logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Processing request (" 
+                      + request.describe() + "), " + std::to_string(servers.timeLeft(i)) 
+                      + " cycles remaining");
         } else {
-            // b. If it's free: assign it the next request in the queue
-            if (!requestQueue.empty()) {
-                Request nextRequest = requestQueue.front();
-                requestQueue.pop();
-                server->assignrequest(nextRequest);
-                
-                logOutput("Server " + std::to_string(i) + ": Assigned new request (" 
-                          + nextRequest.getin() + " -> " + nextRequest.getout() 
-                          + ", " + std::to_string(nextRequest.gettime()) + " cycles)");
-            } else {
-                logOutput("Server " + std::to_string(i) + ": Idle");
+            logOutput(LogLevel::Debug, "Server " + std::to_string(i) + ": Idle");
+        }
+    }
+}
+
+void LoadBalancer::eventTick() {
+    ScopedPhase timer(profiler.get(), ProfilePhase::Tick);
+    current_time++;
+    servers.setTime(current_time);
+    if (PROFILING && profiler) {
+        profiler->setTick(current_time);
+    }
+    
+    logOutput("\n--- Time " + std::to_string(current_time) + " ---");
+    
+    // Per-server lines are only formatted when debug output is enabled
+    bool verbose = simulationLog->enabled(LogLevel::Debug);
+    
+    // 1. Arrivals, 2. scaling and head drops are shared with the tick engine
+    addArrivals();
+    manageServerLoad();
+    ScopedPhase serverTimer(profiler.get(), ProfilePhase::Servers);
+    shedQueueHead();
+    
+    // 3a. Servers that were idle at the start of the tick take queued requests in
+    // the dispatch policy's order, exactly as the tick engine hands them out
+    dispatchToIdle(verbose ? &assigned_scratch : nullptr, true);
+    if (discipline == QueueDiscipline::ShortestRemaining) {
+        preemptLongest(verbose ? &assigned_scratch : nullptr, true);
+    }
+    
+    // 3b. Requests scheduled to finish on this tick complete
+    if (verbose) {
+        finished_scratch.assign(servers.wordCount(), 0);
+    }
+    // A multi-slot server's completion moves when it takes another request, so its
+    // events may be stale (nothing due) or repeated
+    std::vector<size_t> finishing;
+    while (!single_completions.empty() && single_completions.key(single_completions.top()) == static_cast<uint64_t>(current_time)) {
+        finishing.push_back(single_completions.top());
+        single_completions.erase(single_completions.top());
+    }
+    while (!completions.empty() && completions.front().time == current_time) {
+        size_t index = completions.front().server;
+        if (servers.isDue(index)) {
+            finishing.push_back(index);
+        }
+        std::pop_heap(completions.begin(), completions.end(), std::greater<CompletionEvent>());
+        completions.pop_back();
+    }
+    if (verbose) {
+        // Only servers with an event this tick are reported; the event engine does
+        // not track the countdown of the others
+        for (size_t index : finishing) {
+            finished_scratch[index >> 6] |= 1ULL << (index & 63);
+        }
+        logServerStates(finished_scratch, assigned_scratch, false);
+    }
+    // Complete in index order like the tick engine's bitmap walk, so both engines
+    // leave the idle list in the same order
+    std::sort(finishing.begin(), finishing.end());
+    finishing.erase(std::unique(finishing.begin(), finishing.end()), finishing.end());
+    for (size_t index : finishing) {
+        finishRequest(index);
+        if (servers.isRunning(index)) {
+            completions.push_back(CompletionEvent{servers.completionTime(index), event_sequence++, index});
+            std::push_heap(completions.begin(), completions.end(), std::greater<CompletionEvent>());
+        }
+    }
+    
+    logTickSummary();
+}
+
+void LoadBalancer::runEvents(int totalTime) {
+    int end_time = current_time + totalTime;
+    
+    // Seed the heap with servers that are already busy (e.g. from an earlier tick run)
+    completions.clear();
+    single_completions.clear();
+    for (size_t i = 0; i < servers.slotCount(); ++i) {
+        if (servers.isRunning(i)) {
+            scheduleCompletion(i);
+        }
+    }
+    
+    bool started = true;    // servers may have started on the current tick before this call
+    while (current_time < end_time) {
+        // A tick is quiet when nothing arrives, nothing completes, no idle server can
+        // take a queued request and the scaler would not act; servers only count down,
+        // which the completion times already account for, so such ticks are skipped
+        // The autoscaler still has to observe the skipped ticks, and may act on one
+        // Under SRPT, requests that started on the last tick become preemptible on the next
+        bool pendingAssignment = queuedCount() > 0 && servers.idleCount() > 0;
+        bool pendingPreemption = discipline == QueueDiscipline::ShortestRemaining && started && queuedCount() > 0;
+        if (!pendingAssignment && !pendingPreemption) {
+            int next_event = std::min(next_arrival, end_time);
+            if (!completions.empty()) {
+                next_event = std::min(next_event, completions.front().time);
+            }
+            if (!single_completions.empty()) {
+                next_event = std::min(next_event, static_cast<int>(single_completions.key(single_completions.top())));
+            }
+            next_event = std::min(next_event, provisioner.nextEvent());
+            if (next_event - 1 > current_time) {
+                ScalingSignals quiet = scalingSignals();
+                quiet.time = current_time + 1;
+                quiet.arrivals = quiet.arrival_work = 0;
+                int skipped = autoscaler->quietTicks(quiet, next_event - 1 - current_time);
+                if (simulationLog->enabled(LogLevel::Info)) {
+                    // Nothing changes on a skipped tick, so each repeats the last summary
+                    for (int i = 0; i < skipped; ++i) {
+                        current_time++;
+                        logOutput("\n--- Time " + std::to_string(current_time) + " ---");
+                        logTickSummary();
+                    }
+                } else {
+                    current_time += skipped;
+                }
             }
         }
+        uint64_t scheduled = event_sequence;
+        eventTick();
+        started = event_sequence != scheduled;
     }
     
-    int idle_servers = getIdleServerCount();
-    logOutput("Queue size: " + std::to_string(requestQueue.size()) 
-              + " | Active servers: " + std::to_string(active_servers) + "/" + std::to_string(max_servers)
-              + " | Idle servers: " + std::to_string(idle_servers));
+    // Bring every server's remaining time up to date so the tick engine (or any
+    // inspection of the servers) can continue from here
+    for (const CompletionEvent& event : completions) {
+        servers.advance(event.server, servers.timeLeft(event.server) - (event.time - current_time));
+    }
+    for (size_t i = 0; i < servers.slotCount(); ++i) {
+        if (single_completions.contains(i)) {
+            int time = static_cast<int>(single_completions.key(i));
+            servers.advance(i, servers.timeLeft(i) - (time - current_time));
+        }
+    }
+    completions.clear();
+    single_completions.clear();
 }
 
 void LoadBalancer::run(int totalTime) {
     logOutput("Starting Load Balancer simulation with " + std::to_string(servers.size()) 
-              + " servers for " + std::to_string(totalTime) + " ticks.\n");
+              + " servers for " + std::to_string(totalTime) + " ticks (dispatch policy: "
+              + dispatchPolicy->name() + ").\n");
+    
+    if (producer_count > 0 && !replay) {
+        // A single producer continues the simulation's generator. With more, each jumps
+        // to a stream of its own and has an equal share of the arrival rate.
+        std::vector<WorkloadGenerator> sources;
+        for (int p = 0; p < producer_count; ++p) {
+            WorkloadGenerator source = workload;
+            if (producer_count > 1) {
+                source.split(static_cast<unsigned int>(p), 1.0 / producer_count, current_time);
+            }
+            sources.push_back(source);
+        }
+        ingress.reset(new Ingress());
+        ingress->start(producer_count, current_time, [this, sources](Ingress::Producer& out) {
+            produceTraffic(out, sources[out.number()]);
+        });
+        next_arrival = ingress->nextTime();
+    }
     
-    for (int t = 0; t < totalTime; ++t) {
-        tick();
+    if (PROFILING && profiler) {
+        profiler->begin(workers ? workers->size() : 1);
+    }
+    advance(totalTime);
+    bool profiled = PROFILING && profiler && profiler->finish();
+    if (ingress) {
+        ingress->stop();
+        ingress.reset();
     }
 
     // std::cout << "\n=== Processing remaining requests ===" << std::endl;
     // while (!requestQueue.empty() || hasActiveTasks()) {
     //     tick();
     // }
-        
+    
+    report();
+    if (PROFILING && profiler) {
+        const std::string& prefix = profiler->outputPrefix();
+        if (profiled) {
+            logOutput("Wrote the profile to " + prefix + ".json and the timeline to " + prefix + ".trace.json");
+        } else {
+            logOutput(LogLevel::Error, "ERROR: Could not write the profile to " + prefix + ".json");
+        }
+        simulationLog->flush();
+    }
+}
+
+void LoadBalancer::advance(int ticks) {
+    if (cluster) {
+        next_arrival = cluster->nextTime();     // deliveries may have been added since the last call
+    }
+    if (engine == SimulationEngine::Event) {
+        runEvents(ticks);
+    } else {
+        for (int t = 0; t < ticks; ++t) {
+            tick();
+        }
+    }
+}
+
+void LoadBalancer::report() {
     logOutput("\nSimulation complete!");
-    logOutput("Requests remaining in queue: " + std::to_string(requestQueue.size()));
+    logOutput("Requests remaining in queue: " + std::to_string(queuedCount()));
+    
+    logOutput("Servers still busy: " + std::to_string(servers.runningCount()) + "/" + std::to_string(servers.size()));
+    collectLatency();
+    audit.flush(current_time);
+    logStatistics();
     
-    int busyCount = 0;
-    for (const WebServer* server : servers) {
-        if (server->isbusy()) busyCount++;
+    if (replay) {
+        logOutput("Replayed " + std::to_string(replay->count()) + " requests from the trace");
+        if (!replay->error().empty()) {
+            logOutput(LogLevel::Error, "ERROR: " + replay->error());
+        }
     }
-    logOutput("Servers still busy: " + std::to_string(busyCount) + "/" + std::to_string(servers.size()));
+    if (recorder) {
+        uint64_t recorded = recorder->count();
+        if (recorder->close()) {
+            logOutput("Recorded " + std::to_string(recorded) + " requests to the trace");
+        } else {
+            logOutput(LogLevel::Error, "ERROR: " + recorder->error());
+        }
+        recorder.reset();
+    }
+    simulationLog->flush();
 }
 
-bool LoadBalancer::hasActiveTasks() const {
-    for (const WebServer* server : servers) {
-        if (server->isbusy()) {
-            return true;
+bool LoadBalancer::runProxy(const ProxySettings& settings) {
+    std::string backends;
+    for (const ProxyBackend& b : settings.backends) {
+        backends += (backends.empty() ? "" : ", ") + formatIPv4(b.address) + ":" + std::to_string(b.port);
+    }
+    logOutput("Starting proxy on " + formatIPv4(settings.listen_address) + ":" + std::to_string(settings.listen_port)
+              + " with " + std::to_string(settings.workers) + " worker(s) for " + backends + " (dispatch policy: "
+              + settings.policy + ", " + std::to_string(settings.slots) + " connections per backend per worker).");
+
+    Proxy proxy(settings, blocklist);
+    std::string error;
+    if (!proxy.run(error)) {
+        logOutput(LogLevel::Error, "ERROR: " + error);
+        simulationLog->flush();
+        return false;
+    }
+
+    const ProxyStats& stats = proxy.getStats();
+    logOutput("\nProxy stopped.");
+    logOutput("Connections: " + std::to_string(stats.accepted) + " accepted, " + std::to_string(stats.blocked)
+              + " blocked by the firewall, " + std::to_string(stats.rejected) + " rejected (backlog full), "
+              + std::to_string(stats.failed) + " failed (backend unreachable)");
+    logOutput("Backend connections: " + std::to_string(stats.connects) + " opened, " + std::to_string(stats.reused)
+              + " sessions on pooled connections");
+    for (size_t b = 0; b < settings.backends.size(); ++b) {
+        logOutput("  " + formatIPv4(settings.backends[b].address) + ":" + std::to_string(settings.backends[b].port)
+                  + ": " + std::to_string(stats.per_backend[b]) + " sessions");
+    }
+    logOutput("Relayed: " + std::to_string(stats.bytes_up) + " bytes to backends, " + std::to_string(stats.bytes_down)
+              + " bytes to clients");
+    simulationLog->flush();
+    return true;
+}
+
+RunSummary LoadBalancer::getSummary() const {
+    RunSummary summary;
+    summary.wait = waitLatency;
+    summary.service = serviceLatency;
+    summary.sojourn = sojournLatency;
+    for (size_t w = 0; w + 2 < worker_latency.size(); w += 3) {
+        summary.wait.merge(worker_latency[w]);
+        summary.service.merge(worker_latency[w + 1]);
+        summary.sojourn.merge(worker_latency[w + 2]);
+    }
+    summary.server_ticks = serverTicks();
+    summary.scale_ups = scale_ups;
+    summary.scale_downs = scale_downs;
+    summary.servers_added = servers_added;
+    summary.servers_removed = servers_removed;
+    summary.blocked = audit.total(AuditAction::Blocked) + audit.total(AuditAction::RateLimited);
+    summary.shed = shed_on_arrival + shed_at_head;
+    summary.queued = queuedCount();
+    summary.active = active_servers;
+    summary.slo = slo_ticks;
+    return summary;
+}
+
+uint64_t LoadBalancer::serverTicks() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < servers.slotCount(); ++i) {
+        total += servers.presentTime(i);
+    }
+    return total;
+}
+
+void LoadBalancer::setClusterLink(ClusterLink* link) {
+    cluster = link;
+    next_arrival = cluster ? cluster->nextTime() : workload.nextTime();
+}
+
+void LoadBalancer::setEngine(SimulationEngine newEngine) {
+    engine = newEngine;
+}
+
+bool LoadBalancer::replayTrace(const std::string& filepath) {
+    std::unique_ptr<TraceReader> reader(new TraceReader());
+    if (!reader->open(filepath)) {
+        logOutput(LogLevel::Error, "ERROR: " + reader->error());
+        return false;
+    }
+    std::string declared = reader->declaredCount() ? std::to_string(reader->declaredCount()) : "an unknown number of";
+    logOutput("Replaying " + declared + " requests from " + filepath);
+    replay = std::move(reader);
+    replayArrivals();
+    return true;
+}
+
+bool LoadBalancer::recordTrace(const std::string& filepath) {
+    if (workload.isIPv6()) {
+        logOutput(LogLevel::Error, "ERROR: Traces hold IPv4 addresses only; an IPv6 workload cannot be recorded");
+        return false;
+    }
+    std::unique_ptr<TraceWriter> writer(new TraceWriter());
+    if (!writer->open(filepath)) {
+        logOutput(LogLevel::Error, "ERROR: " + writer->error());
+        return false;
+    }
+    // The heap is not kept in arrival order; write its requests sorted by enqueue time
+    std::vector<Request> ranked(shortestQueue.size());
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        ranked[i] = shortestQueue.at(i);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const Request& a, const Request& b) {
+        return a.getenqueued() < b.getenqueued();
+    });
+    for (const Request& request : ranked) {
+        writer->write(request);
+    }
+    
+    // Write out the requests already waiting, then put them back in the same order
+    RequestQueue waiting;
+    waiting.reserve(requestQueue.size());
+    while (!requestQueue.empty()) {
+        writer->write(requestQueue.front());
+        waiting.push(requestQueue.front());
+        requestQueue.pop();
+    }
+    requestQueue = std::move(waiting);
+    recorder = std::move(writer);
+    return true;
+}
+
+namespace {
+    /**
+     * @brief Scalar state of a LoadBalancer as stored in a checkpoint
+     */
+    struct CheckpointCore {
+        uint64_t event_sequence;    ///< Counter used to order completion events
+        uint64_t tick_arrivals;     ///< Requests queued on the last tick
+        uint64_t tick_arrival_work; ///< Processing cycles queued on the last tick
+        uint64_t scale_ups;         ///< Scaling steps that added servers
+        uint64_t scale_downs;       ///< Scaling steps that removed servers
+        uint64_t servers_added;     ///< Servers added by scaling
+        uint64_t servers_removed;   ///< Servers removed by scaling
+        uint64_t shed_on_arrival;   ///< Requests refused a place in the queue
+        uint64_t shed_at_head;      ///< Requests dropped from the head of the queue
+        uint64_t peak_queue;        ///< Longest the queue has been
+        uint64_t preemptions;       ///< Requests preempted under SRPT
+        int32_t current_time;       ///< Current simulation time
+        int32_t max_servers;        ///< Largest allowed pool
+        int32_t active_servers;     ///< Servers in the pool or starting
+        int32_t next_arrival;       ///< Next tick on which traffic arrives
+        int32_t slo_ticks;          ///< Sojourn-time objective
+        int32_t discipline;         ///< QueueDiscipline
+    };
+}
+
+bool LoadBalancer::saveCheckpoint(const std::string& filepath) {
+    if (replay || cluster) {
+        logOutput(LogLevel::Error, "ERROR: A load balancer fed by a trace or a cluster cannot be checkpointed");
+        return false;
+    }
+    collectLatency();
+    CheckpointCore core = CheckpointCore();
+    core.event_sequence = event_sequence;
+    core.tick_arrivals = tick_arrivals;
+    core.tick_arrival_work = tick_arrival_work;
+    core.scale_ups = scale_ups;
+    core.scale_downs = scale_downs;
+    core.servers_added = servers_added;
+    core.servers_removed = servers_removed;
+    core.shed_on_arrival = shed_on_arrival;
+    core.shed_at_head = shed_at_head;
+    core.peak_queue = peak_queue;
+    core.preemptions = preemptions;
+    core.current_time = current_time;
+    core.max_servers = max_servers;
+    core.active_servers = active_servers;
+    core.next_arrival = next_arrival;
+    core.slo_ticks = slo_ticks;
+    core.discipline = static_cast<int32_t>(discipline);
+
+    SnapshotWriter out;
+    out.addValue("lb", core);
+    const LatencyHistogram latency[] = {waitLatency, serviceLatency, sojournLatency};
+    out.add("lb.latency", latency, sizeof(LatencyHistogram), 3);
+    std::vector<Request> waiting(requestQueue.size());
+    for (size_t i = 0; i < waiting.size(); ++i) {
+        waiting[i] = requestQueue.at(i);
+    }
+    out.add("queue", waiting);
+    out.add("ipv6", ipv6Table());
+    shortestQueue.saveState(out);
+    servers.saveState(out);
+    provisioner.saveState(out);
+    workload.saveState(out);
+    blocklist.saveState(out);
+    if (!out.write(filepath)) {
+        logOutput(LogLevel::Error, "ERROR: " + out.error());
+        return false;
+    }
+    logOutput("Saved checkpoint " + filepath + " at time " + std::to_string(current_time) + " ("
+              + std::to_string(servers.size()) + " servers, " + std::to_string(queuedCount()) + " queued requests)");
+    simulationLog->flush();
+    return true;
+}
+
+bool LoadBalancer::restoreCheckpoint(const std::string& filepath) {
+    SnapshotReader in;
+    if (!in.open(filepath)) {
+        logOutput(LogLevel::Error, "ERROR: " + in.error());
+        return false;
+    }
+
+    // Everything is restored off to the side first, so a bad file changes nothing
+    CheckpointCore core;
+    const LatencyHistogram* latency = nullptr;
+    size_t histograms = 0;
+    std::vector<Request> waiting;
+    RequestHeap heap;
+    ServerPool pool;
+    Provisioner restoredProvisioner;
+    std::vector<IPv6Address> addresses;
+    WorkloadGenerator generator = workload;
+    bool complete = in.readValue("lb", core) && in.get("lb.latency", latency, histograms) && histograms == 3
+                    && in.read("queue", waiting) && in.read("ipv6", addresses) && heap.restoreState(in) && pool.restoreState(in)
+                    && restoredProvisioner.restoreState(in) && generator.restoreState(in)
+                    && core.discipline >= 0 && core.discipline <= static_cast<int32_t>(QueueDiscipline::ShortestRemaining)
+                    && blocklist.restoreState(in);
+    if (!complete) {
+        logOutput(LogLevel::Error, "ERROR: " + (in.error().empty() ? "Checkpoint " + filepath + " is inconsistent" : in.error()));
+        return false;
+    }
+
+    // Queued and running IPv6 requests refer to the side table by handle
+    restoreIPv6Table(addresses);
+    requestQueue = RequestQueue();
+    requestQueue.reserve(waiting.size());
+    for (const Request& request : waiting) {
+        requestQueue.push(request);
+    }
+    shortestQueue = std::move(heap);
+    discipline = static_cast<QueueDiscipline>(core.discipline);
+    servers = std::move(pool);
+    provisioner = std::move(restoredProvisioner);
+    workload = generator;
+    waitLatency = latency[0];
+    serviceLatency = latency[1];
+    sojournLatency = latency[2];
+    for (LatencyHistogram& h : worker_latency) {
+        h.clear();
+    }
+    event_sequence = core.event_sequence;
+    tick_arrivals = core.tick_arrivals;
+    tick_arrival_work = core.tick_arrival_work;
+    scale_ups = core.scale_ups;
+    scale_downs = core.scale_downs;
+    servers_added = core.servers_added;
+    servers_removed = core.servers_removed;
+    shed_on_arrival = core.shed_on_arrival;
+    shed_at_head = core.shed_at_head;
+    peak_queue = static_cast<size_t>(core.peak_queue);
+    preemptions = core.preemptions;
+    current_time = core.current_time;
+    max_servers = core.max_servers;
+    active_servers = core.active_servers;
+    next_arrival = core.next_arrival;
+    slo_ticks = core.slo_ticks;
+    completions.clear();
+    single_completions.clear();
+    resetPreemptible();
+
+    // The strategies that are not in the checkpoint start over on the restored state
+    servers.setIdleOrder(workers ? IdleOrder::Index : IdleOrder::Recency);
+    dispatchPolicy->reset(servers);
+    resetAdmission();
+    logOutput("Restored checkpoint " + filepath + " at time " + std::to_string(current_time) + " ("
+              + std::to_string(active_servers) + "/" + std::to_string(max_servers) + " servers, "
+              + std::to_string(servers.runningCount()) + " running, " + std::to_string(queuedCount())
+              + " queued requests, " + std::to_string(blocklist.prefixCount()) + " firewall prefixes)");
+    return true;
+}
+
+bool LoadBalancer::setDispatchPolicy(const std::string& spec) {
+    std::unique_ptr<DispatchPolicy> policy = makeDispatchPolicy(spec, base_seed ^ 0x5bd1e995u);
+    if (!policy) {
+        return false;
+    }
+    if (workers && policy->name() != "first-idle") {
+        logOutput(LogLevel::Error, "ERROR: The " + policy->name() + " dispatch policy cannot be used with multiple threads");
+        return false;
+    }
+    policy->reset(servers);
+    dispatchPolicy = std::move(policy);
+    return true;
+}
+
+void LoadBalancer::setThreads(int threads) {
+    collectLatency();
+    worker_latency.clear();
+    if (threads > 0 && servers.hasMultiSlot()) {
+        logOutput(LogLevel::Warn, "WARNING: Multiple threads need single-slot servers; running serially");
+        threads = 0;
+    }
+    if (threads <= 0) {
+        workers.reset();
+        servers.setIdleOrder(IdleOrder::Recency);
+        dispatchPolicy->reset(servers);
+        return;
+    }
+    if (dispatchPolicy->name() != "first-idle") {
+        logOutput(LogLevel::Warn, "WARNING: Multiple threads only support the first-idle dispatch policy; replacing "
+                  + dispatchPolicy->name());
+        dispatchPolicy = makeDispatchPolicy("first-idle", 0);
+    }
+    workers.reset(new WorkerPool(static_cast<size_t>(threads)));
+    worker_latency.resize(workers->size() * 3);
+    servers.setIdleOrder(IdleOrder::Index);
+    dispatchPolicy->reset(servers);
+}
+
+void LoadBalancer::setQueueDiscipline(QueueDiscipline newDiscipline, int aging) {
+    // Move the waiting requests over in the order they would have been served
+    if (newDiscipline == QueueDiscipline::Fifo) {
+        while (!shortestQueue.empty()) {
+            requestQueue.push(shortestQueue.top());
+            shortestQueue.pop();
+        }
+    } else {
+        shortestQueue.setAging(aging);
+        shortestQueue.reserve(requestQueue.size());
+        while (!requestQueue.empty()) {
+            shortestQueue.push(requestQueue.front());
+            requestQueue.pop();
         }
     }
-    return false;
+    discipline = newDiscipline;
+    resetPreemptible();
+}
+
+bool LoadBalancer::setAutoscaler(const std::string& spec) {
+    std::unique_ptr<Autoscaler> scaler = makeAutoscaler(spec);
+    if (!scaler) {
+        return false;
+    }
+    autoscaler = std::move(scaler);
+    return true;
+}
+
+bool LoadBalancer::setAdmissionPolicy(const std::string& spec) {
+    std::unique_ptr<AdmissionPolicy> policy = makeAdmissionPolicy(spec, base_seed ^ 0x2545f491u);
+    if (!policy) {
+        return false;
+    }
+    admission = std::move(policy);
+    resetAdmission();
+    return true;
+}
+
+void LoadBalancer::resetAdmission() {
+    if (discipline == QueueDiscipline::Fifo) {
+        admission->reset(requestQueue);
+    } else {
+        RequestQueue waiting;
+        waiting.reserve(shortestQueue.size());
+        for (size_t i = 0; i < shortestQueue.size(); ++i) {
+            waiting.push(shortestQueue.at(i));
+        }
+        admission->reset(waiting);
+    }
+}
+
+void LoadBalancer::setSlo(int ticks) {
+    slo_ticks = std::max(0, ticks);
+}
+
+void LoadBalancer::setProvisioning(int delay, int warmupTicks, double coldThroughput, int standby) {
+    servers.setWarmup(warmupTicks, coldThroughput);
+    provisioner.configure(delay, warmupTicks, standby, current_time);
+}
+
+bool LoadBalancer::setFleet(const std::vector<ServerProfile>& profiles) {
+    if (!servers.setFleet(profiles)) {
+        return false;
+    }
+    if (workers && servers.hasMultiSlot()) {
+        setThreads(0);
+        logOutput(LogLevel::Warn, "WARNING: Multiple threads need single-slot servers; running serially");
+    } else {
+        dispatchPolicy->reset(servers);
+    }
+    return true;
+}
+
+bool LoadBalancer::setProducers(int producers) {
+    if (replay && producers > 0) {
+        logOutput(LogLevel::Error, "ERROR: Traffic producers cannot be used while a trace is replayed");
+        return false;
+    }
+    producer_count = std::max(0, producers);
+    return true;
+}
+
+bool LoadBalancer::setProfiling(const std::string& prefix) {
+    if (!PROFILING) {
+        logOutput(LogLevel::Error, "ERROR: This build has no profiler (it was built with PROFILING=0)");
+        return false;
+    }
+    profiler.reset(new Profiler(prefix));
+    return true;
+}
+
+bool LoadBalancer::hasActiveTasks() const {
+    return servers.runningCount() > 0;
 }
 
 void LoadBalancer::scaleUp() {
-    if (active_servers < max_servers) {
-        servers.push_back(new WebServer());
+    if (active_servers >= max_servers) {
+        return;
+    }
+    if (provisioner.takeStandby(current_time)) {
+        size_t index = servers.add();
+        dispatchPolicy->serverIdle(servers, index);
         active_servers++;
-        logOutput(">> SCALED UP: Added server " + std::to_string(active_servers - 1) 
+        logOutput(">> SCALED UP: Added server " + std::to_string(index) + " from standby (" 
+                  + std::to_string(active_servers) + "/" + std::to_string(max_servers) + ", "
+                  + std::to_string(provisioner.standbyCount()) + " left in standby)");
+    } else if (provisioner.instant()) {
+        provisioner.countColdStart();
+        size_t index = servers.add(true);
+        dispatchPolicy->serverIdle(servers, index);
+        active_servers++;
+        logOutput(">> SCALED UP: Added server " + std::to_string(index) 
                   + " (" + std::to_string(active_servers) + "/" + std::to_string(max_servers) + ")");
+    } else {
+        int ready = provisioner.orderCold(current_time);
+        active_servers++;
+        logOutput(">> SCALED UP: Starting a new server, ready at time " + std::to_string(ready) 
+                  + " (" + std::to_string(active_servers) + "/" + std::to_string(max_servers) + ")");
+    }
+}
+
+void LoadBalancer::bringOnline() {
+    for (int joined = provisioner.collect(current_time); joined > 0; --joined) {
+        size_t index = servers.add(true);
+        dispatchPolicy->serverIdle(servers, index);
+        logOutput(">> SERVER READY: Added server " + std::to_string(index));
     }
 }
 
 void LoadBalancer::scaleDown() {
     if (active_servers > 1) { // Keep at least 1 server
-        // Find and remove an idle server
-        for (auto it = servers.begin(); it != servers.end(); ++it) {
-            if (!(*it)->isbusy()) {
-                logOutput(">> SCALED DOWN: Removed idle server " 
-                          + std::to_string(it - servers.begin()));
-                delete *it;
-                servers.erase(it);
-                active_servers--;
-                break;
+        // Remove the server that has been idle the longest; other servers keep their IDs
+        long index = servers.coldestIdle();
+        if (index >= 0) {
+            if (provisioner.offerStandby(current_time)) {
+                logOutput(">> SCALED DOWN: Moved idle server " + std::to_string(index) + " to standby");
+            } else {
+                logOutput(">> SCALED DOWN: Removed idle server " + std::to_string(index));
             }
+            servers.release(index);
+            dispatchPolicy->serverRemoved(index);
+            active_servers--;
         }
     }
 }
 
 void LoadBalancer::manageServerLoad() {
-    int queue_size = requestQueue.size();
-    int idle_servers = getIdleServerCount();
-    
-    // Scale up if queue is building up and we have capacity
-    if (queue_size > idle_servers && active_servers < max_servers) {
-        scaleUp();
-    }
-    // Scale down ONLY if queue is empty AND we have many idle servers
-    else if (queue_size == 0 && idle_servers > 2 && active_servers > 1) {
-        scaleDown();
-    }
+    ScopedPhase timer(profiler.get(), ProfilePhase::Scaling);
+    bringOnline();
+    applyScaling(autoscaler->decide(scalingSignals()));
 }
 
-int LoadBalancer::getIdleServerCount() const {
-    int idle_count = 0;
-    for (const WebServer* server : servers) {
-        if (!server->isbusy()) {
-            idle_count++;
+int LoadBalancer::applyScaling(int change) {
+    int applied = 0;
+    if (change > 0) {
+        scale_ups++;
+        for (; applied < change && active_servers < max_servers; ++applied) {
+            scaleUp();
+            servers_added++;
+        }
+    } else if (change < 0) {
+        scale_downs++;
+        for (; applied > change && active_servers > 1 && servers.emptyCount() > 0; --applied) {
+            scaleDown();
+            servers_removed++;
         }
     }
-    return idle_count;
+    profileCount(profiler.get(), ProfileCounter::ScaleEvents, 0, static_cast<uint64_t>(applied < 0 ? -applied : applied));
+    return applied;
+}
+
+ScalingSignals LoadBalancer::scalingSignals() const {
+    ScalingSignals s;
+    s.time = current_time;
+    s.queued = queuedCount();
+    s.idle = servers.emptyCount();
+    s.busy = servers.runningCount();
+    s.free = servers.freeCount();
+    s.capacity = servers.capacity();
+    s.load = servers.usedCapacity();
+    s.active = active_servers;
+    s.maximum = max_servers;
+    s.arrivals = tick_arrivals;
+    s.arrival_work = tick_arrival_work;
+    return s;
+}
+
+int LoadBalancer::getIdleServerCount() const {
+    return static_cast<int>(servers.idleCount());
 }
 
 double LoadBalancer::getAverageQueueSize() const {
-    return static_cast<double>(requestQueue.size()) / active_servers;
+    return static_cast<double>(queuedCount()) / active_servers;
 }
 
 // IP Blocking functionality
 void LoadBalancer::loadBlockedIPs(const std::string& filepath) {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-        std::cout << "Warning: Could not open blocked IPs file: " << filepath << std::endl;
-        std::cout << "Continuing without IP blocking..." << std::endl;
+    int invalid = 0;
+    int count = blocklist.load(filepath, &invalid);
+    if (count < 0) {
+        logOutput(LogLevel::Warn, "Warning: Could not open blocked IPs file: " + filepath);
+        logOutput(LogLevel::Warn, "Continuing without IP blocking...");
         return;
     }
     
-    std::string ip;
-    int count = 0;
-    while (std::getline(file, ip)) {
-        // Remove any whitespace
-        if (!ip.empty() && ip.back() == '\r') {
-            ip.pop_back(); // Remove carriage return if present
+    if (invalid > 0) {
+        logOutput(LogLevel::Warn, "Warning: Ignored " + std::to_string(invalid) + " invalid lines in " + filepath);
+    }
+    logOutput("Loaded " + std::to_string(count) + " firewall rules (" + std::to_string(blocklist.prefixCount()) 
+              + " prefixes, " + std::to_string(blocklist.memoryBytes() / 1024) + " KB) from " + filepath);
+}
+
+bool LoadBalancer::watchBlockedIPs(const std::string& filepath, int pollMs) {
+    bool started = blocklist.watch(filepath, pollMs, [this, filepath](const BlocklistReload& result) {
+        // Runs on the watcher thread; the loggers accept messages from any thread
+        if (result.rules < 0) {
+            logOutput(LogLevel::Warn, "Warning: Could not reload " + filepath + "; keeping the current firewall rules");
+            return;
         }
-        
-        if (!ip.empty()) {
-            blockedIPs.insert(ip);
-            count++;
+        if (result.invalid > 0) {
+            logOutput(LogLevel::Warn, "Warning: Ignored " + std::to_string(result.invalid) + " invalid lines in " + filepath);
         }
+        logOutput("Reloaded " + std::to_string(result.rules) + " firewall rules (" + std::to_string(result.prefixes) 
+                  + " prefixes, " + std::to_string(result.bytes / 1024) + " KB) from " + filepath 
+                  + " (version " + std::to_string(blocklist.version()) + ")");
+    });
+    if (started) {
+        logOutput("Watching " + filepath + " for changes (" 
+                  + (blocklist.usesInotify() ? std::string("inotify") : "polling every " + std::to_string(pollMs) + " ms") + ")");
     }
-    
-    file.close();
-    logOutput("Loaded " + std::to_string(count) + " blocked IP addresses from " + filepath);
+    return started;
 }
 
-bool LoadBalancer::isBlocked(const std::string& ip) const {
-    return blockedIPs.find(ip) != blockedIPs.end();
+void LoadBalancer::setRateLimit(double rate, double burst, int strikes, int blockTicks, size_t maxSources) {
+    rateLimiter.configure(rate, burst, strikes, blockTicks, maxSources);
 }
 
-void LoadBalancer::logBlockedRequest(const std::string& ip) const {
-    std::ofstream logFile("firewall_log.txt", std::ios::app);
-    if (logFile.is_open()) {
-        // Get current timestamp
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        
-        logFile << "[" << std::ctime(&time_t) << "] "
-                << "BLOCKED: Request from IP " << ip 
-                << " at simulation time " << current_time << std::endl;
-        
-        logFile.close();
+bool LoadBalancer::isBlocked(uint32_t ip) const {
+    return blocklist.isBlocked(ip);
+}
+
+bool LoadBalancer::isBlocked(const Request& request) const {
+    return request.isIPv6() ? blocklist.isBlocked(request.getin6()) : blocklist.isBlocked(request.getin());
+}
+
+void LoadBalancer::logBlockedRequest(const Request& request) {
+    // A counter per block; the audit writes one line per source per window
+    audit.record(request.getin(), AuditAction::Blocked, current_time, request.isIPv6());
+    profileCount(profiler.get(), ProfileCounter::Blocks);
+    if (simulationLog->enabled(LogLevel::Debug)) {
+        logOutput(LogLevel::Debug, "FIREWALL: Blocked request from IP " + request.describeSource());
+    }
+}
+
+void LoadBalancer::logShedRequest(const Request& r, bool atHead) {
+    audit.record(r.getin(), AuditAction::Shed, current_time, r.isIPv6());
+    if (simulationLog->enabled(LogLevel::Debug)) {
+        std::string reason = atHead ? "after waiting " + std::to_string(current_time - r.getenqueued()) + " ticks"
+                                    : std::string("on arrival");
+        logOutput(LogLevel::Debug, "ADMISSION: Shed request from IP " + r.describeSource() + " (" + reason + ")");
     }
-    
-    // Also log to console and simulation log for visibility
-    std::string message = "FIREWALL: Blocked request from IP " + ip;
-    std::cout << message << std::endl;
-    logOutput("FIREWALL: Blocked request from IP " + ip);
 }
 
 void LoadBalancer::logOutput(const std::string& message) const {
-    std::ofstream logFile("simulation_log.txt", std::ios::app);
-    if (logFile.is_open()) {
-        // Get current timestamp
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        
-        logFile << "[" << std::ctime(&time_t) << "] " << message << std::endl;
-        logFile.close();
+    logOutput(LogLevel::Info, message);
+}
+
+void LoadBalancer::logOutput(LogLevel level, const std::string& message) const {
+    // Timestamping, file and console output happen on the logger's writer thread;
+    // the blocklist watcher logs too, but only the simulation thread is profiled
+    ScopedPhase timer(PROFILING && profiler && profiler->onOwnerThread() ? profiler.get() : nullptr, ProfilePhase::Logging);
+    simulationLog->log(level, message);
+}
+
+void LoadBalancer::setLogLevel(LogLevel level) {
+    simulationLog->setLevel(level);
+}
+
+void LoadBalancer::setConsoleOutput(bool enabled) {
+    simulationLog->setConsoleEcho(enabled);
+}
+
+void LoadBalancer::setFirewallAudit(const AuditSettings& settings) {
+    audit.configure(settings);
+}
+
+uint64_t LoadBalancer::getCompletedRequests() const {
+    uint64_t completed = sojournLatency.count();
+    for (size_t w = 2; w < worker_latency.size(); w += 3) {
+        completed += worker_latency[w].count();
     }
-    
-    // Also output to console
-    std::cout << message << std::endl;
+    return completed;
+}
+
+int LoadBalancer::getCurrentTime() const {
+    return current_time;
 }
@@ -5,15 +5,87 @@
 #ifndef LOADBALANCER_H
 #define LOADBALANCER_H
 
-#include "WebServer.h"
+#include "ServerPool.h"
+#include "DispatchPolicy.h"
+#include "Autoscaler.h"
+#include "AdmissionPolicy.h"
 #include "Request.h"
+#include "RequestQueue.h"
+#include "RequestHeap.h"
+#include "Logger.h"
+#include "Blocklist.h"
+#include "FirewallAudit.h"
+#include "RateLimiter.h"
+#include "LatencyHistogram.h"
+#include "Trace.h"
+#include "WorkerPool.h"
+#include "Ingress.h"
+#include "Provisioner.h"
+#include "WorkloadGenerator.h"
+#include "Proxy.h"
+#include "ClusterLink.h"
+#include "Profiler.h"
+#include "IndexedHeap.h"
+#include <cstdint>
 #include <vector>
-#include <queue>
-#include <random>
-#include <unordered_set> 
+#include <memory>
 #include <string>
 #include <fstream>
 
+/**
+ * @brief Strategy used by LoadBalancer::run() to advance simulated time
+ */
+enum class SimulationEngine {
+    Tick,   ///< Call tick() for every time unit, visiting every server each time
+    Event   ///< Jump straight from one arrival/completion/scaling event to the next
+};
+
+/**
+ * @brief Order in which queued requests are served
+ */
+enum class QueueDiscipline {
+    Fifo,               ///< Oldest request first
+    ShortestFirst,      ///< Shortest processing time first (SJF)
+    ShortestRemaining   ///< SJF, and shorter requests preempt the longest running ones (SRPT)
+};
+
+/**
+ * @brief A request completion scheduled by the event-driven engine
+ */
+struct CompletionEvent {
+    int time;               ///< Tick on which the server finishes its request
+    uint64_t sequence;      ///< Scheduling order, breaks ties between equal times
+    size_t server;          ///< Index of the server that completes
+
+    /**
+     * @brief Orders events so that a std::greater heap yields the earliest first
+     * @param other Event to compare against
+     * @return true if this event happens after other
+     */
+    bool operator>(const CompletionEvent& other) const {
+        return time != other.time ? time > other.time : sequence > other.sequence;
+    }
+};
+
+/**
+ * @brief Totals of a load balancer's run so far, for combining several load balancers
+ */
+struct RunSummary {
+    LatencyHistogram wait;          ///< Ticks from enqueue to assignment, per completed request
+    LatencyHistogram service;       ///< Ticks from assignment to completion, per completed request
+    LatencyHistogram sojourn;       ///< Ticks from enqueue to completion, per completed request
+    uint64_t server_ticks = 0;      ///< Time servers have spent in the pool
+    uint64_t scale_ups = 0;         ///< Scaling steps that added servers
+    uint64_t scale_downs = 0;       ///< Scaling steps that removed servers
+    uint64_t servers_added = 0;     ///< Servers added by scaling
+    uint64_t servers_removed = 0;   ///< Servers removed by scaling
+    uint64_t blocked = 0;           ///< Requests denied by the firewall rules or the rate limiter
+    uint64_t shed = 0;              ///< Requests shed by the admission policy
+    size_t queued = 0;              ///< Requests still waiting
+    int active = 0;                 ///< Servers in the pool or starting
+    int slo = 0;                    ///< Sojourn-time objective in ticks
+};
+
 /**
  * @brief A load balancer that distributes incoming requests across multiple web servers
  * 
@@ -25,12 +97,58 @@
  */
 class LoadBalancer {
 private:
-    std::vector<WebServer*> servers;                     ///< Pool of web servers managed by the load balancer
-    std::queue<Request> requestQueue;                    ///< Queue of pending requests waiting to be processed
-    std::unordered_set<std::string> blockedIPs;         ///< Set of blocked IP addresses for security filtering
+    ServerPool servers;                                  ///< Pool of web servers managed by the load balancer
+    RequestQueue requestQueue;                           ///< Queue of pending requests waiting to be processed (FIFO)
+    RequestHeap shortestQueue;                           ///< Pending requests, shortest first (SJF and SRPT)
+    QueueDiscipline discipline;                          ///< Which of the two queues holds the pending requests
+    Blocklist blocklist;                                 ///< Compiled allow/deny rules used for security filtering
+    RateLimiter rateLimiter;                             ///< Per-source token buckets and temporary blocks
+    FirewallAudit audit;                                 ///< Per-source counts of blocked and shed requests (firewall_audit.csv)
+    std::unique_ptr<DispatchPolicy> dispatchPolicy;      ///< Chooses the idle server for each queued request
+    std::unique_ptr<Autoscaler> autoscaler;              ///< Decides how many servers to add or remove each tick
+    Provisioner provisioner;                             ///< Servers starting up and the standby pool
+    std::unique_ptr<AdmissionPolicy> admission;          ///< Decides which requests are shed instead of queued
     int current_time;                                    ///< Current simulation time (tick counter)
     int max_servers;                                     ///< Maximum number of servers allowed in the pool
     int active_servers;                                  ///< Number of currently active servers
+    unsigned int base_seed;                              ///< Seed of workload (derived seeds feed other random choices)
+    WorkloadGenerator workload;                          ///< Arrivals, addresses and service times of generated traffic
+    int next_arrival;                                    ///< Next tick on which traffic arrives
+    SimulationEngine engine;                             ///< How run() advances simulated time
+    std::vector<CompletionEvent> completions;            ///< Min-heap of pending completions of multi-slot servers (event engine only)
+    IndexedHeap single_completions;                      ///< Running single-slot servers by completion tick (event engine only)
+    IndexedHeap preemptible;                             ///< Running single-slot servers, latest completion first (SRPT only)
+    uint64_t event_sequence;                             ///< Counter used to order completion events
+    uint64_t tick_arrivals;                              ///< Requests queued on the current tick
+    uint64_t tick_arrival_work;                          ///< Processing cycles of the requests queued on the current tick
+    uint64_t scale_ups;                                  ///< Scaling steps that added servers
+    uint64_t scale_downs;                                ///< Scaling steps that removed servers
+    uint64_t servers_added;                              ///< Servers added by scaling
+    uint64_t servers_removed;                            ///< Servers removed by scaling
+    int slo_ticks;                                       ///< Sojourn time a request should not exceed (for the report)
+    uint64_t shed_on_arrival;                            ///< Requests refused a place in the queue
+    uint64_t shed_at_head;                               ///< Requests dropped from the head of the queue
+    size_t peak_queue;                                   ///< Longest the queue has been
+    uint64_t preemptions;                                ///< Requests taken off a server by a shorter one (SRPT)
+    std::vector<uint64_t> finished_scratch;              ///< Per-tick bitmap of servers that finish (tick engine)
+    std::vector<uint64_t> assigned_scratch;              ///< Per-tick bitmap of servers given work (debug output only)
+    LatencyHistogram waitLatency;                        ///< Ticks from enqueue to assignment, per completed request
+    LatencyHistogram serviceLatency;                     ///< Ticks from assignment to completion, per completed request
+    LatencyHistogram sojournLatency;                     ///< Ticks from enqueue to completion, per completed request
+    std::unique_ptr<WorkerPool> workers;                 ///< Threads of the sharded tick, or null for the serial tick
+    std::vector<LatencyHistogram> worker_latency;        ///< Wait/service/sojourn histograms, three per worker (sharded tick)
+    std::vector<size_t> shard_offset;                    ///< Queue position of each shard's first assignment (sharded tick)
+    std::vector<long> shard_delta;                       ///< Change in busy servers made by each shard (sharded tick)
+    std::vector<long> shard_units;                       ///< Change in capacity in use made by each shard (sharded tick)
+    std::unique_ptr<TraceReader> replay;                 ///< Trace that replaces the random traffic, if any
+    std::unique_ptr<TraceWriter> recorder;               ///< Trace that receives every arriving request, if any
+    int producer_count;                                  ///< Traffic producer threads used by run() (0 = inline generation)
+    std::unique_ptr<Ingress> ingress;                    ///< Ingress stage fed by the producers while run() is active
+    std::vector<Arrival> arrival_scratch;                ///< Arrivals collected from the ingress this tick
+    ClusterLink* cluster;                                ///< Cluster that supplies the traffic, or null (not owned)
+    std::vector<ClusterArrival> cluster_scratch;         ///< Requests collected from the cluster this tick
+    std::unique_ptr<Logger> simulationLog;               ///< Asynchronous writer for simulation_log.txt (and the console)
+    std::unique_ptr<Profiler> profiler;                  ///< Phase timers and event counters of run(), or null when not profiling
 
 public:
     /**
@@ -38,19 +156,32 @@ public:
      * @param numServers Maximum number of servers to manage
      * @param initialQueueSize Number of initial requests to generate (-1 for default: numServers*100)
      * @param blockedIPsFile Path to file containing blocked IP addresses (default: "blocked_ips.txt")
+     * @param seed Seed for the traffic generator; 0 (the default) seeds from std::random_device
+     * @param consoleOutput Whether to echo the simulation log to stdout, including the
+     *        messages logged during construction (see setConsoleOutput())
+     * @param workloadConfig Traffic model for the initial queue and the generated arrivals
+     * @param filePrefix Prepended to the names of simulation_log.txt and firewall_audit.csv,
+     *        so several load balancers can run in one directory
      */
-    LoadBalancer(int numServers, int initialQueueSize = -1, const std::string& blockedIPsFile = "blocked_ips.txt");
+    LoadBalancer(int numServers, int initialQueueSize = -1, const std::string& blockedIPsFile = "blocked_ips.txt",
+                 unsigned int seed = 0, bool consoleOutput = true,
+                 const WorkloadConfig& workloadConfig = WorkloadConfig(), const std::string& filePrefix = "");
     
     /**
-     * @brief Destructor that cleans up allocated WebServer objects
+     * @brief Destructor that stops the rule file watcher and flushes the logs
+     *
+     * Every message logged before destruction is guaranteed to reach the log files.
      */
     ~LoadBalancer();
 
     /**
-     * @brief Randomly generates and enqueues new requests based on probability
+     * @brief Enqueues the generated requests that arrive on the current tick
      * 
-     * Each tick has a 30% chance of adding 1 request, and a 1% chance of adding
-     * a burst of 5 requests to simulate traffic spikes.
+     * The WorkloadGenerator decides when requests arrive and what they look like;
+     * by default each tick has a 30% chance of adding 1 request, and an arrival
+     * is a burst of 5 requests 1% of the time. It draws the tick of the next
+     * arrival directly, so ticks without arrivals cost nothing and can be skipped
+     * by the event engine.
      */
     void addRandomRequest();
     
@@ -60,63 +191,636 @@ public:
      * Performs the following operations in sequence:
      * 1. Possibly adds new random requests
      * 2. Manages server scaling based on current load
-     * 3. Updates all servers (processes current requests, assigns new ones)
+     * 3. Updates all servers (processes current requests, assigns new ones); the admission
+     *    policy may first drop requests from the head of the queue
      * 4. Reports current system status
      */
     void tick();
     
     /**
      * @brief Runs the main simulation loop for the specified duration
+     * 
+     * Uses the engine selected with setEngine(). Both engines produce the same
+     * events, statistics and info-level output for the same seed; the event
+     * engine only omits the debug-level lines of ticks on which nothing happens.
+     * 
+     * Ends with a report of wait, service and sojourn time percentiles for the
+     * completed requests and of how busy the servers were while in the pool.
+     * 
      * @param totalTime Number of time ticks to simulate
      */
     void run(int totalTime);
+
+    /**
+     * @brief Simulates a number of ticks with the selected engine, without the start and end logging of run()
+     *
+     * Successive calls continue where the previous one stopped, so a caller can
+     * interleave other work (a Cluster exchanging spilled requests) between them.
+     * Producer threads (setProducers()) are only started by run().
+     *
+     * @param ticks Number of time ticks to simulate
+     */
+    void advance(int ticks);
+
+    /**
+     * @brief Logs the end-of-run report: latency percentiles, utilization, scaling, SLO and shedding
+     *
+     * Called by run(); completes a recorded trace.
+     */
+    void report();
+
+    /**
+     * @brief Gets the totals of the run so far
+     * @return Latency histograms and counters
+     */
+    RunSummary getSummary() const;
+
+    /**
+     * @brief Gathers what the autoscaler sees on the current tick
+     * @return Current scaling signals (arrivals are those of the last tick)
+     */
+    ScalingSignals scalingSignals() const;
+
+    /**
+     * @brief Applies a scaling decision made outside the load balancer
+     *
+     * Adds servers up to the pool's maximum or removes idle servers, keeping at
+     * least one, exactly as the autoscaler's own decisions are applied.
+     *
+     * @param change Servers to add (positive) or remove (negative)
+     * @return Servers actually added (positive) or removed (negative)
+     */
+    int applyScaling(int change);
+
+    /**
+     * @brief Takes traffic from a cluster instead of generating it
+     *
+     * Every tick the requests the link delivers are checked against the firewall
+     * and the rate limiter (requests spilled by another node were already checked
+     * there) and offered back to the link for spilling before they are queued. Not
+     * available together with a replayed trace or traffic producers.
+     *
+     * @param link Cluster link that outlives the load balancer's use of it; null
+     *        returns to generated traffic
+     */
+    void setClusterLink(ClusterLink* link);
+
+    /**
+     * @brief Relays real TCP connections to backends instead of simulating traffic
+     *
+     * Each accepted client is checked against the firewall rules (including reloads
+     * from watchBlockedIPs()) and handed to a backend connection slot chosen by a
+     * dispatch policy (see Proxy). The simulated servers, queue and scaling are not
+     * used. Logs the listening address at the start and the connection and byte
+     * counts at the end.
+     *
+     * @param settings Listening address, backends, workers and limits
+     * @return false if the proxy could not start
+     */
+    bool runProxy(const ProxySettings& settings);
+
+    /**
+     * @brief Selects how run() advances simulated time
+     * @param newEngine SimulationEngine::Tick (default) or SimulationEngine::Event
+     */
+    void setEngine(SimulationEngine newEngine);
+
+    /**
+     * @brief Selects how queued requests are distributed over idle servers
+     *
+     * See makeDispatchPolicy() for the available policies. The default is "first-idle".
+     * Policies that make random choices are seeded from the traffic seed, so runs with
+     * the same seed stay reproducible.
+     *
+     * @param spec Policy name, optionally with parameters (e.g. "weighted:3,1")
+     * @return false if the policy is not recognised (the current policy is kept)
+     */
+    bool setDispatchPolicy(const std::string& spec);
+
+    /**
+     * @brief Selects the order in which queued requests are served
+     *
+     * Every request's processing time is known on arrival. ShortestFirst serves the
+     * shortest queued request first, ties in arrival order. ShortestRemaining also
+     * preempts: while no server is idle and the next queued request is shorter than
+     * the most work left on a busy server, that server's request goes back into the
+     * queue with its remaining time and the shorter one takes its place. Requests
+     * that started on the current tick are not preempted.
+     *
+     * Aging keeps long requests from starving: a request moves ahead of requests one
+     * cycle shorter for every aging ticks it has waited.
+     *
+     * Requests already queued are re-ordered. The wait time reported for a preempted
+     * request runs until its last start, so it includes its earlier service. SRPT
+     * needs a pool-wide view of the running requests, so it runs the serial tick
+     * even when setThreads() is in effect.
+     *
+     * @param newDiscipline QueueDiscipline::Fifo (default), ShortestFirst or ShortestRemaining
+     * @param aging Ticks of waiting worth one cycle of processing time; 0 (the default) turns aging off
+     */
+    void setQueueDiscipline(QueueDiscipline newDiscipline, int aging = 0);
+
+    /**
+     * @brief Selects how the pool is scaled
+     *
+     * See makeAutoscaler() for the available autoscalers. The default is "reactive",
+     * the original rule of at most one server per tick.
+     *
+     * @param spec Autoscaler name, optionally with parameters (e.g. "predictive:target=0.8")
+     * @return false if the autoscaler is not recognised (the current one is kept)
+     */
+    bool setAutoscaler(const std::string& spec);
+
+    /**
+     * @brief Selects how requests are shed when the queue fills up
+     *
+     * See makeAdmissionPolicy() for the available policies. The default is "none",
+     * an unbounded queue. Shed requests are logged like firewall blocks and counted
+     * in the report at the end of run(). Requests already queued are kept.
+     *
+     * @param spec Policy name with parameters (e.g. "tail:1000", "codel:1000,10,100")
+     * @return false if the policy is not recognised (the current policy is kept)
+     */
+    bool setAdmissionPolicy(const std::string& spec);
+
+    /**
+     * @brief Sets the service-level objective reported at the end of run()
+     *
+     * The report counts completed requests whose sojourn time exceeded the objective,
+     * next to the server-ticks the pool consumed, so autoscaler settings can be
+     * compared on cost against latency.
+     *
+     * @param ticks Largest acceptable sojourn time (default 50)
+     */
+    void setSlo(int ticks);
+
+    /**
+     * @brief Models the cost of starting servers
+     *
+     * A scale-up first takes a warm server from the standby pool, which joins at once
+     * and is replaced in the background. Otherwise it starts a cold server, which
+     * joins after the provisioning delay and then runs slower until it has warmed up
+     * (see ServerPool::setWarmup()). Servers that are starting count towards the
+     * maximum pool size. Scale-down returns servers to standby while it is short.
+     * The final report adds the server-ticks spent on standby and on booting.
+     *
+     * @param delay Ticks from ordering a cold server until it can take work
+     * @param warmupTicks Ticks a cold server needs to reach full speed
+     * @param coldThroughput Speed of a cold server when it joins, as a share of full speed
+     * @param standby Pre-warmed standby servers to keep; the pool is filled immediately
+     */
+    void setProvisioning(int delay, int warmupTicks, double coldThroughput, int standby);
+
+    /**
+     * @brief Makes the servers heterogeneous
+     *
+     * Servers are spread evenly over the profiles, each with its own speed and number
+     * of request slots (see ServerPool::setFleet()); servers added later continue the
+     * spread. Dispatch and autoscaling see capacity in cycles per tick, so a fast or
+     * wide server counts for more than a slow one. Multi-slot servers are never
+     * preempted under SRPT and rule out setThreads(), which falls back to the serial
+     * tick with a warning.
+     *
+     * @param profiles Server profiles (see parseFleet())
+     * @return false if a server is running a request or profiles is empty
+     */
+    bool setFleet(const std::vector<ServerProfile>& profiles);
+
+    /**
+     * @brief Runs the tick engine's per-server work on several threads
+     *
+     * The server pool is cut into shards of whole bitmap words that the threads
+     * claim one at a time, so a thread that finishes early takes over remaining
+     * shards. Each shard counts down its servers and counts its idle ones; the
+     * queue is then split between shards by prefix sums of those counts, so every
+     * shard knows which requests it hands out without further coordination.
+     *
+     * Idle servers are ranked by index (IdleOrder::Index) and only the "first-idle"
+     * policy is supported; another policy is replaced with a warning. The requests
+     * each server receives are the same for every thread count, so the results do
+     * not depend on how many threads are used. The event engine is unaffected
+     * apart from using the same server order.
+     *
+     * @param threads Number of threads including the caller; 0 restores the serial tick
+     */
+    void setThreads(int threads);
+
+    /**
+     * @brief Moves random traffic generation and firewall filtering to producer threads
+     *
+     * During run() each producer generates its own share of the traffic (the total
+     * rate is unchanged) into an Ingress stage, and every tick the simulation takes
+     * that tick's arrivals from it in a fixed order, so the results do not depend on
+     * thread timing. With one producer the traffic is exactly what inline generation
+     * would produce; each run() starts the producers afresh. Not available while a
+     * trace is replayed.
+     *
+     * @param producers Number of producer threads; 0 (the default) generates traffic inline
+     * @return false if a trace is being replayed (an error is logged)
+     */
+    bool setProducers(int producers);
+
+    /**
+     * @brief Profiles every following run()
+     *
+     * Times the phases of every tick (arrivals, scaling, the server loop and
+     * logging) and counts enqueues, dispatches, completions, blocks and scaling
+     * events per thread. At the end of run() the per-tick distributions are written
+     * to <prefix>.json and the timeline to <prefix>.trace.json in the Chrome
+     * trace-event format (see Profiler). Not available in a build with PROFILING=0.
+     *
+     * @param prefix Output file prefix
+     * @return false if the profiler is compiled out (an error is logged)
+     */
+    bool setProfiling(const std::string& prefix);
+
+    /**
+     * @brief Replaces the random traffic with requests streamed from a binary trace
+     *
+     * Each record enters the queue on the tick given by its arrival time; records at or
+     * before the current time are queued immediately. The trace is read through a small
+     * sliding window, so traces larger than memory can be replayed. Construct the load
+     * balancer with an initial queue size of 0 to replay the trace's traffic alone.
+     *
+     * @param filepath Trace file (see TraceFormat)
+     * @return false if the trace could not be opened (an error is logged)
+     */
+    bool replayTrace(const std::string& filepath);
+
+    /**
+     * @brief Records every request that arrives from now on to a binary trace
+     *
+     * Requests already waiting in the queue are written first with their enqueue
+     * times, so a recording started right after construction captures the initial
+     * queue too. The file is completed at the end of run().
+     *
+     * @param filepath Trace file to create
+     * @return false if the file could not be created or the workload is IPv6, which
+     *         trace records cannot hold (an error is logged)
+     */
+    bool recordTrace(const std::string& filepath);
+
+    /**
+     * @brief Writes the complete simulation state to a checkpoint file
+     *
+     * Stores the current time, the queue (in either discipline), every server with
+     * its requests, the scaling and provisioning state, the traffic generator with
+     * its random stream, the firewall rules and the statistics gathered so far (see
+     * SnapshotFormat). The dispatch policy, autoscaler, admission policy, rate
+     * limiter and firewall audit are not stored. Call it between runs; a replayed
+     * trace or a cluster link cannot be checkpointed.
+     *
+     * @param filepath Checkpoint file to create (replaced atomically)
+     * @return false if the state cannot be checkpointed or the file cannot be written (an error is logged)
+     */
+    bool saveCheckpoint(const std::string& filepath);
+
+    /**
+     * @brief Continues from a checkpoint written by saveCheckpoint()
+     *
+     * The file is memory-mapped and its arrays are copied straight into place, so
+     * restoring takes about as long as reading the file. Everything the checkpoint
+     * holds replaces this load balancer's state, including the pool size, fleet and
+     * workload; the strategies that are not stored keep their current settings and
+     * start fresh on the restored servers, so a checkpoint can be forked into runs
+     * that try different policies. Settings changed after restoring apply as they
+     * would mid-run.
+     *
+     * @param filepath Checkpoint file
+     * @return false if the file is not a valid checkpoint (an error is logged and the
+     *         state is unchanged)
+     */
+    bool restoreCheckpoint(const std::string& filepath);
     
     // Dynamic server management
     /**
      * @brief Adds a new server to the pool if under the maximum limit
+     *
+     * Takes a standby server if there is one; otherwise starts a cold server (see
+     * setProvisioning()).
      */
     void scaleUp();
     
     /**
-     * @brief Removes an idle server from the pool to reduce overhead
+     * @brief Removes the longest-idle server from the pool to reduce overhead
      */
     void scaleDown();
     
     /**
      * @brief Automatically scales the server pool based on current load metrics
      * 
-     * Scales up when queue size exceeds idle server count.
-     * Scales down when queue is empty and there are many idle servers.
+     * Asks the autoscaler (see setAutoscaler()) how many servers to add or remove
+     * and applies the answer. With the default reactive autoscaler this scales up
+     * by one when the queue size exceeds the idle server count and down by one when
+     * the queue is empty and there are many idle servers.
      */
     void manageServerLoad();
     
     // IP Blocking functionality
     /**
-     * @brief Loads blocked IP addresses from a file
-     * @param filepath Path to the file containing blocked IP addresses (one per line)
+     * @brief Loads firewall rules from a file
+     *
+     * Each line is an address, a CIDR block (a.b.c.d/n) or a range (a.b.c.d-e.f.g.h),
+     * optionally preceded by "allow" or "deny" (the default). See Firewall for details.
+     *
+     * @param filepath Path to the file containing firewall rules (one per line)
      */
     void loadBlockedIPs(const std::string& filepath);
+
+    /**
+     * @brief Reloads the firewall rules whenever their file changes
+     *
+     * The file is parsed and compiled on a background thread and swapped in without
+     * pausing the simulation or the traffic producers (see Blocklist). Each reload is
+     * logged; if the file cannot be read, the current rules stay in force. Requests
+     * are checked against whichever rules are current when they arrive, so a run that
+     * reloads is not reproducible.
+     *
+     * @param filepath Rule file to watch
+     * @param pollMs Interval between checks where inotify is not available
+     * @return false if the rules are already being watched
+     */
+    bool watchBlockedIPs(const std::string& filepath, int pollMs = 1000);
     
     /**
-     * @brief Checks if an IP address is in the blocked list
-     * @param ip IP address to check
-     * @return true if the IP is blocked, false otherwise
+     * @brief Checks if an IP address is denied by the firewall rules
+     * @param ip IPv4 address to check (host byte order)
+     * @return true if the most specific matching rule denies the IP, false otherwise
+     */
+    bool isBlocked(uint32_t ip) const;
+
+    /**
+     * @brief Checks if a request's source address is denied by the firewall rules
+     * @param request Request of either address family
+     * @return true if the most specific matching rule denies the source, false otherwise
      */
-    bool isBlocked(const std::string& ip) const;
+    bool isBlocked(const Request& request) const;
     
     /**
-     * @brief Logs a blocked request to the firewall log file
-     * @param ip IP address that was blocked
+     * @brief Rate-limits requests per source address, blocking persistent offenders for a while
+     *
+     * Applied after the firewall rules to every arriving request (not to the initial
+     * queue). Each source may send burst requests at once and rate requests per tick
+     * on average; further requests are dropped. A source that is limited strikes times
+     * in a row is blocked for blockTicks ticks. Drops and blocks are logged like
+     * firewall blocks. See RateLimiter for how memory is bounded.
+     *
+     * @param rate Requests per tick each source may send on average
+     * @param burst Requests a source may send at once
+     * @param strikes Limited requests in a row that block the source; 0 never blocks
+     * @param blockTicks Length of a temporary block
+     * @param maxSources Most sources tracked at once; the least recently seen is forgotten first
      */
-    void logBlockedRequest(const std::string& ip) const;
+    void setRateLimit(double rate, double burst, int strikes, int blockTicks, size_t maxSources = 65536);
+
+    /**
+     * @brief Counts a blocked request in the firewall audit
+     *
+     * The simulation log only gets a line at LogLevel::Debug.
+     *
+     * @param request Request whose source was blocked
+     */
+    void logBlockedRequest(const Request& request);
+
+    /**
+     * @brief Counts a request shed by the admission policy in the firewall audit
+     *
+     * The simulation log only gets a line at LogLevel::Debug.
+     *
+     * @param r Request that was shed
+     * @param atHead Whether it was dropped from the head of the queue rather than on arrival
+     */
+    void logShedRequest(const Request& r, bool atHead);
     
     /**
      * @brief Logs general output to both console and simulation log file
      * @param message Message to log with timestamp
      */
     void logOutput(const std::string& message) const;
+
+    /**
+     * @brief Logs output at the given level to both console and simulation log file
+     * @param level Severity of the message; messages above the configured verbosity are dropped
+     * @param message Message to log with timestamp
+     */
+    void logOutput(LogLevel level, const std::string& message) const;
+
+    /**
+     * @brief Sets the verbosity of the simulation log
+     *
+     * Per-server lines are logged at LogLevel::Debug and are therefore off by default.
+     *
+     * @param level Most verbose level that is recorded
+     */
+    void setLogLevel(LogLevel level);
+
+    /**
+     * @brief Enables or disables echoing simulation log messages to stdout
+     * @param enabled true to print messages to the console as well as the log file
+     */
+    void setConsoleOutput(bool enabled);
+
+    /**
+     * @brief Sets how the firewall audit aggregates and rotates firewall_audit.csv
+     *
+     * Counts already recorded in the open window are kept.
+     *
+     * @param settings Window length, rotation size, rotated files kept and compression
+     */
+    void setFirewallAudit(const AuditSettings& settings);
+
+    /**
+     * @brief Gets the number of requests servers have finished processing
+     * @return Completed request count since construction
+     */
+    uint64_t getCompletedRequests() const;
+
+    /**
+     * @brief Gets the current simulation time
+     * @return Number of ticks simulated so far
+     */
+    int getCurrentTime() const;
     
 private:
+    /**
+     * @brief Adds this tick's arrivals, from the replayed trace or the random generator
+     */
+    void addArrivals();
+
+    /**
+     * @brief Queues the trace records that have arrived by the current time
+     */
+    void replayArrivals();
+
+    /**
+     * @brief Queues the arrivals the producer threads generated for the current time
+     */
+    void ingressArrivals();
+
+    /**
+     * @brief Hands the current queue to the admission policy, e.g. after the policy or the queue was replaced
+     */
+    void resetAdmission();
+
+    /**
+     * @brief Queues or spills the requests the cluster delivers for the current time
+     */
+    void clusterArrivals();
+
+    /**
+     * @brief Sums the time every slot has held a server
+     * @return Server-ticks paid for so far
+     */
+    uint64_t serverTicks() const;
+
+    /**
+     * @brief Applies the rate limiter to a request that passed the firewall rules
+     * @param request Request to check; IPv6 sources are limited by their side table handle
+     * @return true if the request is dropped (it has been logged)
+     */
+    bool throttled(const Request& request);
+
+    /**
+     * @brief Queues an arriving request unless the admission policy sheds it
+     * @param r Request that passed the firewall
+     * @return false if the request was shed
+     */
+    bool enqueueArrival(const Request& r);
+
+    /**
+     * @brief Gets the number of queued requests
+     * @return Queue length under the current discipline
+     */
+    size_t queuedCount() const;
+
+    /**
+     * @brief Gets the request that is served next (the queue must not be empty)
+     * @return Reference to the head of the queue under the current discipline
+     */
+    const Request& nextQueued() const;
+
+    /**
+     * @brief Removes the request that is served next (the queue must not be empty)
+     */
+    void popQueued();
+
+    /**
+     * @brief Adds a request to the queue of the current discipline
+     * @param r Request to queue
+     */
+    void pushQueued(const Request& r);
+
+    /**
+     * @brief Lets queued requests preempt longer running ones (SRPT only)
+     * @param assigned If not null, receives one bit per server that was given work
+     * @param schedule Whether completion events are kept (event engine)
+     */
+    void preemptLongest(std::vector<uint64_t>* assigned, bool schedule);
+
+    /**
+     * @brief Adds a server that was just given a request to the preemption candidates (SRPT only)
+     * @param index Server index
+     */
+    void trackPreemptible(size_t index);
+
+    /**
+     * @brief Rebuilds the preemption candidates from the running servers (SRPT only)
+     */
+    void resetPreemptible();
+
+    /**
+     * @brief Schedules the completion of a server's request (event engine)
+     * @param index Index of a server that was just given a request
+     */
+    void scheduleCompletion(size_t index);
+
+    /**
+     * @brief Lets the admission policy drop requests from the head of the queue
+     *
+     * Only called when idle servers are about to take queued requests, so the
+     * policy sees the wait of the request that would be served next.
+     */
+    void shedQueueHead();
+
+    /**
+     * @brief Producer thread body: generates random traffic into the ingress stage
+     * @param out Producer handle
+     * @param gen Generator of this producer, positioned at its first arrival
+     */
+    void produceTraffic(Ingress::Producer& out, WorkloadGenerator gen) const;
+
+    /**
+     * @brief Adds the cold servers whose provisioning delay has passed to the pool
+     */
+    void bringOnline();
+
+    /**
+     * @brief Event-driven replacement for calling tick() totalTime times
+     * 
+     * Keeps a min-heap of completion times and advances directly to the next tick
+     * with an arrival, a completion, a pending assignment or a pending scaling step.
+     * 
+     * @param totalTime Number of time ticks to simulate
+     */
+    void runEvents(int totalTime);
+
+    /**
+     * @brief Processes one tick on which something happens (event engine only)
+     */
+    void eventTick();
+
+    /**
+     * @brief Hands queued requests to idle servers in the order chosen by the dispatch policy
+     * @param assigned If not null, receives one bit per server that was given work
+     * @param schedule Whether to push a CompletionEvent for each assignment (event engine)
+     */
+    void dispatchToIdle(std::vector<uint64_t>* assigned, bool schedule);
+
+    /**
+     * @brief Completes a server's request, recording its latencies, and makes the server idle
+     * @param index Server whose request finishes on the current tick
+     */
+    void finishRequest(size_t index);
+
+    /**
+     * @brief Records the wait, service and sojourn times of a server's finishing request
+     * @param index Server whose request finishes on the current tick
+     * @param wait Receives the ticks from enqueue to assignment
+     * @param service Receives the ticks from assignment to completion
+     * @param sojourn Receives the ticks from enqueue to completion
+     */
+    void recordLatency(size_t index, LatencyHistogram& wait, LatencyHistogram& service, LatencyHistogram& sojourn) const;
+
+    /**
+     * @brief Sharded replacement for the countdown, dispatch and completion steps of tick()
+     * @param verbose Whether to log the per-server states in between
+     */
+    void shardedStep(bool verbose);
+
+    /**
+     * @brief Merges the per-worker latency histograms into the totals
+     */
+    void collectLatency();
+
+    /**
+     * @brief Logs latency percentiles and the per-server utilization summary
+     */
+    void logStatistics() const;
+
+    /**
+     * @brief Logs the queue length and the active and idle server counts at the end of a tick
+     */
+    void logTickSummary() const;
+
+    /**
+     * @brief Writes one debug line per server describing what it did this tick
+     * @param finished Bitmap of servers that completed their request this tick
+     * @param assigned Bitmap of servers that were given a request this tick
+     * @param unchanged Whether to also report servers that only kept processing or stayed idle
+     */
+    void logServerStates(const std::vector<uint64_t>& finished, const std::vector<uint64_t>& assigned,
+                         bool unchanged) const;
+
     /**
      * @brief Checks if any server is currently processing a request
      * @return true if at least one server is busy, false if all servers are idle
@@ -125,7 +829,7 @@ private:
     
     /**
      * @brief Counts the number of idle (not busy) servers
-     * @return Number of servers that are currently idle
+     * @return Number of servers that are currently idle (constant time)
      */
     int getIdleServerCount() const;
     
@@ -0,0 +1,149 @@
+/**
+ * @file Logger.cpp
+ * @brief Logger class implementation
+ *
+ * Contains the background writer thread that drains queued log messages in
+ * batches and writes them through a single long-lived file handle.
+ */
+
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+    const size_t MAX_BATCH = 4096;  ///< Largest number of messages written by one batch
+}
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    if (name == "error") {
+        level = LogLevel::Error;
+    } else if (name == "warn") {
+        level = LogLevel::Warn;
+    } else if (name == "info") {
+        level = LogLevel::Info;
+    } else if (name == "debug") {
+        level = LogLevel::Debug;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Logger::Logger(const std::string& filepath, bool echoToConsole, size_t capacity)
+    : ring(capacity), file(filepath, std::ios::app), level(static_cast<int>(LogLevel::Info)),
+      echo_console(echoToConsole), running(true), enqueued(0), written(0) {
+    writer = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    running.store(false, std::memory_order_release);
+    if (writer.joinable()) {
+        writer.join();
+    }
+    file.close();
+}
+
+void Logger::log(LogLevel msgLevel, std::string message) {
+    if (!enabled(msgLevel)) {
+        return;
+    }
+
+    Record record{msgLevel, std::move(message)};
+    while (!ring.tryPush(std::move(record))) {
+        // Ring is full: let the writer catch up rather than dropping the message
+        std::this_thread::yield();
+    }
+    enqueued.fetch_add(1, std::memory_order_release);
+}
+
+void Logger::flush() {
+    uint64_t target = enqueued.load(std::memory_order_acquire);
+    while (written.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
+
+void Logger::setLevel(LogLevel newLevel) {
+    level.store(static_cast<int>(newLevel), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const {
+    return static_cast<LogLevel>(level.load(std::memory_order_relaxed));
+}
+
+void Logger::setConsoleEcho(bool echo) {
+    echo_console.store(echo, std::memory_order_relaxed);
+}
+
+void Logger::writerLoop() {
+    std::string batch;
+    std::string console;
+    std::string stamp;
+    int64_t stamp_second = -1;
+
+    for (;;) {
+        if (drainBatch(batch, console, stamp, stamp_second) > 0) {
+            continue;
+        }
+
+        if (!running.load(std::memory_order_acquire)) {
+            // Stop requested: anything logged before the request is already in
+            // the ring, so keep draining until it is empty
+            while (drainBatch(batch, console, stamp, stamp_second) > 0) {
+            }
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+size_t Logger::drainBatch(std::string& batch, std::string& console, std::string& stamp, int64_t& stamp_second) {
+    batch.clear();
+    console.clear();
+    bool echo = echo_console.load(std::memory_order_relaxed);
+
+    Record record;
+    size_t count = 0;
+    while (count < MAX_BATCH && ring.tryPop(record)) {
+        // Format the timestamp once per second rather than once per message
+        auto now = std::chrono::system_clock::now();
+        std::time_t now_t = std::chrono::system_clock::to_time_t(now);
+        if (static_cast<int64_t>(now_t) != stamp_second) {
+            // Every logger has a writer thread, so the shared buffer of std::localtime is off limits
+            std::tm local;
+#ifdef _WIN32
+            localtime_s(&local, &now_t);
+#else
+            localtime_r(&now_t, &local);
+#endif
+            char buffer[64];
+            std::strftime(buffer, sizeof(buffer), "[%a %b %e %H:%M:%S %Y] ", &local);
+            stamp = buffer;
+            stamp_second = static_cast<int64_t>(now_t);
+        }
+
+        batch += stamp;
+        batch += record.text;
+        batch += '\n';
+        if (echo) {
+            console += record.text;
+            console += '\n';
+        }
+        count++;
+    }
+
+    if (count > 0) {
+        if (file.is_open()) {
+            file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            file.flush();
+        }
+        if (!console.empty()) {
+            std::fwrite(console.data(), 1, console.size(), stdout);
+            std::fflush(stdout);
+        }
+        written.fetch_add(count, std::memory_order_release);
+    }
+    return count;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file Logger.h
+ * @brief Logger class header file
+ */
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "RingBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Severity of a log message, ordered from most to least important
+ */
+enum class LogLevel {
+    Error = 0,  ///< Failures that affect the simulation
+    Warn,       ///< Unexpected but recoverable conditions
+    Info,       ///< Simulation events (arrivals, scaling, per-tick summary)
+    Debug       ///< Per-server detail emitted for every server on every tick
+};
+
+/**
+ * @brief Parses a log level name ("error", "warn", "info" or "debug")
+ * @param name Level name, case sensitive
+ * @param level Receives the parsed level on success
+ * @return true if the name was recognised, false otherwise
+ */
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+/**
+ * @brief Asynchronous, buffered log writer
+ *
+ * Callers format a message and push it into a lock-free ring buffer; a background
+ * writer thread drains the ring in batches and writes each batch with a single call
+ * to a file handle that stays open for the lifetime of the logger. Timestamps are
+ * formatted by the writer once per second instead of once per message. Messages
+ * above the configured level are discarded before they are queued, and callers on
+ * hot paths should test enabled() before building the message string at all.
+ *
+ * The destructor drains everything that has been logged before it returns.
+ */
+class Logger {
+private:
+    /**
+     * @brief One queued log message
+     */
+    struct Record {
+        LogLevel level;     ///< Severity of the message
+        std::string text;   ///< Message body without timestamp or newline
+    };
+
+    RingBuffer<Record> ring;                ///< Messages waiting for the writer thread
+    std::ofstream file;                     ///< Long-lived output file handle
+    std::atomic<int> level;                 ///< Most verbose level that is still recorded
+    std::atomic<bool> echo_console;         ///< Whether messages are also written to stdout
+    std::atomic<bool> running;              ///< Cleared to ask the writer thread to exit
+    std::atomic<uint64_t> enqueued;         ///< Number of messages accepted by log()
+    std::atomic<uint64_t> written;          ///< Number of messages written out by the writer
+    std::thread writer;                     ///< Background writer thread
+
+    /**
+     * @brief Writer thread body: drains the ring and writes batches until stopped
+     */
+    void writerLoop();
+
+    /**
+     * @brief Writes up to one batch of queued messages
+     * @param batch Scratch buffer for the file copy of the batch
+     * @param console Scratch buffer for the console copy of the batch
+     * @param stamp Cached "[timestamp] " prefix
+     * @param stamp_second Second the cached prefix was formatted for
+     * @return Number of messages written
+     */
+    size_t drainBatch(std::string& batch, std::string& console, std::string& stamp, int64_t& stamp_second);
+
+public:
+    /**
+     * @brief Opens the log file in append mode and starts the writer thread
+     * @param filepath Path of the log file
+     * @param echoToConsole Whether messages are also printed to stdout
+     * @param capacity Number of messages that can be queued before log() waits for the writer
+     */
+    Logger(const std::string& filepath, bool echoToConsole = true, size_t capacity = 1 << 16);
+
+    /**
+     * @brief Flushes all pending messages, stops the writer thread and closes the file
+     */
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @brief Checks whether messages of the given level are recorded
+     * @param msgLevel Level to test
+     * @return true if a message of this level would be written
+     */
+    bool enabled(LogLevel msgLevel) const {
+        return static_cast<int>(msgLevel) <= level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Queues a message for the writer thread
+     *
+     * Returns immediately unless the ring is full, in which case the caller yields
+     * until the writer makes room, so no message is ever dropped.
+     *
+     * @param msgLevel Severity of the message
+     * @param message Message body (moved into the queue)
+     */
+    void log(LogLevel msgLevel, std::string message);
+
+    /**
+     * @brief Blocks until every message queued so far has been written and flushed
+     */
+    void flush();
+
+    /**
+     * @brief Sets the most verbose level that is recorded
+     * @param newLevel New verbosity threshold
+     */
+    void setLevel(LogLevel newLevel);
+
+    /**
+     * @brief Gets the current verbosity threshold
+     * @return Most verbose level that is recorded
+     */
+    LogLevel getLevel() const;
+
+    /**
+     * @brief Enables or disables the copy of each message on stdout
+     * @param echo true to print messages to the console as well as the file
+     */
+    void setConsoleEcho(bool echo);
+};
+
+#endif // LOGGER_H
@@ -0,0 +1,146 @@
+/**
+ * @file Profiler.cpp
+ * @brief Profiler class implementation
+ */
+
+#include "Profiler.h"
+#include <cstdio>
+
+namespace {
+    const char* const PHASE_NAMES[PROFILE_PHASES] = {"tick", "arrivals", "scaling", "servers", "logging"};
+    const char* const COUNTER_NAMES[PROFILE_COUNTERS] = {"enqueues", "dispatches", "completions", "blocks", "scale_events"};
+}
+
+Profiler::Profiler(const std::string& outputPrefix)
+    : prefix(outputPrefix), tick_time(), previous(), dropped(0), tick(0), ticks(0), start_clock(0) {}
+
+void Profiler::begin(size_t workers) {
+    owner = std::this_thread::get_id();
+    threads.assign(workers > 0 ? workers : 1, ThreadCounters());
+    for (size_t p = 0; p < PROFILE_PHASES; ++p) {
+        tick_time[p] = 0;
+    }
+    for (size_t c = 0; c < PROFILE_COUNTERS; ++c) {
+        previous[c] = 0;
+    }
+    phases.assign(PROFILE_PHASES, LatencyHistogram());
+    counters.assign(PROFILE_COUNTERS, LatencyHistogram());
+    spans.clear();
+    samples.clear();
+    dropped = 0;
+    ticks = 0;
+    start_wall = std::chrono::steady_clock::now();
+    start_clock = clock();
+}
+
+void Profiler::endTick(uint64_t end) {
+    ticks++;
+    TickSample sample;
+    sample.end = end;
+    for (size_t c = 0; c < PROFILE_COUNTERS; ++c) {
+        uint64_t total = 0;
+        for (const ThreadCounters& slot : threads) {
+            total += slot.counts[c];
+        }
+        sample.counts[c] = total - previous[c];
+        counters[c].record(sample.counts[c]);
+        previous[c] = total;
+    }
+    for (size_t p = 0; p < PROFILE_PHASES; ++p) {
+        phases[p].record(tick_time[p]);
+        tick_time[p] = 0;
+    }
+    if (samples.size() < MAX_SPANS) {
+        samples.push_back(sample);
+    } else {
+        dropped++;
+    }
+}
+
+bool Profiler::finish() {
+    owner = std::thread::id();
+    // The time stamp counter runs at a fixed rate; measure it against the wall clock
+    uint64_t clocks = clock() - start_clock;
+    double wall = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_wall).count());
+    double perNs = 1.0;
+#ifdef PROFILER_TSC
+    if (wall > 0.0 && clocks > 0) {
+        perNs = static_cast<double>(clocks) / wall;
+    }
+#else
+    (void)clocks;
+#endif
+    bool report = writeReport(prefix + ".json", perNs);
+    bool trace = writeTrace(prefix + ".trace.json", perNs);
+    return report && trace;
+}
+
+bool Profiler::writeReport(const std::string& filepath, double perNs) const {
+    FILE* out = std::fopen(filepath.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    double tickTotal = phases.empty() ? 0.0 : phases[0].mean() * static_cast<double>(phases[0].count());
+    std::fprintf(out, "{\n  \"clock\": \"%s\",\n  \"clock_per_ns\": %.4f,\n  \"ticks\": %llu,\n  \"workers\": %zu,\n",
+#ifdef PROFILER_TSC
+                 "tsc",
+#else
+                 "steady_clock",
+#endif
+                 perNs, static_cast<unsigned long long>(ticks), threads.size());
+    std::fprintf(out, "  \"phases\": {\n");
+    for (size_t p = 0; p < phases.size(); ++p) {
+        const LatencyHistogram& h = phases[p];
+        double total = h.mean() * static_cast<double>(h.count());
+        std::fprintf(out, "    \"%s\": {\"total_ms\": %.3f, \"share\": %.4f, \"mean_ns\": %.1f, \"p50_ns\": %.1f, "
+                     "\"p90_ns\": %.1f, \"p99_ns\": %.1f, \"p999_ns\": %.1f, \"max_ns\": %.1f}%s\n",
+                     PHASE_NAMES[p], total / perNs / 1e6, tickTotal > 0.0 ? total / tickTotal : 0.0, h.mean() / perNs,
+                     h.percentile(50.0) / perNs, h.percentile(90.0) / perNs, h.percentile(99.0) / perNs,
+                     h.percentile(99.9) / perNs, h.max() / perNs, p + 1 < phases.size() ? "," : "");
+    }
+    std::fprintf(out, "  },\n  \"counters\": {\n");
+    for (size_t c = 0; c < counters.size(); ++c) {
+        const LatencyHistogram& h = counters[c];
+        std::fprintf(out, "    \"%s\": {\"total\": %llu, \"per_tick_mean\": %.3f, \"per_tick_p99\": %llu, "
+                     "\"per_tick_max\": %llu, \"per_thread\": [",
+                     COUNTER_NAMES[c], static_cast<unsigned long long>(previous[c]), h.mean(),
+                     static_cast<unsigned long long>(h.percentile(99.0)), static_cast<unsigned long long>(h.max()));
+        for (size_t t = 0; t < threads.size(); ++t) {
+            std::fprintf(out, "%s%llu", t ? ", " : "", static_cast<unsigned long long>(threads[t].counts[c]));
+        }
+        std::fprintf(out, "]}%s\n", c + 1 < counters.size() ? "," : "");
+    }
+    std::fprintf(out, "  },\n  \"timeline\": {\"spans\": %zu, \"ticks\": %zu, \"dropped\": %llu}\n}\n",
+                 spans.size(), samples.size(), static_cast<unsigned long long>(dropped));
+    return std::fclose(out) == 0;
+}
+
+bool Profiler::writeTrace(const std::string& filepath, double perNs) const {
+    FILE* out = std::fopen(filepath.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    // Trace-event timestamps are microseconds from the start of the profile
+    const double perUs = perNs * 1000.0;
+    std::fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n"
+                 "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"LoadBalancer\"}},\n"
+                 "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"simulation\"}}");
+    for (const Span& span : spans) {
+        std::fprintf(out, ",\n{\"name\": \"%s\", \"cat\": \"tick\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+                     "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"tick\": %d}}",
+                     PHASE_NAMES[static_cast<size_t>(span.phase)], static_cast<double>(span.start - start_clock) / perUs,
+                     static_cast<double>(span.duration) / perUs, span.tick);
+    }
+    for (const TickSample& sample : samples) {
+        std::fprintf(out, ",\n{\"name\": \"events\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"args\": {",
+                     static_cast<double>(sample.end - start_clock) / perUs);
+        for (size_t c = 0; c < PROFILE_COUNTERS; ++c) {
+            std::fprintf(out, "%s\"%s\": %llu", c ? ", " : "", COUNTER_NAMES[c],
+                         static_cast<unsigned long long>(sample.counts[c]));
+        }
+        std::fprintf(out, "}}");
+    }
+    std::fprintf(out, "\n]}\n");
+    return std::fclose(out) == 0;
+}
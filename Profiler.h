@@ -0,0 +1,277 @@
+/**
+ * @file Profiler.h
+ * @brief Profiler class header file
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PROFILER_TSC 1
+#endif
+
+// Built in unless the build says otherwise (make PROFILING=0)
+#ifndef LB_PROFILING
+#define LB_PROFILING 1
+#endif
+
+/**
+ * @brief Whether the profiler is compiled in
+ *
+ * When false every ScopedPhase and profileCount() folds away, so the hot path
+ * carries no trace of the profiler at all.
+ */
+constexpr bool PROFILING = LB_PROFILING != 0;
+
+/**
+ * @brief Part of a simulated tick that is timed separately
+ */
+enum class ProfilePhase : uint8_t {
+    Tick = 0,   ///< The whole tick
+    Arrivals,   ///< Generating, filtering and queuing the arriving requests
+    Scaling,    ///< Servers coming online and the autoscaler
+    Servers,    ///< Head drops, dispatch, countdown and completions
+    Logging     ///< Handing messages to the log writer (also counted in the phase that logs)
+};
+
+/**
+ * @brief Event counted per thread while profiling
+ */
+enum class ProfileCounter : uint8_t {
+    Enqueues = 0,   ///< Requests queued
+    Dispatches,     ///< Requests handed to a server (including preemptions)
+    Completions,    ///< Requests finished
+    Blocks,         ///< Requests refused by the firewall or the rate limiter
+    ScaleEvents     ///< Servers added or removed by the autoscaler
+};
+
+const size_t PROFILE_PHASES = 5;    ///< Number of ProfilePhase values
+const size_t PROFILE_COUNTERS = 5;  ///< Number of ProfileCounter values
+
+/**
+ * @brief Low-overhead instrumentation of the simulation's hot path
+ *
+ * Scoped timers (see ScopedPhase) read the time stamp counter where there is one
+ * and std::chrono::steady_clock elsewhere; the counter is converted to nanoseconds
+ * with a rate measured over the run. Each phase's time is summed over a tick, and
+ * when the tick's own timer closes the sums go into one histogram per phase and the
+ * counters into one histogram per counter, so the report shows how the cost of a
+ * tick is distributed rather than just its mean.
+ *
+ * Counters are kept per worker thread in cache-line sized slots, so the sharded
+ * tick counts without sharing lines; they are summed at the end of every tick.
+ * Every timed span is also kept for a timeline, up to a fixed number of spans.
+ *
+ * A profiler belongs to the thread that calls begin(); timers on other threads
+ * must not be given it. finish() writes the report as JSON and the spans in the
+ * Chrome trace-event format, which chrome://tracing and Perfetto show as a
+ * timeline and flame chart.
+ */
+class Profiler {
+private:
+    /**
+     * @brief One worker's counters, padded to a cache line
+     */
+    struct alignas(64) ThreadCounters {
+        uint64_t counts[PROFILE_COUNTERS];  ///< Events per ProfileCounter
+    };
+
+    /**
+     * @brief One timed span of the timeline
+     */
+    struct Span {
+        uint64_t start;     ///< Clock reading when the span began
+        uint64_t duration;  ///< Clock units the span lasted
+        int32_t tick;       ///< Simulated tick the span belongs to
+        ProfilePhase phase; ///< What was timed
+    };
+
+    /**
+     * @brief Counters of one tick for the timeline
+     */
+    struct TickSample {
+        uint64_t end;                       ///< Clock reading when the tick ended
+        uint64_t counts[PROFILE_COUNTERS];  ///< Events on the tick
+    };
+
+    static constexpr size_t MAX_SPANS = size_t(1) << 19;   ///< Spans kept for the timeline (about 12 MB)
+
+    std::string prefix;                         ///< Output files are <prefix>.json and <prefix>.trace.json
+    std::thread::id owner;                      ///< Thread that runs the simulation
+    std::vector<ThreadCounters> threads;        ///< Counters per worker (worker 0 is the owner)
+    uint64_t tick_time[PROFILE_PHASES];         ///< Time per phase on the current tick
+    uint64_t previous[PROFILE_COUNTERS];        ///< Counter totals at the end of the last tick
+    std::vector<LatencyHistogram> phases;       ///< Time per tick, one histogram per phase (clock units)
+    std::vector<LatencyHistogram> counters;     ///< Events per tick, one histogram per counter
+    std::vector<Span> spans;                    ///< Timeline, oldest first
+    std::vector<TickSample> samples;            ///< Counters per tick for the timeline
+    uint64_t dropped;                           ///< Spans and samples that did not fit
+    int32_t tick;                               ///< Current simulated tick
+    uint64_t ticks;                             ///< Ticks profiled
+    uint64_t start_clock;                       ///< Clock reading at begin()
+    std::chrono::steady_clock::time_point start_wall;  ///< Wall time at begin()
+
+    /**
+     * @brief Moves the current tick's times and counts to the histograms and the timeline
+     * @param end Clock reading at the end of the tick
+     */
+    void endTick(uint64_t end);
+
+    /**
+     * @brief Writes the summary report
+     * @param filepath Output file
+     * @param perNs Clock units per nanosecond
+     * @return false if the file could not be written
+     */
+    bool writeReport(const std::string& filepath, double perNs) const;
+
+    /**
+     * @brief Writes the timeline in the Chrome trace-event format
+     * @param filepath Output file
+     * @param perNs Clock units per nanosecond
+     * @return false if the file could not be written
+     */
+    bool writeTrace(const std::string& filepath, double perNs) const;
+
+public:
+    /**
+     * @brief Constructs a profiler
+     * @param outputPrefix Output files are <outputPrefix>.json and <outputPrefix>.trace.json
+     */
+    explicit Profiler(const std::string& outputPrefix);
+
+    /**
+     * @brief Reads the profiling clock
+     * @return Time stamp counter, or nanoseconds of steady_clock where there is none
+     */
+    static uint64_t clock() {
+#ifdef PROFILER_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * @brief Starts a profile on the calling thread, discarding any earlier one
+     * @param workers Worker threads that count events (at least 1)
+     */
+    void begin(size_t workers);
+
+    /**
+     * @brief Stops the profile and writes <prefix>.json and <prefix>.trace.json
+     *
+     * No thread owns the profiler afterwards (see onOwnerThread()).
+     *
+     * @return false if a file could not be written
+     */
+    bool finish();
+
+    /**
+     * @brief Tells the profiler which tick is being simulated
+     * @param time Simulated tick
+     */
+    void setTick(int time) { tick = time; }
+
+    /**
+     * @brief Checks whether the caller is the thread that runs the simulation
+     * @return true on the thread that called begin()
+     */
+    bool onOwnerThread() const { return std::this_thread::get_id() == owner; }
+
+    /**
+     * @brief Records a timed span
+     *
+     * A Tick span closes the tick: the phase times and the counts gathered since
+     * the previous one go to the histograms.
+     *
+     * @param phase What was timed
+     * @param start Clock reading at the start
+     * @param end Clock reading at the end
+     */
+    void record(ProfilePhase phase, uint64_t start, uint64_t end) {
+        uint64_t duration = end - start;
+        tick_time[static_cast<size_t>(phase)] += duration;
+        if (spans.size() < MAX_SPANS) {
+            spans.push_back(Span{start, duration, tick, phase});
+        } else {
+            dropped++;
+        }
+        if (phase == ProfilePhase::Tick) {
+            endTick(end);
+        }
+    }
+
+    /**
+     * @brief Counts events
+     * @param counter What happened
+     * @param worker Worker thread that saw it (0 on the simulation thread)
+     * @param n Number of events
+     */
+    void count(ProfileCounter counter, size_t worker = 0, uint64_t n = 1) {
+        threads[worker].counts[static_cast<size_t>(counter)] += n;
+    }
+
+    /**
+     * @brief Gets the files finish() writes
+     * @return Output prefix
+     */
+    const std::string& outputPrefix() const { return prefix; }
+};
+
+/**
+ * @brief Times the enclosing scope as one phase
+ *
+ * Does nothing if it is given no profiler or the profiler is compiled out.
+ */
+class ScopedPhase {
+private:
+    Profiler* profiler;     ///< Profiler that receives the span, or null
+    ProfilePhase phase;     ///< What is timed
+    uint64_t start;         ///< Clock reading at construction
+
+public:
+    /**
+     * @brief Starts timing
+     * @param target Profiler of the calling thread, or null
+     * @param timed What is timed
+     */
+    ScopedPhase(Profiler* target, ProfilePhase timed)
+        : profiler(PROFILING ? target : nullptr), phase(timed), start(profiler ? Profiler::clock() : 0) {}
+
+    /**
+     * @brief Records the span
+     */
+    ~ScopedPhase() {
+        if (PROFILING && profiler) {
+            profiler->record(phase, start, Profiler::clock());
+        }
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+};
+
+/**
+ * @brief Counts events if a profiler is given and compiled in
+ * @param profiler Profiler, or null
+ * @param counter What happened
+ * @param worker Worker thread that saw it (0 on the simulation thread)
+ * @param n Number of events
+ */
+inline void profileCount(Profiler* profiler, ProfileCounter counter, size_t worker = 0, uint64_t n = 1) {
+    if (PROFILING && profiler) {
+        profiler->count(counter, worker, n);
+    }
+}
+
+#endif // PROFILER_H
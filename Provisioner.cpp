@@ -0,0 +1,139 @@
+/**
+ * @file Provisioner.cpp
+ * @brief Provisioner class implementation
+ */
+#include "Provisioner.h"
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+Provisioner::Provisioner()
+    : delay(0), warmup(0), target(0), ready(0), last_time(0), standby_ticks(0), booting_ticks(0), draws(0),
+      cold_starts(0) {
+}
+
+void Provisioner::accrue(int now) {
+    standby_ticks = standbyTicks(now);
+    booting_ticks = bootingTicks(now);
+    last_time = now;
+}
+
+void Provisioner::configure(int provisionDelay, int warmupTicks, int standby, int now) {
+    accrue(now);
+    delay = std::max(provisionDelay, 0);
+    warmup = std::max(warmupTicks, 0);
+    target = std::max(standby, 0);
+    ready = target;
+    refills.clear();
+}
+
+bool Provisioner::takeStandby(int now) {
+    if (ready == 0) {
+        return false;
+    }
+    accrue(now);
+    ready--;
+    refills.push_back(now + delay + warmup);    // the replacement must boot and warm up
+    draws++;
+    return true;
+}
+
+int Provisioner::orderCold(int now) {
+    accrue(now);
+    booting.push_back(now + delay);
+    cold_starts++;
+    return now + delay;
+}
+
+bool Provisioner::offerStandby(int now) {
+    if (ready + static_cast<int>(refills.size()) >= target) {
+        return false;
+    }
+    accrue(now);
+    ready++;
+    return true;
+}
+
+int Provisioner::collect(int now) {
+    if (nextEvent() > now) {
+        return 0;
+    }
+    accrue(now);
+    while (!refills.empty() && refills.front() <= now) {
+        refills.pop_front();
+        ready++;
+    }
+    int joined = 0;
+    while (!booting.empty() && booting.front() <= now) {
+        booting.pop_front();
+        joined++;
+    }
+    return joined;
+}
+
+int Provisioner::nextEvent() const {
+    int next = INT_MAX;
+    if (!refills.empty()) {
+        next = std::min(next, refills.front());
+    }
+    if (!booting.empty()) {
+        next = std::min(next, booting.front());
+    }
+    return next;
+}
+
+uint64_t Provisioner::standbyTicks(int now) const {
+    uint64_t elapsed = static_cast<uint64_t>(std::max(now - last_time, 0));
+    return standby_ticks + elapsed * (static_cast<uint64_t>(ready) + refills.size());
+}
+
+uint64_t Provisioner::bootingTicks(int now) const {
+    uint64_t elapsed = static_cast<uint64_t>(std::max(now - last_time, 0));
+    return booting_ticks + elapsed * booting.size();
+}
+
+namespace {
+    /**
+     * @brief Scalar state of a Provisioner as stored in a checkpoint
+     */
+    struct ProvisionerScalars {
+        uint64_t standby_ticks;     ///< Server-ticks spent on standby and refills
+        uint64_t booting_ticks;     ///< Server-ticks spent booting cold servers
+        uint64_t draws;             ///< Scale-ups served from standby
+        uint64_t cold_starts;       ///< Scale-ups that booted a cold server
+        int32_t delay;              ///< Provisioning delay
+        int32_t warmup;             ///< Warm-up time
+        int32_t target;             ///< Standby servers to keep
+        int32_t ready;              ///< Warm standby servers available
+        int32_t last_time;          ///< Tick up to which costs have been accumulated
+    };
+}
+
+void Provisioner::saveState(SnapshotWriter& out) const {
+    out.addValue("provisioner", ProvisionerScalars{standby_ticks, booting_ticks, draws, cold_starts, delay, warmup,
+                                                   target, ready, last_time});
+    out.add("provisioner.refills", std::vector<int>(refills.begin(), refills.end()));
+    out.add("provisioner.booting", std::vector<int>(booting.begin(), booting.end()));
+}
+
+bool Provisioner::restoreState(SnapshotReader& in) {
+    ProvisionerScalars scalars;
+    std::vector<int> restoredRefills;
+    std::vector<int> restoredBooting;
+    if (!in.readValue("provisioner", scalars) || !in.read("provisioner.refills", restoredRefills)
+        || !in.read("provisioner.booting", restoredBooting)) {
+        return false;
+    }
+    delay = scalars.delay;
+    warmup = scalars.warmup;
+    target = scalars.target;
+    ready = scalars.ready;
+    refills.assign(restoredRefills.begin(), restoredRefills.end());
+    booting.assign(restoredBooting.begin(), restoredBooting.end());
+    last_time = scalars.last_time;
+    standby_ticks = scalars.standby_ticks;
+    booting_ticks = scalars.booting_ticks;
+    draws = scalars.draws;
+    cold_starts = scalars.cold_starts;
+    return true;
+}
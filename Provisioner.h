@@ -0,0 +1,166 @@
+/**
+ * @file Provisioner.h
+ * @brief Provisioner class header file
+ */
+#ifndef PROVISIONER_H
+#define PROVISIONER_H
+
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * @brief Tracks servers that are starting up and the pre-warmed standby pool
+ *
+ * A cold server ordered by scale-up takes a provisioning delay before it can join
+ * the pool. Standby servers are already provisioned and warm, so a scale-up that
+ * draws one gets a working server immediately; the provisioner then orders a
+ * replacement in the background, which takes the provisioning delay plus the
+ * warm-up time before it is back in standby. A server removed by scale-down
+ * returns to standby if standby is short.
+ *
+ * All changes are keyed to the simulation tick, so the event engine can jump to
+ * nextEvent() instead of polling. Every server the provisioner holds is paid for;
+ * the server-ticks spent on standby and on booting cold servers are accumulated
+ * for the cost report.
+ */
+class Provisioner {
+private:
+    int delay;                      ///< Ticks from ordering a server until it can take work
+    int warmup;                     ///< Ticks a new server needs to reach full speed
+    int target;                     ///< Standby servers to keep
+    int ready;                      ///< Warm standby servers available now
+    std::deque<int> refills;        ///< Ticks at which ordered standby replacements arrive
+    std::deque<int> booting;        ///< Ticks at which ordered cold servers can join the pool
+    int last_time;                  ///< Tick up to which costs have been accumulated
+    uint64_t standby_ticks;         ///< Server-ticks spent on standby and on refilling it
+    uint64_t booting_ticks;         ///< Server-ticks spent booting cold servers
+    uint64_t draws;                 ///< Scale-ups served from standby
+    uint64_t cold_starts;           ///< Scale-ups that had to boot a cold server
+
+    /**
+     * @brief Accumulates the cost of the servers held since the last change
+     * @param now Current tick
+     */
+    void accrue(int now);
+
+public:
+    /**
+     * @brief Constructs a provisioner with no delay, no warm-up and no standby servers
+     */
+    Provisioner();
+
+    /**
+     * @brief Sets the provisioning model and fills the standby pool
+     * @param provisionDelay Ticks from ordering a server until it can take work
+     * @param warmupTicks Ticks a new server needs to reach full speed
+     * @param standby Standby servers to keep (all of them warm from now on)
+     * @param now Current tick
+     */
+    void configure(int provisionDelay, int warmupTicks, int standby, int now);
+
+    /**
+     * @brief Checks whether scale-ups can take effect on the tick they are ordered
+     * @return true if there is no provisioning delay
+     */
+    bool instant() const { return delay == 0; }
+
+    /**
+     * @brief Checks whether any part of the provisioning model is in use
+     * @return true if there is a delay, a warm-up or a standby pool
+     */
+    bool enabled() const { return delay > 0 || warmup > 0 || target > 0; }
+
+    /**
+     * @brief Takes a warm server from standby and orders its replacement
+     * @param now Current tick
+     * @return false if standby is empty
+     */
+    bool takeStandby(int now);
+
+    /**
+     * @brief Orders a cold server
+     * @param now Current tick
+     * @return Tick at which the server can join the pool
+     */
+    int orderCold(int now);
+
+    /**
+     * @brief Counts a cold start that joins the pool at once (no provisioning delay)
+     */
+    void countColdStart() { cold_starts++; }
+
+    /**
+     * @brief Puts a server removed from the pool into standby if standby is short
+     * @param now Current tick
+     * @return true if the server was kept in standby
+     */
+    bool offerStandby(int now);
+
+    /**
+     * @brief Moves arrived replacements into standby and collects cold servers that are ready
+     * @param now Current tick
+     * @return Number of cold servers that can join the pool now
+     */
+    int collect(int now);
+
+    /**
+     * @brief Gets the tick of the next arrival of an ordered server
+     * @return Tick, or INT_MAX if nothing is on order
+     */
+    int nextEvent() const;
+
+    /**
+     * @brief Gets the number of cold servers on order
+     * @return Servers still booting
+     */
+    size_t bootingCount() const { return booting.size(); }
+
+    /**
+     * @brief Gets the number of warm standby servers
+     * @return Standby servers available now
+     */
+    int standbyCount() const { return ready; }
+
+    /**
+     * @brief Gets the server-ticks spent on standby servers, including replacements on order
+     * @param now Current tick
+     * @return Standby server-ticks
+     */
+    uint64_t standbyTicks(int now) const;
+
+    /**
+     * @brief Gets the server-ticks spent booting cold servers
+     * @param now Current tick
+     * @return Booting server-ticks
+     */
+    uint64_t bootingTicks(int now) const;
+
+    /**
+     * @brief Gets the number of scale-ups served from standby
+     * @return Standby draws
+     */
+    uint64_t standbyDraws() const { return draws; }
+
+    /**
+     * @brief Gets the number of scale-ups that booted a cold server
+     * @return Cold starts
+     */
+    uint64_t coldStarts() const { return cold_starts; }
+
+    /**
+     * @brief Adds the settings, standby pool, booting servers and costs to a checkpoint
+     * @param out Checkpoint being written
+     */
+    void saveState(SnapshotWriter& out) const;
+
+    /**
+     * @brief Replaces the provisioner's state with the one stored in a checkpoint
+     * @param in Open checkpoint
+     * @return false if a section is missing (the state is then unchanged)
+     */
+    bool restoreState(SnapshotReader& in);
+};
+
+#endif // PROVISIONER_H
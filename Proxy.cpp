@@ -0,0 +1,744 @@
+/**
+ * @file Proxy.cpp
+ * @brief Proxy class implementation
+ */
+
+#include "Proxy.h"
+#include "DispatchPolicy.h"
+#include "IpAddress.h"
+#include "ServerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * @brief Parses "[<address>:]<port>"
+     * @param text Text to parse
+     * @param address Receives the address (127.0.0.1 if none is given)
+     * @param port Receives the port
+     * @return false if the text is not a valid endpoint
+     */
+    bool parseEndpoint(const std::string& text, uint32_t& address, uint16_t& port) {
+        size_t colon = text.rfind(':');
+        std::string digits = colon == std::string::npos ? text : text.substr(colon + 1);
+        address = 0x7F000001u;
+        if (colon != std::string::npos && !parseIPv4(text.substr(0, colon), address)) {
+            return false;
+        }
+        if (digits.empty() || digits.size() > 5 || digits.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        unsigned long value = std::strtoul(digits.c_str(), nullptr, 10);
+        if (value == 0 || value > 65535) {
+            return false;
+        }
+        port = static_cast<uint16_t>(value);
+        return true;
+    }
+}
+
+bool parseProxySettings(const std::string& spec, ProxySettings& settings) {
+    std::istringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, equals);
+        std::string text = item.substr(equals + 1);
+        if (key == "listen") {
+            if (!parseEndpoint(text, settings.listen_address, settings.listen_port)) {
+                return false;
+            }
+            continue;
+        }
+        if (key == "backend") {
+            ProxyBackend backend;
+            if (!parseEndpoint(text, backend.address, backend.port)) {
+                return false;
+            }
+            settings.backends.push_back(backend);
+            continue;
+        }
+        if (key == "policy") {
+            // Dispatch parameters use commas too ("weighted:3,1"), so the policy takes the rest
+            std::string rest;
+            if (std::getline(list, rest, '\0')) {
+                text += "," + rest;
+            }
+            if (!makeDispatchPolicy(text, 0)) {
+                return false;
+            }
+            settings.policy = text;
+            continue;
+        }
+
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0') {
+            return false;
+        }
+        if (key == "workers" && value >= 1 && value <= 256) {
+            settings.workers = static_cast<int>(value);
+        } else if (key == "slots" && value >= 1 && value <= 65536) {
+            settings.slots = static_cast<int>(value);
+        } else if (key == "pool" && value >= 0 && value <= 65536) {
+            settings.pool = static_cast<int>(value);
+        } else if (key == "backlog" && value >= 0 && value <= 1000000) {
+            settings.backlog = static_cast<int>(value);
+        } else if (key == "seconds" && value >= 0 && value <= 100000000) {
+            settings.seconds = static_cast<int>(value);
+        } else {
+            return false;
+        }
+    }
+    return !settings.backends.empty();
+}
+
+Proxy::Proxy(const ProxySettings& proxySettings, const Blocklist& rules)
+    : settings(proxySettings), blocklist(rules), stopping(false) {}
+
+#ifdef __linux__
+
+namespace {
+    std::atomic<bool> signalled(false);     ///< Set by SIGINT and SIGTERM while a proxy runs
+
+    /**
+     * @brief Signal handler that asks the running proxy to stop
+     * @param signal Signal number
+     */
+    void onSignal(int signal) {
+        (void)signal;
+        signalled.store(true);
+    }
+
+    /**
+     * @brief Disables Nagle's algorithm; the proxy forwards whatever arrives at once
+     * @param fd TCP socket
+     */
+    void setNoDelay(int fd) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    /**
+     * @brief Fills an IPv4 socket address
+     * @param address Address (host byte order)
+     * @param port Port
+     * @return Socket address
+     */
+    sockaddr_in socketAddress(uint32_t address, uint16_t port) {
+        sockaddr_in sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(address);
+        sa.sin_port = htons(port);
+        return sa;
+    }
+
+    /**
+     * @brief Opens a non-blocking listening socket that other workers can bind as well
+     * @param address Address to listen on (host byte order)
+     * @param port Port to listen on
+     * @param error Receives the reason on failure
+     * @return Socket, or -1 on failure
+     */
+    int openListener(uint32_t address, uint16_t port, std::string& error) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            error = std::string("socket: ") + std::strerror(errno);
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        sockaddr_in sa = socketAddress(address, port);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 || listen(fd, SOMAXCONN) != 0) {
+            error = "Cannot listen on " + formatIPv4(address) + ":" + std::to_string(port) + ": " + std::strerror(errno);
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+}
+
+/**
+ * @brief One event loop: a listening socket, its sessions and its backend connections
+ *
+ * Epoll data packs what an event is for: the kind in the top byte, then 24 bits and
+ * 32 bits whose meaning depends on the kind. A session event carries the slot and
+ * the slot's generation, so an event that was already queued for a session that
+ * ended is recognised and dropped. A pooled connection carries its backend and fd.
+ */
+class Proxy::Worker {
+public:
+    /**
+     * @brief Creates a worker around a listening socket
+     * @param owner Proxy the worker belongs to
+     * @param listenFd Listening socket (owned by the worker from now on)
+     * @param policy Dispatch policy of this worker
+     */
+    Worker(Proxy& owner, int listenFd, std::unique_ptr<DispatchPolicy> policy)
+        : proxy(owner), settings(owner.settings), listener(listenFd), epoll(-1), dispatch(std::move(policy)),
+          backends(settings.backends.size()), idle(backends), started(std::chrono::steady_clock::now()) {
+        stats.per_backend.assign(backends, 0);
+        ServerProfile profile;
+        profile.slots = settings.slots;
+        pool.setFleet(std::vector<ServerProfile>(1, profile));
+        pool.reserve(backends);
+        for (size_t i = 0; i < backends; ++i) {
+            pool.add();
+        }
+        dispatch->reset(pool);
+        size_t slots = backends * static_cast<size_t>(settings.slots);
+        sessions.resize(slots);
+        free_sessions.reserve(slots);
+        for (size_t slot = slots; slot > 0; --slot) {
+            free_sessions.push_back(slot - 1);
+        }
+    }
+
+    /**
+     * @brief Closes every socket and pipe the worker still holds
+     */
+    ~Worker() {
+        for (size_t slot = 0; slot < sessions.size(); ++slot) {
+            if (sessions[slot].client >= 0) {
+                finish(slot, false);
+            }
+        }
+        for (std::vector<int>& fds : idle) {
+            for (int fd : fds) {
+                close(fd);
+            }
+        }
+        for (const Pending& p : pending) {
+            close(p.fd);
+        }
+        for (const Pipes& p : spare_pipes) {
+            closePipes(p);
+        }
+        if (listener >= 0) {
+            close(listener);
+        }
+        if (epoll >= 0) {
+            close(epoll);
+        }
+    }
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    /**
+     * @brief Serves connections until the proxy stops or the deadline passes
+     * @param deadline Time to stop at
+     */
+    void run(std::chrono::steady_clock::time_point deadline) {
+        epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll < 0 || !watch(listener, EPOLL_CTL_ADD, EPOLLIN, pack(LISTENER, 0, 0))) {
+            return;
+        }
+        epoll_event events[256];
+        while (!proxy.stopping.load() && !signalled.load() && std::chrono::steady_clock::now() < deadline) {
+            int n = epoll_wait(epoll, events, 256, 100);
+            for (int i = 0; i < n; ++i) {
+                handle(events[i]);
+            }
+            startPending();
+        }
+    }
+
+    /**
+     * @brief Gets the worker's counters
+     * @return Counters
+     */
+    const ProxyStats& getStats() const { return stats; }
+
+private:
+    enum Kind : uint64_t { LISTENER = 1, CLIENT = 2, BACKEND = 3, POOLED = 4 };
+
+    static constexpr size_t CHUNK = 1 << 16;    ///< Most bytes moved by one splice() call
+
+    /**
+     * @brief Pipe pair of a session; [0] is the read end
+     */
+    struct Pipes {
+        int up[2];      ///< Client to backend
+        int down[2];    ///< Backend to client
+    };
+
+    /**
+     * @brief A client connection relayed to a backend
+     */
+    struct Session {
+        int client = -1;            ///< Client socket, or -1 if the slot is free
+        int backend = -1;           ///< Backend socket
+        size_t target = 0;          ///< Backend index
+        uint32_t generation = 0;    ///< Incremented for every session on the slot
+        Pipes pipes = {{-1, -1}, {-1, -1}};    ///< Splice buffers (up[0] is -1 without pipes)
+        size_t up_bytes = 0;        ///< Bytes in the client-to-backend pipe
+        size_t down_bytes = 0;      ///< Bytes in the backend-to-client pipe
+        bool connecting = false;    ///< Backend connection still in progress
+        bool client_eof = false;    ///< Client sent FIN
+        bool backend_eof = false;   ///< Backend sent FIN
+        bool shut_backend = false;  ///< FIN forwarded to the backend
+        bool awaiting = false;      ///< Bytes went to the backend after the last reply bytes came back
+    };
+
+    /**
+     * @brief A client waiting for a free slot
+     */
+    struct Pending {
+        int fd;         ///< Client socket
+        uint32_t ip;    ///< Client address
+    };
+
+    Proxy& proxy;                               ///< Owner (stop flag)
+    const ProxySettings& settings;              ///< Listening address, backends and limits
+    int listener;                               ///< Listening socket
+    int epoll;                                  ///< Event loop
+    std::unique_ptr<DispatchPolicy> dispatch;   ///< Picks a slot for each client
+    size_t backends;                            ///< Number of backends
+    ServerPool pool;                            ///< One server per backend, with a request slot per connection
+    std::vector<Session> sessions;              ///< Session slots, backends * slots of them
+    std::vector<size_t> free_sessions;          ///< Session slots without a client (stack)
+    std::vector<std::vector<int>> idle;         ///< Pooled idle connections per backend
+    std::vector<Pipes> spare_pipes;             ///< Empty pipe pairs of ended sessions
+    std::deque<Pending> pending;                ///< Clients waiting for a slot
+    std::chrono::steady_clock::time_point started;  ///< Start of the run (ServerPool time is in ms since)
+    ProxyStats stats;                           ///< Counters
+
+    static uint64_t pack(uint64_t kind, uint32_t high, uint32_t low) {
+        return (kind << 56) | (static_cast<uint64_t>(high & 0xFFFFFFu) << 32) | low;
+    }
+
+    bool watch(int fd, int op, uint32_t events, uint64_t data) {
+        epoll_event e;
+        e.events = events;
+        e.data.u64 = data;
+        return epoll_ctl(epoll, op, fd, &e) == 0;
+    }
+
+    static void closePipes(const Pipes& p) {
+        close(p.up[0]);
+        close(p.up[1]);
+        close(p.down[0]);
+        close(p.down[1]);
+    }
+
+    /**
+     * @brief Updates the pool's clock so busy times are in milliseconds
+     */
+    void tick() {
+        pool.setTime(static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count()));
+    }
+
+    /**
+     * @brief Dispatches one epoll event
+     * @param e Event
+     */
+    void handle(const epoll_event& e) {
+        uint64_t kind = e.data.u64 >> 56;
+        uint32_t high = static_cast<uint32_t>(e.data.u64 >> 32) & 0xFFFFFFu;
+        uint32_t low = static_cast<uint32_t>(e.data.u64);
+        if (kind == LISTENER) {
+            acceptClients();
+        } else if (kind == POOLED) {
+            // An idle connection is only ever closed or written to by the backend: drop it
+            std::vector<int>& fds = idle[high];
+            std::vector<int>::iterator it = std::find(fds.begin(), fds.end(), static_cast<int>(low));
+            if (it != fds.end()) {
+                fds.erase(it);
+                close(static_cast<int>(low));
+            }
+        } else if (low < sessions.size()) {
+            Session& s = sessions[low];
+            if (s.client < 0 || (s.generation & 0xFFFFFFu) != high) {
+                return;     // queued before its session ended
+            }
+            if (kind == BACKEND && s.connecting) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                if ((e.events & (EPOLLERR | EPOLLHUP))
+                    || getsockopt(s.backend, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+                    stats.failed++;
+                    finish(low, false);
+                    return;
+                }
+                if (!(e.events & EPOLLOUT)) {
+                    return;
+                }
+                s.connecting = false;
+            } else if (e.events & EPOLLERR) {
+                finish(low, false);
+                return;
+            }
+            pump(low);
+        }
+    }
+
+    /**
+     * @brief Accepts every waiting client, applying the firewall and the slot limit
+     */
+    void acceptClients() {
+        for (;;) {
+            sockaddr_in peer;
+            socklen_t length = sizeof(peer);
+            int fd = accept4(listener, reinterpret_cast<sockaddr*>(&peer), &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;     // EAGAIN, or a client that gave up before being accepted
+            }
+            stats.accepted++;
+            uint32_t ip = ntohl(peer.sin_addr.s_addr);
+            if (proxy.blocklist.isBlocked(ip)) {
+                stats.blocked++;
+                close(fd);
+            } else if (!pending.empty() || !start(fd, ip)) {
+                if (pending.size() < static_cast<size_t>(settings.backlog)) {
+                    pending.push_back(Pending{fd, ip});
+                } else {
+                    stats.rejected++;
+                    close(fd);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Gives waiting clients the slots that sessions released
+     */
+    void startPending() {
+        while (!pending.empty() && start(pending.front().fd, pending.front().ip)) {
+            pending.pop_front();
+        }
+    }
+
+    /**
+     * @brief Starts relaying a client to the backend the policy picks
+     * @param fd Client socket
+     * @param ip Client address
+     * @return false if every backend has all its slots taken (the client is left untouched)
+     */
+    bool start(int fd, uint32_t ip) {
+        if (pool.idleCount() == 0) {
+            return false;
+        }
+        Request r(ip, settings.listen_address, 1, pool.getTime());
+        long chosen = dispatch->select(pool, r);
+        if (chosen < 0) {
+            return false;
+        }
+        size_t target = static_cast<size_t>(chosen);
+        tick();
+        pool.assign(target, r);
+        dispatch->serverAssigned(pool, target, r);
+        if (!pool.isBusy(target)) {
+            dispatch->serverIdle(pool, target);     // the backend has slots left
+        }
+
+        // A backend never has more sessions than slots, so a session slot is always free
+        size_t slot = free_sessions.back();
+        free_sessions.pop_back();
+        Session& s = sessions[slot];
+        s.client = fd;
+        s.target = target;
+        s.generation++;
+        s.up_bytes = 0;
+        s.down_bytes = 0;
+        s.client_eof = false;
+        s.backend_eof = false;
+        s.shut_backend = false;
+        s.awaiting = false;
+        s.connecting = false;
+        s.backend = -1;
+        stats.per_backend[s.target]++;
+        setNoDelay(fd);
+
+        if (!spare_pipes.empty()) {
+            s.pipes = spare_pipes.back();
+            spare_pipes.pop_back();
+        } else if (pipe2(s.pipes.up, O_NONBLOCK | O_CLOEXEC) != 0) {
+            s.pipes.up[0] = s.pipes.up[1] = s.pipes.down[0] = s.pipes.down[1] = -1;
+        } else if (pipe2(s.pipes.down, O_NONBLOCK | O_CLOEXEC) != 0) {
+            close(s.pipes.up[0]);
+            close(s.pipes.up[1]);
+            s.pipes.up[0] = s.pipes.up[1] = s.pipes.down[0] = s.pipes.down[1] = -1;
+        }
+
+        uint32_t tag = s.generation & 0xFFFFFFu;
+        uint32_t events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        std::vector<int>& fds = idle[s.target];
+        while (!fds.empty() && !quiet(fds.back())) {
+            close(fds.back());      // the backend wrote to it or closed it while it was pooled
+            fds.pop_back();
+        }
+        if (!fds.empty()) {
+            s.backend = fds.back();
+            fds.pop_back();
+            stats.reused++;
+            watch(s.backend, EPOLL_CTL_MOD, events, pack(BACKEND, tag, static_cast<uint32_t>(slot)));
+        } else {
+            s.backend = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (s.backend >= 0) {
+                setNoDelay(s.backend);
+                const ProxyBackend& b = settings.backends[s.target];
+                sockaddr_in sa = socketAddress(b.address, b.port);
+                if (connect(s.backend, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0) {
+                    stats.connects++;
+                } else if (errno == EINPROGRESS) {
+                    stats.connects++;
+                    s.connecting = true;
+                } else {
+                    close(s.backend);
+                    s.backend = -1;
+                }
+            }
+            if (s.backend >= 0) {
+                watch(s.backend, EPOLL_CTL_ADD, events, pack(BACKEND, tag, static_cast<uint32_t>(slot)));
+            }
+        }
+        if (s.backend < 0 || s.pipes.up[0] < 0) {
+            stats.failed++;
+            finish(slot, false);
+            return true;
+        }
+        watch(fd, EPOLL_CTL_ADD, events, pack(CLIENT, tag, static_cast<uint32_t>(slot)));
+        pump(slot);
+        return true;
+    }
+
+    /**
+     * @brief Moves bytes between a pipe and a socket
+     * @param from Source descriptor
+     * @param to Destination descriptor
+     * @param length Most bytes to move
+     * @return Bytes moved, 0 at end of stream, -1 if nothing can move now, -2 on an error
+     */
+    static long move(int from, int to, size_t length) {
+        ssize_t n = splice(from, nullptr, to, nullptr, length, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n >= 0) {
+            return static_cast<long>(n);
+        }
+        return errno == EAGAIN || errno == EINTR ? -1 : -2;
+    }
+
+    /**
+     * @brief Relays whatever can move in either direction, then ends the session if it is done
+     * @param slot Session slot
+     */
+    void pump(size_t slot) {
+        Session& s = sessions[slot];
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            long n;
+            if (!s.client_eof) {
+                n = move(s.client, s.pipes.up[1], CHUNK);
+                if (n == -2) {
+                    finish(slot, false);
+                    return;
+                }
+                s.client_eof = n == 0;
+                s.up_bytes += n > 0 ? static_cast<size_t>(n) : 0;
+                progress |= n >= 0;
+            }
+            if (!s.connecting && s.up_bytes > 0) {
+                n = move(s.pipes.up[0], s.backend, s.up_bytes);
+                if (n < -1 || n == 0) {
+                    finish(slot, false);
+                    return;
+                }
+                if (n > 0) {
+                    s.up_bytes -= static_cast<size_t>(n);
+                    stats.bytes_up += static_cast<uint64_t>(n);
+                    s.awaiting = true;
+                    progress = true;
+                }
+            }
+            if (!s.connecting && !s.backend_eof) {
+                n = move(s.backend, s.pipes.down[1], CHUNK);
+                if (n == -2) {
+                    finish(slot, false);
+                    return;
+                }
+                s.backend_eof = n == 0;
+                s.down_bytes += n > 0 ? static_cast<size_t>(n) : 0;
+                s.awaiting = s.awaiting && n <= 0;
+                progress |= n >= 0;
+            }
+            if (s.down_bytes > 0) {
+                n = move(s.pipes.down[0], s.client, s.down_bytes);
+                if (n < -1 || n == 0) {
+                    finish(slot, false);
+                    return;
+                }
+                if (n > 0) {
+                    s.down_bytes -= static_cast<size_t>(n);
+                    stats.bytes_down += static_cast<uint64_t>(n);
+                    progress = true;
+                }
+            }
+        }
+
+        if (s.connecting) {
+            return;
+        }
+        if (s.backend_eof && s.down_bytes == 0) {
+            finish(slot, false);
+        } else if (s.client_eof && s.up_bytes == 0 && !s.shut_backend) {
+            if (settings.pool > 0 && !s.awaiting && s.down_bytes == 0 && !s.backend_eof) {
+                // The client left after its replies: keep the connection for the next client
+                finish(slot, true);
+            } else {
+                // A reply may still be on its way, and it belongs to this client only:
+                // pass the half-close on and relay until the backend closes
+                shutdown(s.backend, SHUT_WR);
+                s.shut_backend = true;
+            }
+        }
+    }
+
+    /**
+     * @brief Checks that a pooled connection has nothing to read and is still open
+     * @param fd Backend socket
+     * @return true if the backend has neither written to nor closed the connection
+     */
+    static bool quiet(int fd) {
+        char byte;
+        return recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) < 0 && errno == EAGAIN;
+    }
+
+    /**
+     * @brief Ends a session, pooling its backend connection if asked and there is room
+     * @param slot Session slot
+     * @param reuse Whether the backend connection is clean and can serve another client
+     */
+    void finish(size_t slot, bool reuse) {
+        Session& s = sessions[slot];
+        close(s.client);
+        s.client = -1;
+        if (s.backend >= 0) {
+            std::vector<int>& fds = idle[s.target];
+            if (reuse && fds.size() < static_cast<size_t>(settings.pool)
+                && watch(s.backend, EPOLL_CTL_MOD, EPOLLIN | EPOLLRDHUP | EPOLLET,
+                         pack(POOLED, static_cast<uint32_t>(s.target), static_cast<uint32_t>(s.backend)))) {
+                fds.push_back(s.backend);
+            } else {
+                close(s.backend);
+            }
+            s.backend = -1;
+        }
+        if (s.pipes.up[0] >= 0) {
+            if (s.up_bytes == 0 && s.down_bytes == 0) {
+                spare_pipes.push_back(s.pipes);
+            } else {
+                closePipes(s.pipes);
+            }
+            s.pipes.up[0] = -1;
+        }
+        // The backend's requests are interchangeable placeholders, so it does not
+        // matter which one the pool retires
+        tick();
+        pool.complete(s.target);
+        dispatch->serverIdle(pool, s.target);
+        free_sessions.push_back(slot);
+    }
+};
+
+bool Proxy::run(std::string& error) {
+    stopping.store(false);
+    stats = ProxyStats();
+    if (settings.backends.empty()) {
+        error = "The proxy needs at least one backend";
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < settings.workers; ++i) {
+        // Each worker's policy gets its own seed so random policies do not move in step
+        std::unique_ptr<DispatchPolicy> policy = makeDispatchPolicy(settings.policy, static_cast<unsigned int>(i + 1));
+        if (!policy) {
+            error = "Unknown dispatch policy: " + settings.policy;
+            return false;
+        }
+        int fd = openListener(settings.listen_address, settings.listen_port, error);
+        if (fd < 0) {
+            return false;
+        }
+        workers.emplace_back(new Worker(*this, fd, std::move(policy)));
+    }
+
+    // Relayed peers that vanish must not kill the process; SIGINT and SIGTERM stop the run
+    struct sigaction action;
+    struct sigaction oldPipe, oldInt, oldTerm;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, &oldPipe);
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, &oldInt);
+    sigaction(SIGTERM, &action, &oldTerm);
+    signalled.store(false);
+
+    std::chrono::steady_clock::time_point deadline = settings.seconds > 0
+        ? std::chrono::steady_clock::now() + std::chrono::seconds(settings.seconds)
+        : std::chrono::steady_clock::time_point::max();
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers.size(); ++i) {
+        threads.emplace_back(&Worker::run, workers[i].get(), deadline);
+    }
+    workers[0]->run(deadline);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    stats.per_backend.assign(settings.backends.size(), 0);
+    for (const std::unique_ptr<Worker>& w : workers) {
+        const ProxyStats& s = w->getStats();
+        stats.accepted += s.accepted;
+        stats.blocked += s.blocked;
+        stats.rejected += s.rejected;
+        stats.failed += s.failed;
+        stats.connects += s.connects;
+        stats.reused += s.reused;
+        stats.bytes_up += s.bytes_up;
+        stats.bytes_down += s.bytes_down;
+        for (size_t b = 0; b < s.per_backend.size(); ++b) {
+            stats.per_backend[b] += s.per_backend[b];
+        }
+    }
+    workers.clear();
+
+    sigaction(SIGPIPE, &oldPipe, nullptr);
+    sigaction(SIGINT, &oldInt, nullptr);
+    sigaction(SIGTERM, &oldTerm, nullptr);
+    return true;
+}
+
+#else
+
+bool Proxy::run(std::string& error) {
+    error = "The proxy needs Linux (epoll and splice)";
+    return false;
+}
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file Proxy.h
+ * @brief Proxy class header file
+ */
+#ifndef PROXY_H
+#define PROXY_H
+
+#include "Blocklist.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief TCP address of a proxy backend
+ */
+struct ProxyBackend {
+    uint32_t address;   ///< IPv4 address (host byte order)
+    uint16_t port;      ///< TCP port
+};
+
+/**
+ * @brief Configuration of a Proxy
+ */
+struct ProxySettings {
+    uint32_t listen_address = 0x7F000001u;  ///< Address to accept connections on (default 127.0.0.1)
+    uint16_t listen_port = 8080;            ///< Port to accept connections on
+    std::vector<ProxyBackend> backends;     ///< Backends the connections are spread over
+    int workers = 1;                        ///< Event-loop threads, each with its own listening socket
+    int slots = 64;                         ///< Connections each worker may have open to one backend at once
+    int pool = 8;                           ///< Idle backend connections each worker keeps per backend
+    int backlog = 1024;                     ///< Clients each worker holds while every slot is taken
+    int seconds = 0;                        ///< How long run() serves; 0 until SIGINT or SIGTERM
+    std::string policy = "round-robin";     ///< Dispatch policy spec (see makeDispatchPolicy())
+};
+
+/**
+ * @brief Parses "key=value,..." proxy settings
+ *
+ * Keys: listen=[<address>:]<port>, backend=[<address>:]<port> (repeat for each
+ * backend), workers, slots, pool, backlog, seconds and policy. Addresses default
+ * to 127.0.0.1. Policy parameters may contain commas, so policy has to come last.
+ *
+ * @param spec Parameter list
+ * @param settings Receives the parsed values (keys that are not given keep their value)
+ * @return false on an unknown key, an invalid value or no backend at all
+ */
+bool parseProxySettings(const std::string& spec, ProxySettings& settings);
+
+/**
+ * @brief Counters of a proxy run, summed over the workers
+ */
+struct ProxyStats {
+    uint64_t accepted = 0;      ///< Client connections accepted
+    uint64_t blocked = 0;       ///< Clients closed because the firewall denies their address
+    uint64_t rejected = 0;      ///< Clients closed because every slot was taken and the backlog was full
+    uint64_t failed = 0;        ///< Clients closed because their backend could not be reached
+    uint64_t connects = 0;      ///< New connections opened to backends
+    uint64_t reused = 0;        ///< Sessions served over a pooled backend connection
+    uint64_t bytes_up = 0;      ///< Bytes relayed from clients to backends
+    uint64_t bytes_down = 0;    ///< Bytes relayed from backends to clients
+    std::vector<uint64_t> per_backend;  ///< Sessions handed to each backend
+};
+
+/**
+ * @brief Epoll-based TCP proxy that applies the load balancer's firewall and dispatch
+ *
+ * Every worker thread runs its own event loop with its own listening socket bound
+ * with SO_REUSEPORT, so the kernel spreads new connections over the workers and
+ * they share nothing on the connection path. A new client is checked against the
+ * Blocklist, then the worker's DispatchPolicy picks a backend from the worker's
+ * ServerPool, in which each backend is one server with `slots` request slots: the
+ * policies and their weights see backends exactly as they see multi-slot simulated
+ * servers, and a session holds one of its backend's slots. A client that finds every
+ * slot of every backend taken waits in a backlog until a session ends.
+ *
+ * Bytes are moved with splice() through a pipe per direction, so they never enter
+ * user space. The loops are edge-triggered; every event on a session retries all
+ * four splice steps until none makes progress.
+ *
+ * When a client closes after a reply has come back for everything it sent, and its
+ * session has no bytes in flight, the backend connection goes back to a per-backend
+ * pool for the next client instead of being closed. That suits request/response
+ * protocols (echo, HTTP keep-alive) where a client waits for its reply before it
+ * leaves. A client that closes with a request still unanswered has its half-close
+ * forwarded to the backend, and its session relays the reply until the backend
+ * closes; that connection is never pooled. A pooled connection that the backend
+ * closes or writes to is dropped. With pool=0 nothing is pooled and every client's
+ * half-close is forwarded, so any TCP protocol works.
+ *
+ * Linux only; elsewhere run() fails.
+ */
+class Proxy {
+public:
+    /**
+     * @brief Creates a proxy; nothing is opened until run()
+     * @param settings Listening address, backends and limits
+     * @param blocklist Firewall rules applied to each client address (read concurrently)
+     */
+    Proxy(const ProxySettings& settings, const Blocklist& blocklist);
+
+    /**
+     * @brief Serves connections until settings.seconds have passed, SIGINT or SIGTERM
+     * @param error Receives a description of the problem if the proxy cannot start
+     * @return false if a listening socket or the dispatch policy could not be set up
+     */
+    bool run(std::string& error);
+
+    /**
+     * @brief Asks a running proxy to stop; safe from any thread
+     */
+    void stop() { stopping.store(true); }
+
+    /**
+     * @brief Gets the counters of the last run()
+     * @return Counters summed over the workers
+     */
+    const ProxyStats& getStats() const { return stats; }
+
+private:
+    ProxySettings settings;         ///< Listening address, backends and limits
+    const Blocklist& blocklist;     ///< Firewall rules
+    std::atomic<bool> stopping;     ///< Set to make the workers return
+    ProxyStats stats;               ///< Counters of the last run
+
+    class Worker;
+};
+
+#endif // PROXY_H
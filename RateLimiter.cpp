@@ -0,0 +1,151 @@
+/**
+ * @file RateLimiter.cpp
+ * @brief RateLimiter class implementation
+ */
+
+#include "RateLimiter.h"
+#include <algorithm>
+#include <climits>
+
+RateLimiter::RateLimiter()
+    : mask(0), shift(31), limit(0), count(0), lru_head(NONE), lru_tail(NONE), rate(0.0), burst(1.0), strikes(0),
+      block_ticks(0), limited(0), blocked(0), promotions(0), evictions(0) {}
+
+void RateLimiter::configure(double tokensPerTick, double bucketSize, int strikeLimit, int blockTicks, size_t maxSources) {
+    limit = std::max<size_t>(maxSources, 1);
+    rate = std::max(tokensPerTick, 0.0);
+    burst = std::max(bucketSize, 1.0);
+    strikes = std::min(std::max(strikeLimit, 0), 65535);     // fits Entry::strikes
+    block_ticks = std::max(blockTicks, 0);
+
+    // At most half full, so probe runs stay short
+    size_t size = 2;
+    shift = 31;
+    while (size < limit * 2) {
+        size <<= 1;
+        shift--;
+    }
+    table.assign(size, Entry());
+    mask = static_cast<uint32_t>(size - 1);
+    count = 0;
+    lru_head = lru_tail = NONE;
+}
+
+void RateLimiter::unlink(uint32_t slot) {
+    Entry& e = table[slot];
+    if (e.prev != NONE) {
+        table[e.prev].next = e.next;
+    } else {
+        lru_head = e.next;
+    }
+    if (e.next != NONE) {
+        table[e.next].prev = e.prev;
+    } else {
+        lru_tail = e.prev;
+    }
+}
+
+void RateLimiter::linkFront(uint32_t slot) {
+    Entry& e = table[slot];
+    e.prev = NONE;
+    e.next = lru_head;
+    if (lru_head != NONE) {
+        table[lru_head].prev = slot;
+    } else {
+        lru_tail = slot;
+    }
+    lru_head = slot;
+}
+
+void RateLimiter::erase(uint32_t slot) {
+    unlink(slot);
+    count--;
+
+    // Backward-shift deletion: pull each later entry of the probe run into the hole
+    // unless the hole lies before its home slot
+    uint32_t hole = slot;
+    for (uint32_t j = (hole + 1) & mask; table[j].used; j = (j + 1) & mask) {
+        if (((j - home(table[j].ip)) & mask) < ((j - hole) & mask)) {
+            continue;
+        }
+        table[hole] = table[j];
+        Entry& moved = table[hole];
+        if (moved.prev != NONE) {
+            table[moved.prev].next = hole;
+        } else {
+            lru_head = hole;
+        }
+        if (moved.next != NONE) {
+            table[moved.next].prev = hole;
+        } else {
+            lru_tail = hole;
+        }
+        hole = j;
+    }
+    table[hole].used = false;
+}
+
+uint32_t RateLimiter::findOrInsert(uint32_t ip, int now) {
+    uint32_t slot = home(ip);
+    for (; table[slot].used; slot = (slot + 1) & mask) {
+        if (table[slot].ip == ip) {
+            if (slot != lru_head) {
+                unlink(slot);
+                linkFront(slot);
+            }
+            return slot;
+        }
+    }
+
+    if (count >= limit) {
+        // Evicting may shift entries, so probe again for a free slot
+        erase(lru_tail);
+        evictions++;
+        for (slot = home(ip); table[slot].used; slot = (slot + 1) & mask) {
+        }
+    }
+    table[slot] = Entry{ip, NONE, NONE, now, INT_MIN, 0, true, burst};
+    count++;
+    linkFront(slot);
+    return slot;
+}
+
+RateVerdict RateLimiter::check(uint32_t ip, int now) {
+    if (!enabled()) {
+        return RateVerdict::Allow;
+    }
+    Entry& e = table[findOrInsert(ip, now)];
+    if (now < e.blocked_until) {
+        blocked++;
+        return RateVerdict::Blocked;
+    }
+
+    e.tokens = std::min(burst, e.tokens + rate * (now - e.last));
+    e.last = now;
+    if (e.tokens >= 1.0) {
+        e.tokens -= 1.0;
+        e.strikes = 0;
+        return RateVerdict::Allow;
+    }
+
+    limited++;
+    if (strikes > 0 && ++e.strikes >= strikes) {
+        e.strikes = 0;
+        e.blocked_until = now + block_ticks;
+        promotions++;
+        return RateVerdict::Promoted;
+    }
+    return RateVerdict::Limited;
+}
+
+int RateLimiter::blockedUntil(uint32_t ip) const {
+    if (!enabled()) {
+        return INT_MIN;
+    }
+    for (uint32_t slot = home(ip); table[slot].used; slot = (slot + 1) & mask) {
+        if (table[slot].ip == ip) {
+            return table[slot].blocked_until;
+        }
+    }
+    return INT_MIN;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file RateLimiter.h
+ * @brief RateLimiter class header file
+ */
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Outcome of a rate limiter check
+ */
+enum class RateVerdict : uint8_t {
+    Allow,      ///< The source is within its rate; the request may pass
+    Limited,    ///< The source is over its rate; the request is dropped
+    Promoted,   ///< The source went over its rate too often and is now temporarily blocked
+    Blocked     ///< The source is temporarily blocked; the request is dropped
+};
+
+/**
+ * @brief Per-source token-bucket rate limiter with temporary blocks
+ *
+ * Every source address has a bucket of up to burst tokens that refills at rate
+ * tokens per tick; a request takes one token and is limited if none is left.
+ * Buckets are refilled lazily from the tick of their last request, so idle sources
+ * cost nothing. A source whose requests are limited strikes times in a row is
+ * blocked for blockTicks ticks.
+ *
+ * Buckets live in an open-addressing hash table (linear probing, backward-shift
+ * deletion, so no tombstones) of fixed size. Entries are also chained into an LRU
+ * list; when the table holds maxSources entries, the least recently seen source is
+ * evicted, so memory stays bounded however many sources there are. An evicted
+ * source starts again with a full bucket, which also ends a temporary block that
+ * has not seen a request for longer than every other tracked source.
+ * Each check is a hash probe plus a few list link updates, O(1) on average.
+ */
+class RateLimiter {
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;    ///< Marks a missing list link
+
+    /**
+     * @brief Bucket of one source (32 bytes, two per cache line)
+     */
+    struct Entry {
+        uint32_t ip;            ///< Source address
+        uint32_t prev;          ///< More recently seen neighbour in the LRU list
+        uint32_t next;          ///< Less recently seen neighbour in the LRU list
+        int32_t last;           ///< Tick up to which tokens have been refilled
+        int32_t blocked_until;  ///< First tick on which the source is no longer blocked
+        uint16_t strikes;       ///< Limited requests in a row
+        bool used;              ///< Whether the slot holds a source
+        double tokens;          ///< Tokens left
+    };
+
+    std::vector<Entry> table;   ///< Hash table; the size is a power of two
+    uint32_t mask;              ///< table.size() - 1
+    int shift;                  ///< Right shift that turns a 32-bit hash into a slot
+    size_t limit;               ///< Most sources tracked at once
+    size_t count;               ///< Sources tracked now
+    uint32_t lru_head;          ///< Most recently seen source
+    uint32_t lru_tail;          ///< Least recently seen source
+    double rate;                ///< Tokens added per tick
+    double burst;               ///< Bucket size
+    int strikes;                ///< Limited requests in a row that trigger a block (0 = never block)
+    int block_ticks;            ///< Length of a temporary block
+    uint64_t limited;           ///< Requests dropped for being over the rate
+    uint64_t blocked;           ///< Requests dropped by temporary blocks
+    uint64_t promotions;        ///< Temporary blocks imposed
+    uint64_t evictions;         ///< Sources evicted to make room
+
+    /**
+     * @brief Gets the home slot of an address
+     * @param ip Source address
+     * @return Slot where probing for the address starts
+     */
+    uint32_t home(uint32_t ip) const {
+        return static_cast<uint32_t>((ip * 0x9e3779b1u) >> shift);
+    }
+
+    /**
+     * @brief Removes an entry from the LRU list
+     * @param slot Slot of the entry
+     */
+    void unlink(uint32_t slot);
+
+    /**
+     * @brief Puts an entry at the most recently seen end of the LRU list
+     * @param slot Slot of the entry
+     */
+    void linkFront(uint32_t slot);
+
+    /**
+     * @brief Removes an entry, shifting later entries of its probe run back
+     * @param slot Slot of the entry
+     */
+    void erase(uint32_t slot);
+
+    /**
+     * @brief Finds the entry of an address, creating it (and evicting if full) if needed
+     * @param ip Source address
+     * @param now Current tick
+     * @return Slot of the entry
+     */
+    uint32_t findOrInsert(uint32_t ip, int now);
+
+public:
+    /**
+     * @brief Constructs a limiter that allows everything (see configure())
+     */
+    RateLimiter();
+
+    /**
+     * @brief Sets the limits and empties the table
+     * @param tokensPerTick Rate at which each bucket refills
+     * @param bucketSize Largest burst a source may send (at least one request)
+     * @param strikeLimit Limited requests in a row that trigger a block; 0 never blocks
+     * @param blockTicks Length of a temporary block
+     * @param maxSources Most sources tracked at once
+     */
+    void configure(double tokensPerTick, double bucketSize, int strikeLimit, int blockTicks, size_t maxSources);
+
+    /**
+     * @brief Checks whether the limiter is in use
+     * @return true once configure() has been called
+     */
+    bool enabled() const { return limit > 0; }
+
+    /**
+     * @brief Accounts for one request and decides whether it may pass
+     * @param ip Source address (host byte order)
+     * @param now Current tick; must not decrease between calls
+     * @return Verdict for the request
+     */
+    RateVerdict check(uint32_t ip, int now);
+
+    /**
+     * @brief Gets the tick on which a source's temporary block ends
+     * @param ip Source address
+     * @return First unblocked tick, or INT_MIN if the source is not tracked or never blocked
+     */
+    int blockedUntil(uint32_t ip) const;
+
+    /**
+     * @brief Gets the number of sources tracked now
+     * @return Table entries in use
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Gets the number of requests dropped for being over the rate
+     * @return Limited requests, including those that triggered a block
+     */
+    uint64_t limitedCount() const { return limited; }
+
+    /**
+     * @brief Gets the number of requests dropped by temporary blocks
+     * @return Blocked requests
+     */
+    uint64_t blockedCount() const { return blocked; }
+
+    /**
+     * @brief Gets the number of temporary blocks imposed
+     * @return Promotions to the block list
+     */
+    uint64_t promotionCount() const { return promotions; }
+
+    /**
+     * @brief Gets the number of sources evicted to keep the table bounded
+     * @return Evictions
+     */
+    uint64_t evictionCount() const { return evictions; }
+};
+
+#endif // RATELIMITER_H
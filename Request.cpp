@@ -1,39 +1,62 @@
-/** 
+/**
  * @file Request.cpp
  * @brief Request class implementation
- * 
+ *
  * Contains the implementation of the Request class methods for managing
  * network request data including IP addresses and processing time.
  */
 
 #include "Request.h"
-
-Request::Request(const std::string& ip_in, const std::string& ip_out, int process_time)
-    : ip_in(ip_in), ip_out(ip_out), process_time(process_time) {}
-
-Request::Request() 
-    : ip_in(""), ip_out(""), process_time(0) {}
-
-std::string Request::getin() const {
-    return ip_in;
+#include "IpAddress.h"
+
+namespace {
+    /**
+     * @brief Parses IPv4 or IPv6 address text into an IPv6 address
+     * @param text Address text
+     * @return Parsed address (IPv4-mapped for IPv4 text), or :: if it does not parse
+     */
+    IPv6Address parseEither(const std::string& text) {
+        uint32_t v4;
+        if (parseIPv4(text, v4)) {
+            return IPv6Address::fromIPv4(v4);
+        }
+        IPv6Address ip{0, 0};
+        parseIPv6(text, ip);
+        return ip;
+    }
 }
 
-std::string Request::getout() const {
-    return ip_out;
+Request::Request(const std::string& ip_in, const std::string& ip_out, int process_time)
+    : ip_in(0), ip_out(0), process_time(process_time), enqueue_time(0), ipv6(0) {
+    if (ip_in.find(':') != std::string::npos || ip_out.find(':') != std::string::npos) {
+        *this = fromIPv6(parseEither(ip_in), parseEither(ip_out), process_time);
+        return;
+    }
+    parseIPv4(ip_in, Request::ip_in);
+    parseIPv4(ip_out, Request::ip_out);
 }
 
-int Request::gettime() const{
-    return process_time;
+Request Request::fromIPv6(const IPv6Address& ip_in, const IPv6Address& ip_out,
+                          int process_time, int enqueue_time) {
+    Request r(internIPv6(ip_in), internIPv6(ip_out), process_time, enqueue_time);
+    r.ipv6 = 1;
+    return r;
 }
 
-void Request::setin(const std::string& ip_in) {
-    Request::ip_in = ip_in;
+std::string Request::describe() const {
+    if (ipv6) {
+        return formatIPv6(ipv6At(ip_in)) + " -> " + formatIPv6(ipv6At(ip_out));
+    }
+    char buffer[40];
+    size_t len = formatIPv4(ip_in, buffer);
+    buffer[len++] = ' ';
+    buffer[len++] = '-';
+    buffer[len++] = '>';
+    buffer[len++] = ' ';
+    len += formatIPv4(ip_out, buffer + len);
+    return std::string(buffer, len);
 }
 
-void Request::setout(const std::string& ip_out) {
-    Request::ip_out = ip_out;
+std::string Request::describeSource() const {
+    return ipv6 ? formatIPv6(ipv6At(ip_in)) : formatIPv4(ip_in);
 }
-
-void Request::settime(int process_time) {
-    Request::process_time = process_time;
-}
\ No newline at end of file
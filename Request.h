@@ -3,28 +3,57 @@
  * @brief Request class header file
  */
 #ifndef REQUEST_H
-#define REQUEST_H 
+#define REQUEST_H
 
+#include "IpAddress.h"
+#include <cstdint>
 #include <string>
+#include <type_traits>
 
 /**
  * @brief Represents a network request with source/destination IPs and processing time
- * 
+ *
  * The Request class encapsulates a network request that needs to be processed by a web server.
  * Each request contains source and destination IP addresses and requires a specific amount
  * of processing time to complete.
+ *
+ * Addresses are stored as packed IPv4 integers in host byte order (see IpAddress.h) and are
+ * only formatted as text when they are logged, so a Request is a small trivially copyable
+ * value that can be queued, copied and compared without touching the heap. IPv6 requests
+ * set a flag bit and store handles into the IPv6 side table (internIPv6()) in place of the
+ * packed addresses; the firewall and log formatting resolve them with getin6()/getout6().
+ *
+ * Each request also carries the simulation tick on which it entered the queue, which
+ * the load balancer uses to measure how long it waited for a server.
  */
 class Request {
 private:
-    std::string ip_in;      ///< Source IP address of the request
-    std::string ip_out;     ///< Destination IP address of the request
+    uint32_t ip_in;         ///< Source IPv4 address (host byte order), or IPv6 side table handle
+    uint32_t ip_out;        ///< Destination IPv4 address (host byte order), or IPv6 side table handle
     int process_time;       ///< Number of time cycles required to process this request
+    int enqueue_time : 31;  ///< Simulation tick on which the request was queued
+    unsigned ipv6 : 1;      ///< Set when ip_in/ip_out are IPv6 side table handles
 
 public:
     /**
      * @brief Constructs a Request with specified parameters
+     * @param ip_in Source IPv4 address (host byte order)
+     * @param ip_out Destination IPv4 address (host byte order)
+     * @param process_time Number of time cycles needed to process the request
+     * @param enqueue_time Simulation tick on which the request is queued (default: 0)
+     */
+    constexpr Request(uint32_t ip_in, uint32_t ip_out, int process_time, int enqueue_time = 0)
+        : ip_in(ip_in), ip_out(ip_out), process_time(process_time), enqueue_time(enqueue_time), ipv6(0) {}
+
+    /**
+     * @brief Constructs a Request from address text
+     *
+     * If either address is IPv6 text the request becomes an IPv6 request and an IPv4
+     * address on the other side is carried as its IPv4-mapped form. Addresses that do
+     * not parse are stored as 0.0.0.0 (or :: for an IPv6 request).
+     *
      * @param ip_in Source IP address
-     * @param ip_out Destination IP address  
+     * @param ip_out Destination IP address
      * @param process_time Number of time cycles needed to process the request
      */
     Request(const std::string& ip_in, const std::string& ip_out, int process_time);
@@ -32,43 +61,104 @@ public:
     /**
      * @brief Default constructor that creates an empty request
      */
-    Request();
+    constexpr Request() : ip_in(0), ip_out(0), process_time(0), enqueue_time(0), ipv6(0) {}
+
+    /**
+     * @brief Constructs an IPv6 request, interning both addresses in the IPv6 side table
+     * @param ip_in Source IPv6 address
+     * @param ip_out Destination IPv6 address
+     * @param process_time Number of time cycles needed to process the request
+     * @param enqueue_time Simulation tick on which the request is queued (default: 0)
+     * @return Request carrying side table handles
+     */
+    static Request fromIPv6(const IPv6Address& ip_in, const IPv6Address& ip_out,
+                            int process_time, int enqueue_time = 0);
 
     /**
      * @brief Gets the source IP address
-     * @return Source IP address as a string
+     *
+     * Code that only needs a stable per-source key (rate limiting, zone and hash
+     * affinity) can use this for either family; for an IPv6 request it is the side
+     * table handle, which is unique per address.
+     *
+     * @return Source IPv4 address (host byte order), or IPv6 side table handle
      */
-    std::string getin() const;
-    
+    uint32_t getin() const { return ip_in; }
+
     /**
      * @brief Gets the destination IP address
-     * @return Destination IP address as a string
+     * @return Destination IPv4 address (host byte order), or IPv6 side table handle
+     */
+    uint32_t getout() const { return ip_out; }
+
+    /**
+     * @brief Checks whether the addresses are IPv6 side table handles
+     * @return true for an IPv6 request
+     */
+    bool isIPv6() const { return ipv6 != 0; }
+
+    /**
+     * @brief Gets the full source address of either family
+     * @return Source address (IPv4-mapped for an IPv4 request)
+     */
+    IPv6Address getin6() const { return ipv6 ? ipv6At(ip_in) : IPv6Address::fromIPv4(ip_in); }
+
+    /**
+     * @brief Gets the full destination address of either family
+     * @return Destination address (IPv4-mapped for an IPv4 request)
      */
-    std::string getout() const;
-    
+    IPv6Address getout6() const { return ipv6 ? ipv6At(ip_out) : IPv6Address::fromIPv4(ip_out); }
+
     /**
      * @brief Gets the processing time required for this request
      * @return Number of time cycles needed to process the request
      */
-    int gettime() const;
+    int gettime() const { return process_time; }
+
+    /**
+     * @brief Gets the simulation tick on which the request was queued
+     * @return Enqueue tick
+     */
+    int getenqueued() const { return enqueue_time; }
+
+    /**
+     * @brief Formats the request's addresses for log output
+     * @return "<source> -> <destination>"
+     */
+    std::string describe() const;
+
+    /**
+     * @brief Formats the source address for log output
+     * @return Source address text of either family
+     */
+    std::string describeSource() const;
 
     /**
      * @brief Sets the source IP address
-     * @param ip_in New source IP address
+     * @param ip_in New source IPv4 address (host byte order), or side table handle for an IPv6 request
      */
-    void setin(const std::string& ip_in);
-    
+    void setin(uint32_t ip_in) { Request::ip_in = ip_in; }
+
     /**
      * @brief Sets the destination IP address
-     * @param ip_out New destination IP address
+     * @param ip_out New destination IPv4 address (host byte order), or side table handle for an IPv6 request
      */
-    void setout(const std::string& ip_out);
-    
+    void setout(uint32_t ip_out) { Request::ip_out = ip_out; }
+
     /**
      * @brief Sets the processing time for this request
      * @param process_time New processing time in time cycles
      */
-    void settime(int process_time);
+    void settime(int process_time) { Request::process_time = process_time; }
+
+    /**
+     * @brief Sets the simulation tick on which the request was queued
+     * @param enqueue_time Enqueue tick (31-bit signed range)
+     */
+    void setenqueued(int enqueue_time) { Request::enqueue_time = enqueue_time; }
 };
 
+static_assert(std::is_trivially_copyable<Request>::value, "Request must stay trivially copyable");
+static_assert(sizeof(Request) <= 16, "Request must fit in 16 bytes");
+
 #endif // REQUEST_H
@@ -0,0 +1,161 @@
+/**
+ * @file RequestHeap.cpp
+ * @brief RequestHeap class implementation
+ */
+
+#include "RequestHeap.h"
+#include <algorithm>
+
+uint32_t RequestHeap::meld(uint32_t a, uint32_t b) {
+    if (before(b, a)) {
+        std::swap(a, b);
+    }
+    // b becomes the first child of a
+    nodes[b].next = nodes[a].child;
+    if (nodes[b].next != NONE) {
+        nodes[nodes[b].next].prev = b;
+    }
+    nodes[b].prev = a;
+    nodes[a].child = b;
+    return a;
+}
+
+void RequestHeap::relocate(uint32_t from, uint32_t to) {
+    Node& node = nodes[to];
+    node = nodes[from];
+    if (node.prev != NONE) {
+        if (nodes[node.prev].child == from) {
+            nodes[node.prev].child = to;
+        } else {
+            nodes[node.prev].next = to;
+        }
+    }
+    if (node.next != NONE) {
+        nodes[node.next].prev = to;
+    }
+    if (node.child != NONE) {
+        nodes[node.child].prev = to;
+    }
+    if (root == from) {
+        root = to;
+    }
+}
+
+void RequestHeap::setAging(int ticks) {
+    aging = std::max(ticks, 0);
+    root = NONE;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        Node& node = nodes[i];
+        node.key = keyOf(node.request);
+        node.child = node.next = node.prev = NONE;
+        root = root == NONE ? i : meld(root, i);
+    }
+}
+
+void RequestHeap::push(const Request& r) {
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node{r, keyOf(r), pushed++, NONE, NONE, NONE});
+    root = root == NONE ? index : meld(root, index);
+}
+
+void RequestHeap::pop() {
+    uint32_t old = root;
+
+    // Two-pass pairing: meld the children in pairs from the left, then fold the
+    // pairs into one tree from the right
+    roots.clear();
+    for (uint32_t c = nodes[old].child; c != NONE;) {
+        uint32_t d = nodes[c].next;
+        nodes[c].next = nodes[c].prev = NONE;
+        if (d == NONE) {
+            roots.push_back(c);
+            break;
+        }
+        uint32_t after = nodes[d].next;
+        nodes[d].next = nodes[d].prev = NONE;
+        roots.push_back(meld(c, d));
+        c = after;
+    }
+    root = NONE;
+    for (size_t i = roots.size(); i-- > 0;) {
+        root = root == NONE ? roots[i] : meld(roots[i], root);
+    }
+
+    // Keep the array dense by moving the last node into the freed slot
+    uint32_t last = static_cast<uint32_t>(nodes.size() - 1);
+    if (old != last) {
+        relocate(last, old);
+    }
+    nodes.pop_back();
+}
+
+namespace {
+    /**
+     * @brief Scalar state of a RequestHeap as stored in a checkpoint
+     */
+    struct HeapScalars {
+        uint64_t pushed;    ///< Requests pushed so far
+        uint32_t root;      ///< Node with the smallest key
+        int32_t aging;      ///< Ticks of waiting worth one cycle
+    };
+}
+
+void RequestHeap::saveState(SnapshotWriter& out) const {
+    out.addValue("heap", HeapScalars{pushed, root, aging});
+    out.add("heap.nodes", nodes);
+}
+
+bool RequestHeap::restoreState(SnapshotReader& in) {
+    HeapScalars scalars;
+    std::vector<Node> restored;
+    if (!in.readValue("heap", scalars) || !in.read("heap.nodes", restored)) {
+        return false;
+    }
+    // Walk the tree from the root: every node must be reached exactly once, with its
+    // back link and the heap order intact, so a corrupt file cannot loop or send a
+    // later pop() out of bounds
+    uint32_t size = static_cast<uint32_t>(restored.size());
+    auto ordered = [&](uint32_t parent, uint32_t node) {
+        const Node& p = restored[parent];
+        const Node& n = restored[node];
+        return p.key != n.key ? p.key < n.key : p.sequence < n.sequence;
+    };
+    if (scalars.aging < 0 || restored.size() >= NONE || (restored.empty() ? scalars.root != NONE : scalars.root >= size)) {
+        return false;
+    }
+    std::vector<uint8_t> seen(size, 0);
+    std::vector<uint32_t> pending;
+    size_t reached = 0;
+    bool linked = restored.empty()
+                  || (restored[scalars.root].prev == NONE && restored[scalars.root].next == NONE);
+    if (linked && !restored.empty()) {
+        pending.push_back(scalars.root);
+    }
+    while (linked && !pending.empty()) {
+        uint32_t parent = pending.back();
+        pending.pop_back();
+        if (seen[parent]) {
+            linked = false;
+            break;
+        }
+        seen[parent] = 1;
+        reached++;
+        uint32_t previous = parent;
+        for (uint32_t c = restored[parent].child; c != NONE && linked; c = restored[c].next) {
+            linked = c < size && !seen[c] && restored[c].prev == previous && ordered(parent, c)
+                     && pending.size() < size;
+            if (linked) {
+                pending.push_back(c);
+                previous = c;
+            }
+        }
+    }
+    if (!linked || reached != size) {
+        return false;
+    }
+    nodes = std::move(restored);
+    root = scalars.root;
+    pushed = scalars.pushed;
+    aging = scalars.aging;
+    return true;
+}
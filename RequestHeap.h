@@ -0,0 +1,166 @@
+/**
+ * @file RequestHeap.h
+ * @brief RequestHeap class header file
+ */
+#ifndef REQUESTHEAP_H
+#define REQUESTHEAP_H
+
+#include "Request.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Priority queue of pending requests that yields the shortest request first
+ *
+ * A pairing heap: push() is constant time and pop() amortized logarithmic, which
+ * suits a queue that takes a few arrivals and hands out a few requests every tick.
+ * Nodes live in one dense array and refer to each other by index; pop() moves the
+ * last node into the freed slot, so the array never has holes and at() can walk
+ * every queued request.
+ *
+ * Requests are ordered by processing time, ties in arrival order. With aging, a
+ * request also moves ahead of requests one cycle shorter for every aging ticks it
+ * has waited. Waiting time grows at the same rate for every queued request, so this
+ * order never changes while requests wait: the key processing time * aging +
+ * enqueue time ranks them the same way at every tick, and nothing is re-keyed.
+ */
+class RequestHeap {
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;   ///< Marks a missing node link
+
+    /**
+     * @brief One queued request and its links
+     *
+     * prev is the parent for the first child of a node and the previous sibling for
+     * the others; NONE for the root.
+     */
+    struct Node {
+        Request request;        ///< Queued request
+        int64_t key;            ///< Priority; smaller is served first
+        uint64_t sequence;      ///< Push order, breaks ties between equal keys
+        uint32_t child;         ///< First child
+        uint32_t next;          ///< Next sibling
+        uint32_t prev;          ///< Parent or previous sibling
+    };
+
+    std::vector<Node> nodes;        ///< Queued requests; all of them are in use
+    std::vector<uint32_t> roots;    ///< Scratch list of subtrees merged by pop()
+    uint32_t root;                  ///< Node with the smallest key, or NONE
+    uint64_t pushed;                ///< Requests pushed so far
+    int aging;                      ///< Ticks of waiting worth one cycle (0 = no aging)
+
+    /**
+     * @brief Compares two nodes
+     * @param a Node index
+     * @param b Node index
+     * @return true if a is served before b
+     */
+    bool before(uint32_t a, uint32_t b) const {
+        return nodes[a].key != nodes[b].key ? nodes[a].key < nodes[b].key : nodes[a].sequence < nodes[b].sequence;
+    }
+
+    /**
+     * @brief Computes the key of a request
+     * @param r Request
+     * @return Priority key
+     */
+    int64_t keyOf(const Request& r) const {
+        return aging > 0 ? static_cast<int64_t>(r.gettime()) * aging + r.getenqueued() : r.gettime();
+    }
+
+    /**
+     * @brief Links two detached trees
+     * @param a Root of the first tree
+     * @param b Root of the second tree
+     * @return Root of the merged tree
+     */
+    uint32_t meld(uint32_t a, uint32_t b);
+
+    /**
+     * @brief Moves a node to another slot and repoints the links to it
+     * @param from Current slot
+     * @param to Free slot
+     */
+    void relocate(uint32_t from, uint32_t to);
+
+public:
+    /**
+     * @brief Constructs an empty heap without aging
+     */
+    RequestHeap() : root(NONE), pushed(0), aging(0) {}
+
+    /**
+     * @brief Sets how fast waiting requests move ahead, re-ordering the queued ones
+     * @param ticks Ticks of waiting worth one cycle of processing time; 0 turns aging off
+     */
+    void setAging(int ticks);
+
+    /**
+     * @brief Gets the aging rate
+     * @return Ticks of waiting worth one cycle (0 = no aging)
+     */
+    int getAging() const { return aging; }
+
+    /**
+     * @brief Ensures the heap can hold the given number of requests without reallocating
+     * @param n Number of requests to make room for
+     */
+    void reserve(size_t n) { nodes.reserve(n); }
+
+    /**
+     * @brief Adds a request
+     * @param r Request to queue
+     */
+    void push(const Request& r);
+
+    /**
+     * @brief Gets the request that is served next (the heap must not be empty)
+     * @return Reference to the request with the smallest key
+     */
+    const Request& top() const { return nodes[root].request; }
+
+    /**
+     * @brief Removes the request that is served next (the heap must not be empty)
+     */
+    void pop();
+
+    /**
+     * @brief Gets a queued request by storage position, in no particular order
+     * @param i Position; must be below size()
+     * @return Reference to the request
+     */
+    const Request& at(size_t i) const { return nodes[i].request; }
+
+    /**
+     * @brief Gets the number of queued requests
+     * @return Queue length
+     */
+    size_t size() const { return nodes.size(); }
+
+    /**
+     * @brief Checks whether the heap is empty
+     * @return true if no requests are queued
+     */
+    bool empty() const { return nodes.empty(); }
+
+    /**
+     * @brief Adds the heap to a checkpoint, links and push order included
+     * @param out Checkpoint being written
+     */
+    void saveState(SnapshotWriter& out) const;
+
+    /**
+     * @brief Replaces the heap with the one stored in a checkpoint
+     *
+     * The nodes link to each other by index, so they are copied as they are and the
+     * restored heap pops its requests in exactly the original order.
+     *
+     * @param in Open checkpoint
+     * @return false if a section is missing or a link points outside the heap (the heap is then unchanged)
+     */
+    bool restoreState(SnapshotReader& in);
+};
+
+#endif // REQUESTHEAP_H
@@ -0,0 +1,25 @@
+/**
+ * @file RequestQueue.cpp
+ * @brief RequestQueue class implementation
+ *
+ * Contains the growth path of the request ring; the hot push/pop operations are
+ * defined inline in the header.
+ */
+
+#include "RequestQueue.h"
+
+void RequestQueue::grow(size_t minCapacity) {
+    size_t newCapacity = capacity == 0 ? 16 : capacity;
+    while (newCapacity < minCapacity) {
+        newCapacity <<= 1;
+    }
+
+    std::unique_ptr<Request[]> newRing(new Request[newCapacity]);
+    for (size_t i = 0; i < count; ++i) {
+        newRing[i] = ring[(head + i) & (capacity - 1)];
+    }
+
+    ring = std::move(newRing);
+    capacity = newCapacity;
+    head = 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file RequestQueue.h
+ * @brief RequestQueue class header file
+ */
+#ifndef REQUESTQUEUE_H
+#define REQUESTQUEUE_H
+
+#include "Request.h"
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief FIFO queue of pending requests backed by a single contiguous ring
+ *
+ * Unlike std::queue (which sits on a std::deque and allocates a new block every few
+ * dozen elements), the ring only allocates when it has to grow, and reserve() lets
+ * callers that know the queue size up front build and drain it with no allocator
+ * traffic at all. Requests are trivially copyable, so growing is a plain copy.
+ */
+class RequestQueue {
+private:
+    std::unique_ptr<Request[]> ring;    ///< Ring storage; capacity is always a power of two
+    size_t capacity;                    ///< Number of slots in the ring
+    size_t head;                        ///< Index of the oldest request
+    size_t count;                       ///< Number of queued requests
+
+    /**
+     * @brief Reallocates the ring with at least the given capacity, preserving order
+     * @param minCapacity Required number of slots
+     */
+    void grow(size_t minCapacity);
+
+public:
+    /**
+     * @brief Constructs an empty queue without allocating
+     */
+    RequestQueue() : capacity(0), head(0), count(0) {}
+
+    /**
+     * @brief Ensures the queue can hold the given number of requests without reallocating
+     * @param n Number of requests to make room for
+     */
+    void reserve(size_t n) {
+        if (n > capacity) {
+            grow(n);
+        }
+    }
+
+    /**
+     * @brief Appends a request to the back of the queue
+     * @param r Request to enqueue
+     */
+    void push(const Request& r) {
+        if (count == capacity) {
+            grow(count + 1);
+        }
+        ring[(head + count) & (capacity - 1)] = r;
+        count++;
+    }
+
+    /**
+     * @brief Constructs a request in place at the back of the queue
+     * @param ip_in Source IPv4 address
+     * @param ip_out Destination IPv4 address
+     * @param process_time Number of time cycles needed to process the request
+     * @param enqueue_time Simulation tick on which the request is queued
+     */
+    void emplace(uint32_t ip_in, uint32_t ip_out, int process_time, int enqueue_time = 0) {
+        push(Request(ip_in, ip_out, process_time, enqueue_time));
+    }
+
+    /**
+     * @brief Gets the oldest request (the queue must not be empty)
+     * @return Reference to the request at the front of the queue
+     */
+    const Request& front() const {
+        return ring[head];
+    }
+
+    /**
+     * @brief Removes the oldest request (the queue must not be empty)
+     */
+    void pop() {
+        head = (head + 1) & (capacity - 1);
+        count--;
+    }
+
+    /**
+     * @brief Gets a queued request by position
+     * @param i Position from the front (0 is the oldest request); must be below size()
+     * @return Reference to the request
+     */
+    const Request& at(size_t i) const {
+        return ring[(head + i) & (capacity - 1)];
+    }
+
+    /**
+     * @brief Removes the n oldest requests (the queue must hold at least n)
+     * @param n Number of requests to remove
+     */
+    void pop(size_t n) {
+        head = (head + n) & (capacity - 1);
+        count -= n;
+    }
+
+    /**
+     * @brief Gets the number of queued requests
+     * @return Queue length
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Checks whether the queue is empty
+     * @return true if no requests are queued
+     */
+    bool empty() const {
+        return count == 0;
+    }
+};
+
+#endif // REQUESTQUEUE_H
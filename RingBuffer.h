@@ -0,0 +1,133 @@
+/**
+ * @file RingBuffer.h
+ * @brief Bounded lock-free ring buffer template
+ */
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer ring buffer
+ *
+ * Every cell carries a sequence number that tells producers and the consumer
+ * whether the cell is free or holds a published value, so pushes and pops only
+ * need a single compare-and-swap on the shared position counters. Any number of
+ * threads may push concurrently; the buffer is meant to be drained by one
+ * consumer thread. The capacity is rounded up to a power of two.
+ *
+ * @tparam T Element type (must be default constructible and move assignable)
+ */
+template <typename T>
+class RingBuffer {
+private:
+    /**
+     * @brief One slot of the ring with its publication sequence number
+     */
+    struct Cell {
+        std::atomic<size_t> sequence;   ///< Position this cell is ready for (push or pop)
+        T value;                        ///< Stored element
+    };
+
+    static constexpr size_t CACHE_LINE = 64;                ///< Assumed cache line size in bytes
+
+    std::unique_ptr<Cell[]> cells;                          ///< Ring storage
+    size_t mask;                                            ///< capacity - 1, used to wrap positions
+    alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos;    ///< Next position producers will claim
+    alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos;    ///< Next position the consumer will read
+    char padding[CACHE_LINE - sizeof(std::atomic<size_t>)]; ///< Keeps neighbouring data off the consumer's line
+
+public:
+    /**
+     * @brief Constructs an empty ring buffer
+     * @param capacity Minimum number of elements the buffer can hold
+     */
+    explicit RingBuffer(size_t capacity) : enqueue_pos(0), dequeue_pos(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * @brief Attempts to append an element without blocking
+     * @param value Element to move into the buffer
+     * @return true if the element was stored, false if the buffer is full
+     */
+    bool tryPush(T&& value) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Attempts to remove the oldest element without blocking
+     * @param out Receives the element when one is available
+     * @return true if an element was removed, false if the buffer is empty
+     */
+    bool tryPop(T& out) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Gets the number of elements the buffer can hold
+     * @return Capacity of the ring
+     */
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    /**
+     * @brief Gets an approximate element count (exact when no push/pop is in flight)
+     * @return Number of stored elements
+     */
+    size_t size() const {
+        size_t head = dequeue_pos.load(std::memory_order_acquire);
+        size_t tail = enqueue_pos.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+};
+
+#endif // RINGBUFFER_H
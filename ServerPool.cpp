@@ -0,0 +1,943 @@
+/**
+ * @file ServerPool.cpp
+ * @brief ServerPool class implementation
+ *
+ * Contains slot management for the struct-of-arrays server pool, the request
+ * heaps of multi-slot servers, the fleet spec parser and the vectorized countdown
+ * kernels (AVX2, SSE2 and a portable scalar version).
+ */
+
+#include "ServerPool.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SERVERPOOL_X86 1
+#endif
+
+namespace {
+    /**
+     * @brief Signature shared by the countdown kernels
+     * @param time_left Remaining times, 64 per bitmap word
+     * @param running Bitmap of servers running a request
+     * @param done Receives the servers that reach zero
+     * @param words Number of bitmap words
+     */
+    typedef void (*CountdownKernel)(int32_t* time_left, const uint64_t* running, uint64_t* done, size_t words);
+
+    void countdownScalar(int32_t* time_left, const uint64_t* running, uint64_t* done, size_t words) {
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t finished = 0;
+            uint64_t pending = running[w];
+            while (pending) {
+                unsigned bit = __builtin_ctzll(pending);
+                pending &= pending - 1;
+                int32_t& t = time_left[w * 64 + bit];
+                if (t > 0 && --t == 0) {
+                    finished |= 1ULL << bit;
+                }
+            }
+            done[w] = finished;
+        }
+    }
+
+#ifdef SERVERPOOL_X86
+    // Empty and padding lanes hold zero, so every lane can be decremented with a
+    // saturating "t + (t > 0 ? -1 : 0)" and finishers are the lanes that held one
+
+    __attribute__((target("sse2")))
+    void countdownSSE2(int32_t* time_left, const uint64_t* running, uint64_t* done, size_t words) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi32(1);
+        for (size_t w = 0; w < words; ++w) {
+            if (running[w] == 0) {
+                done[w] = 0;
+                continue;
+            }
+            uint64_t finished = 0;
+            int32_t* lanes = time_left + w * 64;
+            for (int k = 0; k < 16; ++k) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes + 4 * k));
+                __m128i last = _mm_cmpeq_epi32(v, one);
+                __m128i positive = _mm_cmpgt_epi32(v, zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 4 * k), _mm_add_epi32(v, positive));
+                finished |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(last))) << (4 * k);
+            }
+            done[w] = finished & running[w];
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void countdownAVX2(int32_t* time_left, const uint64_t* running, uint64_t* done, size_t words) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+        for (size_t w = 0; w < words; ++w) {
+            if (running[w] == 0) {
+                done[w] = 0;
+                continue;
+            }
+            uint64_t finished = 0;
+            int32_t* lanes = time_left + w * 64;
+            for (int k = 0; k < 8; ++k) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes + 8 * k));
+                __m256i last = _mm256_cmpeq_epi32(v, one);
+                __m256i positive = _mm256_cmpgt_epi32(v, zero);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + 8 * k), _mm256_add_epi32(v, positive));
+                finished |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(last))) << (8 * k);
+            }
+            done[w] = finished & running[w];
+        }
+    }
+#endif
+
+    /**
+     * @brief Picks the widest countdown kernel the CPU supports
+     * @return Kernel function
+     */
+    CountdownKernel selectKernel() {
+#ifdef SERVERPOOL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return countdownAVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return countdownSSE2;
+        }
+#endif
+        return countdownScalar;
+    }
+
+    const CountdownKernel countdownKernel = selectKernel();
+
+    /**
+     * @brief Gets the capacity of one slot of a profile
+     * @param profile Server profile
+     * @return Speed in thousandths of a cycle per tick
+     */
+    uint32_t slotUnits(const ServerProfile& profile) {
+        return static_cast<uint32_t>(std::lround(profile.speed * 1000.0));
+    }
+
+    /**
+     * @brief Heap order for the requests of a multi-slot server (earliest on top)
+     */
+    struct FinishesLater {
+        template <typename Job>
+        bool operator()(const Job& a, const Job& b) const {
+            return a.finish != b.finish ? a.finish > b.finish : a.sequence > b.sequence;
+        }
+    };
+}
+
+bool parseFleet(const std::string& spec, std::vector<ServerProfile>& fleet) {
+    std::vector<ServerProfile> parsed;
+    std::istringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        ServerProfile profile;
+        size_t colon = item.find(':');
+        if (colon != std::string::npos) {
+            std::string model = item.substr(colon + 1);
+            if (model == "ps") {
+                profile.sharing = SlotSharing::ProcessorSharing;
+            } else if (model != "fifo") {
+                return false;
+            }
+            item.resize(colon);
+        }
+        char* end = nullptr;
+        long slots = std::strtol(item.c_str(), &end, 10);
+        if (end == item.c_str()) {
+            return false;
+        }
+        if (*end == 'x') {
+            const char* speed = end + 1;
+            profile.speed = std::strtod(speed, &end);
+            if (end == speed) {
+                return false;
+            }
+        }
+        if (*end != '\0' || slots < 1 || slots > 1024 || !(profile.speed >= 0.01 && profile.speed <= 100.0)) {
+            return false;
+        }
+        profile.slots = static_cast<int>(slots);
+        parsed.push_back(profile);
+    }
+    if (parsed.empty()) {
+        return false;
+    }
+    fleet = parsed;
+    return true;
+}
+
+std::string formatFleet(const std::vector<ServerProfile>& fleet) {
+    std::string spec;
+    char speed[32];
+    for (const ServerProfile& profile : fleet) {
+        spec += (spec.empty() ? "" : ",") + std::to_string(profile.slots);
+        if (profile.speed != 1.0) {
+            std::snprintf(speed, sizeof(speed), "x%g", profile.speed);
+            spec += speed;
+        }
+        if (profile.sharing == SlotSharing::ProcessorSharing) {
+            spec += ":ps";
+        }
+    }
+    return spec;
+}
+
+ServerPool::ServerPool() : fleet(1), fleet_count(1, 0), multi_slot(false), job_sequence(0), now(0), warmup_ticks(0), cold_throughput(1.0), order(IdleOrder::Recency), idle_hint(0), idle_head(NONE), idle_tail(NONE), slot_count(0), count(0), busy_count(0), running_count(0), free_count(0), total_units(0), used_units(0) {}
+
+void ServerPool::ensureCapacity(size_t slots) {
+    size_t words = (slots + 63) / 64;
+    if (words > busy.size()) {
+        busy.resize(words, ~0ULL);          // new slots start as padding
+        running.resize(words, 0);
+        time_left.resize(words * 64, 0);
+        requests.resize(words * 64);
+        active.resize(words * 64, 0);
+        idle_prev.resize(words * 64, NONE);
+        idle_next.resize(words * 64, NONE);
+        started.resize(words * 64, 0);
+        joined.resize(words * 64, 0);
+        warm_at.resize(words * 64, 0);
+        served.resize(words * 64, 0);
+        busy_time.resize(words * 64, 0);
+        present_time.resize(words * 64, 0);
+        profile_of.resize(words * 64, 0);
+        width.resize(words * 64, 1);
+        in_flight.resize(words * 64, 0);
+        units.resize(words * 64, 0);
+        if (multi_slot) {
+            hosts.resize(words * 64);
+        }
+    }
+}
+
+void ServerPool::reserve(size_t servers) {
+    ensureCapacity(servers);
+}
+
+void ServerPool::pushIdleFront(size_t index) {
+    idle_prev[index] = NONE;
+    idle_next[index] = idle_head;
+    if (idle_head != NONE) {
+        idle_prev[idle_head] = static_cast<int32_t>(index);
+    } else {
+        idle_tail = static_cast<int32_t>(index);
+    }
+    idle_head = static_cast<int32_t>(index);
+}
+
+void ServerPool::pushIdleBack(size_t index) {
+    idle_next[index] = NONE;
+    idle_prev[index] = idle_tail;
+    if (idle_tail != NONE) {
+        idle_next[idle_tail] = static_cast<int32_t>(index);
+    } else {
+        idle_head = static_cast<int32_t>(index);
+    }
+    idle_tail = static_cast<int32_t>(index);
+}
+
+void ServerPool::unlinkIdle(size_t index) {
+    int32_t prev = idle_prev[index];
+    int32_t next = idle_next[index];
+    if (prev != NONE) {
+        idle_next[prev] = next;
+    } else {
+        idle_head = next;
+    }
+    if (next != NONE) {
+        idle_prev[next] = prev;
+    } else {
+        idle_tail = prev;
+    }
+    idle_prev[index] = NONE;
+    idle_next[index] = NONE;
+}
+
+size_t ServerPool::add(bool cold) {
+    size_t index;
+    if (!free_slots.empty()) {
+        index = static_cast<size_t>(free_slots.back());
+        free_slots.pop_back();
+    } else {
+        ensureCapacity(slot_count + 1);
+        index = slot_count++;
+    }
+    count++;
+    active[index] = 1;
+    busy[index >> 6] &= ~(1ULL << (index & 63));
+    time_left[index] = 0;
+    requests[index] = Request();
+    joined[index] = now;
+    warm_at[index] = cold ? now + warmup_ticks : now;
+    in_flight[index] = 0;
+    applyProfile(index);
+    if (multi_slot) {
+        hosts[index].jobs.clear();
+        hosts[index].updated = now;
+    }
+    if (order == IdleOrder::Recency) {
+        pushIdleBack(index);    // a fresh server has never been active, so it is the coldest
+    }
+    idle_hint = std::min(idle_hint, index >> 6);
+    return index;
+}
+
+void ServerPool::applyProfile(size_t index) {
+    size_t best = 0;
+    for (size_t p = 1; p < fleet.size(); ++p) {
+        if (fleet_count[p] < fleet_count[best]) {
+            best = p;
+        }
+    }
+    fleet_count[best]++;
+    profile_of[index] = static_cast<uint16_t>(best);
+    width[index] = fleet[best].slots;
+    units[index] = slotUnits(fleet[best]) * static_cast<uint32_t>(fleet[best].slots);
+    total_units += units[index];
+    free_count += static_cast<size_t>(width[index]);
+}
+
+bool ServerPool::setFleet(const std::vector<ServerProfile>& profiles) {
+    if (profiles.empty() || running_count > 0) {
+        return false;
+    }
+    fleet = profiles;
+    fleet_count.assign(fleet.size(), 0);
+    multi_slot = std::any_of(fleet.begin(), fleet.end(), [](const ServerProfile& p) { return p.slots > 1; });
+    if (multi_slot) {
+        hosts.resize(time_left.size());
+    } else {
+        hosts.clear();
+    }
+    total_units = 0;
+    free_count = 0;
+    for (size_t i = 0; i < slot_count; ++i) {
+        if (active[i]) {
+            applyProfile(i);
+        }
+    }
+    return true;
+}
+
+void ServerPool::release(size_t index) {
+    if (!isActive(index) || isRunning(index)) {
+        return;
+    }
+    if (order == IdleOrder::Recency) {
+        unlinkIdle(index);
+    }
+    present_time[index] += static_cast<uint64_t>(now - joined[index]);
+    fleet_count[profile_of[index]]--;
+    total_units -= units[index];
+    free_count -= static_cast<size_t>(width[index]);
+    active[index] = 0;
+    busy[index >> 6] |= 1ULL << (index & 63);     // unavailable, like padding
+    time_left[index] = 0;
+    requests[index] = Request();
+    free_slots.push_back(static_cast<int32_t>(index));
+    count--;
+}
+
+void ServerPool::assign(size_t index, const Request& r) {
+    if (!isActive(index) || isBusy(index)) {
+        return;
+    }
+    if (width[index] > 1) {
+        startJob(index, r);
+        return;
+    }
+    if (order == IdleOrder::Recency) {
+        unlinkIdle(index);
+    }
+    startSlot(index, r);
+    busy_count++;
+    running_count++;
+    free_count--;
+    used_units += units[index];
+}
+
+void ServerPool::startSlot(size_t index, const Request& r) {
+    requests[index] = r;
+    started[index] = now;
+    time_left[index] = serviceTime(index, r.gettime());
+    in_flight[index] = 1;
+    busy[index >> 6] |= 1ULL << (index & 63);
+    running[index >> 6] |= 1ULL << (index & 63);
+}
+
+void ServerPool::advanceHost(size_t index) {
+    Host& host = hosts[index];
+    if (in_flight[index] > 0 && fleet[profile_of[index]].sharing == SlotSharing::ProcessorSharing) {
+        host.virtual_time += static_cast<double>(now - host.updated) * width[index] / in_flight[index];
+    }
+    host.updated = now;
+}
+
+int ServerPool::completionTime(size_t index) const {
+    if (width[index] <= 1 || in_flight[index] == 0) {
+        return INT_MAX;
+    }
+    const Host& host = hosts[index];
+    const Job& next = host.jobs.front();
+    if (fleet[profile_of[index]].sharing == SlotSharing::Fifo) {
+        return static_cast<int>(next.finish);
+    }
+    // The virtual clock runs at slots / requests per tick until the next completion
+    double ticks = (next.finish - host.virtual_time) * in_flight[index] / width[index];
+    return host.updated + std::max(0, static_cast<int>(std::ceil(ticks - 1e-9)));
+}
+
+void ServerPool::rescheduleHost(size_t index) {
+    time_left[index] = in_flight[index] > 0 ? std::max(completionTime(index) - now, 1) : 0;
+}
+
+void ServerPool::startJob(size_t index, const Request& r) {
+    Host& host = hosts[index];
+    advanceHost(index);
+    bool shared = fleet[profile_of[index]].sharing == SlotSharing::ProcessorSharing;
+    Job job;
+    job.sequence = job_sequence++;
+    job.started = now;
+    job.request = r;
+    double work = serviceTime(index, r.gettime());
+    job.finish = shared ? host.virtual_time + work : static_cast<double>(now) + work;
+    if (in_flight[index] == 0) {
+        running[index >> 6] |= 1ULL << (index & 63);
+        running_count++;
+        host.running_since = now;
+        if (shared) {
+            used_units += units[index];
+        }
+    }
+    if (!shared) {
+        used_units += units[index] / static_cast<uint32_t>(width[index]);
+    }
+    in_flight[index]++;
+    free_count--;
+    host.jobs.push_back(job);
+    std::push_heap(host.jobs.begin(), host.jobs.end(), FinishesLater());
+    
+    if (order == IdleOrder::Recency) {
+        unlinkIdle(index);
+    }
+    if (in_flight[index] == width[index]) {
+        busy[index >> 6] |= 1ULL << (index & 63);
+        busy_count++;
+    } else if (order == IdleOrder::Recency) {
+        pushIdleFront(index);   // still has room, and is now the most recently active
+    }
+    rescheduleHost(index);
+}
+
+void ServerPool::finishJob(size_t index) {
+    Host& host = hosts[index];
+    advanceHost(index);
+    bool shared = fleet[profile_of[index]].sharing == SlotSharing::ProcessorSharing;
+    std::pop_heap(host.jobs.begin(), host.jobs.end(), FinishesLater());
+    int jobStarted = host.jobs.back().started;
+    host.jobs.pop_back();
+    served[index]++;
+    if (!shared) {
+        busy_time[index] += static_cast<uint64_t>(now - jobStarted);
+        used_units -= units[index] / static_cast<uint32_t>(width[index]);
+    }
+    in_flight[index]--;
+    free_count++;
+    if (in_flight[index] == 0) {
+        running[index >> 6] &= ~(1ULL << (index & 63));
+        running_count--;
+        if (shared) {
+            busy_time[index] += static_cast<uint64_t>(width[index]) * static_cast<uint64_t>(now - host.running_since);
+            used_units -= units[index];
+        }
+    }
+    
+    bool wasFull = isBusy(index);
+    if (wasFull) {
+        busy[index >> 6] &= ~(1ULL << (index & 63));
+        busy_count--;
+    }
+    if (order == IdleOrder::Recency) {
+        if (!wasFull) {
+            unlinkIdle(index);
+        }
+        pushIdleFront(index);
+    } else {
+        idle_hint = std::min(idle_hint, index >> 6);
+    }
+    rescheduleHost(index);
+}
+
+void ServerPool::setWarmup(int ticks, double throughput) {
+    warmup_ticks = std::max(ticks, 0);
+    cold_throughput = std::min(std::max(throughput, 0.01), 1.0);
+}
+
+int ServerPool::serviceTime(size_t index, int cycles) const {
+    cycles = std::max(cycles, 1);
+    double rate = fleet[profile_of[index]].speed;
+    int remaining = warm_at[index] - now;
+    if (remaining > 0 && warmup_ticks > 0) {
+        double warmed = 1.0 - static_cast<double>(remaining) / warmup_ticks;
+        rate *= cold_throughput + (1.0 - cold_throughput) * warmed;
+    } else if (rate == 1.0) {
+        return cycles;
+    }
+    return static_cast<int>(std::ceil(cycles / rate));
+}
+
+void ServerPool::complete(size_t index) {
+    if (!isRunning(index)) {
+        return;
+    }
+    if (width[index] > 1) {
+        finishJob(index);
+        return;
+    }
+    finishSlot(index);
+    busy_count--;
+    running_count--;
+    free_count++;
+    used_units -= units[index];
+    if (order == IdleOrder::Recency) {
+        pushIdleFront(index);
+    } else {
+        idle_hint = std::min(idle_hint, index >> 6);
+    }
+}
+
+Request ServerPool::preempt(size_t index, int remaining) {
+    if (!isRunning(index) || width[index] > 1) {
+        return Request();
+    }
+    Request r = requests[index];
+    r.settime(remaining);
+    busy[index >> 6] &= ~(1ULL << (index & 63));
+    running[index >> 6] &= ~(1ULL << (index & 63));
+    in_flight[index] = 0;
+    busy_time[index] += static_cast<uint64_t>(now - started[index]);
+    time_left[index] = 0;
+    requests[index] = Request();
+    busy_count--;
+    running_count--;
+    free_count++;
+    used_units -= units[index];
+    if (order == IdleOrder::Recency) {
+        pushIdleFront(index);
+    } else {
+        idle_hint = std::min(idle_hint, index >> 6);
+    }
+    return r;
+}
+
+void ServerPool::finishSlot(size_t index) {
+    busy[index >> 6] &= ~(1ULL << (index & 63));
+    running[index >> 6] &= ~(1ULL << (index & 63));
+    in_flight[index] = 0;
+    served[index]++;
+    busy_time[index] += static_cast<uint64_t>(now - started[index]);
+    time_left[index] = 0;
+    requests[index] = Request();
+}
+
+void ServerPool::commitSlots(long busyDelta, long unitsDelta) {
+    busy_count = static_cast<size_t>(static_cast<long>(busy_count) + busyDelta);
+    running_count = static_cast<size_t>(static_cast<long>(running_count) + busyDelta);
+    free_count = static_cast<size_t>(static_cast<long>(free_count) - busyDelta);
+    used_units = static_cast<uint64_t>(static_cast<long long>(used_units) + unitsDelta);
+    idle_hint = 0;      // finished servers may sit anywhere below the hint
+}
+
+void ServerPool::setIdleOrder(IdleOrder idleOrder) {
+    if (idleOrder == order) {
+        return;
+    }
+    order = idleOrder;
+    idle_head = idle_tail = NONE;
+    idle_hint = 0;
+    if (order == IdleOrder::Recency) {
+        for (long i = findIdle(0); i >= 0; i = findIdle(i + 1)) {
+            pushIdleBack(i);
+        }
+    }
+}
+
+long ServerPool::firstIdle() const {
+    if (order == IdleOrder::Recency) {
+        return idle_head;
+    }
+    long index = findIdle(idle_hint * 64);
+    idle_hint = index < 0 ? busy.size() : static_cast<size_t>(index) >> 6;
+    return index;
+}
+
+long ServerPool::coldestIdle() const {
+    if (order == IdleOrder::Recency) {
+        // Only multi-slot servers can be on the list while running a request
+        int32_t index = idle_tail;
+        while (index != NONE && isRunning(index)) {
+            index = idle_prev[index];
+        }
+        return index;
+    }
+    for (size_t w = busy.size(); w-- > 0;) {
+        uint64_t empty = ~(busy[w] | running[w]);
+        if (empty) {
+            return static_cast<long>(w * 64 + 63 - __builtin_clzll(empty));
+        }
+    }
+    return -1;
+}
+
+uint64_t ServerPool::busyTime(size_t index) const {
+    uint64_t total = busy_time[index];
+    if (!isRunning(index)) {
+        return total;
+    }
+    if (width[index] <= 1) {
+        return total + static_cast<uint64_t>(now - started[index]);
+    }
+    const Host& host = hosts[index];
+    if (fleet[profile_of[index]].sharing == SlotSharing::ProcessorSharing) {
+        return total + static_cast<uint64_t>(width[index]) * static_cast<uint64_t>(now - host.running_since);
+    }
+    for (const Job& job : host.jobs) {
+        total += static_cast<uint64_t>(now - job.started);
+    }
+    return total;
+}
+
+uint64_t ServerPool::presentTime(size_t index) const {
+    uint64_t total = present_time[index];
+    if (active[index]) {
+        total += static_cast<uint64_t>(now - joined[index]);
+    }
+    return total;
+}
+
+void ServerPool::advance(size_t index, int cycles) {
+    if (!isRunning(index)) {
+        return;
+    }
+    if (width[index] > 1) {
+        while (isDue(index)) {
+            finishJob(index);
+        }
+        rescheduleHost(index);
+        return;
+    }
+    if (cycles <= 0) {
+        return;
+    }
+    if (cycles >= time_left[index]) {
+        complete(index);
+    } else {
+        time_left[index] -= cycles;
+    }
+}
+
+void ServerPool::countdown(std::vector<uint64_t>& done) {
+    done.resize(busy.size());
+    countdownKernel(time_left.data(), running.data(), done.data(), busy.size());
+}
+
+void ServerPool::countdown(std::vector<uint64_t>& done, size_t firstWord, size_t lastWord) {
+    countdownKernel(time_left.data() + firstWord * 64, running.data() + firstWord, done.data() + firstWord,
+                    lastWord - firstWord);
+}
+
+size_t ServerPool::idleCount(size_t firstWord, size_t lastWord) const {
+    size_t idle = 0;
+    for (size_t w = firstWord; w < lastWord; ++w) {
+        idle += __builtin_popcountll(~busy[w]);
+    }
+    return idle;
+}
+
+long ServerPool::findIdle(size_t from) const {
+    return findIdle(from, busy.size() * 64);
+}
+
+long ServerPool::findIdle(size_t from, size_t end) const {
+    size_t lastWord = std::min(busy.size(), (end + 63) >> 6);
+    for (size_t w = from >> 6; w < lastWord; ++w) {
+        uint64_t idle = ~busy[w];
+        if (w == (from >> 6)) {
+            idle &= ~0ULL << (from & 63);
+        }
+        if (idle) {
+            size_t index = w * 64 + __builtin_ctzll(idle);
+            return index < end ? static_cast<long>(index) : -1;
+        }
+    }
+    return -1;
+}
+
+namespace {
+    /**
+     * @brief Scalar state of a ServerPool as stored in a checkpoint
+     */
+    struct PoolScalars {
+        uint64_t job_sequence;      ///< Assignments to multi-slot servers so far
+        uint64_t idle_hint;         ///< No idle server below this word
+        uint64_t slot_count;        ///< Number of slots ever used
+        uint64_t count;             ///< Number of servers in the pool
+        uint64_t busy_count;        ///< Servers with every request slot taken
+        uint64_t running_count;     ///< Servers running at least one request
+        uint64_t free_count;        ///< Free request slots over all servers
+        uint64_t total_units;       ///< Capacity of all servers
+        uint64_t used_units;        ///< Capacity in use
+        double cold_throughput;     ///< Speed of a cold server when it joins
+        int32_t now;                ///< Current time
+        int32_t warmup_ticks;       ///< Ticks a cold server needs to reach full speed
+        int32_t idle_head;          ///< Most recently active idle server
+        int32_t idle_tail;          ///< Least recently active idle server
+        uint8_t multi_slot;         ///< Whether any profile has more than one slot
+        uint8_t order;              ///< IdleOrder
+    };
+
+    /**
+     * @brief Per-server part of a multi-slot server's state in a checkpoint
+     */
+    struct HostRecord {
+        double virtual_time;        ///< Processor-sharing clock
+        int32_t updated;            ///< Time virtual_time was last brought up to date
+        int32_t running_since;      ///< Time the server last went from empty to running
+        uint64_t first_job;         ///< Index of the server's first request in the job section
+        uint64_t jobs;              ///< Number of requests the server runs
+    };
+}
+
+void ServerPool::saveState(SnapshotWriter& out) const {
+    PoolScalars scalars = PoolScalars();
+    scalars.job_sequence = job_sequence;
+    scalars.idle_hint = idle_hint;
+    scalars.slot_count = slot_count;
+    scalars.count = count;
+    scalars.busy_count = busy_count;
+    scalars.running_count = running_count;
+    scalars.free_count = free_count;
+    scalars.total_units = total_units;
+    scalars.used_units = used_units;
+    scalars.cold_throughput = cold_throughput;
+    scalars.now = now;
+    scalars.warmup_ticks = warmup_ticks;
+    scalars.idle_head = idle_head;
+    scalars.idle_tail = idle_tail;
+    scalars.multi_slot = multi_slot ? 1 : 0;
+    scalars.order = static_cast<uint8_t>(order);
+    out.addValue("pool", scalars);
+    out.add("pool.busy", busy);
+    out.add("pool.running", running);
+    out.add("pool.time_left", time_left);
+    out.add("pool.requests", requests);
+    out.add("pool.active", active);
+    out.add("pool.idle_prev", idle_prev);
+    out.add("pool.idle_next", idle_next);
+    out.add("pool.free_slots", free_slots);
+    out.add("pool.started", started);
+    out.add("pool.joined", joined);
+    out.add("pool.warm_at", warm_at);
+    out.add("pool.served", served);
+    out.add("pool.busy_time", busy_time);
+    out.add("pool.present_time", present_time);
+    out.add("pool.profile_of", profile_of);
+    out.add("pool.width", width);
+    out.add("pool.in_flight", in_flight);
+    out.add("pool.units", units);
+    out.add("pool.fleet", fleet);
+    std::vector<uint64_t> counts(fleet_count.begin(), fleet_count.end());
+    out.add("pool.fleet_count", counts);
+
+    // Heaps of jobs become one array; each server records where its part starts
+    std::vector<HostRecord> records;
+    std::vector<Job> jobs;
+    records.reserve(hosts.size());
+    for (const Host& host : hosts) {
+        records.push_back(HostRecord{host.virtual_time, host.updated, host.running_since, jobs.size(), host.jobs.size()});
+        jobs.insert(jobs.end(), host.jobs.begin(), host.jobs.end());
+    }
+    out.add("pool.hosts", records);
+    out.add("pool.jobs", jobs);
+}
+
+bool ServerPool::restoreState(SnapshotReader& in) {
+    ServerPool restored;
+    PoolScalars scalars;
+    std::vector<uint64_t> counts;
+    std::vector<HostRecord> records;
+    const Job* jobs = nullptr;
+    size_t jobCount = 0;
+    if (!in.readValue("pool", scalars) || !in.read("pool.busy", restored.busy) || !in.read("pool.running", restored.running)
+        || !in.read("pool.time_left", restored.time_left) || !in.read("pool.requests", restored.requests)
+        || !in.read("pool.active", restored.active) || !in.read("pool.idle_prev", restored.idle_prev)
+        || !in.read("pool.idle_next", restored.idle_next) || !in.read("pool.free_slots", restored.free_slots)
+        || !in.read("pool.started", restored.started) || !in.read("pool.joined", restored.joined)
+        || !in.read("pool.warm_at", restored.warm_at) || !in.read("pool.served", restored.served)
+        || !in.read("pool.busy_time", restored.busy_time) || !in.read("pool.present_time", restored.present_time)
+        || !in.read("pool.profile_of", restored.profile_of) || !in.read("pool.width", restored.width)
+        || !in.read("pool.in_flight", restored.in_flight) || !in.read("pool.units", restored.units)
+        || !in.read("pool.fleet", restored.fleet) || !in.read("pool.fleet_count", counts)
+        || !in.read("pool.hosts", records) || !in.get("pool.jobs", jobs, jobCount)) {
+        return false;
+    }
+
+    // Every per-slot lane must cover the bitmaps, and every job range the job array
+    size_t lanes = restored.busy.size() * 64;
+    bool consistent = restored.running.size() == restored.busy.size() && restored.fleet.size() == counts.size()
+                      && !restored.fleet.empty() && scalars.slot_count <= lanes
+                      && (records.empty() || records.size() == lanes);
+    for (const std::vector<int32_t>* lane : {&restored.time_left, &restored.idle_prev, &restored.idle_next,
+                                              &restored.started, &restored.joined, &restored.warm_at,
+                                              &restored.width, &restored.in_flight}) {
+        consistent = consistent && lane->size() == lanes;
+    }
+    consistent = consistent && restored.requests.size() == lanes && restored.active.size() == lanes
+                 && restored.served.size() == lanes && restored.busy_time.size() == lanes
+                 && restored.present_time.size() == lanes && restored.profile_of.size() == lanes
+                 && restored.units.size() == lanes;
+    for (const HostRecord& record : records) {
+        consistent = consistent && record.first_job <= jobCount && record.jobs <= jobCount - record.first_job;
+    }
+    if (!consistent || scalars.order > static_cast<uint8_t>(IdleOrder::Index)) {
+        return false;
+    }
+
+    restored.fleet_count.assign(counts.begin(), counts.end());
+    restored.hosts.resize(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        Host& host = restored.hosts[i];
+        host.jobs.assign(jobs + records[i].first_job, jobs + records[i].first_job + records[i].jobs);
+        host.virtual_time = records[i].virtual_time;
+        host.updated = records[i].updated;
+        host.running_since = records[i].running_since;
+    }
+    restored.multi_slot = scalars.multi_slot != 0;
+    restored.job_sequence = scalars.job_sequence;
+    restored.now = scalars.now;
+    restored.warmup_ticks = scalars.warmup_ticks;
+    restored.cold_throughput = scalars.cold_throughput;
+    restored.order = static_cast<IdleOrder>(scalars.order);
+    restored.idle_hint = static_cast<size_t>(scalars.idle_hint);
+    restored.idle_head = scalars.idle_head;
+    restored.idle_tail = scalars.idle_tail;
+    restored.slot_count = static_cast<size_t>(scalars.slot_count);
+    restored.count = static_cast<size_t>(scalars.count);
+    restored.busy_count = static_cast<size_t>(scalars.busy_count);
+    restored.running_count = static_cast<size_t>(scalars.running_count);
+    restored.free_count = static_cast<size_t>(scalars.free_count);
+    restored.total_units = scalars.total_units;
+    restored.used_units = scalars.used_units;
+    if (!restored.consistent()) {
+        return false;
+    }
+    *this = std::move(restored);
+    return true;
+}
+
+bool ServerPool::consistent() const {
+    const size_t lanes = time_left.size();
+    if (fleet.size() > UINT16_MAX || slot_count > lanes || idle_hint > busy.size()) {
+        return false;
+    }
+    bool multi = false;
+    for (const ServerProfile& profile : fleet) {
+        if (profile.slots < 1 || !(profile.speed > 0.0) || std::isinf(profile.speed)
+            || (profile.sharing != SlotSharing::Fifo && profile.sharing != SlotSharing::ProcessorSharing)) {
+            return false;
+        }
+        multi = multi || profile.slots > 1;
+    }
+    if (multi_slot != multi || hosts.size() != (multi ? lanes : 0)) {
+        return false;
+    }
+
+    // Each slot against its bitmap bits, its profile and its requests, recounting as we go
+    size_t servers = 0, full = 0, runners = 0, free = 0, idle = 0;
+    std::vector<size_t> perProfile(fleet.size(), 0);
+    for (size_t i = 0; i < lanes; ++i) {
+        bool isFull = (busy[i >> 6] >> (i & 63)) & 1;
+        bool runs = (running[i >> 6] >> (i & 63)) & 1;
+        if (profile_of[i] >= fleet.size() || width[i] < 1 || in_flight[i] < 0 || in_flight[i] > width[i]
+            || time_left[i] < 0 || active[i] > 1 || (active[i] && i >= slot_count)) {
+            return false;
+        }
+        if (hosts.empty() ? in_flight[i] > 1 : hosts[i].jobs.size() != static_cast<size_t>(width[i] > 1 ? in_flight[i] : 0)) {
+            return false;
+        }
+        if (!hosts.empty() && !std::is_heap(hosts[i].jobs.begin(), hosts[i].jobs.end(), FinishesLater())) {
+            return false;
+        }
+        if (!active[i]) {
+            if (!isFull || runs || in_flight[i] != 0) {
+                return false;
+            }
+            continue;
+        }
+        if (width[i] != fleet[profile_of[i]].slots || isFull != (in_flight[i] == width[i]) || runs != (in_flight[i] > 0)) {
+            return false;
+        }
+        servers++;
+        full += isFull;
+        runners += runs;
+        idle += !isFull;
+        free += static_cast<size_t>(width[i] - in_flight[i]);
+        perProfile[profile_of[i]]++;
+    }
+    if (servers != count || full != busy_count || runners != running_count || free != free_count
+        || std::vector<size_t>(fleet_count.begin(), fleet_count.end()) != perProfile) {
+        return false;
+    }
+
+    // Released slots are exactly the inactive slots in use, each on the stack once
+    std::vector<uint8_t> stacked(slot_count, 0);
+    for (int32_t index : free_slots) {
+        if (index < 0 || static_cast<size_t>(index) >= slot_count || active[index] || stacked[index]) {
+            return false;
+        }
+        stacked[index] = 1;
+    }
+    if (free_slots.size() != slot_count - count) {
+        return false;
+    }
+
+    // The idle list holds every server with a free request slot once, with matching back links
+    std::vector<uint8_t> listed(lanes, 0);
+    size_t length = 0;
+    int32_t previous = NONE;
+    if (order == IdleOrder::Recency) {
+        for (int32_t index = idle_head; index != NONE; index = idle_next[index]) {
+            if (index < 0 || static_cast<size_t>(index) >= slot_count || listed[index] || !active[index]
+                || isBusy(index) || idle_prev[index] != previous) {
+                return false;
+            }
+            listed[index] = 1;
+            length++;
+            previous = index;
+        }
+    } else if (idle_head != NONE) {
+        return false;
+    }
+    if (idle_tail != previous || (order == IdleOrder::Recency && length != idle)) {
+        return false;
+    }
+    // Under IdleOrder::Index the links are unused and may be left over from the recency list
+    for (size_t i = 0; i < lanes; ++i) {
+        bool stale = idle_prev[i] != NONE || idle_next[i] != NONE;
+        bool inRange = idle_prev[i] >= NONE && idle_prev[i] < static_cast<int32_t>(slot_count)
+                       && idle_next[i] >= NONE && idle_next[i] < static_cast<int32_t>(slot_count);
+        if (!listed[i] && (order == IdleOrder::Recency ? stale : !inRange)) {
+            return false;
+        }
+    }
+    return true;
+}
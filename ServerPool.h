@@ -0,0 +1,672 @@
+/**
+ * @file ServerPool.h
+ * @brief ServerPool class header file
+ */
+#ifndef SERVERPOOL_H
+#define SERVERPOOL_H
+
+#include "Request.h"
+#include "Snapshot.h"
+#include "WebServer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Order in which a ServerPool offers its idle servers
+ */
+enum class IdleOrder {
+    Recency,    ///< Most recently active first; scale-down removes the longest-idle server
+    Index       ///< Lowest index first; scale-down removes the highest-indexed idle server
+};
+
+/**
+ * @brief How a multi-slot server shares its capacity between the requests it runs
+ */
+enum class SlotSharing {
+    Fifo,               ///< Every request runs on a slot of its own at the server's speed
+    ProcessorSharing    ///< The requests split all the server's slots equally between them
+};
+
+/**
+ * @brief Hardware class of the servers in a heterogeneous pool
+ */
+struct ServerProfile {
+    int slots = 1;                          ///< Requests the server runs at once
+    double speed = 1.0;                     ///< Cycles one slot processes per tick
+    SlotSharing sharing = SlotSharing::Fifo;    ///< How the slots are shared
+};
+
+/**
+ * @brief Parses a fleet spec: comma-separated "<slots>[x<speed>][:fifo|:ps]" profiles
+ *
+ * For example "4x1,2x2:ps" mixes four-slot servers of speed 1 with two-slot
+ * processor-sharing servers of speed 2. Servers are spread evenly over the
+ * profiles (see ServerPool::setFleet()).
+ *
+ * @param spec Fleet spec
+ * @param fleet Receives the profiles
+ * @return false on an empty spec, slots outside [1, 1024] or speed outside [0.01, 100]
+ */
+bool parseFleet(const std::string& spec, std::vector<ServerProfile>& fleet);
+
+/**
+ * @brief Formats a fleet in the syntax parseFleet() accepts
+ * @param fleet Profiles
+ * @return Fleet spec, e.g. "4x1,2x2:ps"
+ */
+std::string formatFleet(const std::vector<ServerProfile>& fleet);
+
+/**
+ * @brief Struct-of-arrays storage for the load balancer's web servers
+ *
+ * Instead of one heap object per server, the pool keeps each server attribute in
+ * its own contiguous array: a bitmap with one "unavailable" bit per slot, an int32
+ * array of remaining processing times and a (cold) array of current requests. The
+ * tick loop therefore streams through a few dense arrays instead of chasing pointers:
+ * countdown() decrements every remaining time with SSE2/AVX2 (picked at run time,
+ * with a scalar fallback) and reports finished servers as a bitmap.
+ *
+ * Every server keeps the slot index it was given for its whole lifetime, which is
+ * also its ID in the logs. Removing a server releases its slot without moving any
+ * other server, and adding a server recycles the most recently released slot before
+ * growing the arrays. Idle servers are threaded on an intrusive doubly linked list
+ * (ordered from most to least recently active), so idle counts, picking an idle
+ * server, taking a specific server off the list and choosing a server to remove
+ * are all constant time regardless of pool size.
+ *
+ * IdleOrder::Index drops the list and ranks idle servers by index instead, found
+ * with bit scans of the busy bitmap. Nothing in that mode is shared between slots
+ * of different bitmap words, so disjoint word ranges can be updated from different
+ * threads with startSlot()/finishSlot() and the counters reconciled afterwards with
+ * commitSlots().
+ *
+ * Arrays are padded to a multiple of 64 slots. Padding and released slots are
+ * marked unavailable with zero time left, so bit scans never return them and the
+ * countdown never finishes them.
+ *
+ * The pool also keeps cold per-slot statistics (requests served, busy and present
+ * time) against a clock the owner advances with setTime(). A recycled slot keeps
+ * accumulating into the same counters, matching its reuse of the server ID.
+ *
+ * By default every server runs one request at a time at speed 1. setFleet() gives
+ * the servers profiles with a speed factor and several request slots. A server is
+ * "unavailable" in the busy bitmap only when all its slots are taken, so idle
+ * counts, firstIdle() and the dispatch policies see servers that can take another
+ * request; isRunning() tells whether a server holds any request at all. Single-slot
+ * servers keep the plain countdown above. A multi-slot server keeps its requests in
+ * a min-heap on their completion (FIFO slots) or virtual finish time (processor
+ * sharing, where a virtual clock advances by slots / requests per tick), and its
+ * time-left lane holds the ticks until the earliest one completes, so the countdown
+ * finds it without looking at its other requests. Completions are rounded up to
+ * whole ticks. Capacity is counted in thousandths of a cycle per tick
+ * (capacityUnits()), so autoscaling and dispatch can weigh fast servers against
+ * slow ones.
+ *
+ * WebServer is a lightweight handle to one slot of a pool.
+ */
+class ServerPool {
+private:
+    static constexpr int32_t NONE = -1; ///< End-of-list marker for the idle list and slot stack
+
+    /**
+     * @brief One request on a multi-slot server
+     */
+    struct Job {
+        double finish;                  ///< Completion tick (FIFO) or virtual finish time (processor sharing)
+        uint64_t sequence;              ///< Assignment order, breaks ties between equal finishes
+        int started;                    ///< Time the request was assigned
+        Request request;                ///< The request
+    };
+
+    /**
+     * @brief Requests of a multi-slot server
+     */
+    struct Host {
+        std::vector<Job> jobs;          ///< Min-heap on (finish, sequence)
+        double virtual_time = 0.0;      ///< Processor-sharing clock: slot-ticks each request has received
+        int updated = 0;                ///< Time virtual_time was last brought up to date
+        int running_since = 0;          ///< Time the server last went from empty to running
+    };
+
+    std::vector<uint64_t> busy;         ///< Bit i set unless slot i holds a server with a free request slot
+    std::vector<uint64_t> running;      ///< Bit i set if slot i holds a server with at least one request
+    std::vector<int32_t> time_left;     ///< Remaining processing time per slot (0 when idle)
+    std::vector<Request> requests;      ///< Request currently being processed per slot
+    std::vector<uint8_t> active;        ///< 1 if the slot holds a server, 0 if released or never used
+    std::vector<int32_t> idle_prev;     ///< Previous (more recently active) server on the idle list
+    std::vector<int32_t> idle_next;     ///< Next (less recently active) server on the idle list
+    std::vector<int32_t> free_slots;    ///< Released slots available for reuse (stack)
+    std::vector<int32_t> started;       ///< Time the current request was assigned, per slot
+    std::vector<int32_t> joined;        ///< Time the slot's current server was added
+    std::vector<int32_t> warm_at;       ///< Time the slot's current server reaches full speed
+    std::vector<uint64_t> served;       ///< Requests completed, per slot
+    std::vector<uint64_t> busy_time;    ///< Time spent on completed requests, per slot
+    std::vector<uint64_t> present_time; ///< Time spent in the pool by earlier servers of the slot
+    std::vector<uint16_t> profile_of;   ///< Fleet profile of each slot's server
+    std::vector<int32_t> width;         ///< Request slots of each slot's server
+    std::vector<int32_t> in_flight;     ///< Requests each slot's server is running
+    std::vector<uint32_t> units;        ///< Capacity of each slot's server, in thousandths of a cycle per tick
+    std::vector<Host> hosts;            ///< Requests of multi-slot servers (empty while the fleet has none)
+    std::vector<ServerProfile> fleet;   ///< Server profiles, assigned round-robin
+    std::vector<size_t> fleet_count;    ///< Servers of each profile in the pool
+    bool multi_slot;                    ///< Whether any profile has more than one slot
+    uint64_t job_sequence;              ///< Assignments to multi-slot servers so far
+    int now;                            ///< Current time, set by the owner with setTime()
+    int warmup_ticks;                   ///< Ticks a cold server needs to reach full speed
+    double cold_throughput;             ///< Speed of a cold server when it joins, as a share of full speed
+    IdleOrder order;                    ///< How idle servers are ranked
+    mutable size_t idle_hint;           ///< No idle server below this word (IdleOrder::Index)
+    int32_t idle_head;                  ///< Most recently active idle server, or NONE
+    int32_t idle_tail;                  ///< Least recently active idle server, or NONE
+    size_t slot_count;                  ///< Number of slots ever used (upper bound for iteration)
+    size_t count;                       ///< Number of servers in the pool
+    size_t busy_count;                  ///< Number of servers with every request slot taken
+    size_t running_count;               ///< Number of servers running at least one request
+    size_t free_count;                  ///< Free request slots over all servers
+    uint64_t total_units;               ///< Capacity of all servers, in thousandths of a cycle per tick
+    uint64_t used_units;                ///< Capacity in use, in thousandths of a cycle per tick
+
+    /**
+     * @brief Checks a pool read from a checkpoint before it is used
+     *
+     * Every index, link and bitmap bit is checked against the arrays, and the
+     * counters are recounted, so a corrupt file cannot send the pool out of bounds.
+     *
+     * @return true if the pool is internally consistent
+     */
+    bool consistent() const;
+
+    /**
+     * @brief Grows the arrays to hold at least the given number of slots
+     * @param slots Required number of slots
+     */
+    void ensureCapacity(size_t slots);
+
+    /**
+     * @brief Puts an idle server at the front (most recently active end) of the idle list
+     * @param index Server slot
+     */
+    void pushIdleFront(size_t index);
+
+    /**
+     * @brief Puts an idle server at the back (least recently active end) of the idle list
+     * @param index Server slot
+     */
+    void pushIdleBack(size_t index);
+
+    /**
+     * @brief Unlinks a server from the idle list
+     * @param index Server slot (must be on the list)
+     */
+    void unlinkIdle(size_t index);
+
+    /**
+     * @brief Gives a server the least-represented fleet profile (lowest first on ties)
+     * @param index Slot of a server that is being added
+     */
+    void applyProfile(size_t index);
+
+    /**
+     * @brief Brings a multi-slot server's processor-sharing clock up to now
+     * @param index Server slot
+     */
+    void advanceHost(size_t index);
+
+    /**
+     * @brief Sets a multi-slot server's time left to the ticks until its next completion
+     * @param index Server slot
+     */
+    void rescheduleHost(size_t index);
+
+    /**
+     * @brief Starts a request on a multi-slot server with a free request slot
+     * @param index Server slot
+     * @param r Request to process
+     */
+    void startJob(size_t index, const Request& r);
+
+    /**
+     * @brief Finishes the earliest request of a running multi-slot server
+     * @param index Server slot
+     */
+    void finishJob(size_t index);
+
+public:
+    /**
+     * @brief Constructs an empty pool
+     */
+    ServerPool();
+
+    /**
+     * @brief Preallocates room for the given number of servers
+     * @param servers Number of servers the pool is expected to hold
+     */
+    void reserve(size_t servers);
+
+    /**
+     * @brief Adds an idle server, reusing a released slot when one is available
+     *
+     * The server gets the fleet profile that has the fewest servers in the pool.
+     *
+     * @param cold Whether the server starts cold and has to warm up (see setWarmup())
+     * @return Slot index (ID) of the new server
+     */
+    size_t add(bool cold = false);
+
+    /**
+     * @brief Sets the server profiles and reprofiles the servers already in the pool
+     *
+     * Servers keep their slots; profiles are dealt out in index order as add() would.
+     *
+     * @param profiles Profiles to spread the servers over (at least one)
+     * @return false if a server is running a request or profiles is empty
+     */
+    bool setFleet(const std::vector<ServerProfile>& profiles);
+
+    /**
+     * @brief Gets the server profiles
+     * @return Profiles (a single one-slot, speed-1 profile by default)
+     */
+    const std::vector<ServerProfile>& getFleet() const { return fleet; }
+
+    /**
+     * @brief Checks whether any profile has more than one request slot
+     * @return true if some server can run several requests at once
+     */
+    bool hasMultiSlot() const { return multi_slot; }
+
+    /**
+     * @brief Sets how cold servers warm up
+     *
+     * A cold server's speed rises linearly from the given share of full speed when it
+     * joins to full speed after the given number of ticks. A request's processing
+     * time is fixed when it is assigned, from the server's speed at that moment.
+     *
+     * @param ticks Warm-up time; 0 (the default) makes every server start at full speed
+     * @param throughput Speed on joining, in (0, 1]
+     */
+    void setWarmup(int ticks, double throughput);
+
+    /**
+     * @brief Gets how long a server would take for a request assigned now
+     * @param index Server index
+     * @param cycles Processing time of the request on a warm speed-1 slot
+     * @return Ticks one of the server's slots needs for the request (at least one)
+     */
+    int serviceTime(size_t index, int cycles) const;
+
+    /**
+     * @brief Removes an idle server by releasing its slot; no other server moves
+     * @param index Slot of the server to remove (must not be running a request)
+     */
+    void release(size_t index);
+
+    /**
+     * @brief Gets the number of servers in the pool
+     * @return Pool size
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Gets the number of slots ever used; every server's index is below this
+     * @return Slot high-water mark
+     */
+    size_t slotCount() const { return slot_count; }
+
+    /**
+     * @brief Gets the number of busy servers (every request slot taken)
+     * @return Busy server count (constant time)
+     */
+    size_t busyCount() const { return busy_count; }
+
+    /**
+     * @brief Gets the number of idle servers (at least one free request slot)
+     * @return Idle server count (constant time)
+     */
+    size_t idleCount() const { return count - busy_count; }
+
+    /**
+     * @brief Gets the number of servers running at least one request
+     * @return Running server count (constant time)
+     */
+    size_t runningCount() const { return running_count; }
+
+    /**
+     * @brief Gets the number of servers running no request at all
+     * @return Empty server count (constant time)
+     */
+    size_t emptyCount() const { return count - running_count; }
+
+    /**
+     * @brief Gets the number of free request slots over all servers
+     * @return Free slot count (constant time)
+     */
+    size_t freeCount() const { return free_count; }
+
+    /**
+     * @brief Gets the capacity of all servers
+     * @return Cycles the pool processes per tick when every slot is in use
+     */
+    double capacity() const { return static_cast<double>(total_units) / 1000.0; }
+
+    /**
+     * @brief Gets the capacity in use
+     *
+     * A FIFO server uses its speed for every running request; a processor-sharing
+     * server uses all its capacity while it runs anything.
+     *
+     * @return Cycles per tick the running requests are being processed at
+     */
+    double usedCapacity() const { return static_cast<double>(used_units) / 1000.0; }
+
+    /**
+     * @brief Checks whether a slot holds a server
+     * @param index Slot index
+     * @return true if a server occupies the slot
+     */
+    bool isActive(size_t index) const { return index < slot_count && active[index]; }
+
+    /**
+     * @brief Checks whether a server has every request slot taken
+     * @param index Server index
+     * @return true if the server is busy
+     */
+    bool isBusy(size_t index) const {
+        return active[index] && ((busy[index >> 6] >> (index & 63)) & 1);
+    }
+
+    /**
+     * @brief Checks whether a server is processing at least one request
+     * @param index Server index
+     * @return true if the server is running a request
+     */
+    bool isRunning(size_t index) const { return (running[index >> 6] >> (index & 63)) & 1; }
+
+    /**
+     * @brief Gets a server's remaining processing time
+     * @param index Server index
+     * @return Time cycles left on the current (for multi-slot servers, the earliest) request
+     */
+    int timeLeft(size_t index) const { return time_left[index]; }
+
+    /**
+     * @brief Gets the request a server is processing
+     * @param index Server index
+     * @return Current (for multi-slot servers, earliest completing) request; an empty
+     *         request when the server runs none
+     */
+    const Request& request(size_t index) const {
+        return width[index] > 1 && in_flight[index] > 0 ? hosts[index].jobs.front().request : requests[index];
+    }
+
+    /**
+     * @brief Gets the number of request slots of a server
+     * @param index Server index
+     * @return Requests the server can run at once
+     */
+    int concurrency(size_t index) const { return width[index]; }
+
+    /**
+     * @brief Gets the number of requests a server is running
+     * @param index Server index
+     * @return Requests in flight
+     */
+    int inFlight(size_t index) const { return in_flight[index]; }
+
+    /**
+     * @brief Gets the speed factor of a server's slots
+     * @param index Server index
+     * @return Cycles one slot processes per tick once warm
+     */
+    double speed(size_t index) const { return fleet[profile_of[index]].speed; }
+
+    /**
+     * @brief Gets how a server shares its slots
+     * @param index Server index
+     * @return Sharing model of the server's profile
+     */
+    SlotSharing sharing(size_t index) const { return fleet[profile_of[index]].sharing; }
+
+    /**
+     * @brief Gets the capacity of a server
+     * @param index Server index
+     * @return Slots times speed, in thousandths of a cycle per tick
+     */
+    uint32_t capacityUnits(size_t index) const { return units[index]; }
+
+    /**
+     * @brief Gets when a multi-slot server's earliest request completes
+     * @param index Index of a multi-slot server
+     * @return Completion tick, or INT_MAX if the server runs no request
+     */
+    int completionTime(size_t index) const;
+
+    /**
+     * @brief Checks whether a multi-slot server has a request that completes by now
+     * @param index Server index
+     * @return true if complete() would finish a request of a multi-slot server now;
+     *         always false for single-slot servers
+     */
+    bool isDue(size_t index) const {
+        return width[index] > 1 && in_flight[index] > 0 && completionTime(index) <= now;
+    }
+
+    /**
+     * @brief Gets a handle to one server
+     * @param index Server index
+     * @return WebServer handle bound to this pool
+     */
+    WebServer server(size_t index) { return WebServer(*this, index); }
+
+    /**
+     * @brief Sets the clock used to stamp assignments, completions and membership changes
+     * @param time Current simulation time
+     */
+    void setTime(int time) { now = time; }
+
+    /**
+     * @brief Gets the time the pool's clock was last set to
+     * @return Current simulation time
+     */
+    int getTime() const { return now; }
+
+    /**
+     * @brief Gets the time a busy server was given its current request
+     * @param index Server index
+     * @return Assignment time of the current (for multi-slot servers, earliest
+     *         completing) request; meaningless for servers running none
+     */
+    int startTime(size_t index) const {
+        return width[index] > 1 && in_flight[index] > 0 ? hosts[index].jobs.front().started : started[index];
+    }
+
+    /**
+     * @brief Gets the number of requests a slot has completed
+     * @param index Slot index
+     * @return Completed request count
+     */
+    uint64_t servedCount(size_t index) const { return served[index]; }
+
+    /**
+     * @brief Gets the time a slot has spent processing requests, up to now
+     * @param index Slot index
+     * @return Busy time, including the elapsed part of the current request; a
+     *         multi-slot server counts one unit per running slot per tick (all of
+     *         its slots while processor sharing runs anything)
+     */
+    uint64_t busyTime(size_t index) const;
+
+    /**
+     * @brief Gets the time servers have occupied a slot, up to now
+     * @param index Slot index
+     * @return Time in the pool, including the current server's time so far
+     */
+    uint64_t presentTime(size_t index) const;
+
+    /**
+     * @brief Selects how idle servers are ranked by firstIdle() and coldestIdle()
+     * @param idleOrder IdleOrder::Recency (the default) or IdleOrder::Index
+     */
+    void setIdleOrder(IdleOrder idleOrder);
+
+    /**
+     * @brief Gets how idle servers are ranked
+     * @return Current idle order
+     */
+    IdleOrder getIdleOrder() const { return order; }
+
+    /**
+     * @brief Gets the idle server that should receive work first
+     * @return Most recently active (or, in index order, lowest-indexed) idle server,
+     *         or -1 if every server is busy
+     */
+    long firstIdle() const;
+
+    /**
+     * @brief Gets the idle server that should be removed first
+     * @return Longest-idle (or, in index order, highest-indexed) server that runs no
+     *         request, or -1 if every server is running one
+     */
+    long coldestIdle() const;
+
+    /**
+     * @brief Starts processing a request on a server with a free request slot
+     * @param index Index of an idle server
+     * @param r Request to process; process times below one cycle are treated as one,
+     *        and slow or cold servers take longer (see serviceTime())
+     */
+    void assign(size_t index, const Request& r);
+
+    /**
+     * @brief Finishes a server's current request and frees its request slot
+     *
+     * Multi-slot servers finish their earliest request, which should be due (isDue()).
+     *
+     * @param index Server index
+     */
+    void complete(size_t index);
+
+    /**
+     * @brief Takes a server's request away before it finishes and marks the server idle
+     *
+     * The time spent on the request so far counts as busy time, but not as a served
+     * request.
+     *
+     * @param index Index of a busy single-slot server
+     * @param remaining Ticks the request still needs (under the event engine the
+     *        pool's own countdown is not kept current, so the caller supplies it)
+     * @return The request, with its processing time set to the remaining ticks
+     */
+    Request preempt(size_t index, int remaining);
+
+    /**
+     * @brief Advances one server by several ticks, completing its request if time runs out
+     *
+     * Multi-slot servers follow the pool's clock instead: their requests that are due
+     * by now complete and the time left is recomputed.
+     *
+     * @param index Server index
+     * @param cycles Number of ticks to advance
+     */
+    void advance(size_t index, int cycles);
+
+    /**
+     * @brief Decrements the remaining time of every running server by one tick
+     *
+     * Servers whose time reaches zero are reported in done (bit i for server i) but
+     * keep their request until complete() is called, so callers can still hand work to
+     * the servers that were idle before this tick without picking up the finishers.
+     *
+     * @param done Receives one bit per slot; resized to wordCount()
+     */
+    void countdown(std::vector<uint64_t>& done);
+
+    /**
+     * @brief Runs countdown() on a range of bitmap words only
+     *
+     * Safe to call concurrently for disjoint ranges.
+     *
+     * @param done Receives the finished servers of the range; must already hold wordCount() words
+     * @param firstWord First bitmap word of the range
+     * @param lastWord One past the last bitmap word of the range
+     */
+    void countdown(std::vector<uint64_t>& done, size_t firstWord, size_t lastWord);
+
+    /**
+     * @brief Counts the idle servers in a range of bitmap words
+     * @param firstWord First bitmap word of the range
+     * @param lastWord One past the last bitmap word of the range
+     * @return Number of servers with a free request slot in the range
+     */
+    size_t idleCount(size_t firstWord, size_t lastWord) const;
+
+    /**
+     * @brief Starts a request on an idle server without updating pool-wide state
+     *
+     * Only writes the slot and its bitmap words, so threads working on disjoint word
+     * ranges may call it concurrently. Requires IdleOrder::Index and single-slot
+     * servers; call commitSlots() once the threads are done.
+     *
+     * @param index Index of an idle server
+     * @param r Request to process; process times below one cycle are treated as one
+     */
+    void startSlot(size_t index, const Request& r);
+
+    /**
+     * @brief Finishes a server's request without updating pool-wide state
+     *
+     * The concurrent counterpart of complete(); see startSlot().
+     *
+     * @param index Index of a busy server
+     */
+    void finishSlot(size_t index);
+
+    /**
+     * @brief Reconciles the pool-wide counters after startSlot()/finishSlot() calls
+     * @param busyDelta Number of startSlot() calls minus number of finishSlot() calls
+     * @param unitsDelta capacityUnits() of the started servers minus those of the finished ones
+     */
+    void commitSlots(long busyDelta, long unitsDelta);
+
+    /**
+     * @brief Finds the lowest-indexed idle server at or after a position
+     * @param from First index to consider
+     * @return Index of an idle server, or -1 if there is none
+     */
+    long findIdle(size_t from) const;
+
+    /**
+     * @brief Finds the lowest-indexed idle server in a range
+     * @param from First index to consider
+     * @param end One past the last index to consider
+     * @return Index of an idle server, or -1 if there is none in the range
+     */
+    long findIdle(size_t from, size_t end) const;
+
+    /**
+     * @brief Gets the number of 64-bit words in the slot bitmaps
+     * @return Bitmap length in words
+     */
+    size_t wordCount() const { return busy.size(); }
+
+    /**
+     * @brief Adds the complete pool to a checkpoint: fleet, slots, requests and statistics
+     *
+     * The requests of multi-slot servers are stored as one array with an offset per
+     * server.
+     *
+     * @param out Checkpoint being written
+     */
+    void saveState(SnapshotWriter& out) const;
+
+    /**
+     * @brief Replaces the pool with the one stored in a checkpoint
+     * @param in Open checkpoint
+     * @return false if a section is missing or inconsistent (the pool is then unchanged)
+     */
+    bool restoreState(SnapshotReader& in);
+};
+
+#endif // SERVERPOOL_H
@@ -0,0 +1,216 @@
+/**
+ * @file Snapshot.cpp
+ * @brief Checkpoint writer and reader implementation
+ */
+
+#include "Snapshot.h"
+#include <cstdio>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * @brief Rounds a size up to the section alignment
+     * @param n Size in bytes
+     * @return Smallest multiple of SnapshotFormat::ALIGNMENT not below n
+     */
+    size_t aligned(size_t n) {
+        return (n + SnapshotFormat::ALIGNMENT - 1) & ~(SnapshotFormat::ALIGNMENT - 1);
+    }
+
+    /**
+     * @brief Stores an integer at a byte position
+     * @tparam T Integer type
+     * @param out Buffer
+     * @param at Byte position
+     * @param value Value
+     */
+    template <typename T>
+    void put(std::string& out, size_t at, T value) {
+        std::memcpy(&out[at], &value, sizeof(T));
+    }
+
+    /**
+     * @brief Loads an integer from a byte position
+     * @tparam T Integer type
+     * @param in Buffer
+     * @return Value
+     */
+    template <typename T>
+    T take(const unsigned char* in) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        return value;
+    }
+}
+
+void SnapshotWriter::add(const std::string& name, const void* elements, size_t elementSize, size_t count) {
+    if (name.empty() || name.size() >= SnapshotFormat::NAME_SIZE) {
+        failure = failure.empty() ? "Invalid checkpoint section name: " + name : failure;
+        return;
+    }
+    size_t start = aligned(data.size());
+    data.resize(start + elementSize * count, '\0');
+    if (count > 0) {
+        std::memcpy(&data[start], elements, elementSize * count);
+    }
+    sections.push_back(Section{name, static_cast<uint32_t>(elementSize), count, start});
+}
+
+bool SnapshotWriter::write(const std::string& filepath) {
+    if (!failure.empty()) {
+        return false;
+    }
+    size_t tableEnd = SnapshotFormat::HEADER_SIZE + sections.size() * SnapshotFormat::ENTRY_SIZE;
+    size_t dataStart = aligned(tableEnd);
+    std::string head(dataStart, '\0');
+    std::memcpy(&head[0], SnapshotFormat::MAGIC, sizeof(SnapshotFormat::MAGIC));
+    put<uint32_t>(head, 8, SnapshotFormat::VERSION);
+    put<uint32_t>(head, 12, SnapshotFormat::ENDIAN_MARK);
+    put<uint64_t>(head, 16, static_cast<uint64_t>(dataStart + data.size()));
+    put<uint32_t>(head, 24, static_cast<uint32_t>(sections.size()));
+    for (size_t i = 0; i < sections.size(); ++i) {
+        size_t at = SnapshotFormat::HEADER_SIZE + i * SnapshotFormat::ENTRY_SIZE;
+        std::memcpy(&head[at], sections[i].name.data(), sections[i].name.size());
+        put<uint32_t>(head, at + 24, sections[i].element_size);
+        put<uint64_t>(head, at + 32, static_cast<uint64_t>(dataStart + sections[i].start));
+        put<uint64_t>(head, at + 40, sections[i].count);
+    }
+
+    // A reader never sees a half-written checkpoint under the final name
+    std::string partial = filepath + ".tmp";
+    FILE* file = std::fopen(partial.c_str(), "wb");
+    if (!file) {
+        failure = "Could not create checkpoint file: " + partial;
+        return false;
+    }
+    bool written = std::fwrite(head.data(), 1, head.size(), file) == head.size()
+                   && std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(partial.c_str(), filepath.c_str()) != 0) {
+        std::remove(partial.c_str());
+        failure = "Could not write checkpoint file: " + filepath;
+        return false;
+    }
+    return true;
+}
+
+SnapshotReader::SnapshotReader() : base(nullptr), length(0), mapped(false) {}
+
+SnapshotReader::~SnapshotReader() {
+    if (!base) {
+        return;
+    }
+#ifdef __linux__
+    if (mapped) {
+        munmap(const_cast<unsigned char*>(base), length);
+        return;
+    }
+#endif
+    delete[] base;
+}
+
+bool SnapshotReader::open(const std::string& filepath) {
+#ifdef __linux__
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        failure = "Could not open checkpoint file: " + filepath;
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    void* view = length >= SnapshotFormat::HEADER_SIZE ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (view != MAP_FAILED) {
+        base = static_cast<const unsigned char*>(view);
+        mapped = true;
+    }
+#else
+    FILE* file = std::fopen(filepath.c_str(), "rb");
+    if (!file) {
+        failure = "Could not open checkpoint file: " + filepath;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    length = size > 0 ? static_cast<size_t>(size) : 0;
+    if (length >= SnapshotFormat::HEADER_SIZE) {
+        unsigned char* copy = new unsigned char[length];
+        if (std::fread(copy, 1, length, file) == length) {
+            base = copy;
+        } else {
+            delete[] copy;
+        }
+    }
+    std::fclose(file);
+#endif
+    if (!base) {
+        failure = "Not a load balancer checkpoint: " + filepath;
+        return false;
+    }
+
+    if (std::memcmp(base, SnapshotFormat::MAGIC, sizeof(SnapshotFormat::MAGIC)) != 0) {
+        failure = "Not a load balancer checkpoint: " + filepath;
+        return false;
+    }
+    if (take<uint32_t>(base + 8) != SnapshotFormat::VERSION) {
+        failure = "Unsupported checkpoint version " + std::to_string(take<uint32_t>(base + 8)) + " in " + filepath;
+        return false;
+    }
+    if (take<uint32_t>(base + 12) != SnapshotFormat::ENDIAN_MARK) {
+        failure = "Checkpoint " + filepath + " was written on a machine of another byte order";
+        return false;
+    }
+    uint64_t count = take<uint32_t>(base + 24);
+    if (take<uint64_t>(base + 16) != length
+        || SnapshotFormat::HEADER_SIZE + count * SnapshotFormat::ENTRY_SIZE > length) {
+        failure = "Checkpoint " + filepath + " is truncated";
+        return false;
+    }
+
+    // Fixup pass: every offset becomes a pointer once it is known to stay inside the file
+    sections.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        const unsigned char* entry = base + SnapshotFormat::HEADER_SIZE + i * SnapshotFormat::ENTRY_SIZE;
+        Section section;
+        section.name.assign(reinterpret_cast<const char*>(entry),
+                            strnlen(reinterpret_cast<const char*>(entry), SnapshotFormat::NAME_SIZE));
+        section.element_size = take<uint32_t>(entry + 24);
+        uint64_t offset = take<uint64_t>(entry + 32);
+        section.count = take<uint64_t>(entry + 40);
+        bool fits = offset % SnapshotFormat::ALIGNMENT == 0 && offset <= length
+                    && (section.element_size == 0 || section.count <= (length - offset) / section.element_size);
+        if (!fits || section.name.size() == SnapshotFormat::NAME_SIZE) {
+            failure = "Checkpoint " + filepath + " has a corrupt section table";
+            return false;
+        }
+        section.data = base + offset;
+        sections.push_back(section);
+    }
+    return true;
+}
+
+const SnapshotReader::Section* SnapshotReader::find(const std::string& name, size_t elementSize) {
+    for (const Section& section : sections) {
+        if (section.name != name) {
+            continue;
+        }
+        if (section.element_size != elementSize) {
+            failure = "Checkpoint section " + name + " has " + std::to_string(section.element_size)
+                      + "-byte elements instead of " + std::to_string(elementSize);
+            return nullptr;
+        }
+        return &section;
+    }
+    failure = "Checkpoint has no section " + name;
+    return nullptr;
+}
@@ -0,0 +1,236 @@
+/**
+ * @file Snapshot.h
+ * @brief Checkpoint file format, writer and memory-mapped reader
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Checkpoint file layout
+ *
+ * A checkpoint is a 32-byte header, a table of 48-byte section entries and the
+ * section data. Every section is an array of fixed-size elements stored exactly as
+ * they are laid out in memory, starting on a 64-byte boundary. Sections are found
+ * by name and refer to their data by offset from the start of the file, so the
+ * file does not depend on where it is mapped; links between elements are indices.
+ * Values are in the writing machine's byte order and layout, which the header
+ * records; a checkpoint is meant to be restored by the same build.
+ *
+ * Header: 8-byte magic "LBSNAPS1", uint32 version, uint32 byte-order mark
+ * (0x01020304), uint64 file size, uint32 section count, 4 reserved bytes.
+ *
+ * Section entry: 24-byte zero-padded name, uint32 element size, 4 reserved bytes,
+ * uint64 offset, uint64 element count.
+ */
+namespace SnapshotFormat {
+    const char MAGIC[8] = {'L', 'B', 'S', 'N', 'A', 'P', 'S', '1'};     ///< File signature
+    const uint32_t VERSION = 1;             ///< Current format version
+    const uint32_t ENDIAN_MARK = 0x01020304u;   ///< Reads back differently on a machine of the other byte order
+    const size_t HEADER_SIZE = 32;          ///< Bytes before the section table
+    const size_t ENTRY_SIZE = 48;           ///< Bytes per section table entry
+    const size_t NAME_SIZE = 24;            ///< Longest section name plus its terminator
+    const size_t ALIGNMENT = 64;            ///< Alignment of every section's data
+}
+
+/**
+ * @brief Collects named sections and writes them as a checkpoint file
+ *
+ * Sections are copied when they are added, so the caller's data may change
+ * afterwards. Only trivially copyable element types are accepted.
+ */
+class SnapshotWriter {
+private:
+    /**
+     * @brief A section waiting to be written
+     */
+    struct Section {
+        std::string name;       ///< Section name
+        uint32_t element_size;  ///< Bytes per element
+        uint64_t count;         ///< Number of elements
+        size_t start;           ///< Position of the data in data
+    };
+
+    std::vector<Section> sections;  ///< Sections in the order they were added
+    std::string data;               ///< Section data, each part aligned like in the file
+    std::string failure;            ///< Description of the first error
+
+public:
+    /**
+     * @brief Adds a section of raw elements
+     * @param name Section name (at most 23 characters, unique within the file)
+     * @param elements First element
+     * @param elementSize Bytes per element
+     * @param count Number of elements
+     */
+    void add(const std::string& name, const void* elements, size_t elementSize, size_t count);
+
+    /**
+     * @brief Adds an array section
+     * @tparam T Trivially copyable element type
+     * @param name Section name
+     * @param values Elements
+     */
+    template <typename T>
+    void add(const std::string& name, const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot sections hold plain data");
+        add(name, values.data(), sizeof(T), values.size());
+    }
+
+    /**
+     * @brief Adds a section holding one value
+     * @tparam T Trivially copyable type
+     * @param name Section name
+     * @param value Value
+     */
+    template <typename T>
+    void addValue(const std::string& name, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot sections hold plain data");
+        add(name, &value, sizeof(T), 1);
+    }
+
+    /**
+     * @brief Writes the checkpoint to a temporary file and renames it over the target
+     * @param filepath Path of the checkpoint
+     * @return false if the file could not be written; see error()
+     */
+    bool write(const std::string& filepath);
+
+    /**
+     * @brief Gets the description of the first error
+     * @return Error text, empty if none occurred
+     */
+    const std::string& error() const { return failure; }
+};
+
+/**
+ * @brief Maps a checkpoint file and hands out its sections in place
+ *
+ * open() maps the file read-only (falling back to reading it into memory where
+ * mmap is unavailable), checks the header and runs one fixup pass over the section
+ * table that turns every offset into a pointer after checking its bounds and
+ * alignment. After that a section is a pointer and an element count: restoring
+ * copies arrays out of the mapping and never parses anything.
+ */
+class SnapshotReader {
+private:
+    /**
+     * @brief A section resolved by the fixup pass
+     */
+    struct Section {
+        std::string name;           ///< Section name
+        uint32_t element_size;      ///< Bytes per element
+        uint64_t count;             ///< Number of elements
+        const unsigned char* data;  ///< First element inside the mapping
+    };
+
+    const unsigned char* base;      ///< Start of the mapped file, or null
+    size_t length;                  ///< Size of the mapping
+    bool mapped;                    ///< Whether base came from mmap (otherwise from new[])
+    std::vector<Section> sections;  ///< Sections in file order
+    std::string failure;            ///< Description of the first error
+
+    /**
+     * @brief Finds a section and checks its element size
+     * @param name Section name
+     * @param elementSize Expected bytes per element
+     * @return Section, or null (with error() set) if it is missing or has another element size
+     */
+    const Section* find(const std::string& name, size_t elementSize);
+
+public:
+    /**
+     * @brief Constructs a reader with no open file
+     */
+    SnapshotReader();
+
+    /**
+     * @brief Unmaps the file if one is open
+     */
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /**
+     * @brief Maps a checkpoint and resolves its sections
+     * @param filepath Path of the checkpoint
+     * @return false if the file cannot be read or is not a valid checkpoint of this
+     *         version; see error()
+     */
+    bool open(const std::string& filepath);
+
+    /**
+     * @brief Gets an array section in place
+     * @tparam T Element type the section was written with
+     * @param name Section name
+     * @param values Receives a pointer to the first element inside the mapping
+     * @param count Receives the number of elements
+     * @return false if the section is missing or has another element size
+     */
+    template <typename T>
+    bool get(const std::string& name, const T*& values, size_t& count) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot sections hold plain data");
+        const Section* section = find(name, sizeof(T));
+        if (!section) {
+            return false;
+        }
+        values = reinterpret_cast<const T*>(section->data);
+        count = static_cast<size_t>(section->count);
+        return true;
+    }
+
+    /**
+     * @brief Copies an array section into a vector
+     * @tparam T Element type the section was written with
+     * @param name Section name
+     * @param values Receives the elements
+     * @return false if the section is missing or has another element size
+     */
+    template <typename T>
+    bool read(const std::string& name, std::vector<T>& values) {
+        const T* first = nullptr;
+        size_t count = 0;
+        if (!get(name, first, count)) {
+            return false;
+        }
+        values.assign(first, first + count);
+        return true;
+    }
+
+    /**
+     * @brief Copies a single-value section
+     * @tparam T Type the section was written with
+     * @param name Section name
+     * @param value Receives the value
+     * @return false if the section is missing, has another element size or does not hold exactly one value
+     */
+    template <typename T>
+    bool readValue(const std::string& name, T& value) {
+        const T* first = nullptr;
+        size_t count = 0;
+        if (!get(name, first, count)) {
+            return false;
+        }
+        if (count != 1) {
+            failure = "Checkpoint section " + name + " does not hold a single value";
+            return false;
+        }
+        std::memcpy(static_cast<void*>(&value), first, sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief Gets the description of the first error
+     * @return Error text, empty if none occurred
+     */
+    const std::string& error() const { return failure; }
+};
+
+#endif // SNAPSHOT_H
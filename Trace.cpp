@@ -0,0 +1,396 @@
+/**
+ * @file Trace.cpp
+ * @brief Trace reader, writer and JSONL importer implementation
+ *
+ * Where POSIX mmap is available the reader maps a sliding window of the file;
+ * elsewhere it falls back to reading the same window with stdio.
+ */
+
+#include "Trace.h"
+#include "IpAddress.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRACE_MMAP 1
+#endif
+
+namespace {
+    void put32(unsigned char* p, uint32_t v) {
+        p[0] = static_cast<unsigned char>(v);
+        p[1] = static_cast<unsigned char>(v >> 8);
+        p[2] = static_cast<unsigned char>(v >> 16);
+        p[3] = static_cast<unsigned char>(v >> 24);
+    }
+
+    void put64(unsigned char* p, uint64_t v) {
+        put32(p, static_cast<uint32_t>(v));
+        put32(p + 4, static_cast<uint32_t>(v >> 32));
+    }
+
+    uint32_t get32(const unsigned char* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    uint64_t get64(const unsigned char* p) {
+        return uint64_t(get32(p)) | (uint64_t(get32(p + 4)) << 32);
+    }
+
+    /**
+     * @brief Extracts the fields of a flat JSON object as raw text
+     *
+     * Handles string values (with backslash escapes kept verbatim) and bare values
+     * such as numbers; nested objects and arrays are not supported.
+     *
+     * @param line JSON object text
+     * @param keys Receives the field names
+     * @param values Receives the field values (strings without their quotes)
+     * @return false if the line is not a flat JSON object
+     */
+    bool parseFlatObject(const std::string& line, std::vector<std::string>& keys, std::vector<std::string>& values) {
+        size_t i = 0;
+        auto skipSpace = [&]() {
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) i++;
+        };
+        auto readString = [&](std::string& out) {
+            if (i >= line.size() || line[i] != '"') return false;
+            size_t start = ++i;
+            while (i < line.size() && line[i] != '"') {
+                i += line[i] == '\\' ? 2 : 1;
+            }
+            if (i >= line.size()) return false;
+            out = line.substr(start, i - start);
+            i++;
+            return true;
+        };
+
+        skipSpace();
+        if (i >= line.size() || line[i++] != '{') return false;
+        skipSpace();
+        if (i < line.size() && line[i] == '}') return true;
+        for (;;) {
+            std::string key, value;
+            skipSpace();
+            if (!readString(key)) return false;
+            skipSpace();
+            if (i >= line.size() || line[i++] != ':') return false;
+            skipSpace();
+            if (i < line.size() && line[i] == '"') {
+                if (!readString(value)) return false;
+            } else {
+                size_t start = i;
+                while (i < line.size() && line[i] != ',' && line[i] != '}' && line[i] != ' ') i++;
+                value = line.substr(start, i - start);
+                if (value.empty() || value[0] == '{' || value[0] == '[') return false;
+            }
+            keys.push_back(key);
+            values.push_back(value);
+            skipSpace();
+            if (i < line.size() && line[i] == ',') {
+                i++;
+                continue;
+            }
+            if (i < line.size() && line[i] == '}') {
+                i++;
+                skipSpace();
+                return i == line.size();
+            }
+            return false;
+        }
+    }
+
+    /**
+     * @brief Parses a JSON number that must be a non-negative int
+     * @param text Number text
+     * @param value Receives the number
+     * @return false if text is not an integer in [0, INT_MAX]
+     */
+    bool parseTick(const std::string& text, int& value) {
+        if (text.empty() || text.size() > 10 || text.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        long long parsed = std::stoll(text);
+        if (parsed > INT_MAX) {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TraceWriter
+
+TraceWriter::TraceWriter() : file(nullptr), records(0), last_time(INT_MIN) {}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& filepath) {
+    close();
+    path = filepath;
+    failure.clear();
+    records = 0;
+    last_time = INT_MIN;
+    file = std::fopen(filepath.c_str(), "wb");
+    if (!file) {
+        failure = "Cannot create trace file " + filepath;
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    unsigned char header[TraceFormat::HEADER_SIZE] = {};
+    std::memcpy(header, TraceFormat::MAGIC, sizeof(TraceFormat::MAGIC));
+    put32(header + 8, TraceFormat::VERSION);
+    put32(header + 12, TraceFormat::RECORD_SIZE);
+    if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        failure = "Cannot write trace file " + filepath;
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool TraceWriter::write(const Request& r) {
+    if (!file) {
+        return false;
+    }
+    if (r.getenqueued() < last_time) {
+        failure = "Trace arrival times must not decrease (record " + std::to_string(records + 1) + ")";
+        return false;
+    }
+    if (r.isIPv6()) {
+        failure = "Trace records hold IPv4 addresses only (record " + std::to_string(records + 1) + " is IPv6)";
+        return false;
+    }
+    unsigned char record[TraceFormat::RECORD_SIZE];
+    put32(record, static_cast<uint32_t>(r.getenqueued()));
+    put32(record + 4, r.getin());
+    put32(record + 8, r.getout());
+    put32(record + 12, static_cast<uint32_t>(r.gettime()));
+    if (std::fwrite(record, 1, sizeof(record), file) != sizeof(record)) {
+        failure = "Cannot write trace file " + path;
+        return false;
+    }
+    last_time = r.getenqueued();
+    records++;
+    return true;
+}
+
+bool TraceWriter::close() {
+    if (!file) {
+        return failure.empty();
+    }
+    unsigned char count[8];
+    put64(count, records);
+    bool ok = std::fseek(file, 16, SEEK_SET) == 0 && std::fwrite(count, 1, sizeof(count), file) == sizeof(count);
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    if (!ok && failure.empty()) {
+        failure = "Cannot finish trace file " + path;
+    }
+    return ok && failure.empty();
+}
+
+// ---------------------------------------------------------------------------
+// TraceReader
+
+TraceReader::TraceReader()
+    : fd(-1), file(nullptr), window(nullptr), window_size(0), cursor(nullptr), limit(nullptr),
+      file_size(0), offset(0), declared(0), consumed(0), has_pending(false) {}
+
+TraceReader::~TraceReader() {
+    unmapWindow();
+#ifdef TRACE_MMAP
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+void TraceReader::unmapWindow() {
+#ifdef TRACE_MMAP
+    if (window) {
+        munmap(const_cast<unsigned char*>(window), window_size);
+    }
+#endif
+    window = nullptr;
+    window_size = 0;
+    cursor = limit = nullptr;
+}
+
+bool TraceReader::loadWindow() {
+    unmapWindow();
+#ifdef TRACE_MMAP
+    if (offset + TraceFormat::RECORD_SIZE > file_size) {
+        if (offset < file_size) {
+            failure = "Trace ends with a truncated record";
+        }
+        return false;
+    }
+    // Map from the page holding offset so the window start is page-aligned
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t base = offset - offset % page;
+    size_t length = static_cast<size_t>(std::min<uint64_t>(WINDOW, file_size - base));
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(base));
+    if (mapped == MAP_FAILED) {
+        failure = "Cannot map trace file";
+        return false;
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    window = static_cast<const unsigned char*>(mapped);
+    window_size = length;
+    cursor = window + (offset - base);
+#else
+    buffer.resize(WINDOW);
+    size_t length = std::fread(buffer.data(), 1, WINDOW, file);
+    if (length % TraceFormat::RECORD_SIZE != 0 && length < WINDOW) {
+        failure = "Trace ends with a truncated record";
+    }
+    window = buffer.data();
+    window_size = length;
+    cursor = window;
+#endif
+    size_t available = static_cast<size_t>(window + window_size - cursor);
+    limit = cursor + available / TraceFormat::RECORD_SIZE * TraceFormat::RECORD_SIZE;
+    return limit > cursor;
+}
+
+bool TraceReader::open(const std::string& filepath) {
+    failure.clear();
+    unsigned char header[TraceFormat::HEADER_SIZE];
+#ifdef TRACE_MMAP
+    fd = ::open(filepath.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        failure = "Cannot open trace file " + filepath;
+        return false;
+    }
+    file_size = static_cast<uint64_t>(info.st_size);
+    bool complete = ::pread(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+#else
+    file = std::fopen(filepath.c_str(), "rb");
+    if (!file) {
+        failure = "Cannot open trace file " + filepath;
+        return false;
+    }
+    bool complete = std::fread(header, 1, sizeof(header), file) == sizeof(header);
+#endif
+    if (!complete || std::memcmp(header, TraceFormat::MAGIC, sizeof(TraceFormat::MAGIC)) != 0) {
+        failure = filepath + " is not a trace file";
+        return false;
+    }
+    if (get32(header + 8) != TraceFormat::VERSION || get32(header + 12) != TraceFormat::RECORD_SIZE) {
+        failure = filepath + " uses an unsupported trace version";
+        return false;
+    }
+    declared = get64(header + 16);
+    offset = TraceFormat::HEADER_SIZE;
+    advance();
+    return failure.empty();
+}
+
+void TraceReader::advance() {
+    int previous = has_pending ? pending.getenqueued() : INT_MIN;
+    has_pending = false;
+    if (declared != 0 && consumed + 1 > declared) {
+        return;     // anything after the declared records is ignored
+    }
+    if (cursor == limit && !loadWindow()) {
+        return;
+    }
+    int time = static_cast<int>(get32(cursor));
+    pending = Request(get32(cursor + 4), get32(cursor + 8), static_cast<int>(get32(cursor + 12)), time);
+    cursor += TraceFormat::RECORD_SIZE;
+    offset += TraceFormat::RECORD_SIZE;
+    if (time < previous) {
+        failure = "Trace record " + std::to_string(consumed + 1) + " arrives before the one preceding it";
+        return;
+    }
+    if (pending.getenqueued() != time) {
+        failure = "Trace record " + std::to_string(consumed + 1) + " has an arrival tick outside the simulated range";
+        return;
+    }
+    has_pending = true;
+}
+
+int TraceReader::nextTime() const {
+    return has_pending ? pending.getenqueued() : INT_MAX;
+}
+
+bool TraceReader::next(Request& r) {
+    if (!has_pending) {
+        return false;
+    }
+    r = pending;
+    consumed++;
+    advance();
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// JSONL import
+
+long long importTraceJsonl(const std::string& jsonlPath, const std::string& tracePath, std::string& error) {
+    std::ifstream input(jsonlPath);
+    if (!input.is_open()) {
+        error = "Cannot open " + jsonlPath;
+        return -1;
+    }
+    TraceWriter writer;
+    if (!writer.open(tracePath)) {
+        error = writer.error();
+        return -1;
+    }
+
+    std::string line;
+    long long lineNumber = 0;
+    std::vector<std::string> keys, values;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        keys.clear();
+        values.clear();
+        int time = -1, processTime = -1;
+        uint32_t ipIn = 0, ipOut = 0;
+        bool haveIn = false, haveOut = false;
+        bool valid = parseFlatObject(line, keys, values);
+        for (size_t k = 0; valid && k < keys.size(); ++k) {
+            if (keys[k] == "time") {
+                valid = parseTick(values[k], time);
+            } else if (keys[k] == "process_time") {
+                valid = parseTick(values[k], processTime);
+            } else if (keys[k] == "ip_in") {
+                valid = haveIn = parseIPv4(values[k], ipIn);
+            } else if (keys[k] == "ip_out") {
+                valid = haveOut = parseIPv4(values[k], ipOut);
+            }
+        }
+        if (!valid || time < 0 || processTime < 0 || !haveIn || !haveOut) {
+            error = jsonlPath + ":" + std::to_string(lineNumber) + ": expected {\"time\", \"ip_in\", \"ip_out\", \"process_time\"}";
+            return -1;
+        }
+        if (!writer.write(Request(ipIn, ipOut, processTime, time))) {
+            error = jsonlPath + ":" + std::to_string(lineNumber) + ": " + writer.error();
+            return -1;
+        }
+    }
+    if (!writer.close()) {
+        error = writer.error();
+        return -1;
+    }
+    return static_cast<long long>(writer.count());
+}
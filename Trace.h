@@ -0,0 +1,211 @@
+/**
+ * @file Trace.h
+ * @brief Traffic trace format, reader, writer and JSONL importer
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Request.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary traffic trace layout
+ *
+ * A trace is a 32-byte header followed by fixed-size 16-byte records in arrival
+ * order. All integers are little-endian.
+ *
+ * Header: 8-byte magic "LBTRACE1", uint32 version (1), uint32 record size (16),
+ * uint64 record count, 8 reserved bytes.
+ *
+ * Record: int32 arrival tick, uint32 source IPv4, uint32 destination IPv4,
+ * int32 process time.
+ */
+namespace TraceFormat {
+    const char MAGIC[8] = {'L', 'B', 'T', 'R', 'A', 'C', 'E', '1'};     ///< File signature
+    const uint32_t VERSION = 1;             ///< Current format version
+    const size_t HEADER_SIZE = 32;          ///< Bytes before the first record
+    const size_t RECORD_SIZE = 16;          ///< Bytes per record
+}
+
+/**
+ * @brief Writes requests to a binary trace file
+ *
+ * Records are buffered through stdio and the record count in the header is filled
+ * in by close(). Arrival ticks must not decrease.
+ */
+class TraceWriter {
+private:
+    FILE* file;                 ///< Open trace file, or null
+    uint64_t records;           ///< Records written so far
+    int last_time;              ///< Arrival tick of the previous record
+    std::string path;           ///< File name, for error messages
+    std::string failure;        ///< Description of the first error
+
+public:
+    /**
+     * @brief Constructs a writer with no open file
+     */
+    TraceWriter();
+
+    /**
+     * @brief Closes the file if it is still open
+     */
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    /**
+     * @brief Creates (or truncates) a trace file and writes its header
+     * @param filepath Path of the trace file
+     * @return false if the file could not be created; see error()
+     */
+    bool open(const std::string& filepath);
+
+    /**
+     * @brief Appends one request; its enqueue tick is used as the arrival tick
+     * @param r Request to record
+     * @return false if the write failed, the arrival tick went backwards or the
+     *         request is IPv6 (records have room for IPv4 addresses only)
+     */
+    bool write(const Request& r);
+
+    /**
+     * @brief Completes the header and closes the file
+     * @return false if the file could not be finalised or an earlier write was refused
+     */
+    bool close();
+
+    /**
+     * @brief Gets the number of records written so far
+     * @return Record count
+     */
+    uint64_t count() const { return records; }
+
+    /**
+     * @brief Describes the first error that occurred
+     * @return Error message, or an empty string
+     */
+    const std::string& error() const { return failure; }
+};
+
+/**
+ * @brief Streams requests out of a binary trace file in constant memory
+ *
+ * The file is never read as a whole: a fixed-size window of it is memory-mapped
+ * (read with stdio where mmap is not available) and slid forward as records are
+ * consumed, so replaying a trace of any size needs only the window plus one
+ * decoded record.
+ */
+class TraceReader {
+private:
+    static constexpr size_t WINDOW = size_t(16) << 20;  ///< Bytes of the file mapped at a time
+
+    int fd;                         ///< File descriptor (POSIX)
+    FILE* file;                     ///< Stream (fallback without mmap)
+    std::vector<unsigned char> buffer; ///< Window storage (fallback without mmap)
+    const unsigned char* window;    ///< Start of the current window
+    size_t window_size;             ///< Bytes in the current window
+    const unsigned char* cursor;    ///< Next undecoded record in the window
+    const unsigned char* limit;     ///< End of the last whole record in the window
+    uint64_t file_size;             ///< Size of the trace file
+    uint64_t offset;                ///< File offset of cursor
+    uint64_t declared;              ///< Record count from the header (0 if unknown)
+    uint64_t consumed;              ///< Records returned by next()
+    Request pending;                ///< Decoded record that next() will return
+    bool has_pending;               ///< Whether pending holds a record
+    std::string failure;            ///< Description of the first error
+
+    /**
+     * @brief Releases the current window
+     */
+    void unmapWindow();
+
+    /**
+     * @brief Maps (or reads) the window that starts at offset
+     * @return false at the end of the file
+     */
+    bool loadWindow();
+
+    /**
+     * @brief Decodes the next record into pending
+     */
+    void advance();
+
+public:
+    /**
+     * @brief Constructs a reader with no open file
+     */
+    TraceReader();
+
+    /**
+     * @brief Unmaps and closes the file
+     */
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    /**
+     * @brief Opens a trace file and validates its header
+     * @param filepath Path of the trace file
+     * @return false if the file is missing or not a valid trace; see error()
+     */
+    bool open(const std::string& filepath);
+
+    /**
+     * @brief Gets the arrival tick of the next record
+     * @return Arrival tick, or INT_MAX when the trace is exhausted
+     */
+    int nextTime() const;
+
+    /**
+     * @brief Takes the next record
+     * @param r Receives the request, with its enqueue tick set to the arrival tick
+     * @return false when the trace is exhausted
+     */
+    bool next(Request& r);
+
+    /**
+     * @brief Gets the number of records taken so far
+     * @return Record count
+     */
+    uint64_t count() const { return consumed; }
+
+    /**
+     * @brief Gets the record count stored in the header
+     * @return Declared records, or 0 if the writer did not finish the file
+     */
+    uint64_t declaredCount() const { return declared; }
+
+    /**
+     * @brief Describes why the trace ended early, if it did
+     * @return Error message (e.g. a truncated or out-of-order record), or an empty string
+     */
+    const std::string& error() const { return failure; }
+};
+
+/**
+ * @brief Converts a JSON Lines trace into the binary trace format
+ *
+ * Each non-blank line must be a JSON object with the fields "time" (arrival tick),
+ * "ip_in" and "ip_out" (dotted-quad strings) and "process_time"; other fields are
+ * ignored, e.g.
+ * @code
+ * {"time": 12, "ip_in": "10.0.0.1", "ip_out": "10.0.0.9", "process_time": 4}
+ * @endcode
+ * The input is streamed line by line, so its size is not limited by memory. Arrival
+ * ticks must not decrease.
+ *
+ * @param jsonlPath Input file
+ * @param tracePath Output file (created or truncated)
+ * @param error Receives a message naming the offending line if the import fails
+ * @return Number of records written, or -1 on failure
+ */
+long long importTraceJsonl(const std::string& jsonlPath, const std::string& tracePath, std::string& error);
+
+#endif // TRACE_H
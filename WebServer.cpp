@@ -2,44 +2,56 @@
  * @file WebServer.cpp
  * @brief WebServer class implementation
  * 
- * Contains the implementation of the WebServer class methods for processing
- * requests and managing server state transitions.
+ * Contains the implementation of the WebServer handle methods, which forward
+ * to the server's slot in its ServerPool.
  */
 
 #include "WebServer.h"
+#include "ServerPool.h"
 
-// WebServer class implementation will go here
+WebServer::WebServer(ServerPool& pool, size_t index) : pool(&pool), index(index) {
+}
 
-WebServer::WebServer() : busy(false), time_left(0), curr_request() {
-    // Initialize as not busy with no time left and empty request
+size_t WebServer::getid() const {
+    return index;
 }
 
 bool WebServer::isbusy() const {
-    return busy;
+    return pool->isBusy(index);
+}
+
+double WebServer::getspeed() const {
+    return pool->speed(index);
+}
+
+int WebServer::getslots() const {
+    return pool->concurrency(index);
+}
+
+int WebServer::getinflight() const {
+    return pool->inFlight(index);
 }
 
 int WebServer::gettimeleft() const {
-    return time_left;
+    return pool->timeLeft(index);
 }
 
-Request WebServer::getcurr() const {
-    return curr_request;
+const Request& WebServer::getcurr() const {
+    return pool->request(index);
 }
 
 void WebServer::assignrequest(const Request& r) {
-    if (!busy) {
-        curr_request = r;
-        time_left = r.gettime();
-        busy = true;
-    }
+    pool->assign(index, r);
 }
 
 void WebServer::tick() {
-    if (busy && time_left > 0) {
-        time_left--;
-        if (time_left == 0) {
-            busy = false;
-            curr_request = Request();
-        }
-    }
+    pool->advance(index, 1);
+}
+
+void WebServer::advance(int cycles) {
+    pool->advance(index, cycles);
+}
+
+Request WebServer::preempt() {
+    return pool->preempt(index, pool->timeLeft(index));
 }
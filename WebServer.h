@@ -5,7 +5,9 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 #include "Request.h" 
-#include <queue>
+#include <cstddef>
+
+class ServerPool;
 
 /**
  * @brief A web server that processes requests over time
@@ -13,24 +15,53 @@
  * The WebServer class represents a single server that can process one request at a time.
  * Each request takes a specified number of time cycles to complete. The server maintains
  * its state (busy/idle) and tracks the remaining processing time for the current request.
+ * 
+ * Server state is stored column-wise in a ServerPool; a WebServer is a small handle
+ * (pool pointer plus index) that reads and updates one slot of the pool. Handles are
+ * cheap to copy and stay valid until the server is removed from the pool.
  */
 class WebServer {
 private:
-    bool busy;                  ///< Flag indicating if the server is currently processing a request
-    int time_left;              ///< Number of time cycles remaining to complete the current request
-    Request curr_request;       ///< The request currently being processed by this server
+    ServerPool* pool;           ///< Pool that stores this server's state
+    size_t index;               ///< Position of this server in the pool
 
 public:
     /**
-     * @brief Default constructor that initializes the server as idle
+     * @brief Constructs a handle to one server of a pool
+     * @param pool Pool that stores the server
+     * @param index Index of the server in the pool
+     */
+    WebServer(ServerPool& pool, size_t index);
+
+    /**
+     * @brief Gets the index of this server in its pool
+     * @return Server index
      */
-    WebServer();
+    size_t getid() const;
 
     /**
      * @brief Checks if the server is currently busy processing a request
-     * @return true if the server is busy, false if idle
+     * @return true if every request slot of the server is taken, false if it can take another
      */
     bool isbusy() const;
+
+    /**
+     * @brief Gets the speed factor of the server's slots
+     * @return Cycles one slot processes per tick once warm
+     */
+    double getspeed() const;
+
+    /**
+     * @brief Gets the number of requests the server can process at once
+     * @return Request slots
+     */
+    int getslots() const;
+
+    /**
+     * @brief Gets the number of requests the server is processing
+     * @return Requests in flight
+     */
+    int getinflight() const;
     
     /**
      * @brief Gets the remaining processing time for the current request
@@ -39,10 +70,10 @@ public:
     int gettimeleft() const;
     
     /**
-     * @brief Gets a copy of the current request being processed
-     * @return Copy of the current Request object
+     * @brief Gets the current request being processed
+     * @return Reference to the current Request object (an empty request when idle)
      */
-    Request getcurr() const;
+    const Request& getcurr() const;
     
     /**
      * @brief Assigns a new request to this server if it's not busy
@@ -58,5 +89,21 @@ public:
      */
     void tick();
 
+    /**
+     * @brief Advances the server by several time ticks at once
+     * 
+     * Equivalent to calling tick() the given number of times; used by the
+     * event-driven engine to catch a server up after skipping idle time.
+     * 
+     * @param cycles Number of ticks to advance
+     */
+    void advance(int cycles);
+
+    /**
+     * @brief Takes the current request away before it finishes, leaving the server idle
+     * @return The request, with its processing time set to the cycles it still needs
+     */
+    Request preempt();
+
 };
 #endif // WEBSERVER_H
@@ -0,0 +1,92 @@
+/**
+ * @file WorkerPool.cpp
+ * @brief WorkerPool class implementation
+ */
+#include "WorkerPool.h"
+
+namespace {
+    const int SPIN_LIMIT = 4096;    ///< Polls before a waiting thread blocks
+}
+
+WorkerPool::WorkerPool(size_t workers)
+    : job(nullptr), task_count(0), next_task(0), active(0), generation(0), stopping(false) {
+    for (size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back(&WorkerPool::helperLoop, this, worker);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::work(size_t worker) {
+    for (;;) {
+        size_t task = next_task.fetch_add(1, std::memory_order_relaxed);
+        if (task >= task_count) {
+            return;
+        }
+        (*job)(task, worker);
+    }
+}
+
+void WorkerPool::helperLoop(size_t worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        int spins = 0;
+        while (generation.load(std::memory_order_acquire) == seen && spins < SPIN_LIMIT) {
+            spins++;
+        }
+        if (generation.load(std::memory_order_acquire) == seen) {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&]() { return stopping || generation.load(std::memory_order_acquire) != seen; });
+            if (stopping) {
+                return;
+            }
+        }
+        seen = generation.load(std::memory_order_acquire);
+
+        work(worker);
+        if (active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> guard(lock);    // the caller may be about to block
+            finished.notify_one();
+        }
+    }
+}
+
+void WorkerPool::run(size_t tasks, const std::function<void(size_t task, size_t worker)>& body) {
+    if (threads.empty() || tasks <= 1) {
+        for (size_t task = 0; task < tasks; ++task) {
+            body(task, 0);
+        }
+        return;
+    }
+
+    job = &body;
+    task_count = tasks;
+    next_task.store(0, std::memory_order_relaxed);
+    active.store(threads.size(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_all();
+
+    work(0);
+
+    int spins = 0;
+    while (active.load(std::memory_order_acquire) != 0 && spins < SPIN_LIMIT) {
+        spins++;
+    }
+    if (active.load(std::memory_order_acquire) != 0) {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [&]() { return active.load(std::memory_order_acquire) == 0; });
+    }
+    job = nullptr;
+}
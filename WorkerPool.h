@@ -0,0 +1,87 @@
+/**
+ * @file WorkerPool.h
+ * @brief WorkerPool class header file
+ */
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of threads that run parallel loops for the simulator
+ *
+ * run() hands out task numbers from a shared atomic counter, so a thread that
+ * finishes its tasks early simply claims the next unclaimed one (work stealing
+ * without per-thread deques). The calling thread takes part as worker 0, which
+ * makes a pool of size one run everything inline.
+ *
+ * Between runs the helper threads spin briefly on the run generation and then
+ * block on a condition variable, so an idle simulation does not burn CPU while
+ * back-to-back ticks avoid the cost of a wake-up.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;               ///< Helper threads (workers 1..n-1)
+    const std::function<void(size_t, size_t)>* job; ///< Body of the current run
+    size_t task_count;                              ///< Number of tasks in the current run
+    std::atomic<size_t> next_task;                  ///< Next unclaimed task number
+    std::atomic<size_t> active;                     ///< Helpers still working on the current run
+    std::atomic<uint64_t> generation;               ///< Incremented to start a run
+    bool stopping;                                  ///< Set (under lock) to end the helpers
+    std::mutex lock;                                ///< Guards the sleep/wake handshake
+    std::condition_variable wake;                   ///< Signals helpers that a run started
+    std::condition_variable finished;               ///< Signals the caller that helpers are done
+
+    /**
+     * @brief Claims and runs tasks of the current run until none are left
+     * @param worker Worker number passed to the body
+     */
+    void work(size_t worker);
+
+    /**
+     * @brief Helper thread body: waits for runs and works on them until stopped
+     * @param worker Worker number of the thread
+     */
+    void helperLoop(size_t worker);
+
+public:
+    /**
+     * @brief Starts the helper threads
+     * @param workers Total number of workers including the caller (at least 1)
+     */
+    explicit WorkerPool(size_t workers);
+
+    /**
+     * @brief Stops and joins the helper threads
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Gets the number of workers including the caller
+     * @return Worker count
+     */
+    size_t size() const { return threads.size() + 1; }
+
+    /**
+     * @brief Runs body(task, worker) for every task in [0, tasks) and waits for all of them
+     *
+     * Tasks may run in any order and on any worker; each worker number is used by
+     * one thread at a time, so it can index per-worker scratch state.
+     *
+     * @param tasks Number of tasks
+     * @param body Task body
+     */
+    void run(size_t tasks, const std::function<void(size_t task, size_t worker)>& body);
+};
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,647 @@
+/**
+ * @file WorkloadGenerator.cpp
+ * @brief WorkloadGenerator class implementation
+ */
+
+#include "WorkloadGenerator.h"
+#include "IpAddress.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    const double TWO_PI = 6.283185307179586;
+    const int MAX_GAP = INT_MAX / 4;    ///< Longest gap drawn at once (later draws continue from there)
+
+    /**
+     * @brief Adds a gap to a tick without overflowing
+     * @param time Tick
+     * @param gap Ticks to add
+     * @return time + gap, or INT_MAX if that does not fit
+     */
+    int later(int time, long long gap) {
+        long long t = static_cast<long long>(time) + gap;
+        return t >= INT_MAX ? INT_MAX : static_cast<int>(t);
+    }
+
+    /**
+     * @brief Removes leading and trailing whitespace
+     * @param text Text to trim
+     * @return Trimmed copy
+     */
+    std::string trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            return "";
+        }
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    /**
+     * @brief Parses a finite floating-point number
+     * @param text Number text
+     * @param value Receives the number
+     * @return false if the text is not a number
+     */
+    bool parseNumber(const std::string& text, double& value) {
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        return !text.empty() && *end == '\0' && std::isfinite(value);
+    }
+
+    /**
+     * @brief Parses an integer
+     * @param text Number text
+     * @param value Receives the number
+     * @return false if the text is not an integer in int range
+     */
+    bool parseInt(const std::string& text, int& value) {
+        char* end = nullptr;
+        long parsed = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || parsed < INT_MIN || parsed > INT_MAX) {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    /**
+     * @brief Parses a comma-separated list of numbers
+     * @param text List text
+     * @param values Receives the numbers
+     * @return false on an empty list or an entry that is not a number
+     */
+    bool parseNumbers(const std::string& text, std::vector<double>& values) {
+        values.clear();
+        std::istringstream list(text);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            double value;
+            if (!parseNumber(trim(item), value)) {
+                return false;
+            }
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    /**
+     * @brief Parses an address range: "a.b.c.d", "a.b.c.d-e.f.g.h" or "a.b.c.d/len"
+     * @param text Range text
+     * @param first Receives the lowest address
+     * @param last Receives the highest address
+     * @return false if the text is not a valid, non-empty range
+     */
+    bool parseRange(const std::string& text, uint32_t& first, uint32_t& last) {
+        size_t dash = text.find('-');
+        size_t slash = text.find('/');
+        if (dash != std::string::npos) {
+            return parseIPv4(trim(text.substr(0, dash)), first) && parseIPv4(trim(text.substr(dash + 1)), last)
+                && first <= last;
+        }
+        if (slash != std::string::npos) {
+            int length;
+            if (!parseIPv4(trim(text.substr(0, slash)), first) || !parseInt(trim(text.substr(slash + 1)), length)
+                || length < 0 || length > 32) {
+                return false;
+            }
+            uint32_t hostMask = length == 0 ? 0xffffffffu : (1u << (32 - length)) - 1;
+            first &= ~hostMask;
+            last = first | hostMask;
+            return true;
+        }
+        if (!parseIPv4(text, first)) {
+            return false;
+        }
+        last = first;
+        return true;
+    }
+
+    /**
+     * @brief Parses an IPv4 or IPv6 address range
+     *
+     * An IPv6 range must stay within one /96, since requests keep its low 32 bits
+     * apart from the shared upper bits. IPv4 ranges get the IPv4-mapped base.
+     *
+     * @param text Range text: a single address, first-last or a CIDR block
+     * @param first Receives the low 32 bits of the lowest address
+     * @param last Receives the low 32 bits of the highest address
+     * @param base Receives the upper 96 bits shared by the range
+     * @return false if the text is not a valid, non-empty range inside one /96
+     */
+    bool parseRange(const std::string& text, uint32_t& first, uint32_t& last, IPv6Address& base) {
+        if (text.find(':') == std::string::npos) {
+            base = IPv6Address::fromIPv4(0);
+            return parseRange(text, first, last);
+        }
+        size_t dash = text.find('-');
+        size_t slash = text.find('/');
+        IPv6Address low, high;
+        if (dash != std::string::npos) {
+            if (!parseIPv6(trim(text.substr(0, dash)), low) || !parseIPv6(trim(text.substr(dash + 1)), high)) {
+                return false;
+            }
+        } else if (slash != std::string::npos) {
+            int length;
+            if (!parseIPv6(trim(text.substr(0, slash)), low) || !parseInt(trim(text.substr(slash + 1)), length)
+                || length < 96 || length > 128) {
+                return false;
+            }
+            uint64_t hostMask = length == 96 ? 0xffffffffULL : (1ULL << (128 - length)) - 1;
+            low.lo &= ~hostMask;
+            high = IPv6Address{low.hi, low.lo | hostMask};
+        } else {
+            if (!parseIPv6(text, low)) {
+                return false;
+            }
+            high = low;
+        }
+        first = static_cast<uint32_t>(low.lo);
+        last = static_cast<uint32_t>(high.lo);
+        base = IPv6Address{low.hi, low.lo & ~0xffffffffULL};
+        return low.hi == high.hi && (low.lo >> 32) == (high.lo >> 32) && first <= last;
+    }
+
+    /**
+     * @brief Checks a configuration for values the generator cannot use
+     * @param config Configuration to check
+     * @return Description of the first problem, or an empty string
+     */
+    std::string validate(const WorkloadConfig& config) {
+        if (config.rate < 0.0 || (config.arrivals == ArrivalModel::Bernoulli && config.rate > 1.0)) {
+            return "rate must be at least 0 (and at most 1 for bernoulli arrivals)";
+        }
+        if (config.burst_probability < 0.0 || config.burst_probability > 1.0) {
+            return "burst_probability must be in [0, 1]";
+        }
+        if (config.burst_size < 1 || config.burst_size > 65535) {
+            return "burst_size must be in [1, 65535]";
+        }
+        if (config.mmpp_rates.size() < 2 || config.mmpp_rates.size() != config.mmpp_dwell.size()) {
+            return "mmpp_rates and mmpp_dwell must list the same number (at least 2) of states";
+        }
+        for (size_t i = 0; i < config.mmpp_rates.size(); ++i) {
+            if (config.mmpp_rates[i] < 0.0 || config.mmpp_dwell[i] < 1.0) {
+                return "mmpp_rates must be at least 0 and mmpp_dwell at least 1";
+            }
+        }
+        if (config.diurnal_period < 1 || config.diurnal_amplitude < 0.0 || config.diurnal_amplitude > 1.0) {
+            return "diurnal_period must be at least 1 and diurnal_amplitude in [0, 1]";
+        }
+        if (config.service_min < 1 || config.service_max < config.service_min) {
+            return "service_min must be at least 1 and service_max at least service_min";
+        }
+        if (config.service_mean <= 0.0 || config.pareto_shape <= 0.0 || config.pareto_scale <= 0.0
+            || config.lognormal_sigma < 0.0 || config.service_cap < 1) {
+            return "service_mean, pareto_shape and pareto_scale must be positive, lognormal_sigma at least 0 "
+                   "and service_cap at least 1";
+        }
+        return "";
+    }
+}
+
+void Xoshiro256::seed(uint64_t seed) {
+    // splitmix64 turns any seed, including 0, into a well-mixed non-zero state
+    for (uint64_t& word : s) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+void Xoshiro256::jump() {
+    static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL,
+                                    0x39abdc4529b1661cULL};
+    uint64_t t[4] = {0, 0, 0, 0};
+    for (uint64_t word : JUMP) {
+        for (int b = 0; b < 64; ++b) {
+            if (word & (1ULL << b)) {
+                for (int i = 0; i < 4; ++i) {
+                    t[i] ^= s[i];
+                }
+            }
+            (*this)();
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        s[i] = t[i];
+    }
+}
+
+bool loadWorkloadConfig(const std::string& filepath, WorkloadConfig& config, std::string& error) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        error = "Could not open workload file " + filepath;
+        return false;
+    }
+
+    WorkloadConfig parsed;
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        size_t equals = line.find('=');
+        std::string key = equals == std::string::npos ? line : trim(line.substr(0, equals));
+        std::string value = equals == std::string::npos ? "" : trim(line.substr(equals + 1));
+        bool ok = equals != std::string::npos;
+        double number_value = 0.0;
+
+        if (!ok) {
+        } else if (key == "arrivals") {
+            ok = value == "bernoulli" || value == "poisson" || value == "mmpp" || value == "diurnal";
+            parsed.arrivals = value == "poisson" ? ArrivalModel::Poisson : value == "mmpp" ? ArrivalModel::Mmpp
+                            : value == "diurnal" ? ArrivalModel::Diurnal : ArrivalModel::Bernoulli;
+        } else if (key == "service") {
+            ok = value == "uniform" || value == "exponential" || value == "pareto" || value == "lognormal";
+            parsed.service = value == "exponential" ? ServiceModel::Exponential : value == "pareto" ? ServiceModel::Pareto
+                           : value == "lognormal" ? ServiceModel::Lognormal : ServiceModel::Uniform;
+        } else if (key == "mmpp_rates") {
+            ok = parseNumbers(value, parsed.mmpp_rates);
+        } else if (key == "mmpp_dwell") {
+            ok = parseNumbers(value, parsed.mmpp_dwell);
+        } else if (key == "sources") {
+            ok = parseRange(value, parsed.source_first, parsed.source_last, parsed.source_base);
+        } else if (key == "destinations") {
+            ok = parseRange(value, parsed.destination_first, parsed.destination_last, parsed.destination_base);
+        } else if (key == "burst_size") {
+            ok = parseInt(value, parsed.burst_size);
+        } else if (key == "diurnal_period") {
+            ok = parseInt(value, parsed.diurnal_period);
+        } else if (key == "diurnal_phase") {
+            ok = parseInt(value, parsed.diurnal_phase);
+        } else if (key == "service_min") {
+            ok = parseInt(value, parsed.service_min);
+        } else if (key == "service_max") {
+            ok = parseInt(value, parsed.service_max);
+        } else if (key == "service_cap") {
+            ok = parseInt(value, parsed.service_cap);
+        } else if (!parseNumber(value, number_value)) {
+            ok = false;
+        } else if (key == "rate") {
+            parsed.rate = number_value;
+        } else if (key == "burst_probability") {
+            parsed.burst_probability = number_value;
+        } else if (key == "diurnal_amplitude") {
+            parsed.diurnal_amplitude = number_value;
+        } else if (key == "service_mean") {
+            parsed.service_mean = number_value;
+        } else if (key == "pareto_shape") {
+            parsed.pareto_shape = number_value;
+        } else if (key == "pareto_scale") {
+            parsed.pareto_scale = number_value;
+        } else if (key == "lognormal_mu") {
+            parsed.lognormal_mu = number_value;
+        } else if (key == "lognormal_sigma") {
+            parsed.lognormal_sigma = number_value;
+        } else {
+            error = filepath + ":" + std::to_string(number) + ": unknown key " + key;
+            return false;
+        }
+        if (!ok) {
+            error = filepath + ":" + std::to_string(number) + ": invalid line: " + line;
+            return false;
+        }
+    }
+
+    std::string problem = validate(parsed);
+    if (!problem.empty()) {
+        error = filepath + ": " + problem;
+        return false;
+    }
+    config = parsed;
+    return true;
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& workloadConfig, uint64_t seed)
+    : random(seed), share(1.0), source_span(1), destination_span(1), ipv6(false), next_time(0), batch(1), surge(false), state(0),
+      state_end(0), spare_normal(0.0), has_spare(false), gap_p(0.0), gap_log(0.0), zero_mean(0.0), zero_chance(1.0) {
+    configure(workloadConfig, 0);
+}
+
+void WorkloadGenerator::configure(const WorkloadConfig& workloadConfig, int now) {
+    config = workloadConfig;
+    source_span = static_cast<uint64_t>(config.source_last) - config.source_first + 1;
+    destination_span = static_cast<uint64_t>(config.destination_last) - config.destination_first + 1;
+    ipv6 = !config.source_base.isIPv4Mapped() || !config.destination_base.isIPv4Mapped();
+    start(now);
+}
+
+void WorkloadGenerator::split(unsigned int stream, double rateShare, int now) {
+    for (unsigned int i = 0; i < stream; ++i) {
+        random.jump();
+    }
+    share = rateShare;
+    has_spare = false;
+    start(now);
+}
+
+void WorkloadGenerator::start(int now) {
+    state = 0;
+    if (config.arrivals == ArrivalModel::Mmpp) {
+        state_end = later(now, std::max(1LL, static_cast<long long>(
+                              std::ceil(-config.mmpp_dwell[0] * std::log1p(-random.uniform())))));
+    }
+    scheduleAfter(now);
+}
+
+void WorkloadGenerator::advance() {
+    scheduleAfter(next_time);
+}
+
+double WorkloadGenerator::rateAt(int time) const {
+    switch (config.arrivals) {
+        case ArrivalModel::Mmpp:
+            return config.mmpp_rates[state] * share;
+        case ArrivalModel::Diurnal: {
+            double phase = TWO_PI * std::fmod(static_cast<double>(time) + config.diurnal_phase, config.diurnal_period)
+                         / config.diurnal_period;
+            return config.rate * share * (1.0 + config.diurnal_amplitude * std::sin(phase));
+        }
+        default:
+            return config.rate * share;
+    }
+}
+
+int WorkloadGenerator::geometricGap(double p) {
+    if (p >= 1.0) {
+        return 0;
+    }
+    // Inversion: 1 - U is in (0, 1], so the logarithm is finite. The rate rarely
+    // changes between draws, so its logarithm is cached
+    if (p != gap_p) {
+        gap_p = p;
+        gap_log = std::log1p(-p);
+    }
+    double gap = std::floor(std::log(1.0 - random.uniform()) / gap_log);
+    return gap < MAX_GAP ? static_cast<int>(gap) : MAX_GAP;
+}
+
+int WorkloadGenerator::positivePoisson(double mean) {
+    if (mean > 30.0) {
+        // Normal approximation; P(0) is negligible this far out
+        return std::max(1, static_cast<int>(std::lround(mean + std::sqrt(mean) * normal())));
+    }
+    // Inversion over k >= 1: draw u from [P(0), 1) and walk the distribution
+    if (mean != zero_mean) {
+        zero_mean = mean;
+        zero_chance = std::exp(-mean);
+    }
+    double p = zero_chance;
+    double cumulative = p;
+    double u = p + random.uniform() * (1.0 - p);
+    int k = 0;
+    while (cumulative <= u && k < 1000) {
+        k++;
+        p *= mean / k;
+        cumulative += p;
+    }
+    return std::max(k, 1);
+}
+
+double WorkloadGenerator::normal() {
+    if (has_spare) {
+        has_spare = false;
+        return spare_normal;
+    }
+    // Marsaglia's polar method yields two values per accepted pair
+    double u, v, s;
+    do {
+        u = 2.0 * random.uniform() - 1.0;
+        v = 2.0 * random.uniform() - 1.0;
+        s = u * u + v * v;
+    } while (s >= 1.0 || s == 0.0);
+    double scale = std::sqrt(-2.0 * std::log(s) / s);
+    spare_normal = v * scale;
+    has_spare = true;
+    return u * scale;
+}
+
+void WorkloadGenerator::scheduleAfter(int after) {
+    int time = after;
+    double mean = 0.0;
+    switch (config.arrivals) {
+        case ArrivalModel::Bernoulli:
+        case ArrivalModel::Poisson: {
+            mean = rateAt(time);
+            double p = config.arrivals == ArrivalModel::Bernoulli ? std::min(mean, 1.0) : -std::expm1(-mean);
+            time = p > 0.0 ? later(time, 1LL + geometricGap(p)) : INT_MAX;
+            break;
+        }
+        case ArrivalModel::Mmpp: {
+            // Poisson within a state; the process is memoryless, so a gap that crosses
+            // a state change is simply redrawn from the change at the new state's rate
+            bool anyTraffic = false;
+            for (double rate : config.mmpp_rates) {
+                anyTraffic = anyTraffic || rate > 0.0;
+            }
+            for (;;) {
+                mean = rateAt(time);
+                double p = -std::expm1(-mean);
+                int candidate = p > 0.0 ? later(time, 1LL + geometricGap(p)) : INT_MAX;
+                if (candidate < state_end || !anyTraffic || state_end == INT_MAX) {
+                    time = anyTraffic ? candidate : INT_MAX;
+                    break;
+                }
+                time = state_end - 1;
+                size_t states = config.mmpp_rates.size();
+                state = (state + 1 + random.below(states - 1)) % states;
+                state_end = later(state_end, std::max(1LL, static_cast<long long>(
+                                  std::ceil(-config.mmpp_dwell[state] * std::log1p(-random.uniform())))));
+            }
+            break;
+        }
+        case ArrivalModel::Diurnal: {
+            // Thinning: candidates at the peak rate, each kept with the ratio of the
+            // arrival probability at its tick to the peak's
+            double peak = -std::expm1(-config.rate * share * (1.0 + config.diurnal_amplitude));
+            if (peak <= 0.0) {
+                time = INT_MAX;
+                break;
+            }
+            do {
+                time = later(time, 1LL + geometricGap(peak));
+                mean = rateAt(time);
+            } while (time < INT_MAX && random.uniform() * peak >= -std::expm1(-mean));
+            break;
+        }
+    }
+
+    next_time = time;
+    batch = config.arrivals == ArrivalModel::Bernoulli || time == INT_MAX ? 1 : positivePoisson(mean);
+    surge = config.burst_probability > 0.0 && random.uniform() < config.burst_probability;
+    if (surge) {
+        batch = config.burst_size;
+    }
+}
+
+int WorkloadGenerator::serviceTime() {
+    double work;
+    switch (config.service) {
+        case ServiceModel::Exponential:
+            work = -config.service_mean * std::log1p(-random.uniform());
+            break;
+        case ServiceModel::Pareto:
+            work = config.pareto_scale / std::pow(1.0 - random.uniform(), 1.0 / config.pareto_shape);
+            break;
+        case ServiceModel::Lognormal:
+            work = std::exp(config.lognormal_mu + config.lognormal_sigma * normal());
+            break;
+        default:
+            return config.service_min + static_cast<int>(random.below(
+                static_cast<uint64_t>(config.service_max - config.service_min) + 1));
+    }
+    // Whole ticks, at least one; the heavy tails are capped
+    if (!(work < config.service_cap)) {
+        return config.service_cap;
+    }
+    return std::max(1, static_cast<int>(std::ceil(work)));
+}
+
+namespace {
+    /**
+     * @brief A WorkloadGenerator as stored in a checkpoint (MMPP lists in their own sections)
+     */
+    struct GeneratorRecord {
+        Xoshiro256 random;          ///< Random stream
+        double rate;                ///< WorkloadConfig::rate
+        double burst_probability;   ///< WorkloadConfig::burst_probability
+        double diurnal_amplitude;   ///< WorkloadConfig::diurnal_amplitude
+        double service_mean;        ///< WorkloadConfig::service_mean
+        double pareto_shape;        ///< WorkloadConfig::pareto_shape
+        double pareto_scale;        ///< WorkloadConfig::pareto_scale
+        double lognormal_mu;        ///< WorkloadConfig::lognormal_mu
+        double lognormal_sigma;     ///< WorkloadConfig::lognormal_sigma
+        double share;               ///< Fraction of the configured rates generated
+        double spare_normal;        ///< Unused second normal draw
+        double gap_p;               ///< Probability cached in gap_log
+        double gap_log;             ///< log(1 - gap_p)
+        double zero_mean;           ///< Poisson mean cached in zero_chance
+        double zero_chance;         ///< exp(-zero_mean)
+        uint64_t state;             ///< Current MMPP state
+        int32_t arrivals;           ///< WorkloadConfig::arrivals
+        int32_t service;            ///< WorkloadConfig::service
+        int32_t burst_size;         ///< WorkloadConfig::burst_size
+        int32_t diurnal_period;     ///< WorkloadConfig::diurnal_period
+        int32_t diurnal_phase;      ///< WorkloadConfig::diurnal_phase
+        int32_t service_min;        ///< WorkloadConfig::service_min
+        int32_t service_max;        ///< WorkloadConfig::service_max
+        int32_t service_cap;        ///< WorkloadConfig::service_cap
+        uint32_t source_first;      ///< WorkloadConfig::source_first
+        uint32_t source_last;       ///< WorkloadConfig::source_last
+        uint32_t destination_first; ///< WorkloadConfig::destination_first
+        uint32_t destination_last;  ///< WorkloadConfig::destination_last
+        IPv6Address source_base;    ///< WorkloadConfig::source_base
+        IPv6Address destination_base;   ///< WorkloadConfig::destination_base
+        int32_t next_time;          ///< Tick of the next batch
+        int32_t batch;              ///< Size of the next batch
+        int32_t state_end;          ///< Tick at which the MMPP state next changes
+        uint8_t surge;              ///< Whether the next batch is a surge
+        uint8_t has_spare;          ///< Whether spare_normal is unused
+    };
+}
+
+void WorkloadGenerator::saveState(SnapshotWriter& out) const {
+    GeneratorRecord r;
+    std::memset(static_cast<void*>(&r), 0, sizeof(r));
+    r.random = random;
+    r.rate = config.rate;
+    r.burst_probability = config.burst_probability;
+    r.diurnal_amplitude = config.diurnal_amplitude;
+    r.service_mean = config.service_mean;
+    r.pareto_shape = config.pareto_shape;
+    r.pareto_scale = config.pareto_scale;
+    r.lognormal_mu = config.lognormal_mu;
+    r.lognormal_sigma = config.lognormal_sigma;
+    r.share = share;
+    r.spare_normal = spare_normal;
+    r.gap_p = gap_p;
+    r.gap_log = gap_log;
+    r.zero_mean = zero_mean;
+    r.zero_chance = zero_chance;
+    r.state = state;
+    r.arrivals = static_cast<int32_t>(config.arrivals);
+    r.service = static_cast<int32_t>(config.service);
+    r.burst_size = config.burst_size;
+    r.diurnal_period = config.diurnal_period;
+    r.diurnal_phase = config.diurnal_phase;
+    r.service_min = config.service_min;
+    r.service_max = config.service_max;
+    r.service_cap = config.service_cap;
+    r.source_first = config.source_first;
+    r.source_last = config.source_last;
+    r.destination_first = config.destination_first;
+    r.destination_last = config.destination_last;
+    r.source_base = config.source_base;
+    r.destination_base = config.destination_base;
+    r.next_time = next_time;
+    r.batch = batch;
+    r.state_end = state_end;
+    r.surge = surge ? 1 : 0;
+    r.has_spare = has_spare ? 1 : 0;
+    out.addValue("workload", r);
+    out.add("workload.mmpp_rates", config.mmpp_rates);
+    out.add("workload.mmpp_dwell", config.mmpp_dwell);
+}
+
+bool WorkloadGenerator::restoreState(SnapshotReader& in) {
+    GeneratorRecord r;
+    WorkloadConfig c;
+    if (!in.readValue("workload", r) || !in.read("workload.mmpp_rates", c.mmpp_rates)
+        || !in.read("workload.mmpp_dwell", c.mmpp_dwell)) {
+        return false;
+    }
+    if (c.mmpp_rates.size() != c.mmpp_dwell.size()
+        || (static_cast<ArrivalModel>(r.arrivals) == ArrivalModel::Mmpp && r.state >= c.mmpp_rates.size())) {
+        return false;
+    }
+    c.arrivals = static_cast<ArrivalModel>(r.arrivals);
+    c.rate = r.rate;
+    c.burst_probability = r.burst_probability;
+    c.burst_size = r.burst_size;
+    c.diurnal_period = r.diurnal_period;
+    c.diurnal_amplitude = r.diurnal_amplitude;
+    c.diurnal_phase = r.diurnal_phase;
+    c.service = static_cast<ServiceModel>(r.service);
+    c.service_min = r.service_min;
+    c.service_max = r.service_max;
+    c.service_mean = r.service_mean;
+    c.pareto_shape = r.pareto_shape;
+    c.pareto_scale = r.pareto_scale;
+    c.lognormal_mu = r.lognormal_mu;
+    c.lognormal_sigma = r.lognormal_sigma;
+    c.service_cap = r.service_cap;
+    c.source_first = r.source_first;
+    c.source_last = r.source_last;
+    c.destination_first = r.destination_first;
+    c.destination_last = r.destination_last;
+    c.source_base = r.source_base;
+    c.destination_base = r.destination_base;
+    config = c;
+    source_span = static_cast<uint64_t>(config.source_last) - config.source_first + 1;
+    destination_span = static_cast<uint64_t>(config.destination_last) - config.destination_first + 1;
+    ipv6 = !config.source_base.isIPv4Mapped() || !config.destination_base.isIPv4Mapped();
+    random = r.random;
+    share = r.share;
+    spare_normal = r.spare_normal;
+    gap_p = r.gap_p;
+    gap_log = r.gap_log;
+    zero_mean = r.zero_mean;
+    zero_chance = r.zero_chance;
+    state = static_cast<size_t>(r.state);
+    next_time = r.next_time;
+    batch = r.batch;
+    state_end = r.state_end;
+    surge = r.surge != 0;
+    has_spare = r.has_spare != 0;
+    return true;
+}
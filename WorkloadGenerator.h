@@ -0,0 +1,317 @@
+/**
+ * @file WorkloadGenerator.h
+ * @brief WorkloadGenerator class header file
+ */
+#ifndef WORKLOADGENERATOR_H
+#define WORKLOADGENERATOR_H
+
+#include "Request.h"
+#include "Snapshot.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief xoshiro256** pseudo-random generator
+ *
+ * Small, fast and statistically strong; a copy continues the same stream, and
+ * jump() moves to a stream 2^128 draws away for another producer. Satisfies
+ * UniformRandomBitGenerator, so it also works with the standard distributions.
+ */
+class Xoshiro256 {
+private:
+    uint64_t s[4];  ///< Generator state (never all zero)
+
+public:
+    using result_type = uint64_t;
+
+    /**
+     * @brief Seeds the generator, expanding the seed with splitmix64
+     * @param seed Any value, including 0
+     */
+    explicit Xoshiro256(uint64_t seed = 1) { this->seed(seed); }
+
+    /**
+     * @brief Reseeds the generator
+     * @param seed Any value, including 0
+     */
+    void seed(uint64_t seed);
+
+    /**
+     * @brief Gets the next 64 random bits
+     * @return Random value
+     */
+    uint64_t operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief Gets a uniform double in [0, 1)
+     * @return Random value with 53 random bits
+     */
+    double uniform() { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; }
+
+    /**
+     * @brief Gets a uniform integer in [0, n) without a division
+     * @param n Number of values (at most 2^32)
+     * @return Random value
+     */
+    uint32_t below(uint64_t n) { return static_cast<uint32_t>((((*this)() >> 32) * n) >> 32); }
+
+    /**
+     * @brief Advances the generator by 2^128 draws
+     */
+    void jump();
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return UINT64_MAX; }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+/**
+ * @brief How arrivals are spread over time
+ */
+enum class ArrivalModel {
+    Bernoulli,  ///< At most one arrival per tick, with probability rate
+    Poisson,    ///< Poisson-distributed arrivals per tick with mean rate
+    Mmpp,       ///< Markov-modulated Poisson: the mean switches between states (quiet, bursty, ...)
+    Diurnal     ///< Poisson with a mean that follows a sine wave around rate
+};
+
+/**
+ * @brief How long requests take to serve
+ */
+enum class ServiceModel {
+    Uniform,        ///< Uniform over [service_min, service_max]
+    Exponential,    ///< Exponential with mean service_mean
+    Pareto,         ///< Pareto with shape pareto_shape and minimum pareto_scale (heavy tail)
+    Lognormal       ///< exp(N(lognormal_mu, lognormal_sigma^2)) (heavy tail)
+};
+
+/**
+ * @brief Parameters of a generated workload; the defaults are the built-in traffic
+ */
+struct WorkloadConfig {
+    ArrivalModel arrivals = ArrivalModel::Bernoulli;    ///< Arrival process
+    double rate = 0.30;                                 ///< Mean arrivals per tick (Bernoulli: probability)
+    double burst_probability = 0.01;                    ///< Chance that an arrival is a surge instead
+    int burst_size = 5;                                 ///< Requests in a surge
+    std::vector<double> mmpp_rates = {0.1, 1.5};        ///< Mean arrivals per tick in each MMPP state
+    std::vector<double> mmpp_dwell = {2000, 200};       ///< Mean ticks spent in each MMPP state
+    int diurnal_period = 10000;                         ///< Ticks per diurnal cycle
+    double diurnal_amplitude = 0.5;                     ///< Relative swing of the diurnal rate, in [0, 1]
+    int diurnal_phase = 0;                              ///< Ticks into the cycle at time 0
+    ServiceModel service = ServiceModel::Uniform;       ///< Service-time distribution
+    int service_min = 1;                                ///< Shortest uniform service time
+    int service_max = 10;                               ///< Longest uniform service time
+    double service_mean = 5.0;                          ///< Mean exponential service time
+    double pareto_shape = 1.5;                          ///< Pareto tail index (smaller is heavier)
+    double pareto_scale = 2.0;                          ///< Smallest Pareto service time
+    double lognormal_mu = 1.2;                          ///< Mean of the logarithm
+    double lognormal_sigma = 0.8;                       ///< Standard deviation of the logarithm
+    int service_cap = 100000;                           ///< Longest service time of the unbounded models
+    uint32_t source_first = 0xC0A80100u;                ///< Lowest source address (192.168.1.0)
+    uint32_t source_last = 0xC0A801FEu;                 ///< Highest source address (192.168.1.254)
+    uint32_t destination_first = 0xC0A80100u;           ///< Lowest destination address
+    uint32_t destination_last = 0xC0A801FEu;            ///< Highest destination address
+    IPv6Address source_base = IPv6Address::fromIPv4(0);      ///< Upper 96 bits of source addresses (low 32 from the range)
+    IPv6Address destination_base = IPv6Address::fromIPv4(0); ///< Upper 96 bits of destination addresses
+};
+
+/**
+ * @brief Loads a workload configuration file
+ *
+ * One "key = value" per line; blank lines and text after '#' are ignored, and keys
+ * that are not given keep their defaults. See workload.conf for every key.
+ *
+ * @param filepath Configuration file
+ * @param config Receives the configuration
+ * @param error Receives a description of the first problem on failure
+ * @return true on success
+ */
+bool loadWorkloadConfig(const std::string& filepath, WorkloadConfig& config, std::string& error);
+
+/**
+ * @brief Deterministic generator of request arrivals and service times
+ *
+ * Arrivals come in batches: nextTime() is the next tick with arrivals and
+ * batchSize() how many arrive then. The caller draws that many requests with
+ * request() and then calls advance(). Gaps between batches are drawn directly
+ * (geometric for a constant rate, thinning for the diurnal rate, and a restart at
+ * every MMPP state change), so quiet ticks cost nothing and the event engine can
+ * skip straight to the next arrival.
+ *
+ * Everything is drawn from one Xoshiro256 stream, so a seed reproduces a run and
+ * a copy of the generator continues exactly where the original was. Addresses are
+ * drawn as integers, never formatted.
+ */
+class WorkloadGenerator {
+public:
+    /**
+     * @brief Creates a generator; the first batch comes after tick 0
+     * @param config Workload parameters
+     * @param seed Seed of the random stream
+     */
+    explicit WorkloadGenerator(const WorkloadConfig& config = WorkloadConfig(), uint64_t seed = 1);
+
+    /**
+     * @brief Replaces the workload parameters and draws a new first batch after a tick
+     * @param config Workload parameters
+     * @param now Current tick
+     */
+    void configure(const WorkloadConfig& config, int now);
+
+    /**
+     * @brief Gets the workload parameters
+     * @return Current configuration
+     */
+    const WorkloadConfig& getConfig() const { return config; }
+
+    /**
+     * @brief Turns this generator into an independent one for another producer
+     *
+     * Moves to a stream of its own, scales every arrival rate and draws a new first
+     * batch after a tick. Several producers with a share of 1/n each generate the
+     * original mean rate between them.
+     *
+     * @param stream Producer number; stream 0 keeps the current stream
+     * @param share Fraction of the arrival rate this producer generates
+     * @param now Current tick
+     */
+    void split(unsigned int stream, double share, int now);
+
+    /**
+     * @brief Gets the tick of the next batch
+     * @return Tick at which batchSize() requests arrive
+     */
+    int nextTime() const { return next_time; }
+
+    /**
+     * @brief Gets the number of requests in the next batch
+     * @return Batch size (at least 1)
+     */
+    int batchSize() const { return batch; }
+
+    /**
+     * @brief Checks whether the next batch is a traffic surge
+     * @return true if the batch was made a surge of burst_size requests
+     */
+    bool isSurge() const { return surge; }
+
+    /**
+     * @brief Checks whether the generated requests are IPv6 requests
+     * @return true if either address range is IPv6 (not IPv4-mapped)
+     */
+    bool isIPv6() const { return ipv6; }
+
+    /**
+     * @brief Draws the batch after the current one
+     */
+    void advance();
+
+    /**
+     * @brief Draws one request
+     * @param time Arrival tick (stored as the enqueue time)
+     * @return Request with random addresses and service time
+     */
+    Request request(int time) {
+        uint32_t in = config.source_first + random.below(source_span);
+        uint32_t out = config.destination_first + random.below(destination_span);
+        if (ipv6) {
+            int work = serviceTime();
+            return Request::fromIPv6(IPv6Address{config.source_base.hi, config.source_base.lo | in},
+                                     IPv6Address{config.destination_base.hi, config.destination_base.lo | out},
+                                     work, time);
+        }
+        return Request(in, out, serviceTime(), time);
+    }
+
+    /**
+     * @brief Draws a service time
+     * @return Ticks of work (at least 1)
+     */
+    int serviceTime();
+
+    /**
+     * @brief Adds the generator to a checkpoint: parameters, random stream and next batch
+     * @param out Checkpoint being written
+     */
+    void saveState(SnapshotWriter& out) const;
+
+    /**
+     * @brief Continues the generator stored in a checkpoint, with its parameters
+     * @param in Open checkpoint
+     * @return false if a section is missing (the generator is then unchanged)
+     */
+    bool restoreState(SnapshotReader& in);
+
+private:
+    WorkloadConfig config;          ///< Workload parameters
+    Xoshiro256 random;              ///< Random stream
+    double share;                   ///< Fraction of the configured rates this generator produces
+    uint64_t source_span;           ///< Number of source addresses
+    uint64_t destination_span;      ///< Number of destination addresses
+    bool ipv6;                      ///< Whether either address range is IPv6 (not IPv4-mapped)
+    int next_time;                  ///< Tick of the next batch
+    int batch;                      ///< Size of the next batch
+    bool surge;                     ///< Whether the next batch is a surge
+    size_t state;                   ///< Current MMPP state
+    int state_end;                  ///< Tick at which the MMPP state next changes
+    double spare_normal;            ///< Second value of the last Marsaglia polar draw
+    bool has_spare;                 ///< Whether spare_normal is unused
+    double gap_p;                   ///< Probability whose logarithm is cached in gap_log
+    double gap_log;                 ///< log(1 - gap_p)
+    double zero_mean;               ///< Poisson mean whose P(0) is cached in zero_chance
+    double zero_chance;             ///< exp(-zero_mean)
+
+    /**
+     * @brief Gets the mean arrivals of a tick under the current model
+     * @param time Tick
+     * @return Mean arrivals (Bernoulli: probability)
+     */
+    double rateAt(int time) const;
+
+    /**
+     * @brief Draws the number of empty ticks before a success of probability p
+     * @param p Success probability per tick, in (0, 1]
+     * @return Geometric gap, capped to stay within int range
+     */
+    int geometricGap(double p);
+
+    /**
+     * @brief Draws a Poisson count conditioned on being at least one
+     * @param mean Poisson mean
+     * @return Count of at least 1
+     */
+    int positivePoisson(double mean);
+
+    /**
+     * @brief Draws a standard normal value
+     * @return N(0, 1) sample
+     */
+    double normal();
+
+    /**
+     * @brief Schedules the first batch after a tick
+     * @param now Current tick
+     */
+    void start(int now);
+
+    /**
+     * @brief Draws the next batch strictly after a tick
+     * @param after Tick after which the batch arrives
+     */
+    void scheduleAfter(int after);
+};
+
+#endif // WORKLOADGENERATOR_H
@@ -0,0 +1,234 @@
+/**
+ * @file backend.cpp
+ * @brief Minimal TCP backend for trying the proxy mode on loopback
+ *
+ * A single-threaded epoll server that either echoes every byte it receives or, with
+ * --http, answers every HTTP request on a keep-alive connection with a small
+ * "200 OK" response. Requests are recognised by their blank line, so request bodies
+ * are not supported; that is enough for load generators. A client that half-closes
+ * still gets its replies; the connection is closed once they are written.
+ *
+ * Usage: backend.exe --port=<n> [--address=<ip>] [--http] [--delay=<ms>] [--seconds=<n>]
+ * - --port is the port to listen on
+ * - --address is the address to listen on (default 127.0.0.1)
+ * - --http answers HTTP requests instead of echoing
+ * - --delay holds every reply back for that many milliseconds, like a slow service
+ * - --seconds stops after that long (default: until SIGINT or SIGTERM)
+ *
+ * Linux only.
+ */
+
+#include "IpAddress.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    volatile std::sig_atomic_t stopped = 0;     ///< Set by SIGINT and SIGTERM
+
+    const char RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 3\r\n\r\nok\n";
+
+    /**
+     * @brief State of one client connection
+     */
+    struct Connection {
+        std::string input;      ///< Received bytes not yet answered (HTTP only)
+        std::string output;     ///< Bytes the socket did not accept yet
+        std::chrono::steady_clock::time_point due;  ///< When the queued output may be sent (--delay)
+        bool closing = false;   ///< The client half-closed; close once the output is written
+    };
+
+    /**
+     * @brief Signal handler that ends the event loop
+     * @param signal Signal number
+     */
+    void onSignal(int signal) {
+        (void)signal;
+        stopped = 1;
+    }
+
+    /**
+     * @brief Writes as much pending output as the socket takes, once it is due
+     * @param fd Client socket
+     * @param c Connection state
+     * @return false if the connection failed
+     */
+    bool flush(int fd, Connection& c) {
+        if (std::chrono::steady_clock::now() < c.due) {
+            return true;
+        }
+        while (!c.output.empty()) {
+            ssize_t n = send(fd, c.output.data(), c.output.size(), MSG_NOSIGNAL);
+            if (n < 0) {
+                return errno == EAGAIN;
+            }
+            c.output.erase(0, static_cast<size_t>(n));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads everything available and queues the replies
+     * @param fd Client socket
+     * @param c Connection state
+     * @param http Whether to answer HTTP requests instead of echoing
+     * @param delay How long replies are held back
+     * @return false if the connection failed
+     */
+    bool serve(int fd, Connection& c, bool http, std::chrono::milliseconds delay) {
+        char buffer[1 << 16];
+        while (!c.closing) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0) {
+                return errno == EAGAIN && flush(fd, c);
+            }
+            if (n == 0) {
+                c.closing = true;   // the replies still go out before the connection closes
+                break;
+            }
+            if (c.output.empty()) {
+                c.due = std::chrono::steady_clock::now() + delay;
+            }
+            if (!http) {
+                c.output.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            c.input.append(buffer, static_cast<size_t>(n));
+            size_t end;
+            while ((end = c.input.find("\r\n\r\n")) != std::string::npos) {
+                c.input.erase(0, end + 4);
+                c.output.append(RESPONSE, sizeof(RESPONSE) - 1);
+            }
+        }
+        return flush(fd, c);
+    }
+}
+
+/**
+ * @brief Entry point of the backend
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 after a clean stop, 1 on an invalid flag or if the port cannot be bound
+ */
+int main(int argc, char* argv[]) {
+    uint32_t address = 0x7F000001u;
+    long port = 0;
+    bool http = false;
+    int delay = 0;
+    int seconds = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--port=", 0) == 0) {
+            port = std::atol(arg.c_str() + 7);
+        } else if (arg.rfind("--address=", 0) == 0 && parseIPv4(arg.substr(10), address)) {
+            continue;
+        } else if (arg == "--http") {
+            http = true;
+        } else if (arg.rfind("--delay=", 0) == 0) {
+            delay = std::atoi(arg.c_str() + 8);
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            seconds = std::atoi(arg.c_str() + 10);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (port <= 0 || port > 65535 || delay < 0) {
+        std::cerr << "Usage: backend.exe --port=<n> [--address=<ip>] [--http] [--delay=<ms>] [--seconds=<n>]" << std::endl;
+        return 1;
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(address);
+    sa.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(listener, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on " << formatIPv4(address) << ":" << port << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event e;
+    e.events = EPOLLIN;
+    e.data.fd = listener;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &e);
+
+    std::unordered_map<int, Connection> connections;
+    uint64_t accepted = 0;
+    std::chrono::steady_clock::time_point deadline = seconds > 0
+        ? std::chrono::steady_clock::now() + std::chrono::seconds(seconds)
+        : std::chrono::steady_clock::time_point::max();
+    epoll_event events[256];
+    while (!stopped && std::chrono::steady_clock::now() < deadline) {
+        // Held-back replies are sent from the loop, so it wakes up often while they wait
+        int n = epoll_wait(epoll, events, 256, delay > 0 ? 1 : 100);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listener) {
+                int client;
+                while ((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    e.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                    e.data.fd = client;
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, client, &e);
+                    connections[client];
+                    accepted++;
+                }
+                continue;
+            }
+            Connection& c = connections[fd];
+            if ((events[i].events & EPOLLERR) || !serve(fd, c, http, std::chrono::milliseconds(delay))
+                || (c.closing && c.output.empty())) {
+                connections.erase(fd);
+                close(fd);
+            }
+        }
+        if (delay > 0) {
+            for (std::unordered_map<int, Connection>::iterator it = connections.begin(); it != connections.end();) {
+                if (!flush(it->first, it->second) || (it->second.closing && it->second.output.empty())) {
+                    close(it->first);
+                    it = connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    for (const std::pair<const int, Connection>& c : connections) {
+        close(c.first);
+    }
+    close(epoll);
+    close(listener);
+    std::cout << "Backend on port " << port << " accepted " << accepted << " connections" << std::endl;
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cerr << "backend.exe needs Linux (epoll)" << std::endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,392 @@
+/**
+ * @file bench.cpp
+ * @brief Benchmark suite for the simulator's hot paths
+ *
+ * Micro-benchmarks time single operations (request construction and copy, workload
+ * generation with each arrival and service model, firewall lookups at several rule-set sizes, server ticks, queue push/pop and the scaling
+ * step); macro-benchmarks time complete LoadBalancer::run() calls at 10, 1k and 100k
+ * servers with both engines and logging turned off, plus the sharded tick engine at
+ * 100k servers on 2, 4 and 8 threads. Results are printed as one
+ * JSON document so that runs can be stored and compared between versions.
+ *
+ * Firewall lookups have their own micro-benchmark; the LoadBalancer benchmarks run
+ * without a rule file so they never write a firewall audit file.
+ *
+ * Usage: bench.exe [--quick] [--filter=<substring>] [--out=<file>]
+ * - --quick shortens every benchmark (for smoke tests; numbers are noisier)
+ * - --filter runs only the benchmarks whose name contains the substring
+ * - --out writes the JSON to a file instead of stdout
+ */
+
+#include "Firewall.h"
+#include "LoadBalancer.h"
+#include "Request.h"
+#include "RequestQueue.h"
+#include "ServerPool.h"
+#include "WebServer.h"
+#include "WorkloadGenerator.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define BENCH_RUSAGE 1
+#endif
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    bool quick = false;         ///< Shorter runs (--quick)
+    std::string filter;         ///< Substring a benchmark name must contain (--filter)
+    std::vector<std::string> results;   ///< JSON objects of the finished benchmarks
+
+    /**
+     * @brief Keeps the compiler from discarding a value that is otherwise unused
+     * @param value Value to keep alive
+     */
+    template <typename T>
+    void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    /**
+     * @brief Gets the process's peak resident set size
+     * @return Peak RSS in kilobytes, or -1 where it cannot be measured
+     */
+    long peakRssKb() {
+#ifdef BENCH_RUSAGE
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return -1;
+        }
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;     // bytes on macOS
+#else
+        return usage.ru_maxrss;
+#endif
+#else
+        return -1;
+#endif
+    }
+
+    /**
+     * @brief Seconds elapsed since a start time
+     * @param start Start time
+     * @return Elapsed seconds
+     */
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief Checks whether a benchmark was selected with --filter
+     * @param name Benchmark name
+     * @return true if the benchmark should run
+     */
+    bool selected(const std::string& name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    /**
+     * @brief Times a batch operation, doubling the batch count until the run is long enough
+     *
+     * @param name Benchmark name
+     * @param opsPerBatch Operations performed by one call of batch
+     * @param batch Performs opsPerBatch operations
+     */
+    template <typename Batch>
+    void micro(const std::string& name, size_t opsPerBatch, Batch batch) {
+        if (!selected(name)) {
+            return;
+        }
+        const double minSeconds = quick ? 0.02 : 0.25;
+        batch();    // warm up caches and lazy allocations
+
+        size_t batches = 1;
+        double seconds = 0.0;
+        for (;;) {
+            Clock::time_point start = Clock::now();
+            for (size_t i = 0; i < batches; ++i) {
+                batch();
+            }
+            seconds = secondsSince(start);
+            if (seconds >= minSeconds || batches >= (size_t(1) << 40)) {
+                break;
+            }
+            batches *= 2;
+        }
+
+        double ops = static_cast<double>(batches) * static_cast<double>(opsPerBatch);
+        char json[256];
+        std::snprintf(json, sizeof(json),
+                      "{\"name\": \"%s\", \"type\": \"micro\", \"ops\": %.0f, \"seconds\": %.6f, \"ns_per_op\": %.3f}",
+                      name.c_str(), ops, seconds, seconds * 1e9 / ops);
+        results.push_back(json);
+        std::cerr << name << ": " << seconds * 1e9 / ops << " ns/op" << std::endl;
+    }
+
+    /**
+     * @brief Draws uniformly random IPv4 addresses
+     * @param rng Random source
+     * @param count Number of addresses
+     * @return Random IPv4 addresses
+     */
+    std::vector<uint32_t> randomAddresses(std::mt19937& rng, size_t count) {
+        std::vector<uint32_t> addresses(count);
+        for (uint32_t& address : addresses) {
+            address = rng();
+        }
+        return addresses;
+    }
+
+    void benchRequests() {
+        const size_t N = 1024;
+        std::vector<Request> source(N), target(N);
+        std::vector<uint32_t> addresses(N);
+        std::mt19937 rng(1);
+        for (size_t i = 0; i < N; ++i) {
+            addresses[i] = rng();
+        }
+
+        micro("request/construct", N, [&]() {
+            for (size_t i = 0; i < N; ++i) {
+                source[i] = Request(addresses[i], addresses[N - 1 - i], static_cast<int>(i & 15), static_cast<int>(i));
+            }
+            keep(source);
+        });
+        micro("request/copy", N, [&]() {
+            for (size_t i = 0; i < N; ++i) {
+                target[i] = source[i];
+            }
+            keep(target);
+        });
+        const Request sample("192.168.1.10", "10.0.0.7", 5);
+        micro("request/construct-from-text", 1, [&]() {
+            Request r("192.168.1.10", "10.0.0.7", 5);
+            keep(r);
+        });
+        micro("request/describe", 1, [&]() {
+            std::string text = sample.describe();
+            keep(text);
+        });
+    }
+
+    void benchWorkload() {
+        const size_t N = 1024;
+        WorkloadConfig configs[4];
+        const char* names[4] = {"bernoulli-uniform", "poisson-pareto", "mmpp-lognormal", "diurnal-exponential"};
+        configs[1].arrivals = ArrivalModel::Poisson;
+        configs[1].service = ServiceModel::Pareto;
+        configs[2].arrivals = ArrivalModel::Mmpp;
+        configs[2].service = ServiceModel::Lognormal;
+        configs[3].arrivals = ArrivalModel::Diurnal;
+        configs[3].service = ServiceModel::Exponential;
+        std::vector<Request> requests(N);
+        for (int m = 0; m < 4; ++m) {
+            std::string name = std::string("workload/") + names[m];
+            // Whole batches, arrival gaps included, as the simulation draws them
+            WorkloadGenerator generator(configs[m], 1);
+            micro(name, N, [&]() {
+                size_t i = 0;
+                while (i < N) {
+                    for (int r = 0; r < generator.batchSize() && i < N; ++r) {
+                        requests[i++] = generator.request(generator.nextTime());
+                    }
+                    generator.advance();
+                }
+                keep(requests);
+            });
+        }
+    }
+
+    void benchFirewall() {
+        const size_t sizes[] = {1, 1000, 100000, 1000000};
+        for (size_t rules : sizes) {
+            std::string name = "firewall/isBlocked/" + std::to_string(rules) + "-rules";
+            if (!selected(name)) {
+                continue;
+            }
+            std::mt19937 rng(static_cast<unsigned int>(rules));
+            Firewall firewall;
+            for (size_t i = 0; i < rules; ++i) {
+                // Mostly hosts, some networks, a few allow holes
+                uint32_t prefix = rng();
+                int length = (i % 10 == 0) ? 24 : 32;
+                firewall.addPrefix(prefix, length, i % 50 == 0 ? FirewallAction::Allow : FirewallAction::Deny);
+            }
+            firewall.compile();
+            std::vector<uint32_t> addresses = randomAddresses(rng, 4096);
+            micro(name, addresses.size(), [&]() {
+                size_t blocked = 0;
+                for (uint32_t address : addresses) {
+                    blocked += firewall.isBlocked(address);
+                }
+                keep(blocked);
+            });
+        }
+    }
+
+    void benchServers() {
+        const size_t N = 65536;
+        ServerPool pool;
+        pool.reserve(N);
+        for (size_t i = 0; i < N; ++i) {
+            pool.add();
+            pool.assign(i, Request(0, 0, 1 << 30));     // long enough to never finish
+        }
+
+        micro("webserver/tick", N, [&]() {
+            for (size_t i = 0; i < N; ++i) {
+                pool.server(i).tick();
+            }
+        });
+        std::vector<uint64_t> done;
+        micro("serverpool/countdown", N, [&]() {
+            pool.countdown(done);
+            keep(done);
+        });
+    }
+
+    void benchQueue() {
+        RequestQueue queue;
+        const size_t depth = 1024;
+        for (size_t i = 0; i < depth; ++i) {
+            queue.emplace(static_cast<uint32_t>(i), 0, 1);
+        }
+        micro("queue/push-pop", depth, [&]() {
+            for (size_t i = 0; i < depth; ++i) {
+                queue.push(queue.front());
+                queue.pop();
+            }
+        });
+    }
+
+    void benchScaling() {
+        const int servers = 1000;
+        if (selected("loadbalancer/manageServerLoad/steady")) {
+            // A long queue and a full pool: the decision is made but nothing changes
+            LoadBalancer lb(servers, servers * 10, "", 1, false);
+            lb.setLogLevel(LogLevel::Error);
+            micro("loadbalancer/manageServerLoad/steady", 1, [&]() {
+                lb.manageServerLoad();
+            });
+        }
+        if (selected("loadbalancer/manageServerLoad/scale")) {
+            // Remove an idle server, then let manageServerLoad() add it back
+            LoadBalancer lb(servers, servers * 10, "", 1, false);
+            lb.setLogLevel(LogLevel::Error);
+            micro("loadbalancer/manageServerLoad/scale", 1, [&]() {
+                lb.scaleDown();
+                lb.manageServerLoad();
+            });
+        }
+    }
+
+    /**
+     * @brief Times one complete simulation
+     * @param servers Number of servers
+     * @param ticks Number of ticks to simulate
+     * @param engine Simulation engine
+     * @param threads Threads of the sharded tick engine, or 0 for the serial engines
+     */
+    void macro(int servers, int ticks, SimulationEngine engine, int threads = 0) {
+        std::string engineName = engine == SimulationEngine::Event ? "event" : "tick";
+        if (threads > 0) {
+            engineName += "-" + std::to_string(threads) + "-threads";
+        }
+        std::string name = "run/" + std::to_string(servers) + "-servers/" + engineName;
+        if (!selected(name)) {
+            return;
+        }
+
+        Clock::time_point start = Clock::now();
+        LoadBalancer lb(servers, -1, "", 1, false);
+        lb.setLogLevel(LogLevel::Error);
+        lb.setEngine(engine);
+        if (threads > 0) {
+            lb.setThreads(threads);
+        }
+        double setup = secondsSince(start);
+
+        start = Clock::now();
+        lb.run(ticks);
+        double seconds = secondsSince(start);
+
+        char json[512];
+        std::snprintf(json, sizeof(json),
+                      "{\"name\": \"%s\", \"type\": \"macro\", \"servers\": %d, \"ticks\": %d, "
+                      "\"setup_seconds\": %.6f, \"seconds\": %.6f, \"ticks_per_sec\": %.1f, "
+                      "\"requests\": %llu, \"requests_per_sec\": %.1f, \"peak_rss_kb\": %ld}",
+                      name.c_str(), servers, ticks, setup, seconds, ticks / seconds,
+                      static_cast<unsigned long long>(lb.getCompletedRequests()),
+                      static_cast<double>(lb.getCompletedRequests()) / seconds, peakRssKb());
+        results.push_back(json);
+        std::cerr << name << ": " << ticks / seconds << " ticks/s" << std::endl;
+    }
+}
+
+/**
+ * @brief Runs the selected benchmarks and prints the results as JSON
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 on success, 1 on an invalid option or unwritable output file
+ */
+int main(int argc, char* argv[]) {
+    std::string outPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            quick = true;
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            filter = arg.substr(9);
+        } else if (arg.rfind("--out=", 0) == 0) {
+            outPath = arg.substr(6);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    benchRequests();
+    benchWorkload();
+    benchFirewall();
+    benchServers();
+    benchQueue();
+    benchScaling();
+
+    // The initial queue holds 100 requests per server, so every pool size starts busy
+    int scale = quick ? 10 : 1;
+    const int runs[][2] = {{10, 100000}, {1000, 20000}, {100000, 1000}};
+    for (const auto& run : runs) {
+        macro(run[0], run[1] / scale, SimulationEngine::Tick);
+        macro(run[0], run[1] / scale, SimulationEngine::Event);
+    }
+    for (int threads : {2, 4, 8}) {
+        macro(100000, 1000 / scale, SimulationEngine::Tick, threads);
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"peak_rss_kb\": " << peakRssKb() << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        json << "    " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (outPath.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream out(outPath);
+        if (!out) {
+            std::cerr << "Cannot write " << outPath << std::endl;
+            return 1;
+        }
+        out << json.str();
+    }
+    return 0;
+}
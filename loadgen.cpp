@@ -0,0 +1,286 @@
+/**
+ * @file loadgen.cpp
+ * @brief Closed-loop TCP load generator for measuring the proxy mode
+ *
+ * Every connection runs on its own thread and keeps exactly one request in flight:
+ * it sends a request, waits for the complete reply and sends the next. In echo
+ * mode a request is --size bytes and the reply is the same bytes; with --http it is
+ * a keep-alive GET and the reply ends after its Content-Length body. With
+ * --reconnect every request uses a new connection, which exercises accepting and
+ * the proxy's backend connection pool instead of relaying alone. --half-close also
+ * uses a new connection per request, shuts down its sending side right after the
+ * request and reads the reply up to the end of the stream.
+ *
+ * Every echo request carries its connection and sequence number, and a reply that is
+ * not exactly its own request (another client's, or with bytes added) is counted as
+ * mismatched.
+ *
+ * Latency is measured per request, from the send (or connect with --reconnect) to
+ * the end of the reply, in microseconds. Prints requests per second, the latency
+ * mean and percentiles, and the number of failed and mismatched requests.
+ *
+ * Usage: loadgen.exe --target=[<ip>:]<port> [--connections=<n>] [--seconds=<n>]
+ *                    [--size=<bytes>] [--http] [--reconnect] [--half-close]
+ * - --target is the proxy (or backend) to load (address default 127.0.0.1)
+ * - --connections is the number of concurrent connections (default 16)
+ * - --seconds is how long to run (default 5)
+ * - --size is the echo request size (default 64)
+ *
+ * Linux only.
+ */
+
+#include "IpAddress.h"
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    /**
+     * @brief Load parameters shared by the connection threads
+     */
+    struct Load {
+        sockaddr_in target;     ///< Address to connect to
+        size_t size;            ///< Echo request size
+        bool http;              ///< Send HTTP requests instead of echo payloads
+        bool reconnect;         ///< Open a new connection for every request
+        bool half_close;        ///< Shut down the sending side after each request (implies reconnect)
+    };
+
+    /**
+     * @brief Results of one connection thread
+     */
+    struct Result {
+        LatencyHistogram latency;   ///< Request latencies in microseconds
+        uint64_t errors = 0;        ///< Requests that failed
+        uint64_t mismatched = 0;    ///< Echo requests answered with other bytes than their own
+    };
+
+    /**
+     * @brief Opens a blocking connection to the target
+     * @param load Load parameters
+     * @return Socket, or -1 on failure
+     */
+    int connectTo(const Load& load) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&load.target), sizeof(load.target)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /**
+     * @brief Checks whether a reply is complete
+     * @param load Load parameters
+     * @param reply Bytes received so far
+     * @return true once the echo or the HTTP response with its body has arrived
+     */
+    bool complete(const Load& load, const std::string& reply) {
+        if (!load.http) {
+            return reply.size() >= load.size;
+        }
+        size_t head = reply.find("\r\n\r\n");
+        if (head == std::string::npos) {
+            return false;
+        }
+        size_t field = reply.find("Content-Length:");
+        size_t body = field < head ? std::strtoul(reply.c_str() + field + 15, nullptr, 10) : 0;
+        return reply.size() >= head + 4 + body;
+    }
+
+    /**
+     * @brief Sends one request and reads its complete reply
+     * @param fd Connected socket
+     * @param load Load parameters
+     * @param request Request bytes
+     * @param reply Scratch buffer for the reply
+     * @return false if the connection failed or closed early
+     */
+    bool exchange(int fd, const Load& load, const std::string& request, std::string& reply) {
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+            return false;
+        }
+        if (load.half_close && shutdown(fd, SHUT_WR) != 0) {
+            return false;
+        }
+        reply.clear();
+        char buffer[1 << 14];
+        for (;;) {
+            // After a half-close the reply runs to the end of the stream, so bytes
+            // that do not belong to it are caught as well
+            if (!load.half_close && complete(load, reply)) {
+                return true;
+            }
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n == 0 && load.half_close) {
+                return complete(load, reply);
+            }
+            if (n <= 0) {
+                return false;
+            }
+            reply.append(buffer, static_cast<size_t>(n));
+        }
+    }
+
+    /**
+     * @brief Runs one closed-loop connection until the deadline
+     * @param load Load parameters
+     * @param number Connection number, written into the echo requests
+     * @param deadline Time to stop at
+     * @param result Receives the latencies and errors
+     */
+    void drive(const Load& load, int number, std::chrono::steady_clock::time_point deadline, Result& result) {
+        std::string request = load.http ? "GET / HTTP/1.1\r\nHost: loadgen\r\nConnection: keep-alive\r\n\r\n"
+                                        : std::string(load.size, 'x');
+        std::string reply;
+        uint64_t sent = 0;
+        int fd = -1;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (!load.http) {
+                std::string tag = std::to_string(number) + ":" + std::to_string(sent++) + ";";
+                tag.copy(&request[0], std::min(tag.size(), request.size()));
+            }
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (fd < 0 && (fd = connectTo(load)) < 0) {
+                result.errors++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            bool ok = exchange(fd, load, request, reply);
+            if (ok && !load.http && reply != request) {
+                result.mismatched++;
+            } else if (ok) {
+                result.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+            } else {
+                result.errors++;
+            }
+            if (!ok || load.reconnect) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+/**
+ * @brief Entry point of the load generator
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 if at least one request succeeded and no reply was mismatched, 1 otherwise
+ *         or on an invalid flag
+ */
+int main(int argc, char* argv[]) {
+    uint32_t address = 0x7F000001u;
+    long port = 0;
+    int connections = 16;
+    int seconds = 5;
+    Load load;
+    load.size = 64;
+    load.http = false;
+    load.reconnect = false;
+    load.half_close = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--target=", 0) == 0) {
+            std::string target = arg.substr(9);
+            size_t colon = target.rfind(':');
+            if (colon != std::string::npos && !parseIPv4(target.substr(0, colon), address)) {
+                std::cerr << "Invalid target: " << target << std::endl;
+                return 1;
+            }
+            port = std::atol(target.c_str() + (colon == std::string::npos ? 0 : colon + 1));
+        } else if (arg.rfind("--connections=", 0) == 0) {
+            connections = std::atoi(arg.c_str() + 14);
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            seconds = std::atoi(arg.c_str() + 10);
+        } else if (arg.rfind("--size=", 0) == 0) {
+            load.size = static_cast<size_t>(std::atol(arg.c_str() + 7));
+        } else if (arg == "--http") {
+            load.http = true;
+        } else if (arg == "--reconnect") {
+            load.reconnect = true;
+        } else if (arg == "--half-close") {
+            load.half_close = load.reconnect = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (port <= 0 || port > 65535 || connections < 1 || seconds < 1 || load.size < 1) {
+        std::cerr << "Usage: loadgen.exe --target=[<ip>:]<port> [--connections=<n>] [--seconds=<n>]"
+                     " [--size=<bytes>] [--http] [--reconnect] [--half-close]" << std::endl;
+        return 1;
+    }
+    std::memset(&load.target, 0, sizeof(load.target));
+    load.target.sin_family = AF_INET;
+    load.target.sin_addr.s_addr = htonl(address);
+    load.target.sin_port = htons(static_cast<uint16_t>(port));
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point deadline = begin + std::chrono::seconds(seconds);
+    std::vector<Result> results(static_cast<size_t>(connections));
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; ++c) {
+        threads.emplace_back(drive, std::cref(load), c, deadline, std::ref(results[static_cast<size_t>(c)]));
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    LatencyHistogram latency;
+    uint64_t errors = 0;
+    uint64_t mismatched = 0;
+    for (const Result& r : results) {
+        latency.merge(r.latency);
+        errors += r.errors;
+        mismatched += r.mismatched;
+    }
+    std::printf("%s %s:%ld, %d connection(s)%s, %.1f s\n", load.http ? "HTTP" : "Echo", formatIPv4(address).c_str(),
+                port, connections, load.half_close ? " half-closing per request"
+                                   : load.reconnect ? " reconnecting per request" : "", elapsed);
+    std::printf("Requests: %llu (%.0f req/s), errors: %llu, mismatched replies: %llu\n",
+                static_cast<unsigned long long>(latency.count()), static_cast<double>(latency.count()) / elapsed,
+                static_cast<unsigned long long>(errors), static_cast<unsigned long long>(mismatched));
+    std::printf("Latency (us): mean %.1f, p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu\n", latency.mean(),
+                static_cast<unsigned long long>(latency.percentile(50.0)),
+                static_cast<unsigned long long>(latency.percentile(90.0)),
+                static_cast<unsigned long long>(latency.percentile(99.0)),
+                static_cast<unsigned long long>(latency.percentile(99.9)),
+                static_cast<unsigned long long>(latency.max()));
+    return latency.count() > 0 && mismatched == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+    std::cerr << "loadgen.exe needs Linux" << std::endl;
+    return 1;
+}
+
+#endif
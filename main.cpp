@@ -8,12 +8,38 @@
  */
 
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
 
+#include "Cluster.h"
 #include "LoadBalancer.h"
+#include "Trace.h"
 #include "Request.h"
 #include "WebServer.h"
 
+/**
+ * @brief Parses the value of a numeric command line flag
+ * @tparam T Integer type of the value
+ * @param text Decimal digits, without sign
+ * @param value Receives the value on success
+ * @return false if the text is empty, not all digits or too large for T
+ */
+template <typename T>
+static bool parseNumber(const std::string& text, T& value) {
+    // Nineteen digits always fit in an unsigned long long
+    if (text.empty() || text.size() > 19 || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long long number = std::stoull(text);
+    if (number > static_cast<unsigned long long>(std::numeric_limits<T>::max())) {
+        return false;
+    }
+    value = static_cast<T>(number);
+    return true;
+}
 
 /**
  * @brief Main entry point for the Load Balancer application
@@ -24,26 +50,346 @@
  * - Number of simulation cycles to run
  * - Initial queue size (or -1 for automatic sizing)
  * 
- * @return 0 on successful completion
+ * Optional command line flags:
+ * - --log-level=<error|warn|info|debug> sets the simulation log verbosity (default: info;
+ *   per-server lines are only shown at debug)
+ * - --quiet stops echoing the simulation log to the console
+ * - --engine=<tick|event> selects tick-by-tick or event-driven simulation (default: tick)
+ * - --discipline=<fifo|sjf|srpt> selects the order in which queued requests are served:
+ *   oldest first (default), shortest first, or shortest first with preemption
+ * - --aging=<ticks> lets a request overtake requests one cycle shorter for every <ticks>
+ *   it waits under sjf and srpt (default: no aging)
+ * - --seed=<n> makes the generated traffic reproducible (default: random)
+ * - --policy=<name> selects the dispatch policy: first-idle (default), round-robin,
+ *   least-loaded, power-of-two, weighted[:w0,w1,...] or hash
+ * - --replay=<trace> replays a binary traffic trace instead of generating random traffic
+ *   (the initial queue prompt is skipped; the trace supplies all requests; cannot be
+ *   combined with --checkpoint or --restore)
+ * - --autoscaler=<spec> selects the autoscaler: reactive (default) or
+ *   predictive[:key=value,...] (see makeAutoscaler() for the keys)
+ * - --admission=<spec> bounds the queue and sheds requests: none (default), tail:<cap>,
+ *   red:<cap>[,...], codel:<cap>[,...] or quota:<cap>[,...] (see makeAdmissionPolicy())
+ * - --rate-limit=<rate>,<burst>[,<strikes>,<block ticks>[,<max sources>]] limits each source
+ *   address to rate requests per tick with bursts of up to burst, and blocks a source for
+ *   block ticks after strikes limited requests in a row (defaults: 5, 1000, 65536)
+ * - --workload=<file> replaces the built-in traffic with the workload described in the file:
+ *   Bernoulli, Poisson, MMPP or diurnal arrivals and uniform, exponential, Pareto or
+ *   lognormal service times (see workload.conf for the keys)
+ * - --firewall-audit=<key=value,...> sets how blocked, rate-limited and shed requests are
+ *   counted in firewall_audit.csv: window=<ticks> (default 1000), max-size=<bytes>[k|m]
+ *   (rotate at this size; default 8m, 0 never), keep=<files> (default 5) and
+ *   compress=gzip|none (gzip needs a build with zlib)
+ * - --watch-blocklist[=<poll ms>] reloads blocked_ips.txt whenever it changes during the run
+ *   (inotify where available, otherwise polling every poll ms; default: 1000)
+ * - --slo=<ticks> sets the sojourn-time objective reported at the end (default: 50)
+ * - --provision-delay=<ticks> makes new servers take that long to start (default: 0)
+ * - --warmup=<ticks>[,<speed>] makes new servers start at the given share of full speed
+ *   (default 0.5) and reach full speed after the given time (default: no warm-up)
+ * - --standby=<n> keeps n pre-warmed standby servers that scale-up takes first (default: 0)
+ * - --fleet=<slots>[x<speed>][:fifo|:ps],... spreads the servers evenly over server profiles
+ *   with that many request slots, slot speed (default 1) and FIFO slots or processor
+ *   sharing (default fifo), e.g. 4x1,2x2:ps (default: every server 1x1)
+ * - --threads=<n> runs the tick engine's per-server work on n threads (default: serial;
+ *   servers are then picked by index and only the first-idle policy is available)
+ * - --producers=<n> generates the random traffic on n producer threads (default: inline;
+ *   cannot be combined with --replay)
+ * - --record=<trace> records the run's traffic to a binary trace
+ * - --profile[=<prefix>] times the phases of every tick and counts enqueues, dispatches,
+ *   completions, blocks and scaling events, and writes <prefix>.json and the Chrome
+ *   trace-event timeline <prefix>.trace.json after the run (default prefix: profile; not
+ *   available with --cluster or in a build with PROFILING=0)
+ * - --checkpoint=<file> writes the complete simulation state to a checkpoint after the run
+ * - --restore=<file> continues from a checkpoint instead of starting afresh (only the
+ *   cycles prompt is shown; the other options apply on top of the restored state, except
+ *   --fleet and --workload, which the checkpoint holds)
+ * - --cluster=<key=value,...> runs several load balancers behind a locality-aware front
+ *   tier that spill load to each other: nodes (default 2), latency=<ticks> a spilled request
+ *   takes (default 5), spill=<queued per cycle/tick of capacity> (default 10, 0 never),
+ *   locality=<source address bits> per client zone (default 28) and
+ *   scaling=independent|global (see parseClusterSettings()); the servers and initial queue
+ *   are spread over the nodes and every other option applies to each node (cannot be
+ *   combined with --replay, --record, --producers, --profile, --checkpoint or --restore)
+ * - --import-jsonl=<input.jsonl>,<output.trace> converts a JSON Lines trace and exits
+ * - --proxy=<key=value,...> relays real TCP connections instead of simulating (no prompts):
+ *   listen=[<ip>:]<port> (default 127.0.0.1:8080), backend=[<ip>:]<port> (once per backend),
+ *   workers, slots, pool, backlog, seconds and policy (see parseProxySettings()); the
+ *   firewall rules, --policy and --watch-blocklist apply
+ * 
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 on successful completion, 1 on an invalid command line flag, trace or
+ *         checkpoint error or proxy that cannot start
  */
-int main() {
+int main(int argc, char* argv[]) {
 	
+    LogLevel logLevel = LogLevel::Info;
+    bool quiet = false;
+    SimulationEngine engine = SimulationEngine::Tick;
+    QueueDiscipline discipline = QueueDiscipline::Fifo;
+    int aging = 0;
+    unsigned int seed = 0;
+    std::string policy;
+    int threads = 0;
+    int producers = 0;
+    std::string autoscaler;
+    std::string admission;
+    int slo = -1;
+    double rateLimit = -1.0;
+    double rateBurst = 0.0;
+    int rateStrikes = 5;
+    int blockTicks = 1000;
+    unsigned long maxSources = 65536;
+    int provisionDelay = 0;
+    int warmupTicks = 0;
+    double coldSpeed = 0.5;
+    int standby = 0;
+    int watchPollMs = -1;
+    AuditSettings auditSettings;
+    WorkloadConfig workloadConfig;
+    bool auditSet = false;
+    std::string replayFile;
+    std::string recordFile;
+    std::string checkpointFile;
+    std::string restoreFile;
+    std::string profileFile;
+    std::vector<ServerProfile> fleet;
+    ProxySettings proxySettings;
+    bool proxy = false;
+    ClusterSettings clusterSettings;
+    bool cluster = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--log-level=", 0) == 0 && parseLogLevel(arg.substr(12), logLevel)) {
+            continue;
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else if (arg == "--engine=tick" || arg == "--engine=event") {
+            engine = arg == "--engine=event" ? SimulationEngine::Event : SimulationEngine::Tick;
+        } else if (arg == "--discipline=fifo" || arg == "--discipline=sjf" || arg == "--discipline=srpt") {
+            discipline = arg == "--discipline=sjf" ? QueueDiscipline::ShortestFirst
+                       : arg == "--discipline=srpt" ? QueueDiscipline::ShortestRemaining : QueueDiscipline::Fifo;
+        } else if (arg.rfind("--aging=", 0) == 0 && parseNumber(arg.substr(8), aging)) {
+            continue;
+        } else if (arg.rfind("--seed=", 0) == 0 && parseNumber(arg.substr(7), seed)) {
+            continue;
+        } else if (arg.rfind("--policy=", 0) == 0 && makeDispatchPolicy(arg.substr(9), 0)) {
+            policy = arg.substr(9);
+        } else if (arg.rfind("--threads=", 0) == 0 && parseNumber(arg.substr(10), threads)) {
+            continue;
+        } else if (arg.rfind("--autoscaler=", 0) == 0 && makeAutoscaler(arg.substr(13))) {
+            autoscaler = arg.substr(13);
+        } else if (arg.rfind("--admission=", 0) == 0 && makeAdmissionPolicy(arg.substr(12), 0)) {
+            admission = arg.substr(12);
+        } else if (arg.rfind("--rate-limit=", 0) == 0) {
+            char tail = 0;
+            int fields = std::sscanf(arg.c_str() + 13, "%lf,%lf,%d,%d,%lu%c", &rateLimit, &rateBurst, &rateStrikes,
+                                     &blockTicks, &maxSources, &tail);
+            if (fields < 2 || fields == 3 || fields > 5 || rateLimit < 0.0 || rateBurst < 1.0 || rateStrikes < 0
+                || blockTicks < 0 || maxSources == 0) {
+                std::cerr << "Invalid rate limit: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--workload=", 0) == 0) {
+            std::string error;
+            if (!loadWorkloadConfig(arg.substr(11), workloadConfig, error)) {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--firewall-audit=", 0) == 0) {
+            if (!parseAuditSettings(arg.substr(17), auditSettings)) {
+                std::cerr << "Invalid firewall audit settings: " << arg
+                          << (FirewallAudit::compressionAvailable() ? "" : " (built without zlib, so compress=gzip is unavailable)")
+                          << std::endl;
+                return 1;
+            }
+            auditSet = true;
+        } else if (arg.rfind("--fleet=", 0) == 0 && parseFleet(arg.substr(8), fleet)) {
+            continue;
+        } else if (arg == "--watch-blocklist") {
+            watchPollMs = 1000;
+        } else if (arg.rfind("--watch-blocklist=", 0) == 0 && parseNumber(arg.substr(18), watchPollMs)) {
+            continue;
+        } else if (arg.rfind("--slo=", 0) == 0 && parseNumber(arg.substr(6), slo)) {
+            continue;
+        } else if (arg.rfind("--provision-delay=", 0) == 0 && parseNumber(arg.substr(18), provisionDelay)) {
+            continue;
+        } else if (arg.rfind("--warmup=", 0) == 0
+                   && parseNumber(arg.substr(9, arg.find(',') == std::string::npos ? std::string::npos : arg.find(',') - 9),
+                                  warmupTicks)) {
+            size_t comma = arg.find(',');
+            if (comma != std::string::npos) {
+                coldSpeed = std::atof(arg.c_str() + comma + 1);
+            }
+            if (coldSpeed <= 0.0 || coldSpeed > 1.0) {
+                std::cerr << "Warm-up speed must be in (0, 1]: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--standby=", 0) == 0 && parseNumber(arg.substr(10), standby)) {
+            continue;
+        } else if (arg.rfind("--producers=", 0) == 0 && parseNumber(arg.substr(12), producers)) {
+            continue;
+        } else if (arg.rfind("--replay=", 0) == 0) {
+            replayFile = arg.substr(9);
+        } else if (arg.rfind("--record=", 0) == 0) {
+            recordFile = arg.substr(9);
+        } else if (arg == "--profile") {
+            profileFile = "profile";
+        } else if (arg.rfind("--profile=", 0) == 0 && arg.size() > 10) {
+            profileFile = arg.substr(10);
+        } else if (arg.rfind("--checkpoint=", 0) == 0 && arg.size() > 13) {
+            checkpointFile = arg.substr(13);
+        } else if (arg.rfind("--restore=", 0) == 0 && arg.size() > 10) {
+            restoreFile = arg.substr(10);
+        } else if (arg.rfind("--proxy=", 0) == 0) {
+            if (!parseProxySettings(arg.substr(8), proxySettings)) {
+                std::cerr << "Invalid proxy settings: " << arg << std::endl;
+                return 1;
+            }
+            proxy = true;
+        } else if (arg.rfind("--cluster=", 0) == 0) {
+            if (!parseClusterSettings(arg.substr(10), clusterSettings)) {
+                std::cerr << "Invalid cluster settings: " << arg << std::endl;
+                return 1;
+            }
+            cluster = true;
+        } else if (arg.rfind("--import-jsonl=", 0) == 0 && arg.find(',') != std::string::npos) {
+            std::string paths = arg.substr(15);
+            std::string input = paths.substr(0, paths.find(','));
+            std::string output = paths.substr(paths.find(',') + 1);
+            std::string error;
+            long long records = importTraceJsonl(input, output, error);
+            if (records < 0) {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+            std::cout << "Imported " << records << " requests into " << output << std::endl;
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (proxy) {
+        LoadBalancer lb(1, 0, "blocked_ips.txt", seed, !quiet);
+        lb.setLogLevel(logLevel);
+        if (watchPollMs >= 0) {
+            lb.watchBlockedIPs("blocked_ips.txt", watchPollMs);
+        }
+        if (!policy.empty()) {
+            proxySettings.policy = policy;
+        }
+        return lb.runProxy(proxySettings) ? 0 : 1;
+    }
+    if (cluster && (!replayFile.empty() || !recordFile.empty() || producers > 0 || !profileFile.empty())) {
+        std::cerr << "--cluster cannot be combined with --replay, --record, --producers or --profile" << std::endl;
+        return 1;
+    }
+    bool checkpointing = !checkpointFile.empty() || !restoreFile.empty();
+    if (checkpointing && (cluster || !replayFile.empty())) {
+        std::cerr << "--checkpoint and --restore cannot be combined with --cluster or --replay" << std::endl;
+        return 1;
+    }
+
     int servers;
     int cycles;
     int initialQueue;
 
     
-    std::cout << "Enter number of servers: ";
-    std::cin >> servers;
+    if (restoreFile.empty()) {
+        std::cout << "Enter number of servers: ";
+        std::cin >> servers;
+    } else {
+        servers = 1;
+    }
     std::cout << "Enter number of simulation cycles: ";
     std::cin >> cycles;
-    std::cout << "Enter initial queue size (or -1 for servers*100): ";
-    std::cin >> initialQueue;
+    if (replayFile.empty() && restoreFile.empty()) {
+        std::cout << "Enter initial queue size (or -1 for servers*100): ";
+        std::cin >> initialQueue;
+    } else {
+        initialQueue = 0;
+    }
+
+    // Options shared by a single load balancer and every node of a cluster
+    auto configure = [&](LoadBalancer& lb) {
+        lb.setLogLevel(logLevel);
+        if (auditSet) {
+            lb.setFirewallAudit(auditSettings);
+        }
+        if (watchPollMs >= 0) {
+            lb.watchBlockedIPs("blocked_ips.txt", watchPollMs);
+        }
+        lb.setEngine(engine);
+        if (discipline != QueueDiscipline::Fifo) {
+            lb.setQueueDiscipline(discipline, aging);
+        }
+        if (!policy.empty()) {
+            lb.setDispatchPolicy(policy);
+        }
+        if (!admission.empty()) {
+            lb.setAdmissionPolicy(admission);
+        }
+        if (rateLimit >= 0.0) {
+            lb.setRateLimit(rateLimit, rateBurst, rateStrikes, blockTicks, maxSources);
+        }
+        if (slo >= 0) {
+            lb.setSlo(slo);
+        }
+        if (provisionDelay > 0 || warmupTicks > 0 || standby > 0) {
+            lb.setProvisioning(provisionDelay, warmupTicks, coldSpeed, standby);
+        }
+        if (!fleet.empty() && restoreFile.empty()) {
+            lb.setFleet(fleet);
+        }
+        if (threads > 0) {
+            lb.setThreads(threads);
+        }
+    };
+
+    if (cluster) {
+        if (servers < clusterSettings.nodes) {
+            std::cerr << "A cluster of " << clusterSettings.nodes << " nodes needs at least as many servers" << std::endl;
+            return 1;
+        }
+        Cluster nodes(clusterSettings, servers, initialQueue, "blocked_ips.txt", seed, !quiet, workloadConfig);
+        nodes.setLogLevel(logLevel);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            configure(nodes.node(i));
+        }
+        if (!autoscaler.empty()) {
+            nodes.setAutoscaler(autoscaler);
+        }
+        nodes.run(cycles);
+        return 0;
+    }
 
     // Create loadbalancer object (automatically loads blocked IPs)
-    LoadBalancer lb(servers, initialQueue);
+    LoadBalancer lb(servers, initialQueue, "blocked_ips.txt", seed, !quiet, workloadConfig);
+    if (!restoreFile.empty() && !lb.restoreCheckpoint(restoreFile)) {
+        return 1;
+    }
+    configure(lb);
+    if (!autoscaler.empty()) {
+        lb.setAutoscaler(autoscaler);
+    }
+    if (!recordFile.empty() && !lb.recordTrace(recordFile)) {
+        return 1;
+    }
+    if (!replayFile.empty() && !lb.replayTrace(replayFile)) {
+        return 1;
+    }
+    if (producers > 0 && !lb.setProducers(producers)) {
+        return 1;
+    }
+    if (!profileFile.empty() && !lb.setProfiling(profileFile)) {
+        return 1;
+    }
     
     // Run simulation
     lb.run(cycles);
+    if (!checkpointFile.empty() && !lb.saveCheckpoint(checkpointFile)) {
+        return 1;
+    }
 	return 0;
 }